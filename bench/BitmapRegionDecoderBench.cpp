@@ -9,14 +9,17 @@
 #include "bench/CodecBenchPriv.h"
 #include "include/core/SkBitmap.h"
 #include "src/core/SkOSFile.h"
+#include "src/core/SkResourceCache.h"
 
 BitmapRegionDecoderBench::BitmapRegionDecoderBench(const char* baseName, SkData* encoded,
-        SkColorType colorType, uint32_t sampleSize, const SkIRect& subset)
+        SkColorType colorType, uint32_t sampleSize, const SkIRect& subset,
+        SkBitmapRegionDecoder::Strategy strategy)
     : fBRD(nullptr)
     , fData(SkRef(encoded))
     , fColorType(colorType)
     , fSampleSize(sampleSize)
     , fSubset(subset)
+    , fStrategy(strategy)
 {
     // Choose a useful name for the color type
     const char* colorName = color_type_to_str(colorType);
@@ -25,6 +28,9 @@ BitmapRegionDecoderBench::BitmapRegionDecoderBench(const char* baseName, SkData*
     if (1 != sampleSize) {
         fName.appendf("_%.3f", 1.0f / (float) sampleSize);
     }
+    if (SkBitmapRegionDecoder::kTiledCache_Strategy == strategy) {
+        fName.append("_Tiled");
+    }
 }
 
 const char* BitmapRegionDecoderBench::onGetName() {
@@ -36,13 +42,17 @@ bool BitmapRegionDecoderBench::isSuitableFor(Backend backend) {
 }
 
 void BitmapRegionDecoderBench::onDelayedSetup() {
-    fBRD.reset(SkBitmapRegionDecoder::Create(fData, SkBitmapRegionDecoder::kAndroidCodec_Strategy));
+    fBRD.reset(SkBitmapRegionDecoder::Create(fData, fStrategy));
 }
 
 void BitmapRegionDecoderBench::onDraw(int n, SkCanvas* canvas) {
     auto ct = fBRD->computeOutputColorType(fColorType);
     auto cs = fBRD->computeOutputColorSpace(ct, nullptr);
     for (int i = 0; i < n; i++) {
+        if (SkBitmapRegionDecoder::kTiledCache_Strategy == fStrategy) {
+            // Time decoding the tiles, not finding the ones the last iteration decoded.
+            SkResourceCache::PurgeAll();
+        }
         SkBitmap bm;
         SkAssertResult(fBRD->decodeRegion(&bm, nullptr, fSubset, fSampleSize, ct, false, cs));
     }
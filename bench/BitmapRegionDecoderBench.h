@@ -25,7 +25,9 @@ class BitmapRegionDecoderBench : public Benchmark {
 public:
     // Calls encoded->ref()
     BitmapRegionDecoderBench(const char* basename, SkData* encoded, SkColorType colorType,
-            uint32_t sampleSize, const SkIRect& subset);
+            uint32_t sampleSize, const SkIRect& subset,
+            SkBitmapRegionDecoder::Strategy strategy =
+                    SkBitmapRegionDecoder::kAndroidCodec_Strategy);
 
 protected:
     const char* onGetName() override;
@@ -40,6 +42,7 @@ private:
     const SkColorType                              fColorType;
     const uint32_t                                 fSampleSize;
     const SkIRect                                  fSubset;
+    const SkBitmapRegionDecoder::Strategy          fStrategy;
     typedef Benchmark INHERITED;
 };
 #endif // BitmapRegionDecoderBench_DEFINED
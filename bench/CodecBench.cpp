@@ -9,6 +9,7 @@
 #include "bench/CodecBenchPriv.h"
 #include "include/codec/SkCodec.h"
 #include "include/core/SkBitmap.h"
+#include "include/core/SkExecutor.h"
 #include "src/core/SkOSFile.h"
 #include "tools/flags/CommandLineFlags.h"
 
@@ -16,6 +17,10 @@
 static DEFINE_bool(zero_init, false,
                    "Pretend our destination is zero-intialized, simulating Android?");
 
+static DEFINE_bool(parallelDecode, false,
+                   "Let codecs split decodes across the threads of the default executor "
+                   "(see --threads).");
+
 CodecBench::CodecBench(SkString baseName, SkData* encoded, SkColorType colorType,
         SkAlphaType alphaType)
     : fColorType(colorType)
@@ -25,6 +30,9 @@ CodecBench::CodecBench(SkString baseName, SkData* encoded, SkColorType colorType
     // Parse filename and the color type to give the benchmark a useful name
     fName.printf("Codec_%s_%s%s", baseName.c_str(), color_type_to_str(colorType),
             alpha_type_to_str(alphaType));
+    if (FLAGS_parallelDecode) {
+        fName.append("_parallel");
+    }
     // Ensure that we can create an SkCodec from this data.
     SkASSERT(SkCodec::MakeFromData(fData));
 }
@@ -53,6 +61,9 @@ void CodecBench::onDraw(int n, SkCanvas* canvas) {
     if (FLAGS_zero_init) {
         options.fZeroInitialized = SkCodec::kYes_ZeroInitialized;
     }
+    if (FLAGS_parallelDecode) {
+        options.fExecutor = &SkExecutor::GetDefault();
+    }
     for (int i = 0; i < n; i++) {
         codec = SkCodec::MakeFromData(fData);
 #ifdef SK_DEBUG
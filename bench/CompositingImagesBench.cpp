@@ -84,7 +84,9 @@ public:
         }
     }
 
-    bool isSuitableFor(Backend backend) override { return kGPU_Backend == backend; }
+    bool isSuitableFor(Backend backend) override {
+        return kGPU_Backend == backend || kRaster_Backend == backend;
+    }
 
 protected:
     const char* onGetName() override { return fName.c_str(); }
@@ -7,6 +7,7 @@
 
 #include "bench/Benchmark.h"
 #include "include/core/SkBitmap.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkStream.h"
 #include "include/encode/SkJpegEncoder.h"
 #include "include/encode/SkPngEncoder.h"
@@ -85,6 +86,21 @@ static bool encode_png(SkWStream* dst,
 #define PNG(FLAG, ZLIBLEVEL) [](SkWStream* d, const SkPixmap& s) { \
            return encode_png(d, s, SkPngEncoder::FilterFlag::FLAG, ZLIBLEVEL); }
 
+// Splits the encode into bands on the default executor; run with --threads to give it some.
+static bool encode_png_parallel(SkWStream* dst,
+                                const SkPixmap& src,
+                                SkPngEncoder::FilterFlag filters,
+                                int zlibLevel) {
+    SkPngEncoder::Options opts;
+    opts.fFilterFlags = filters;
+    opts.fZLibLevel = zlibLevel;
+    opts.fExecutor = &SkExecutor::GetDefault();
+    return SkPngEncoder::Encode(dst, src, opts);
+}
+
+#define PNG_PARALLEL(FLAG, ZLIBLEVEL) [](SkWStream* d, const SkPixmap& s) { \
+           return encode_png_parallel(d, s, SkPngEncoder::FilterFlag::FLAG, ZLIBLEVEL); }
+
 static const char* srcs[2] = {"images/mandrill_512.png", "images/color_wheel.jpg"};
 
 // The Android Photos app uses a quality of 90 on JPEG encodes
@@ -122,4 +138,15 @@ DEF_BENCH(return new EncodeBench(srcs[1], PNG(kNone, 6), "PNG_6n"));
 DEF_BENCH(return new EncodeBench(srcs[1], PNG(kNone, 3), "PNG_3n"));
 DEF_BENCH(return new EncodeBench(srcs[1], PNG(kNone, 1), "PNG_1n"));
 
+DEF_BENCH(return new EncodeBench(srcs[0], PNG_PARALLEL(kAll, 6), "PNG_par"));
+DEF_BENCH(return new EncodeBench(srcs[0], PNG_PARALLEL(kAll, 3), "PNG_par_3"));
+DEF_BENCH(return new EncodeBench(srcs[0], PNG_PARALLEL(kAll, 1), "PNG_par_1"));
+DEF_BENCH(return new EncodeBench(srcs[0], PNG_PARALLEL(kSub, 6), "PNG_par_6s"));
+
+DEF_BENCH(return new EncodeBench(srcs[1], PNG_PARALLEL(kAll, 6), "PNG_par"));
+DEF_BENCH(return new EncodeBench(srcs[1], PNG_PARALLEL(kAll, 3), "PNG_par_3"));
+DEF_BENCH(return new EncodeBench(srcs[1], PNG_PARALLEL(kAll, 1), "PNG_par_1"));
+DEF_BENCH(return new EncodeBench(srcs[1], PNG_PARALLEL(kSub, 6), "PNG_par_6s"));
+
+#undef PNG_PARALLEL
 #undef PNG
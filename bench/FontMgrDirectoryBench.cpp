@@ -0,0 +1,66 @@
+/*
+ * Copyright 2020 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "bench/Benchmark.h"
+#include "include/core/SkFontMgr.h"
+#include "include/ports/SkFontMgr_directory.h"
+#include "src/utils/SkOSPath.h"
+#include "tools/Resources.h"
+#include "tools/flags/CommandLineFlags.h"
+
+#include <stdio.h>
+
+static DEFINE_string(fontIndexDir, "",
+                     "Writable directory for the font index of fontmgr_directory_indexed, "
+                     "which is skipped if not set.");
+
+// Measures start up of the directory font manager, which scans every font file it finds, with and
+// without a warm font index.
+class FontMgrDirectoryBench : public Benchmark {
+public:
+    explicit FontMgrDirectoryBench(bool useIndex) : fUseIndex(useIndex) {}
+
+protected:
+    const char* onGetName() override {
+        return fUseIndex ? "fontmgr_directory_indexed" : "fontmgr_directory_scan";
+    }
+
+    bool isSuitableFor(Backend backend) override {
+        return backend == kNonRendering_Backend && (!fUseIndex || !FLAGS_fontIndexDir.isEmpty());
+    }
+
+    void onDelayedSetup() override {
+        fDirectory = GetResourcePath("fonts");
+        if (fUseIndex) {
+            // Build the index once so that the timed loops only validate it.
+            fIndexFile = SkOSPath::Join(FLAGS_fontIndexDir[0], "fontmgr_directory_bench.index");
+            remove(fIndexFile.c_str());
+            SkFontMgr_New_Custom_Directory(fDirectory.c_str(), fIndexFile.c_str());
+        }
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        const char* index = fUseIndex ? fIndexFile.c_str() : nullptr;
+        for (int i = 0; i < loops; ++i) {
+            sk_sp<SkFontMgr> mgr = SkFontMgr_New_Custom_Directory(fDirectory.c_str(), index);
+            if (mgr->countFamilies() == 0) {
+                SkDebugf("!! No fonts found in %s\n", fDirectory.c_str());
+                return;
+            }
+        }
+    }
+
+private:
+    const bool fUseIndex;
+    SkString fDirectory;
+    SkString fIndexFile;
+
+    using INHERITED = Benchmark;
+};
+
+DEF_BENCH( return new FontMgrDirectoryBench(false); )
+DEF_BENCH( return new FontMgrDirectoryBench(true); )
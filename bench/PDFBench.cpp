@@ -9,6 +9,7 @@
 
 #include "include/core/SkData.h"
 #include "include/core/SkExecutor.h"
+#include "include/core/SkFont.h"
 #include "include/core/SkImage.h"
 #include "include/core/SkPixmap.h"
 #include "include/core/SkStream.h"
@@ -20,6 +21,8 @@
 #include "src/utils/SkFloatToDecimal.h"
 #include "tools/Resources.h"
 
+#include <cstdio>
+
 namespace {
 struct WStreamWriteTextBenchmark : public Benchmark {
     std::unique_ptr<SkWStream> fWStream;
@@ -43,9 +46,12 @@ DEF_BENCH(return new WStreamWriteTextBenchmark;)
 // Test speed of SkFloatToDecimal for typical floats that
 // might be found in a PDF document.
 struct PDFScalarBench : public Benchmark {
-    PDFScalarBench(const char* n, float (*f)(SkRandom*)) : fName(n), fNextFloat(f) {}
+    using WriteFn = unsigned (*)(float, char[kMaximumSkFloatToDecimalLength]);
+    PDFScalarBench(const char* n, float (*f)(SkRandom*), WriteFn w = SkFloatToDecimal)
+        : fName(n), fNextFloat(f), fWrite(w) {}
     const char* fName;
     float (*fNextFloat)(SkRandom*);
+    WriteFn fWrite;
     bool isSuitableFor(Backend b) override {
         return b == kNonRendering_Backend;
     }
@@ -55,7 +61,7 @@ struct PDFScalarBench : public Benchmark {
         char dst[kMaximumSkFloatToDecimalLength];
         while (loops-- > 0) {
             auto f = fNextFloat(&random);
-            (void)SkFloatToDecimal(f, dst);
+            (void)fWrite(f, dst);
         }
     }
 };
@@ -69,12 +75,25 @@ float next_any(SkRandom* random) {
     static_assert(sizeof(float) == sizeof(uint32_t), "");
     return f;
 }
+// Coordinates on a quarter point grid, which have short decimal representations.
+float next_grid(SkRandom* random) {
+    return random->nextRangeU(0, 4 * 1000) * 0.25f;
+}
+
+// What a printf-based writer would cost: %.9g round-trips, but needs scientific notation.
+unsigned printf_decimal(float value, char output[kMaximumSkFloatToDecimalLength]) {
+    return SkToUInt(snprintf(output, kMaximumSkFloatToDecimalLength, "%.9g", value));
+}
 
 DEF_BENCH(return new PDFScalarBench("PDFScalar_common", next_common);)
 DEF_BENCH(return new PDFScalarBench("PDFScalar_random", next_any);)
+DEF_BENCH(return new PDFScalarBench("PDFScalar_grid", next_grid);)
+DEF_BENCH(return new PDFScalarBench("PDFScalar_printf_common", next_common, printf_decimal);)
+DEF_BENCH(return new PDFScalarBench("PDFScalar_printf_random", next_any, printf_decimal);)
 
 #ifdef SK_SUPPORT_PDF
 
+#include "src/pdf/SkDeflate.h"
 #include "src/pdf/SkPDFBitmap.h"
 #include "src/pdf/SkPDFDocumentPriv.h"
 #include "src/pdf/SkPDFShader.h"
@@ -183,6 +202,56 @@ private:
     std::unique_ptr<SkStreamAsset> fAsset;
 };
 
+/** Test SkDeflateWStream on a 1.2MB stream, with and without an executor
+    to split it into blocks.  The incompressible variant stands in for
+    already compressed image and font data. */
+class PDFDeflateBench : public Benchmark {
+public:
+    PDFDeflateBench(bool parallel, bool incompressible)
+        : fParallel(parallel), fIncompressible(incompressible) {
+        fName.printf("PDFDeflate_%s%s", incompressible ? "incompressible_" : "",
+                     parallel ? "parallel" : "serial");
+    }
+
+protected:
+    const char* onGetName() override { return fName.c_str(); }
+    bool isSuitableFor(Backend backend) override {
+        return backend == kNonRendering_Backend;
+    }
+    void onDelayedSetup() override {
+        SkDynamicMemoryWStream input;
+        if (fIncompressible) {
+            SkRandom random;
+            for (int i = 0; i < 300 * 1024; ++i) {
+                input.write32(random.nextU());
+            }
+        } else if (sk_sp<SkData> commands = GetResourceAsData("pdf_command_stream.txt")) {
+            for (int i = 0; i < 16; ++i) {
+                input.write(commands->data(), commands->size());
+            }
+        }
+        fInput = input.detachAsData();
+        if (fParallel) {
+            fExecutor = SkExecutor::MakeFIFOThreadPool();
+        }
+    }
+    void onDraw(int loops, SkCanvas*) override {
+        while (loops-- > 0) {
+            SkNullWStream wStream;
+            SkDeflateWStream deflateWStream(&wStream, -1, false, fExecutor.get());
+            deflateWStream.write(fInput->data(), fInput->size());
+            deflateWStream.finalize();
+        }
+    }
+
+private:
+    const bool fParallel;
+    const bool fIncompressible;
+    SkString fName;
+    sk_sp<SkData> fInput;
+    std::unique_ptr<SkExecutor> fExecutor;
+};
+
 struct PDFColorComponentBench : public Benchmark {
     bool isSuitableFor(Backend b) override {
         return b == kNonRendering_Backend;
@@ -301,17 +370,88 @@ struct PDFClipPathBenchmark : public Benchmark {
     }
 };
 
+/** Write a document of pages full of paths, text and gradients, with and without an executor
+    to draw the pages in parallel. */
+class PDFPagesBench : public Benchmark {
+public:
+    PDFPagesBench(bool parallel) : fParallel(parallel) {}
+
+protected:
+    const char* onGetName() override {
+        return fParallel ? "PDFPages_parallel" : "PDFPages_serial";
+    }
+    bool isSuitableFor(Backend backend) override {
+        return backend == kNonRendering_Backend;
+    }
+    void onDelayedSetup() override {
+        if (fParallel) {
+            fExecutor = SkExecutor::MakeFIFOThreadPool();
+        }
+    }
+    void onDraw(int loops, SkCanvas*) override {
+        const SkPoint points[] = {{0, 0}, {612, 792}};
+        const SkColor colors[] = {SK_ColorRED, SK_ColorBLUE};
+        SkPaint gradient;
+        gradient.setShader(
+                SkGradientShader::MakeLinear(points, colors, nullptr, 2, SkTileMode::kClamp));
+        SkFont font;
+        font.setSize(10);
+        while (loops-- > 0) {
+            SkNullWStream wStream;
+            SkPDF::Metadata metadata;
+            metadata.fExecutor = fExecutor.get();
+            SkPDFDocument doc(&wStream, metadata);
+            SkRandom random;
+            for (int page = 0; page < 16; ++page) {
+                SkCanvas* canvas = doc.beginPage(612, 792);
+                canvas->drawPaint(gradient);
+                SkPaint paint;
+                paint.setAntiAlias(true);
+                for (int i = 0; i < 200; ++i) {
+                    SkPath path;
+                    path.moveTo(random.nextRangeF(0, 612), random.nextRangeF(0, 792));
+                    for (int j = 0; j < 8; ++j) {
+                        path.cubicTo(random.nextRangeF(0, 612), random.nextRangeF(0, 792),
+                                     random.nextRangeF(0, 612), random.nextRangeF(0, 792),
+                                     random.nextRangeF(0, 612), random.nextRangeF(0, 792));
+                    }
+                    paint.setColor(random.nextU() | 0xFF000000);
+                    paint.setStyle(i % 2 ? SkPaint::kStroke_Style : SkPaint::kFill_Style);
+                    canvas->drawPath(path, paint);
+                }
+                for (int line = 0; line < 60; ++line) {
+                    canvas->drawString("Sed ut perspiciatis, unde omnis iste natus error sit",
+                                       36, 36 + 12.0f * line, font, SkPaint());
+                }
+                doc.endPage();
+            }
+            doc.close();
+        }
+    }
+
+private:
+    const bool fParallel;
+    std::unique_ptr<SkExecutor> fExecutor;
+};
+
 }  // namespace
 DEF_BENCH(return new PDFImageBench;)
 DEF_BENCH(return new PDFJpegImageBench;)
 DEF_BENCH(return new PDFCompressionBench;)
+DEF_BENCH(return new PDFDeflateBench(false, false);)
+DEF_BENCH(return new PDFDeflateBench(true, false);)
+DEF_BENCH(return new PDFDeflateBench(false, true);)
+DEF_BENCH(return new PDFDeflateBench(true, true);)
 DEF_BENCH(return new PDFColorComponentBench;)
 DEF_BENCH(return new PDFShaderBench;)
 DEF_BENCH(return new WritePDFTextBenchmark;)
 DEF_BENCH(return new PDFClipPathBenchmark;)
+DEF_BENCH(return new PDFPagesBench(false);)
+DEF_BENCH(return new PDFPagesBench(true);)
 
 #ifdef SK_PDF_ENABLE_SLOW_TESTS
 #include "include/core/SkExecutor.h"
+#include "include/core/SkFont.h"
 namespace {
 void big_pdf_test(SkDocument* doc, const SkBitmap& background) {
     static const char* kText[] = {
@@ -53,6 +53,47 @@ struct ParagraphBench : public Benchmark {
         }
     }
 };
+
+// Lays out a long document at alternating widths, as when a window is being resized.
+struct ParagraphResizeBench : public Benchmark {
+    ParagraphResizeBench(bool edit) : fEdit(edit) {}
+    std::unique_ptr<Paragraph> fParagraph;
+    bool fEdit;
+    const char* onGetName() override {
+        return fEdit ? "paragraph_edit_10k_words" : "paragraph_resize_10k_words";
+    }
+    bool isSuitableFor(Backend backend) override { return backend == kNonRendering_Backend; }
+    void onDelayedSetup() override {
+        SkString text;
+        const char* words[] = { "lorem", "ipsum", "dolor", "sit", "amet", "consectetur" };
+        for (int i = 0; i < 10000; ++i) {
+            text.appendf("%s ", words[i % SK_ARRAY_COUNT(words)]);
+        }
+
+        auto fontCollection = sk_make_sp<FontCollection>();
+        fontCollection->setDefaultFontManager(SkFontMgr::RefDefault());
+        fontCollection->enableFontFallback();
+        ParagraphStyle paragraph_style;
+        paragraph_style.turnHintingOff();
+        ParagraphBuilderImpl builder(paragraph_style, fontCollection);
+        builder.addText(text.c_str(), text.size());
+        fParagraph = builder.Build();
+        fParagraph->layout(1000);
+    }
+    void onDraw(int loops, SkCanvas*) override {
+        for (int i = 0; i < loops; ++i) {
+            if (fEdit) {
+                // Type a character in the middle of the document and take it back again.
+                fParagraph->replaceText(5000, 5000, SkString("x"));
+                fParagraph->layout(1000);
+                fParagraph->replaceText(5000, 5001, SkString());
+                fParagraph->layout(1000);
+            } else {
+                fParagraph->layout(i & 1 ? 1000 : 600);
+            }
+        }
+    }
+};
 }  // namespace
 
 #define PARAGRAPH_BENCH(X) DEF_BENCH(return new ParagraphBench(50000, "text/" #X ".txt", "paragraph_" #X);)
@@ -61,4 +102,7 @@ struct ParagraphBench : public Benchmark {
 PARAGRAPH_BENCH(english)
 #undef PARAGRAPH_BENCH
 
+DEF_BENCH(return new ParagraphResizeBench(false);)
+DEF_BENCH(return new ParagraphResizeBench(true);)
+
 #endif  // !defined(SK_BUILD_FOR_ANDROID_FRAMEWORK) && !defined(SK_BUILD_FOR_GOOGLE3)
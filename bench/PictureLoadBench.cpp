@@ -0,0 +1,75 @@
+/*
+ * Copyright 2020 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#include "bench/Benchmark.h"
+#include "include/core/SkCanvas.h"
+#include "include/core/SkData.h"
+#include "include/core/SkPaint.h"
+#include "include/core/SkPath.h"
+#include "include/core/SkPicture.h"
+#include "include/core/SkPictureRecorder.h"
+#include "include/core/SkString.h"
+#include "include/utils/SkNoDrawCanvas.h"
+#include "include/utils/SkRandom.h"
+
+// Compares opening a serialized picture with SkPicture::MakeFromData() against
+// SkPicture::MakeFromMappedData(), optionally followed by playing all of it back once. Neither
+// picture has a bounding box hierarchy, so the playback reads every op whatever the clip; it goes
+// to an SkNoDrawCanvas to time decoding and dispatching the ops rather than rasterizing them.
+class PictureLoadBench : public Benchmark {
+public:
+    PictureLoadBench(bool mapped, bool draw) : fMapped(mapped), fDraw(draw) {
+        fName.printf("picture_load_%s%s", mapped ? "mapped" : "skp", draw ? "_first_draw" : "");
+    }
+
+protected:
+    const char* onGetName() override { return fName.c_str(); }
+    bool isSuitableFor(Backend backend) override { return backend == kNonRendering_Backend; }
+
+    void onDelayedSetup() override {
+        SkPictureRecorder recorder;
+        SkCanvas* canvas = recorder.beginRecording(4096, 4096);
+        SkRandom rand;
+        for (int i = 0; i < 10000; i++) {
+            SkScalar x = rand.nextRangeScalar(0, 4096),
+                     y = rand.nextRangeScalar(0, 4096),
+                     w = rand.nextRangeScalar(0, 128),
+                     h = rand.nextRangeScalar(0, 128);
+            SkRect r = SkRect::MakeXYWH(x, y, w, h);
+            SkPaint paint;
+            paint.setColor(rand.nextU() | 0xFF000000);
+            if (i % 4 == 0) {
+                canvas->drawPath(SkPath().addOval(r), paint);
+            } else {
+                canvas->drawRect(r, paint);
+            }
+        }
+        sk_sp<SkPicture> picture = recorder.finishRecordingAsPicture();
+        fData = fMapped ? picture->serializeForMapping() : picture->serialize();
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        for (int i = 0; i < loops; i++) {
+            sk_sp<SkPicture> picture = fMapped ? SkPicture::MakeFromMappedData(fData)
+                                               : SkPicture::MakeFromData(fData.get());
+            if (fDraw) {
+                SkNoDrawCanvas canvas(4096, 4096);
+                picture->playback(&canvas);
+            }
+        }
+    }
+
+private:
+    bool          fMapped;
+    bool          fDraw;
+    SkString      fName;
+    sk_sp<SkData> fData;
+};
+
+DEF_BENCH( return new PictureLoadBench(false, false); )
+DEF_BENCH( return new PictureLoadBench(true,  false); )
+DEF_BENCH( return new PictureLoadBench(false, true ); )
+DEF_BENCH( return new PictureLoadBench(true,  true ); )
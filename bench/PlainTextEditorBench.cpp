@@ -0,0 +1,87 @@
+/*
+ * Copyright 2020 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "bench/Benchmark.h"
+#include "include/core/SkCanvas.h"
+#include "include/core/SkFontMgr.h"
+#include "include/core/SkString.h"
+#include "include/utils/SkNoDrawCanvas.h"
+#include "modules/skplaintexteditor/include/editor.h"
+
+using SkPlainTextEditor::Editor;
+
+// Edits and scrolls through a 100k line log file, painting a window's worth of text each time.
+class PlainTextEditorBench : public Benchmark {
+public:
+    enum class Mode { kInsertTop, kInsertNewlineTop, kScroll };
+
+    PlainTextEditorBench(Mode mode) : fMode(mode) {
+        const char* names[] = { "insert_top", "insert_newline_top", "scroll" };
+        fName.printf("plaintexteditor_100k_lines_%s", names[(int)mode]);
+    }
+
+protected:
+    static constexpr int kLines = 100000;
+    static constexpr int kWidth = 800;
+    static constexpr int kHeight = 600;
+
+    const char* onGetName() override { return fName.c_str(); }
+    bool isSuitableFor(Backend backend) override { return backend == kNonRendering_Backend; }
+
+    void onDelayedSetup() override {
+        SkString text;
+        for (int i = 0; i < kLines; ++i) {
+            text.appendf("%06d [info] request served in %d ms from cache shard %d\n",
+                         i, i % 97, i % 13);
+        }
+        fEditor.setFont(SkFont(SkFontMgr::RefDefault()->legacyMakeTypeface(nullptr, {}), 14));
+        fEditor.setWidth(kWidth);
+        fEditor.insert(Editor::TextPosition{0, 0}, text.c_str(), text.size());
+        this->paint(0);
+    }
+
+    void onDraw(int loops, SkCanvas*) override {
+        for (int i = 0; i < loops; ++i) {
+            switch (fMode) {
+                case Mode::kInsertTop: {
+                    auto pos = fEditor.insert(Editor::TextPosition{0, 10}, "x", 1);
+                    this->paint(0);
+                    fEditor.remove(Editor::TextPosition{0, 10}, pos);
+                    this->paint(0);
+                    break;
+                }
+                case Mode::kInsertNewlineTop: {
+                    auto pos = fEditor.insert(Editor::TextPosition{0, 10}, "\n", 1);
+                    this->paint(0);
+                    fEditor.remove(Editor::TextPosition{0, 10}, pos);
+                    this->paint(0);
+                    break;
+                }
+                case Mode::kScroll:
+                    fScroll = (fScroll + kHeight / 2) % fEditor.getHeight();
+                    this->paint(fScroll);
+                    break;
+            }
+        }
+    }
+
+private:
+    void paint(int scroll) {
+        SkNoDrawCanvas canvas(kWidth, kHeight);
+        canvas.translate(0, -(float)scroll);
+        fEditor.paint(&canvas, Editor::PaintOpts());
+    }
+
+    Mode fMode;
+    SkString fName;
+    Editor fEditor;
+    int fScroll = 0;
+};
+
+DEF_BENCH(return new PlainTextEditorBench(PlainTextEditorBench::Mode::kInsertTop);)
+DEF_BENCH(return new PlainTextEditorBench(PlainTextEditorBench::Mode::kInsertNewlineTop);)
+DEF_BENCH(return new PlainTextEditorBench(PlainTextEditorBench::Mode::kScroll);)
@@ -16,14 +16,18 @@ static const SkScalar GENERATE_EXTENTS = 1000.0f;
 static const int NUM_BUILD_RECTS = 500;
 static const int NUM_QUERY_RECTS = 5000;
 static const int GRID_WIDTH = 100;
+static const int NUM_LARGE_RECTS = 100000;
+static const int NUM_BATCH_QUERIES = 64;
 
 typedef SkRect (*MakeRectProc)(SkRandom&, int, int);
 
 // Time how long it takes to build an R-Tree.
 class RTreeBuildBench : public Benchmark {
 public:
-    RTreeBuildBench(const char* name, MakeRectProc proc) : fProc(proc) {
-        fName.printf("rtree_%s_build", name);
+    RTreeBuildBench(const char* name, MakeRectProc proc, int numRects = NUM_BUILD_RECTS)
+        : fProc(proc)
+        , fNumRects(numRects) {
+        fName.printf("rtree_%s_build%s", name, numRects == NUM_BUILD_RECTS ? "" : "_large");
     }
 
     bool isSuitableFor(Backend backend) override {
@@ -36,19 +40,20 @@ protected:
     }
     void onDraw(int loops, SkCanvas* canvas) override {
         SkRandom rand;
-        SkAutoTMalloc<SkRect> rects(NUM_BUILD_RECTS);
-        for (int i = 0; i < NUM_BUILD_RECTS; ++i) {
-            rects[i] = fProc(rand, i, NUM_BUILD_RECTS);
+        SkAutoTMalloc<SkRect> rects(fNumRects);
+        for (int i = 0; i < fNumRects; ++i) {
+            rects[i] = fProc(rand, i, fNumRects);
         }
 
         for (int i = 0; i < loops; ++i) {
             SkRTree tree;
-            tree.insert(rects.get(), NUM_BUILD_RECTS);
+            tree.insert(rects.get(), fNumRects);
             SkASSERT(rects != nullptr);  // It'd break this bench if the tree took ownership of rects.
         }
     }
 private:
     MakeRectProc fProc;
+    int fNumRects;
     SkString fName;
     typedef Benchmark INHERITED;
 };
@@ -56,8 +61,10 @@ private:
 // Time how long it takes to perform queries on an R-Tree.
 class RTreeQueryBench : public Benchmark {
 public:
-    RTreeQueryBench(const char* name, MakeRectProc proc) : fProc(proc) {
-        fName.printf("rtree_%s_query", name);
+    RTreeQueryBench(const char* name, MakeRectProc proc, int numRects = NUM_QUERY_RECTS)
+        : fProc(proc)
+        , fNumRects(numRects) {
+        fName.printf("rtree_%s_query%s", name, numRects == NUM_QUERY_RECTS ? "" : "_large");
     }
 
     bool isSuitableFor(Backend backend) override {
@@ -69,11 +76,11 @@ protected:
     }
     void onDelayedSetup() override {
         SkRandom rand;
-        SkAutoTMalloc<SkRect> rects(NUM_QUERY_RECTS);
-        for (int i = 0; i < NUM_QUERY_RECTS; ++i) {
-            rects[i] = fProc(rand, i, NUM_QUERY_RECTS);
+        SkAutoTMalloc<SkRect> rects(fNumRects);
+        for (int i = 0; i < fNumRects; ++i) {
+            rects[i] = fProc(rand, i, fNumRects);
         }
-        fTree.insert(rects.get(), NUM_QUERY_RECTS);
+        fTree.insert(rects.get(), fNumRects);
     }
 
     void onDraw(int loops, SkCanvas* canvas) override {
@@ -91,6 +98,56 @@ protected:
 private:
     SkRTree fTree;
     MakeRectProc fProc;
+    int fNumRects;
+    SkString fName;
+    typedef Benchmark INHERITED;
+};
+
+// Time how long it takes to look up a set of small dirty rects at once, or one at a time.
+class RTreeDirtyRectsBench : public Benchmark {
+public:
+    RTreeDirtyRectsBench(MakeRectProc proc, bool batch) : fProc(proc), fBatch(batch) {
+        fName.printf("rtree_dirty_rects_%s", batch ? "batch" : "each");
+    }
+
+    bool isSuitableFor(Backend backend) override {
+        return backend == kNonRendering_Backend;
+    }
+protected:
+    const char* onGetName() override {
+        return fName.c_str();
+    }
+    void onDelayedSetup() override {
+        SkRandom rand;
+        SkAutoTMalloc<SkRect> rects(NUM_LARGE_RECTS);
+        for (int i = 0; i < NUM_LARGE_RECTS; ++i) {
+            rects[i] = fProc(rand, i, NUM_LARGE_RECTS);
+        }
+        fTree.insert(rects.get(), NUM_LARGE_RECTS);
+
+        for (int i = 0; i < NUM_BATCH_QUERIES; ++i) {
+            fQueries[i] = SkRect::MakeXYWH(rand.nextRangeF(0, GENERATE_EXTENTS),
+                                           rand.nextRangeF(0, GENERATE_EXTENTS), 16, 16);
+        }
+    }
+
+    void onDraw(int loops, SkCanvas* canvas) override {
+        for (int i = 0; i < loops; ++i) {
+            std::vector<int> hits[NUM_BATCH_QUERIES];
+            if (fBatch) {
+                fTree.searchBatch(fQueries, NUM_BATCH_QUERIES, hits);
+            } else {
+                for (int j = 0; j < NUM_BATCH_QUERIES; ++j) {
+                    fTree.search(fQueries[j], &hits[j]);
+                }
+            }
+        }
+    }
+private:
+    SkRTree fTree;
+    MakeRectProc fProc;
+    SkRect fQueries[NUM_BATCH_QUERIES];
+    bool fBatch;
     SkString fName;
     typedef Benchmark INHERITED;
 };
@@ -136,3 +193,9 @@ DEF_BENCH(return new RTreeQueryBench("XY", &make_XYordered_rects));
 DEF_BENCH(return new RTreeQueryBench("YX", &make_YXordered_rects));
 DEF_BENCH(return new RTreeQueryBench("random", &make_random_rects));
 DEF_BENCH(return new RTreeQueryBench("concentric", &make_concentric_rects));
+
+DEF_BENCH(return new RTreeBuildBench("random", &make_random_rects, NUM_LARGE_RECTS));
+DEF_BENCH(return new RTreeQueryBench("random", &make_random_rects, NUM_LARGE_RECTS));
+
+DEF_BENCH(return new RTreeDirtyRectsBench(&make_random_rects, true));
+DEF_BENCH(return new RTreeDirtyRectsBench(&make_random_rects, false));
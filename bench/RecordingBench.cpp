@@ -32,17 +32,28 @@ SkIPoint PictureCentricBench::onGetSize() {
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
-RecordingBench::RecordingBench(const char* name, const SkPicture* pic, bool useBBH)
+RecordingBench::RecordingBench(const char* name, const SkPicture* pic, bool useBBH,
+                               bool cullOccludedOps, bool recycleRecord,
+                               bool conservativeBounds)
     : INHERITED(name, pic)
     , fUseBBH(useBBH)
+    , fCullOccludedOps(cullOccludedOps)
+    , fRecycleRecord(recycleRecord)
+    , fConservativeBounds(conservativeBounds)
 {}
 
 void RecordingBench::onDraw(int loops, SkCanvas*) {
     SkRTreeFactory factory;
     SkPictureRecorder recorder;
+    const uint32_t recordFlags =
+            (fRecycleRecord      ? SkPictureRecorder::kRecycleRecord_RecordFlag      : 0) |
+            (fConservativeBounds ? SkPictureRecorder::kConservativeBounds_RecordFlag : 0);
+    const uint32_t finishFlags =
+            fCullOccludedOps ? SkPictureRecorder::kCullOccludedOps_FinishFlag : 0;
     while (loops --> 0) {
-        fSrc->playback(recorder.beginRecording(fSrc->cullRect(), fUseBBH ? &factory : nullptr));
-        (void)recorder.finishRecordingAsPicture();
+        fSrc->playback(recorder.beginRecording(fSrc->cullRect(), fUseBBH ? &factory : nullptr,
+                                               recordFlags));
+        (void)recorder.finishRecordingAsPicture(finishFlags);
     }
 }
 
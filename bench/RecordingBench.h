@@ -29,13 +29,17 @@ protected:
 
 class RecordingBench : public PictureCentricBench {
 public:
-    RecordingBench(const char* name, const SkPicture*, bool useBBH);
+    RecordingBench(const char* name, const SkPicture*, bool useBBH, bool cullOccludedOps = false,
+                   bool recycleRecord = false, bool conservativeBounds = false);
 
 protected:
     void onDraw(int loops, SkCanvas*) override;
 
 private:
     bool fUseBBH;
+    bool fCullOccludedOps;
+    bool fRecycleRecord;
+    bool fConservativeBounds;
 
     typedef PictureCentricBench INHERITED;
 };
@@ -7,6 +7,7 @@
 
 #include "bench/SKPBench.h"
 #include "include/core/SkSurface.h"
+#include "include/utils/SkParallelPicturePlayback.h"
 #include "tools/flags/CommandLineFlags.h"
 
 #include "include/gpu/GrContext.h"
@@ -19,6 +20,11 @@ static DEFINE_int(CPUbenchTileH, 256, "Tile height used for CPU SKP playback.");
 static DEFINE_int(GPUbenchTileW, 1600, "Tile width  used for GPU SKP playback.");
 static DEFINE_int(GPUbenchTileH, 512, "Tile height used for GPU SKP playback.");
 
+static DEFINE_bool(CPUparallelPlayback, false,
+                   "Draw CPU SKPs in one pass with SkParallelPicturePlayback, "
+                   "splitting them into CPUbench tiles run on --threads. "
+                   "Only raster configs are run.");
+
 SKPBench::SKPBench(const char* name, const SkPicture* pic, const SkIRect& clip, SkScalar scale,
                    bool useMultiPictureDraw, bool doLooping)
     : fPic(SkRef(pic))
@@ -31,6 +37,10 @@ SKPBench::SKPBench(const char* name, const SkPicture* pic, const SkIRect& clip,
     if (useMultiPictureDraw) {
         fUniqueName.append("_mpd");
     }
+    if (FLAGS_CPUparallelPlayback) {
+        // The name is shared by every config, so only raster configs run; see isSuitableFor().
+        fUniqueName.append("_parallel");
+    }
 }
 
 SKPBench::~SKPBench() {
@@ -57,6 +67,11 @@ void SKPBench::onPerCanvasPreDraw(SkCanvas* canvas) {
 
     tileW = std::min(tileW, bounds.width());
     tileH = std::min(tileH, bounds.height());
+    if (!gpu && FLAGS_CPUparallelPlayback) {
+        // SkParallelPicturePlayback does its own tiling of a single surface.
+        tileW = bounds.width();
+        tileH = bounds.height();
+    }
 
     int xTiles = SkScalarCeilToInt(bounds.width()  / SkIntToScalar(tileW));
     int yTiles = SkScalarCeilToInt(bounds.height() / SkIntToScalar(tileH));
@@ -98,6 +113,9 @@ void SKPBench::onPerCanvasPostDraw(SkCanvas* canvas) {
 }
 
 bool SKPBench::isSuitableFor(Backend backend) {
+    if (FLAGS_CPUparallelPlayback) {
+        return backend == kRaster_Backend;
+    }
     return backend != kNonRendering_Backend;
 }
 
@@ -131,6 +149,14 @@ void SKPBench::drawPicture() {
     for (int j = 0; j < fTileRects.count(); ++j) {
         const SkMatrix trans = SkMatrix::MakeTrans(-fTileRects[j].fLeft / fScale,
                                                    -fTileRects[j].fTop / fScale);
+        SkPixmap pixmap;
+        if (FLAGS_CPUparallelPlayback && fSurfaces[j]->peekPixels(&pixmap)) {
+            SkMatrix matrix = fSurfaces[j]->getCanvas()->getTotalMatrix();
+            matrix.preConcat(trans);
+            SkParallelPicturePlayback::Draw(fPic.get(), pixmap, matrix, nullptr,
+                                            {FLAGS_CPUbenchTileW, FLAGS_CPUbenchTileH});
+            continue;
+        }
         fSurfaces[j]->getCanvas()->drawPicture(fPic.get(), &trans, nullptr);
     }
 
@@ -12,15 +12,25 @@
 
 namespace {
 struct ShaperBench : public Benchmark {
-    ShaperBench(const char* r, const char* n) : fResource(r), fName(n) {}
+    ShaperBench(const char* r, const char* n, bool cached = false)
+        : fResource(r), fName(n), fCached(cached) {}
     std::unique_ptr<SkShaper> fShaper;
     sk_sp<SkData> fData;
     const char* fResource;
     const char* fName;
+    bool fCached;
     const char* onGetName() override { return fName; }
     bool isSuitableFor(Backend backend) override { return backend == kNonRendering_Backend; }
     void onDelayedSetup() override {
-        fShaper = SkShaper::Make();
+#if defined(SK_SHAPER_HARFBUZZ_AVAILABLE)
+        if (fCached) {
+            fShaper = SkShaper::MakeShaperDrivenWrapper(nullptr,
+                                                        sk_make_sp<SkShaper::ShapeCache>());
+        } else
+#endif
+        {
+            fShaper = SkShaper::Make();
+        }
         fData = GetResourceAsData(fResource);
     }
     void onDraw(int loops, SkCanvas*) override {
@@ -74,4 +84,14 @@ SHAPER_BENCH(tifnagh)
 SHAPER_BENCH(vai)
 #undef SHAPER_BENCH
 
+#if defined(SK_SHAPER_HARFBUZZ_AVAILABLE)
+#define CACHED_SHAPER_BENCH(X) \
+    DEF_BENCH(return new ShaperBench("text/" #X ".txt", "shaper_cached_" #X, true);)
+CACHED_SHAPER_BENCH(arabic)
+CACHED_SHAPER_BENCH(devanagari)
+CACHED_SHAPER_BENCH(english)
+CACHED_SHAPER_BENCH(han_simplified)
+#undef CACHED_SHAPER_BENCH
+#endif
+
 #endif  // !defined(SK_BUILD_FOR_ANDROID_FRAMEWORK) && !defined(SK_BUILD_FOR_GOOGLE3)
@@ -13,21 +13,26 @@ public:
 
     SwizzleBench(const char* name, SkOpts::Swizzle_8888_u32 fn) : fName(name), fFn_u32(fn) {}
     SwizzleBench(const char* name, SkOpts::Swizzle_8888_u8  fn) : fName(name), fFn_u8 (fn) {}
+    SwizzleBench(const char* name, SkOpts::Swizzle_8888_index fn)
+        : fName(name), fFn_index(fn) {}
 
     bool isSuitableFor(Backend backend) override { return backend == kNonRendering_Backend; }
     const char* onGetName() override { return fName; }
     void onDraw(int loops, SkCanvas*) override {
         static const int K = 1023; // Arbitrary, but nice to be a non-power-of-two to trip up SIMD.
-        uint32_t dst[K], src[K];
+        // src is big enough for K pixels with 16-bit components.
+        uint32_t dst[K], src[2*K], ctable[256] = {};
         while (loops --> 0) {
-            if (fFn_u32) { fFn_u32(dst,                 src, K); }
-            if (fFn_u8)  { fFn_u8 (dst, (const uint8_t*)src, K); }
+            if (fFn_u32)   { fFn_u32  (dst,                 src, K); }
+            if (fFn_u8)    { fFn_u8   (dst, (const uint8_t*)src, K); }
+            if (fFn_index) { fFn_index(dst, (const uint8_t*)src, K, ctable); }
         }
     }
 private:
     const char* fName;
-    SkOpts::Swizzle_8888_u32 fFn_u32 = nullptr;
-    SkOpts::Swizzle_8888_u8  fFn_u8  = nullptr;
+    SkOpts::Swizzle_8888_u32   fFn_u32   = nullptr;
+    SkOpts::Swizzle_8888_u8    fFn_u8    = nullptr;
+    SkOpts::Swizzle_8888_index fFn_index = nullptr;
 };
 
 
@@ -41,3 +46,9 @@ DEF_BENCH(return new SwizzleBench("SkOpts::grayA_to_RGBA", SkOpts::grayA_to_RGBA
 DEF_BENCH(return new SwizzleBench("SkOpts::grayA_to_rgbA", SkOpts::grayA_to_rgbA));
 DEF_BENCH(return new SwizzleBench("SkOpts::inverted_CMYK_to_RGB1", SkOpts::inverted_CMYK_to_RGB1));
 DEF_BENCH(return new SwizzleBench("SkOpts::inverted_CMYK_to_BGR1", SkOpts::inverted_CMYK_to_BGR1));
+DEF_BENCH(return new SwizzleBench("SkOpts::RGB16_to_RGB1", SkOpts::RGB16_to_RGB1));
+DEF_BENCH(return new SwizzleBench("SkOpts::RGB16_to_BGR1", SkOpts::RGB16_to_BGR1));
+DEF_BENCH(return new SwizzleBench("SkOpts::RGBA16_to_RGBA", SkOpts::RGBA16_to_RGBA));
+DEF_BENCH(return new SwizzleBench("SkOpts::RGBA16_to_BGRA", SkOpts::RGBA16_to_BGRA));
+DEF_BENCH(return new SwizzleBench("SkOpts::index8_to_8888", SkOpts::index8_to_8888));
+DEF_BENCH(return new SwizzleBench("SkOpts::index4_to_8888", SkOpts::index4_to_8888));
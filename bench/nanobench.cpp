@@ -115,6 +115,11 @@ static DEFINE_string(zoom, "1.0,0",
                      "Comma-separated zoomMax,zoomPeriodMs factors for a periodic SKP zoom "
                      "function that ping-pongs between 1.0 and zoomMax.");
 static DEFINE_bool(bbh, true, "Build a BBH for SKPs?");
+static DEFINE_bool(cullOccluded, false, "Cull occluded ops when re-recording SKPs?");
+static DEFINE_bool(recycleRecord, false,
+                   "Record each SKP's RecordingBench loops into the previous loop's storage?");
+static DEFINE_bool(conservativeBounds, false,
+                   "Use conservative op bounds for the BBH when re-recording SKPs?");
 static DEFINE_bool(mpd, true, "Use MultiPictureDraw for the SKPs?");
 static DEFINE_bool(loopSKP, true, "Loop SKPs like we do for micro benches?");
 static DEFINE_int(flushEvery, 10, "Flush --outResultsFile every Nth run.");
@@ -774,7 +779,8 @@ public:
             fBenchType  = "recording";
             fSKPBytes = static_cast<double>(pic->approximateBytesUsed());
             fSKPOps   = pic->approximateOpCount();
-            return new RecordingBench(name.c_str(), pic.get(), FLAGS_bbh);
+            return new RecordingBench(name.c_str(), pic.get(), FLAGS_bbh, FLAGS_cullOccluded,
+                                      FLAGS_recycleRecord, FLAGS_conservativeBounds);
         }
 
         // Add all .skps as DeserializePictureBenchs.
@@ -803,15 +809,17 @@ public:
                 }
 
                 while (fCurrentUseMPD < fUseMPDs.count()) {
-                    if (FLAGS_bbh) {
+                    if (FLAGS_bbh || FLAGS_cullOccluded) {
                         // The SKP we read off disk doesn't have a BBH.  Re-record so it grows one.
                         SkRTreeFactory factory;
                         SkPictureRecorder recorder;
                         pic->playback(recorder.beginRecording(pic->cullRect().width(),
                                                               pic->cullRect().height(),
-                                                              &factory,
+                                                              FLAGS_bbh ? &factory : nullptr,
                                                               0));
-                        pic = recorder.finishRecordingAsPicture();
+                        pic = recorder.finishRecordingAsPicture(
+                                FLAGS_cullOccluded ? SkPictureRecorder::kCullOccludedOps_FinishFlag
+                                                   : 0);
                     }
                     SkString name = SkOSPath::Basename(path.c_str());
                     fSourceType = "skp";
@@ -979,6 +987,10 @@ public:
         //     PNG decodes use the indicated sampling strategy regardless of the sample size, so
         //         these tests are sufficient to provide good coverage of our scaling options.
         const uint32_t brdSampleSizes[] = { 1, 2, 4, 8, 16 };
+        const SkBitmapRegionDecoder::Strategy brdStrategies[] = {
+            SkBitmapRegionDecoder::kAndroidCodec_Strategy,
+            SkBitmapRegionDecoder::kTiledCache_Strategy,
+        };
         const uint32_t minOutputSize = 512;
         for (; fCurrentBRDImage < fImages.count(); fCurrentBRDImage++) {
             fSourceType = "image";
@@ -996,12 +1008,22 @@ public:
                         sk_sp<SkData> encoded(SkData::MakeFromFileName(path.c_str()));
                         const SkColorType colorType = fColorTypes[fCurrentColorType];
                         uint32_t sampleSize = brdSampleSizes[fCurrentSampleSize];
-                        int currentSubsetType = fCurrentSubsetType++;
+                        int currentSubsetType = fCurrentSubsetType;
+                        // Only unscaled regions are decoded from cached tiles.
+                        const auto strategy = brdStrategies[fCurrentBRDStrategy++];
+                        if (1 != sampleSize ||
+                                fCurrentBRDStrategy == (int) SK_ARRAY_COUNT(brdStrategies)) {
+                            fCurrentBRDStrategy = 0;
+                            fCurrentSubsetType++;
+                        }
 
                         int width = 0;
                         int height = 0;
                         if (!valid_brd_bench(encoded, colorType, sampleSize, minOutputSize,
                                 &width, &height)) {
+                            // The next sample size or color type starts again with the first
+                            // strategy.
+                            fCurrentBRDStrategy = 0;
                             break;
                         }
 
@@ -1038,7 +1060,7 @@ public:
                         }
 
                         return new BitmapRegionDecoderBench(basename.c_str(), encoded.get(),
-                                colorType, sampleSize, subset);
+                                colorType, sampleSize, subset, strategy);
                     }
                     fCurrentSubsetType = 0;
                     fCurrentSampleSize++;
@@ -1120,6 +1142,7 @@ private:
     int fCurrentAlphaType = 0;
     int fCurrentSubsetType = 0;
     int fCurrentSampleSize = 0;
+    int fCurrentBRDStrategy = 0;
     int fCurrentAnimSKP = 0;
 };
 
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2020 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "fuzz/Fuzz.h"
+#include "src/utils/SkFloatToDecimal.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Number of significant digits in a decimal string, ignoring leading and trailing zeros.
+static int significant_digits(const char* str) {
+    int first = -1, last = -1, index = 0;
+    for (const char* c = str; *c; ++c) {
+        if (*c >= '0' && *c <= '9') {
+            if (*c != '0') {
+                if (first < 0) {
+                    first = index;
+                }
+                last = index;
+            }
+            ++index;
+        }
+    }
+    return first < 0 ? 1 : last - first + 1;
+}
+
+// Compares SkFloatToDecimal and SkFloatToSVGScalar with the C library's correctly rounded
+// conversions.
+DEF_FUZZ(FloatToDecimal, fuzz) {  // `fuzz -t api -n FloatToDecimal`
+    float value;
+    fuzz->next(&value);
+    if (!std::isfinite(value)) {
+        return;
+    }
+
+    char decimal[kMaximumSkFloatToDecimalLength];
+    unsigned length = SkFloatToDecimal(value, decimal);
+    SkASSERT_RELEASE(length < kMaximumSkFloatToDecimalLength && length == strlen(decimal));
+    SkASSERT_RELEASE(strtof(decimal, nullptr) == value);
+
+    // With one fewer significant digit, even the nearest decimal must not round-trip...
+    int digits = significant_digits(decimal);
+    char reference[32];
+    if (digits > 1) {
+        snprintf(reference, sizeof(reference), "%.*e", digits - 2, value);
+        SkASSERT_RELEASE(strtof(reference, nullptr) != value);
+    }
+    // ... and no decimal with as many digits which round-trips may be closer to the value.
+    snprintf(reference, sizeof(reference), "%.*e", digits - 1, value);
+    if (strtof(reference, nullptr) == value) {
+        SkASSERT_RELEASE(std::fabs(strtod(decimal, nullptr) - value) <=
+                         std::fabs(strtod(reference, nullptr) - value));
+    }
+
+    // SkFloatToSVGScalar writes the same digits, perhaps with an exponent.
+    char svg[kMaximumSkFloatToDecimalLength];
+    length = SkFloatToSVGScalar(value, svg);
+    SkASSERT_RELEASE(length < kMaximumSkFloatToDecimalLength && length == strlen(svg));
+    SkASSERT_RELEASE(strtod(svg, nullptr) == strtod(decimal, nullptr));
+}
@@ -22,6 +22,8 @@ public:
 
     enum Strategy {
         kAndroidCodec_Strategy, // Uses SkAndroidCodec for scaling and subsetting
+        kTiledCache_Strategy,   // Like kAndroidCodec_Strategy, but unscaled regions are decoded
+                                // in tiles, which are cached for later regions
     };
 
     /*
@@ -39,6 +39,28 @@ public:
         kRespect,
     };
 
+    /**
+     *  How getAndroidPixels() reduces the image to smaller dimensions.
+     */
+    enum class DownscaleFilter {
+        /**
+         *  Keep one pixel out of every AndroidOptions::fSampleSize, in each direction.
+         */
+        kPointSample,
+
+        /**
+         *  Average the pixels which each destination pixel covers.  The destination may have
+         *  any dimensions no larger than the image (or subset).
+         */
+        kBox,
+
+        /**
+         *  Like kBox, but weight the pixels by a tent filter twice as wide, which blurs a
+         *  little more and aliases less.
+         */
+        kTriangle,
+    };
+
     /**
      *  Pass ownership of an SkCodec to a newly-created SkAndroidCodec.
      */
@@ -200,6 +222,7 @@ public:
             : fZeroInitialized(SkCodec::kNo_ZeroInitialized)
             , fSubset(nullptr)
             , fSampleSize(1)
+            , fDownscaleFilter(DownscaleFilter::kPointSample)
         {}
 
         /**
@@ -229,6 +252,15 @@ public:
          *  The default is 1, representing no downscaling.
          */
         int fSampleSize;
+
+        /**
+         *  If not kPointSample, fSampleSize is ignored, and the decode is filtered down to the
+         *  dimensions of the info passed to getAndroidPixels(), one row at a time.  Codecs
+         *  which scale natively (e.g. WebP) use their own scaling instead.
+         *
+         *  The default is kPointSample.
+         */
+        DownscaleFilter fDownscaleFilter;
     };
 
     /**
@@ -26,6 +26,7 @@
 
 class SkColorSpace;
 class SkData;
+class SkExecutor;
 class SkFrameHolder;
 class SkPngChunkReader;
 class SkSampler;
@@ -287,6 +288,7 @@ public:
             , fSubset(nullptr)
             , fFrameIndex(0)
             , fPriorFrame(kNoFrame)
+            , fExecutor(nullptr)
         {}
 
         ZeroInitialized            fZeroInitialized;
@@ -330,6 +332,14 @@ public:
          *  If set to kNoFrame, the codec will decode any necessary required frame(s) first.
          */
         int                        fPriorFrame;
+
+        /**
+         *  If not NULL, getPixels() may split the decode into tasks run on this executor.
+         *
+         *  Currently only used for baseline JPEGs with restart markers. Other images, and
+         *  scanline and incremental decodes, ignore it.
+         */
+        SkExecutor*                fExecutor;
     };
 
     /**
@@ -33,6 +33,12 @@ public:
      */
     virtual void search(const SkRect& query, std::vector<int>* results) const = 0;
 
+    /**
+     * Populate results[i] with the indices of bounding boxes intersecting queries[i].
+     */
+    virtual void searchBatch(const SkRect queries[], int count,
+                             std::vector<int> results[]) const;
+
     /**
      * Return approximate size in memory of *this.
      */
@@ -84,6 +84,19 @@ public:
      */
     bool getPixels(const SkImageInfo& info, void* pixels, size_t rowBytes);
 
+    /**
+     *  Like getPixels(), but for only a subset of the pixels, specified by the rectangle:
+     *
+     *      subset = SkIRect::MakeXYWH(origin.x(), origin.y(), info.width(), info.height())
+     *
+     *  If subset is not contained inside the generator's bounds, this returns false.  The subset
+     *  is never scaled.  Generators which can't produce a subset directly produce all of their
+     *  pixels into temporary memory, and copy out the subset.
+     *
+     *  @return true on success.
+     */
+    bool getPixels(const SkImageInfo& info, void* pixels, size_t rowBytes, const SkIPoint& origin);
+
     /**
      *  If decoding to YUV is supported, this returns true.  Otherwise, this
      *  returns false and does not modify any of the parameters.
@@ -175,6 +188,10 @@ protected:
     virtual sk_sp<SkData> onRefEncodedData() { return nullptr; }
     struct Options {};
     virtual bool onGetPixels(const SkImageInfo&, void*, size_t, const Options&) { return false; }
+    // Returns false if the generator can't produce just this subset.
+    virtual bool onGetSubsetPixels(const SkImageInfo&, void*, size_t, const SkIPoint& /*origin*/) {
+        return false;
+    }
     virtual bool onIsValid(GrContext*) const { return true; }
     virtual bool onQueryYUVA8(SkYUVASizeInfo*, SkYUVAIndex[SkYUVAIndex::kIndexCount],
                               SkYUVColorSpace*) const { return false; }
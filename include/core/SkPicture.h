@@ -80,6 +80,24 @@ public:
     static sk_sp<SkPicture> MakeFromData(const void* data, size_t size,
                                          const SkDeserialProcs* procs = nullptr);
 
+    /** Recreates SkPicture that was written by serializeForMapping(). Returns nullptr if data
+        is not in that format or was written by an incompatible version.
+
+        data is typically a memory mapped file, e.g. from SkData::MakeFromFileName(). The
+        returned SkPicture refers to the drawing commands in data without copying them and
+        decodes each command as it is played back, instead of re-recording them all when
+        opened. Paints, paths, text blobs, images and nested pictures are still decoded when
+        opened. Playback has no bounding box hierarchy and does not cull by the canvas clip:
+        every command is read each time the picture is drawn, so drawing part of the picture
+        costs as much as drawing all of it. data is kept alive by the returned SkPicture.
+
+        @param data   storage written by serializeForMapping()
+        @param procs  custom serial data decoders; may be nullptr
+        @return       SkPicture referring to data
+    */
+    static sk_sp<SkPicture> MakeFromMappedData(sk_sp<SkData> data,
+                                               const SkDeserialProcs* procs = nullptr);
+
     /** \class SkPicture::AbortCallback
         AbortCallback is an abstract class. An implementation of AbortCallback may
         passed as a parameter to SkPicture::playback, to stop it before all drawing
@@ -178,6 +196,15 @@ public:
     */
     void serialize(SkWStream* stream, const SkSerialProcs* procs = nullptr) const;
 
+    /** Returns storage containing SkPicture in a layout which MakeFromMappedData() can play
+        back in place. The layout carries its own format version, and procs are used as they
+        are by serialize().
+
+        @param procs  custom serial data encoders; may be nullptr
+        @return       storage containing SkPicture for MakeFromMappedData()
+    */
+    sk_sp<SkData> serializeForMapping(const SkSerialProcs* procs = nullptr) const;
+
     /** Returns a placeholder SkPicture. Result does not draw, and contains only
         cull SkRect, a hint of its bounds. Result is immutable; it cannot be changed
         later. Result identifier is unique.
@@ -234,6 +261,7 @@ private:
     SkPicture();
     friend class SkBigPicture;
     friend class SkEmptyPicture;
+    friend class SkMappedPicture;
     friend class SkPicturePriv;
     template <typename> friend class SkMiniPicture;
 
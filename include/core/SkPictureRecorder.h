@@ -24,6 +24,7 @@ class SkDrawable;
 class SkMiniRecorder;
 class SkPictureRecord;
 class SkRecord;
+class SkRecordBoundsTracker;
 class SkRecorder;
 
 class SK_API SkPictureRecorder {
@@ -35,9 +36,31 @@ public:
         // If you call drawPicture() or drawDrawable() on the recording canvas, this flag forces
         // that object to playback its contents immediately rather than reffing the object.
         kPlaybackDrawPicture_RecordFlag     = 1 << 0,
+
+        // Record into the storage of a picture this recorder finished earlier, if nothing else
+        // refers to that picture anymore.  This saves most of the allocations made while
+        // recording when a similar picture is recorded every frame.  The recorder holds on to
+        // the ops of the last two pictures finished with this flag until they are recycled.
+        kRecycleRecord_RecordFlag           = 1 << 1,
+
+        // When recording with a bounding box hierarchy, bound anything drawn with an image
+        // filter, mask filter or path effect, or inside a layer with one, by the whole cull rect.
+        // This is faster to compute, but the hierarchy culls less at playback.
+        kConservativeBounds_RecordFlag      = 1 << 2,
+
+        // Record paths and text blobs drawn more than once, even as independently built copies,
+        // as a single shared copy.  Saves memory when the same content is drawn many times, at
+        // the cost of hashing each path and blob as it is recorded.  Serialized pictures always
+        // store one copy of each, with or without this flag.
+        kDeduplicate_RecordFlag             = 1 << 3,
     };
 
     enum FinishFlags {
+        // Drop draws hidden under later opaque rects, images and paints, and remember those
+        // occluders so playback can skip everything under one that covers the whole clip.
+        // Dropping assumes the picture is not drawn downscaled or rotated, otherwise the
+        // antialiased edges of hidden draws could differ by a fraction of a pixel.
+        kCullOccludedOps_FinishFlag         = 1 << 0,
     };
 
     /** Returns the canvas that records the drawing commands.
@@ -122,6 +145,10 @@ private:
     std::unique_ptr<SkRecorder> fRecorder;
     sk_sp<SkRecord>             fRecord;
     std::unique_ptr<SkMiniRecorder> fMiniRecorder;
+    // Records of pictures finished with kRecycleRecord_RecordFlag, oldest first.
+    sk_sp<SkRecord>             fRecycled[2];
+    // When there's a BBH, this computes the bounds of the ops for it while they are recorded.
+    std::unique_ptr<SkRecordBoundsTracker> fBoundsTracker;
 
     SkPictureRecorder(SkPictureRecorder&&) = delete;
     SkPictureRecorder& operator=(SkPictureRecorder&&) = delete;
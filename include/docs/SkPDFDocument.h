@@ -195,15 +195,52 @@ struct Metadata {
     /** Executor to handle threaded work within PDF Backend. If this is nullptr,
         then all work will be done serially on the main thread. To have worker
         threads assist with various tasks, set this to a valid SkExecutor
-        instance. Currently used for executing Deflate algorithm in parallel.
+        instance. Currently used for executing Deflate algorithm in parallel,
+        and for drawing the contents of untagged pages in parallel: pages are
+        recorded, and drawn while the caller goes on to the next page. Pages
+        are only drawn this way on machines with more than one core.
 
-        If set, the PDF output will be non-reproducible in the order and
-        internal numbering of objects, but should render the same.
+        If set, the PDF output will be non-reproducible in the order of
+        objects, but should render the same.  Page contents and resource
+        dictionaries do not depend on how the pages were scheduled.
 
         Experimental.
     */
     SkExecutor* fExecutor = nullptr;
 
+    /** If true, each page is written as soon as it is finished, instead of
+        being kept until the document is closed.  Fonts which no recent page
+        has used are written too, and a later page using them again gets a
+        new subset.  Images and shading patterns are remembered for reuse by
+        later pages up to a fixed number, then written again if drawn again.
+
+        What stays in memory is the cross-reference data of the objects
+        written so far, the page references and named destinations, plus
+        per-typeface data (metrics, glyph to Unicode maps and font
+        descriptors) and the distinct graphic states used.  Those grow with
+        the number of typefaces and states rather than with the number of
+        pages.
+
+        The pages are arranged differently in the page tree, and fonts may be
+        embedded more than once.
+
+        Experimental.
+    */
+    bool fStreamPages = false;
+
+    /** If true, subset fonts and encoded images are looked up in and added to
+        a cache shared by every document in the process which sets this, so
+        documents which use the same fonts and images don't subset and encode
+        them again.  Fonts are matched by typeface and the set of glyphs used,
+        images by their contents and fEncodingQuality.
+
+        The cache may be used by several documents at once.  Its size is set
+        with SetSharedCacheLimit().
+
+        Experimental.
+    */
+    bool fUseSharedCache = false;
+
     /** Preferred Subsetter. Only respected if both are compiled in.
 
         The Sfntly subsetter is deprecated.
@@ -241,6 +278,21 @@ SK_API void SetNodeId(SkCanvas* dst, int nodeID);
 */
 SK_API sk_sp<SkDocument> MakeDocument(SkWStream* stream, const Metadata& metadata);
 
+/** Set the byte budget of the cache used by documents with
+    Metadata::fUseSharedCache set, purging the least recently used entries to
+    fit.  Returns the previous budget.  The default is 32 MB.
+*/
+SK_API size_t SetSharedCacheLimit(size_t bytes);
+
+/** Return the byte budget of the shared cache. */
+SK_API size_t GetSharedCacheLimit();
+
+/** Return the number of bytes held by the shared cache. */
+SK_API size_t GetSharedCacheBytesUsed();
+
+/** Empty the shared cache.  Documents which are in progress are not affected. */
+SK_API void PurgeSharedCache();
+
 static inline sk_sp<SkDocument> MakeDocument(SkWStream* stream) {
     return MakeDocument(stream, Metadata());
 }
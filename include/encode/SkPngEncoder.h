@@ -11,6 +11,7 @@
 #include "include/core/SkDataTable.h"
 #include "include/encode/SkEncoder.h"
 
+class SkExecutor;
 class SkPngEncoderMgr;
 class SkWStream;
 
@@ -59,6 +60,20 @@ public:
          *  and the (2i + 1)-th entry is the text for the i-th comment.
          */
         sk_sp<SkDataTable> fComments;
+
+        /**
+         *  If not null, Encode() splits the image into bands of rows which are filtered and
+         *  compressed as separate tasks on this executor, then concatenated into a single zlib
+         *  stream.  Each band starts its compression with the data preceding it as a preset
+         *  dictionary, so the output is typically only slightly larger than a serial encode.
+         *
+         *  When multiple filters are chosen, this path picks each row's filter with a cheaper
+         *  version of libpng's heuristic, looking at a sample of the row's pixels rather than at
+         *  all of them.
+         *
+         *  Small images, and the incremental encoders returned by Make(), ignore this.
+         */
+        SkExecutor* fExecutor = nullptr;
     };
 
     /**
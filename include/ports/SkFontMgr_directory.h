@@ -18,4 +18,12 @@ class SkFontMgr;
  */
 SK_API sk_sp<SkFontMgr> SkFontMgr_New_Custom_Directory(const char* dir);
 
+/** Like SkFontMgr_New_Custom_Directory(dir), but remembers what was found in each font file in
+ *  the index file at indexPath. On later calls only files which were added or changed since the
+ *  index was written are opened, and the index is rewritten if anything changed. The index also
+ *  records each face's Unicode coverage, which enables matchFamilyStyleCharacter.
+ *  If indexPath is null no index is used.
+ */
+SK_API sk_sp<SkFontMgr> SkFontMgr_New_Custom_Directory(const char* dir, const char* indexPath);
+
 #endif // SkFontMgr_directory_DEFINED
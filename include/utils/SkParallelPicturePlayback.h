@@ -0,0 +1,38 @@
+/*
+ * Copyright 2020 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkParallelPicturePlayback_DEFINED
+#define SkParallelPicturePlayback_DEFINED
+
+#include "include/core/SkMatrix.h"
+#include "include/core/SkSize.h"
+#include "include/core/SkSurfaceProps.h"
+
+class SkExecutor;
+class SkPicture;
+class SkPixmap;
+
+class SK_API SkParallelPicturePlayback {
+public:
+    /**
+     *  Draws picture with matrix into dst, as SkPicture::playback() onto a canvas of dst would.
+     *
+     *  dst is split into tiles of tileSize, and each tile is drawn as a separate task on executor
+     *  (the default executor if null).  Each tile replays the picture in full, so save layers,
+     *  clips and matrices behave exactly as they do when drawing all of dst at once, but a picture
+     *  recorded with a bounding box hierarchy only visits the ops that touch the tile.
+     *
+     *  Returns once every tile is drawn.  Returns false if dst has no pixels to draw into.
+     */
+    static bool Draw(const SkPicture* picture, const SkPixmap& dst,
+                     const SkMatrix& matrix = SkMatrix::I(),
+                     SkExecutor* executor = nullptr,
+                     SkISize tileSize = {256, 256},
+                     const SkSurfaceProps* props = nullptr);
+};
+
+#endif
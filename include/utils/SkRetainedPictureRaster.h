@@ -0,0 +1,100 @@
+/*
+ * Copyright 2020 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkRetainedPictureRaster_DEFINED
+#define SkRetainedPictureRaster_DEFINED
+
+#include "include/core/SkBitmap.h"
+#include "include/core/SkImageInfo.h"
+#include "include/core/SkMatrix.h"
+#include "include/core/SkPicture.h"
+#include "include/core/SkRefCnt.h"
+#include "include/core/SkRegion.h"
+
+#include <memory>
+#include <vector>
+
+class SkCanvas;
+class SkPaint;
+
+/**
+ *  SkRetainedPictureRaster keeps a rasterization of the latest of a sequence of pictures, split
+ *  into tiles.  Each update only replays the ops of the new picture which touch the damaged
+ *  region, and only into the tiles overlapping it; pixels outside of the damage are kept from
+ *  the previous frame.  With a bounding box hierarchy on the pictures, the cost of an update is
+ *  proportional to the size of the change rather than to the size of the picture.
+ *
+ *  The damage can be given by the caller, or computed by comparing the ops of the new picture
+ *  with those of the previous one.
+ */
+class SK_API SkRetainedPictureRaster {
+public:
+    /**
+     *  Pictures are drawn with matrix into a raster of info's dimensions.  The pixels start out
+     *  transparent.
+     */
+    SkRetainedPictureRaster(const SkImageInfo& info, const SkMatrix& matrix = SkMatrix::I(),
+                            int tileSize = 256);
+    ~SkRetainedPictureRaster();
+
+    const SkImageInfo& imageInfo() const { return fInfo; }
+    const SkMatrix& matrix() const { return fMatrix; }
+
+    /**
+     *  Makes picture the current one, redrawing only the pixels in damage, which is in the
+     *  raster's pixel space.  Everything outside of damage must draw the same in picture as it
+     *  did in the previous one.
+     */
+    void update(sk_sp<SkPicture> picture, const SkRegion& damage);
+
+    /**
+     *  Makes picture the current one, redrawing the pixels where it may draw differently from the
+     *  previous picture.  Returns the region that was redrawn.  The first update redraws
+     *  everything.
+     */
+    SkRegion update(sk_sp<SkPicture> picture);
+
+    /** Draws the retained pixels into canvas, with their top left corner at (x,y). */
+    void draw(SkCanvas* canvas, SkScalar x = 0, SkScalar y = 0,
+              const SkPaint* paint = nullptr) const;
+
+    /** Copies the retained pixels into dst, which is allocated to match imageInfo(). */
+    void readPixels(SkBitmap* dst) const;
+
+    /**
+     *  Returns a region, in the space of the pictures' ops mapped by matrix, outside of which
+     *  before and after are guaranteed to draw the same pixels.
+     *
+     *  The pictures' ops are compared one by one, along with the matrix and clip state each is
+     *  drawn under, and the damage covers the bounds of the ops in between their longest common
+     *  prefix and suffix.  Images, text blobs, vertices and nested pictures are compared by
+     *  identity, paths by their contents.  Ops which cannot be compared cheaply are always
+     *  treated as changed.
+     */
+    static SkRegion ComputeDamage(const SkPicture& before, const SkPicture& after,
+                                  const SkMatrix& matrix = SkMatrix::I());
+
+private:
+    class Fingerprint;
+
+    void drawTiles(const SkPicture& picture, const SkRegion& damage);
+
+    const SkImageInfo     fInfo;
+    const SkMatrix        fMatrix;
+    const int             fTileSize;
+    const int             fTileCountX;
+    const int             fTileCountY;
+
+    // Tiles are allocated the first time anything draws into them.
+    std::vector<SkBitmap> fTiles;
+
+    sk_sp<SkPicture>             fPicture;
+    // Fingerprint of fPicture, made the first time it is compared with a new picture.
+    std::unique_ptr<Fingerprint> fFingerprint;
+};
+
+#endif
@@ -41,16 +41,16 @@ describe('PathKit\'s SVG Behavior', function() {
 
     it('can create an SVG string from hex values', function(done) {
         LoadPathKit.then(catchException(done, () => {
-            let cmds = [[PathKit.MOVE_VERB, "0x15e80300", "0x400004dc"], // 9.37088e-26f, 2.0003f
+            let cmds = [[PathKit.MOVE_VERB, "0x15e80300", "0x400004dc"], // 9.370879e-26f, 2.0002966f
                        [PathKit.LINE_VERB, 795, 5],
                        [PathKit.LINE_VERB, 595, 295],
                        [PathKit.LINE_VERB, 5, 295],
-                       [PathKit.LINE_VERB, "0x15e80300", "0x400004dc"], // 9.37088e-26f, 2.0003f
+                       [PathKit.LINE_VERB, "0x15e80300", "0x400004dc"], // 9.370879e-26f, 2.0002966f
                        [PathKit.CLOSE_VERB]];
             let path = PathKit.FromCmds(cmds);
 
             let svgStr = path.toSVGString();
-            expect(svgStr).toEqual('M9.37088e-26 2.0003L795 5L595 295L5 295L9.37088e-26 2.0003Z');
+            expect(svgStr).toEqual('M9.370879e-26 2.0002966L795 5L595 295L5 295L9.370879e-26 2.0002966Z');
             path.delete();
             done();
         }));
@@ -9,6 +9,7 @@
 #include "include/private/SkTHash.h"
 #include "modules/skparagraph/include/ParagraphCache.h"
 #include "modules/skparagraph/include/TextStyle.h"
+#include "modules/skshaper/include/SkShaper.h"
 
 namespace skia {
 namespace textlayout {
@@ -40,9 +41,17 @@ public:
     void enableFontFallback();
     bool fontFallbackEnabled() { return fEnableFontFallback; }
 
-    ParagraphCache* getParagraphCache() { return &fParagraphCache; }
+    ParagraphCache* getParagraphCache() { return fParagraphCache.get(); }
+
+    // Collections may share one cache, for instance one per thread laying out paragraphs.
+    void setParagraphCache(sk_sp<ParagraphCache> paragraphCache);
+
+    // Remembers the results of defaultFallback(unicode, ...), cleared when a font manager changes.
+    SkShaper::FontFallbackCache* getFallbackCache() { return fFallbackCache.get(); }
 
 private:
+    friend class ParagraphCacheKey;
+
     std::vector<sk_sp<SkFontMgr>> getFontManagerOrder() const;
 
     sk_sp<SkTypeface> matchTypeface(const SkString& familyName, SkFontStyle fontStyle);
@@ -71,7 +80,8 @@ private:
     sk_sp<SkFontMgr> fTestFontManager;
 
     SkString fDefaultFamilyName;
-    ParagraphCache fParagraphCache;
+    sk_sp<ParagraphCache> fParagraphCache;
+    sk_sp<SkShaper::FontFallbackCache> fFallbackCache;
 };
 }  // namespace textlayout
 }  // namespace skia
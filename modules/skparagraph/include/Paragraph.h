@@ -70,6 +70,9 @@ public:
     // Experimental API that allows fast way to update "immutable" paragraph
     virtual void updateTextAlign(TextAlign textAlign) = 0;
     virtual void updateText(size_t from, SkString text) = 0;
+    // Replaces the utf8 text in [from, to) with text; styles grow or shrink with the edit.
+    // Where possible only the shaped runs touching the edit are shaped again.
+    virtual void replaceText(size_t from, size_t to, const SkString& text) = 0;
     virtual void updateFontSize(size_t from, size_t to, SkScalar fontSize) = 0;
     virtual void updateForegroundPaint(size_t from, size_t to, SkPaint paint) = 0;
     virtual void updateBackgroundPaint(size_t from, size_t to, SkPaint paint) = 0;
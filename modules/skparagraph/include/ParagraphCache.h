@@ -2,10 +2,14 @@
 #ifndef ParagraphCache_DEFINED
 #define ParagraphCache_DEFINED
 
+#include "include/core/SkRefCnt.h"
 #include "include/private/SkMutex.h"
 #include "src/core/SkLRUCache.h"
+#include <atomic>
 #include <functional>  // std::function
 
+class SkTraceMemoryDump;
+
 #define PARAGRAPH_CACHE_STATS
 
 namespace skia {
@@ -27,42 +31,60 @@ class ParagraphCacheValue;
 
 bool operator==(const ParagraphCacheKey& a, const ParagraphCacheKey& b);
 
-class ParagraphCache {
+/**
+ *  Remembers the shaped runs of paragraphs. The cache is safe to use from several threads at
+ *  once and may be shared by font collections (see FontCollection::setParagraphCache); results
+ *  are only reused by collections with the same font managers. Entries are evicted, least
+ *  recently used first, once their total size exceeds the byte limit.
+ */
+class ParagraphCache : public SkRefCnt {
 public:
-    ParagraphCache();
-    ~ParagraphCache();
+    static constexpr size_t kDefaultByteLimit = 4 * 1024 * 1024;
+
+    explicit ParagraphCache(size_t byteLimit = kDefaultByteLimit);
+    ~ParagraphCache() override;
 
     void abandon();
     void reset();
     bool updateParagraph(ParagraphImpl* paragraph);
     bool findParagraph(ParagraphImpl* paragraph);
 
+    size_t getByteLimit() const;
+    void setByteLimit(size_t byteLimit);
+    size_t getBytesUsed() const;
+
+    /** Reports the size, budget and use of the cache under dumpName. */
+    void dumpMemoryStatistics(SkTraceMemoryDump* dump,
+                              const char dumpName[] = "skia/sk_paragraph_cache") const;
+
     // For testing
     void setChecker(std::function<void(ParagraphImpl* impl, const char*, bool)> checker) {
         fChecker = std::move(checker);
     }
     void printStatistics();
     void turnOn(bool value) { fCacheIsOn = value; }
-    int count() { return fLRUCacheMap.count(); }
+    int count() const;
 
  private:
 
     struct Entry;
-    void updateFrom(const ParagraphImpl* paragraph, Entry* entry);
     void updateTo(ParagraphImpl* paragraph, const Entry* entry);
+    void purgeAsNeeded();
 
      mutable SkMutex fParagraphMutex;
      std::function<void(ParagraphImpl* impl, const char*, bool)> fChecker;
 
-    static const int kMaxEntries = 128;
-
     struct KeyHash {
         uint32_t mix(uint32_t hash, uint32_t data) const;
         uint32_t operator()(const ParagraphCacheKey& key) const;
     };
 
-    SkLRUCache<ParagraphCacheKey, std::unique_ptr<Entry>, KeyHash> fLRUCacheMap;
-    bool fCacheIsOn;
+    // Entries are reference counted so that runs can be copied out of the cache without holding
+    // the lock while another thread evicts them. The byte limit bounds the cache, not the count.
+    mutable SkLRUCache<ParagraphCacheKey, sk_sp<Entry>, KeyHash> fLRUCacheMap;
+    size_t fByteLimit;
+    size_t fBytesUsed;
+    std::atomic<bool> fCacheIsOn;
 
 #ifdef PARAGRAPH_CACHE_STATS
     int fTotalRequests;
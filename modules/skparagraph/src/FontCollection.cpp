@@ -23,30 +23,42 @@ size_t FontCollection::FamilyKey::Hasher::operator()(const FontCollection::Famil
 
 FontCollection::FontCollection()
         : fEnableFontFallback(true)
-        , fDefaultFamilyName(DEFAULT_FONT_FAMILY) { }
+        , fDefaultFamilyName(DEFAULT_FONT_FAMILY)
+        , fParagraphCache(sk_make_sp<ParagraphCache>())
+        , fFallbackCache(sk_make_sp<SkShaper::FontFallbackCache>()) { }
+
+void FontCollection::setParagraphCache(sk_sp<ParagraphCache> paragraphCache) {
+    SkASSERT(paragraphCache);
+    fParagraphCache = std::move(paragraphCache);
+}
 
 size_t FontCollection::getFontManagersCount() const { return this->getFontManagerOrder().size(); }
 
 void FontCollection::setAssetFontManager(sk_sp<SkFontMgr> font_manager) {
     fAssetFontManager = font_manager;
+    fFallbackCache->purge();
 }
 
 void FontCollection::setDynamicFontManager(sk_sp<SkFontMgr> font_manager) {
     fDynamicFontManager = font_manager;
+    fFallbackCache->purge();
 }
 
 void FontCollection::setTestFontManager(sk_sp<SkFontMgr> font_manager) {
     fTestFontManager = font_manager;
+    fFallbackCache->purge();
 }
 
 void FontCollection::setDefaultFontManager(sk_sp<SkFontMgr> fontManager,
                                            const char defaultFamilyName[]) {
     fDefaultFontManager = std::move(fontManager);
     fDefaultFamilyName = defaultFamilyName;
+    fFallbackCache->purge();
 }
 
 void FontCollection::setDefaultFontManager(sk_sp<SkFontMgr> fontManager) {
     fDefaultFontManager = fontManager;
+    fFallbackCache->purge();
 }
 
 // Return the available font managers in the order they should be queried.
@@ -118,8 +130,8 @@ sk_sp<SkTypeface> FontCollection::defaultFallback(SkUnichar unicode, SkFontStyle
         if (!locale.isEmpty()) {
             bcp47.push_back(locale.c_str());
         }
-        sk_sp<SkTypeface> typeface(manager->matchFamilyStyleCharacter(
-                0, fontStyle, bcp47.data(), bcp47.size(), unicode));
+        sk_sp<SkTypeface> typeface(fFallbackCache->matchFamilyStyleCharacter(
+                manager.get(), 0, fontStyle, bcp47.data(), bcp47.size(), unicode));
         if (typeface != nullptr) {
             return typeface;
         }
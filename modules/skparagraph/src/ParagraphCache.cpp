@@ -1,7 +1,11 @@
 // Copyright 2019 Google LLC.
+#include "include/core/SkTraceMemoryDump.h"
+#include "modules/skparagraph/include/FontCollection.h"
 #include "modules/skparagraph/include/ParagraphCache.h"
 #include "modules/skparagraph/src/ParagraphImpl.h"
 
+#include <limits>
+
 namespace skia {
 namespace textlayout {
 
@@ -23,12 +27,24 @@ public:
         : fText(paragraph->fText.c_str(), paragraph->fText.size())
         , fPlaceholders(paragraph->fPlaceholders)
         , fTextStyles(paragraph->fTextStyles)
-        , fParagraphStyle(paragraph->paragraphStyle()) { }
+        , fParagraphStyle(paragraph->paragraphStyle())
+        , fFontManagers(paragraph->fFontCollection->getFontManagerOrder())
+        , fDefaultFamilyName(paragraph->fFontCollection->fDefaultFamilyName)
+        , fFontFallback(paragraph->fFontCollection->fEnableFontFallback) {
+        // The default font manager is also used when fallback is disabled.
+        fFontManagers.push_back(paragraph->fFontCollection->fDefaultFontManager);
+    }
 
     SkString fText;
     SkTArray<Placeholder, true> fPlaceholders;
     SkTArray<Block, true> fTextStyles;
     ParagraphStyle fParagraphStyle;
+
+    // The cache can be shared by font collections; the fonts they resolve to depend on these.
+    // Holding the font managers keeps their addresses from being reused while the key exists.
+    std::vector<sk_sp<SkFontMgr>> fFontManagers;
+    SkString fDefaultFamilyName;
+    bool fFontFallback;
 };
 
 class ParagraphCacheValue {
@@ -104,6 +120,12 @@ uint32_t ParagraphCache::KeyHash::operator()(const ParagraphCacheKey& key) const
         }
     }
 
+    for (auto& fontManager : key.fFontManagers) {
+        hash = mix(hash, SkGoodHash()(fontManager.get()));
+    }
+    hash = mix(hash, SkGoodHash()(key.fDefaultFamilyName));
+    hash = mix(hash, SkGoodHash()(key.fFontFallback));
+
     hash = mix(hash, SkGoodHash()(key.fText));
     return hash;
 }
@@ -121,6 +143,11 @@ bool operator==(const ParagraphCacheKey& a, const ParagraphCacheKey& b) {
     if (a.fTextStyles.size() != b.fTextStyles.size()) {
         return false;
     }
+    if (a.fFontManagers != b.fFontManagers ||
+        a.fFontFallback != b.fFontFallback ||
+        a.fDefaultFamilyName != b.fDefaultFamilyName) {
+        return false;
+    }
 
     // There is no need to compare default paragraph styles - they are included into fTextStyles
     if (!nearlyEqual(a.fParagraphStyle.getHeight(), b.fParagraphStyle.getHeight())) {
@@ -170,15 +197,41 @@ bool operator==(const ParagraphCacheKey& a, const ParagraphCacheKey& b) {
     return true;
 }
 
-struct ParagraphCache::Entry {
+struct ParagraphCache::Entry : public SkNVRefCnt<Entry> {
+
+    Entry(ParagraphCacheValue* value) : fValue(value), fBytes(sizeof(Entry) + sizeof(*value)) {
+        const ParagraphCacheKey& key = fValue->fKey;
+        fBytes += key.fText.size() +
+                  key.fPlaceholders.size() * sizeof(Placeholder) +
+                  key.fTextStyles.size() * sizeof(Block) +
+                  key.fFontManagers.size() * sizeof(sk_sp<SkFontMgr>);
+        for (auto& run : fValue->fRuns) {
+            fBytes += sizeof(Run) +
+                      HeapBytes(run.fGlyphs) +
+                      HeapBytes(run.fPositions) +
+                      HeapBytes(run.fJustificationShifts) +
+                      HeapBytes(run.fOffsets) +
+                      HeapBytes(run.fClusterIndexes) +
+                      HeapBytes(run.fBounds) +
+                      HeapBytes(run.fShifts);
+        }
+    }
+
+    // Runs keep up to N elements of each array inline, so only larger arrays add to sizeof(Run).
+    template <int N, typename T>
+    static size_t HeapBytes(const SkSTArray<N, T, true>& array) {
+        return array.size() > N ? array.size() * sizeof(T) : 0;
+    }
 
-    Entry(ParagraphCacheValue* value) : fValue(value) {}
     std::unique_ptr<ParagraphCacheValue> fValue;
+    size_t fBytes;
 };
 
-ParagraphCache::ParagraphCache()
+ParagraphCache::ParagraphCache(size_t byteLimit)
     : fChecker([](ParagraphImpl* impl, const char*, bool){ })
-    , fLRUCacheMap(kMaxEntries)
+    , fLRUCacheMap(std::numeric_limits<int>::max())
+    , fByteLimit(byteLimit)
+    , fBytesUsed(0)
     , fCacheIsOn(true)
 #ifdef PARAGRAPH_CACHE_STATS
     , fTotalRequests(0)
@@ -199,20 +252,18 @@ void ParagraphCache::updateTo(ParagraphImpl* paragraph, const Entry* entry) {
 }
 
 void ParagraphCache::printStatistics() {
+    SkAutoMutexExclusive lock(fParagraphMutex);
     SkDebugf("--- Paragraph Cache ---\n");
     SkDebugf("Total requests: %d\n", fTotalRequests);
     SkDebugf("Cache misses: %d\n", fCacheMisses);
     SkDebugf("Cache miss %%: %f\n", (fTotalRequests > 0) ? 100.f * fCacheMisses / fTotalRequests : 0.f);
     int cacheHits = fTotalRequests - fCacheMisses;
     SkDebugf("Hash miss %%: %f\n", (cacheHits > 0) ? 100.f * fHashMisses / cacheHits : 0.f);
+    SkDebugf("Bytes used: %zu of %zu\n", fBytesUsed, fByteLimit);
     SkDebugf("---------------------\n");
 }
 
 void ParagraphCache::abandon() {
-    SkAutoMutexExclusive lock(fParagraphMutex);
-    fLRUCacheMap.foreach([](ParagraphCacheKey*, std::unique_ptr<Entry>* e) {
-    });
-
     this->reset();
 }
 
@@ -224,28 +275,80 @@ void ParagraphCache::reset() {
     fHashMisses = 0;
 #endif
     fLRUCacheMap.reset();
+    fBytesUsed = 0;
+}
+
+int ParagraphCache::count() const {
+    SkAutoMutexExclusive lock(fParagraphMutex);
+    return fLRUCacheMap.count();
+}
+
+size_t ParagraphCache::getByteLimit() const {
+    SkAutoMutexExclusive lock(fParagraphMutex);
+    return fByteLimit;
+}
+
+void ParagraphCache::setByteLimit(size_t byteLimit) {
+    SkAutoMutexExclusive lock(fParagraphMutex);
+    fByteLimit = byteLimit;
+    this->purgeAsNeeded();
+}
+
+size_t ParagraphCache::getBytesUsed() const {
+    SkAutoMutexExclusive lock(fParagraphMutex);
+    return fBytesUsed;
+}
+
+void ParagraphCache::purgeAsNeeded() {
+    fParagraphMutex.assertHeld();
+    while (fBytesUsed > fByteLimit) {
+        sk_sp<Entry>* oldest = fLRUCacheMap.leastRecentlyUsed();
+        SkASSERT(oldest);
+        fBytesUsed -= (*oldest)->fBytes;
+        fLRUCacheMap.removeLeastRecentlyUsed();
+    }
+}
+
+void ParagraphCache::dumpMemoryStatistics(SkTraceMemoryDump* dump, const char dumpName[]) const {
+    SkAutoMutexExclusive lock(fParagraphMutex);
+    dump->dumpNumericValue(dumpName, "size", "bytes", fBytesUsed);
+    dump->dumpNumericValue(dumpName, "budget_size", "bytes", fByteLimit);
+    dump->dumpNumericValue(dumpName, "paragraph_count", "objects", fLRUCacheMap.count());
+#ifdef PARAGRAPH_CACHE_STATS
+    dump->dumpNumericValue(dumpName, "request_count", "objects", fTotalRequests);
+    dump->dumpNumericValue(dumpName, "miss_count", "objects", fCacheMisses);
+#endif
+    dump->setMemoryBacking(dumpName, "malloc", nullptr);
 }
 
 bool ParagraphCache::findParagraph(ParagraphImpl* paragraph) {
     if (!fCacheIsOn) {
         return false;
     }
+    ParagraphCacheKey key(paragraph);
+    sk_sp<Entry> entry;
+    {
+        SkAutoMutexExclusive lock(fParagraphMutex);
 #ifdef PARAGRAPH_CACHE_STATS
-    ++fTotalRequests;
+        ++fTotalRequests;
 #endif
-    SkAutoMutexExclusive lock(fParagraphMutex);
-    ParagraphCacheKey key(paragraph);
-    std::unique_ptr<Entry>* entry = fLRUCacheMap.find(key);
+        if (sk_sp<Entry>* found = fLRUCacheMap.find(key)) {
+            entry = *found;
+        }
+#ifdef PARAGRAPH_CACHE_STATS
+        else {
+            ++fCacheMisses;
+        }
+#endif
+    }
 
     if (!entry) {
         // We have a cache miss
-#ifdef PARAGRAPH_CACHE_STATS
-        ++fCacheMisses;
-#endif
         fChecker(paragraph, "missingParagraph", true);
         return false;
     }
-    updateTo(paragraph, entry->get());
+    // The entry cannot change once it is in the cache, so the runs are copied without the lock.
+    updateTo(paragraph, entry.get());
     fChecker(paragraph, "foundParagraph", true);
     return true;
 }
@@ -254,21 +357,31 @@ bool ParagraphCache::updateParagraph(ParagraphImpl* paragraph) {
     if (!fCacheIsOn) {
         return false;
     }
+    ParagraphCacheKey key(paragraph);
+    {
+        SkAutoMutexExclusive lock(fParagraphMutex);
 #ifdef PARAGRAPH_CACHE_STATS
-    ++fTotalRequests;
+        ++fTotalRequests;
 #endif
+        if (fLRUCacheMap.find(key)) {
+            // We do not have to update the paragraph
+            return false;
+        }
+    }
+
+    // Copy the runs before taking the lock again.
+    auto entry = sk_make_sp<Entry>(new ParagraphCacheValue(paragraph));
+
     SkAutoMutexExclusive lock(fParagraphMutex);
-    ParagraphCacheKey key(paragraph);
-    std::unique_ptr<Entry>* entry = fLRUCacheMap.find(key);
-    if (!entry) {
-        ParagraphCacheValue* value = new ParagraphCacheValue(paragraph);
-        fLRUCacheMap.insert(key, std::unique_ptr<Entry>(new Entry(value)));
-        fChecker(paragraph, "addedParagraph", true);
-        return true;
-    } else {
-        // We do not have to update the paragraph
+    if (entry->fBytes > fByteLimit || fLRUCacheMap.find(key)) {
+        // Too large to ever fit, or another thread got here first.
         return false;
     }
+    fBytesUsed += entry->fBytes;
+    fLRUCacheMap.insert(key, std::move(entry));
+    this->purgeAsNeeded();
+    fChecker(paragraph, "addedParagraph", true);
+    return true;
 }
 }
 }
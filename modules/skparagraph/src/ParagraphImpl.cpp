@@ -132,10 +132,12 @@ void ParagraphImpl::layout(SkScalar rawWidth) {
         this->fClusters.reset();
         this->resetShifts();
     } else if (fState >= kLineBroken && (fOldWidth != floorWidth || fOldHeight != fHeight)) {
-        // We can use the results from SkShaper but have to do EVERYTHING ELSE again
-        this->fClusters.reset();
-        this->resetShifts();
-        fState = kShaped;
+        // Runs, clusters, line break opportunities and letter/word spacing do not depend on the
+        // width: only break the text into lines and format them again
+        for (auto& run : fRuns) {
+            run.resetJustificationShifts();
+        }
+        fState = kMarked;
     }
 
     if (fState < kShaped) {
@@ -190,6 +192,7 @@ void ParagraphImpl::layout(SkScalar rawWidth) {
         this->resolveStrut();
         this->computeEmptyMetrics();
         this->fLines.reset();
+        this->fOrigin = SkRect::MakeEmpty();
         this->breakShapedTextIntoLines(floorWidth);
         fState = kLineBroken;
     }
@@ -1136,11 +1139,198 @@ void ParagraphImpl::computeEmptyMetrics() {
 }
 
 void ParagraphImpl::updateText(size_t from, SkString text) {
-  fText.remove(from, from + text.size());
-  fText.insert(from, text);
-  fState = kUnknown;
-  fOldWidth = 0;
-  fOldHeight = 0;
+  this->replaceText(from, std::min(from + text.size(), fText.size()), text);
+}
+
+// The runs which have to be shaped again after replacing the text in edit, or an empty range if
+// the paragraph has to be shaped from scratch.
+SkRange<RunIndex> ParagraphImpl::findRunsToReshape(TextRange edit) const {
+    // Only handle text without placeholders (there is always one empty one at the end),
+    // letter/word spacing or mixed directions, laid out in one sequence of runs.
+    if (fState < kShaped || fRuns.empty() || fPlaceholders.size() != 1) {
+        return EMPTY_RANGE;
+    }
+    TextIndex expected = 0;
+    for (auto& run : fRuns) {
+        if (run.isPlaceholder() || run.fSpaced || run.fBidiLevel != fRuns.front().fBidiLevel ||
+            run.fTextRange.start != expected) {
+            return EMPTY_RANGE;
+        }
+        expected = run.fTextRange.end;
+    }
+    if (expected != fText.size()) {
+        return EMPTY_RANGE;
+    }
+
+    // Include the runs on both sides of the edit, they may merge with the new text.
+    RunIndex first = 0;
+    while (first + 1 < fRuns.size() && fRuns[first].fTextRange.end < edit.start) {
+        ++first;
+    }
+    RunIndex last = first;
+    while (last + 1 < fRuns.size() && fRuns[last + 1].fTextRange.start <= edit.end) {
+        ++last;
+    }
+    return SkRange<RunIndex>(first, last + 1);
+}
+
+// Shapes the text now covered by the given runs on its own and puts the result in their place.
+bool ParagraphImpl::reshapeRuns(SkRange<RunIndex> runs, TextRange edit, size_t inserted) {
+    auto moveIndex = [&](TextIndex index) { return index - edit.width() + inserted; };
+
+    SkTArray<BidiRegion> bidiRegions;
+    if (!this->calculateBidiRegions(&bidiRegions) || bidiRegions.size() != 1 ||
+        bidiRegions.front().direction != fRuns.front().fBidiLevel) {
+        return false;
+    }
+
+    TextRange region(fRuns[runs.start].fTextRange.start, moveIndex(fRuns[runs.end - 1].fTextRange.end));
+    SkString regionText(fText.c_str() + region.start, region.width());
+    SkTArray<Block, true> regionStyles;
+    for (auto& block : fTextStyles) {
+        auto start = std::max(block.fRange.start, region.start);
+        auto end = std::min(block.fRange.end, region.end);
+        if (start < end) {
+            regionStyles.emplace_back(start - region.start, end - region.start, block.fStyle);
+        }
+    }
+    SkTArray<Placeholder, true> regionPlaceholders;
+    regionPlaceholders.emplace_back(region.width(), region.width(), PlaceholderStyle(),
+                                    fPlaceholders.back().fTextStyle,
+                                    BlockRange(0, regionStyles.size()),
+                                    TextRange(0, region.width()));
+    ParagraphImpl regionParagraph(regionText, fParagraphStyle, std::move(regionStyles),
+                                  std::move(regionPlaceholders), fFontCollection);
+    regionParagraph.markGraphemes();
+    if (!regionParagraph.shapeTextIntoEndlessLine()) {
+        return false;
+    }
+
+    // Unresolved glyphs end up as glyph 0; recount them for the replaced runs.
+    auto countUnresolved = [](const Run& run) {
+        return std::count(run.fGlyphs.begin(), run.fGlyphs.end(), 0);
+    };
+
+    SkScalar regionX = fRuns[runs.start].fOffset.fX;
+    const Run& oldLast = fRuns[runs.end - 1];
+    SkScalar oldAdvance = oldLast.fOffset.fX + oldLast.fAdvance.fX - regionX;
+    SkScalar newAdvance = 0;
+    if (!regionParagraph.fRuns.empty()) {
+        const Run& newLast = regionParagraph.fRuns.back();
+        newAdvance = newLast.fOffset.fX + newLast.fAdvance.fX;
+    }
+
+    auto moveRun = [this](Run* run, TextIndex start, SkScalar dx) {
+        auto delta = start - run->fTextRange.start;
+        run->setMaster(this);
+        run->fTextRange = TextRange(start, run->fTextRange.end + delta);
+        run->fClusterStart += delta;
+        run->fOffset.fX += dx;
+        for (size_t i = 0; i <= run->size(); ++i) {
+            run->addX(i, dx);
+        }
+    };
+
+    size_t unresolved = fUnresolvedGlyphs;
+    SkTArray<Run, false> newRuns;
+    newRuns.reserve(fRuns.size() - runs.width() + regionParagraph.fRuns.size());
+    for (RunIndex i = 0; i < runs.start; ++i) {
+        newRuns.push_back(fRuns[i]);
+    }
+    for (RunIndex i = runs.start; i < runs.end; ++i) {
+        unresolved -= std::min<size_t>(unresolved, countUnresolved(fRuns[i]));
+    }
+    for (auto& run : regionParagraph.fRuns) {
+        unresolved += countUnresolved(run);
+        auto& newRun = newRuns.push_back(run);
+        moveRun(&newRun, run.fTextRange.start + region.start, regionX);
+    }
+    for (RunIndex i = runs.end; i < fRuns.size(); ++i) {
+        auto& newRun = newRuns.push_back(fRuns[i]);
+        moveRun(&newRun, moveIndex(newRun.fTextRange.start), newAdvance - oldAdvance);
+    }
+    for (RunIndex i = 0; i < newRuns.size(); ++i) {
+        newRuns[i].fIndex = i;
+    }
+    fRuns = std::move(newRuns);
+    fUnresolvedGlyphs = unresolved;
+
+    SkTArray<ResolvedFontDescriptor> fontSwitches;
+    for (auto& fontSwitch : fFontSwitches) {
+        if (fontSwitch.fTextStart < region.start) {
+            fontSwitches.push_back(fontSwitch);
+        }
+    }
+    for (auto& fontSwitch : regionParagraph.fFontSwitches) {
+        fontSwitches.emplace_back(fontSwitch.fTextStart + region.start, fontSwitch.fFont);
+    }
+    for (auto& fontSwitch : fFontSwitches) {
+        if (fontSwitch.fTextStart >= oldLast.fTextRange.end) {
+            fontSwitches.emplace_back(moveIndex(fontSwitch.fTextStart), fontSwitch.fFont);
+        }
+    }
+    fFontSwitches = std::move(fontSwitches);
+    return true;
+}
+
+void ParagraphImpl::replaceText(size_t from, size_t to, const SkString& text) {
+    SkASSERT(from <= to && to <= fText.size());
+    to = std::min(to, fText.size());
+    from = std::min(from, to);
+    TextRange edit(from, to);
+    size_t oldSize = fText.size();
+
+    // Decide which runs are affected while they still describe the old text.
+    auto runs = this->findRunsToReshape(edit);
+
+    SkString newText(fText.c_str(), from);
+    newText.append(text);
+    newText.append(fText.c_str() + to, oldSize - to);
+    fText = std::move(newText);
+
+    // Offsets inside the replaced text move past the inserted text: the style which starts at
+    // (or contains) the edit covers the new text, and an edit at the end extends the last style.
+    auto moveIndex = [&](TextIndex index) {
+        if (index == oldSize) {
+            return fText.size();
+        } else if (index <= from) {
+            return index;
+        } else if (index < to) {
+            return from + text.size();
+        }
+        return index - edit.width() + text.size();
+    };
+    SkTArray<Block, true> blocks;
+    for (auto& block : fTextStyles) {
+        TextRange range(moveIndex(block.fRange.start), moveIndex(block.fRange.end));
+        if (range.width() > 0 || fText.isEmpty()) {
+            blocks.emplace_back(range, block.fStyle);
+        }
+    }
+    fTextStyles = std::move(blocks);
+    for (auto& placeholder : fPlaceholders) {
+        placeholder.fRange = TextRange(moveIndex(placeholder.fRange.start),
+                                       moveIndex(placeholder.fRange.end));
+        placeholder.fTextBefore = TextRange(moveIndex(placeholder.fTextBefore.start),
+                                            moveIndex(placeholder.fTextBefore.end));
+    }
+
+    fGraphemes.reset();
+    fGraphemes16.reset();
+    fCodePoints.reset();
+    fWords.clear();
+    fOldWidth = 0;
+    fOldHeight = 0;
+
+    if (runs.width() == 0 || fText.isEmpty() || !this->reshapeRuns(runs, edit, text.size())) {
+        fState = kUnknown;
+        return;
+    }
+
+    this->markGraphemes();
+    if (fState > kShaped) {
+        this->setState(kShaped);
+    }
 }
 
 void ParagraphImpl::updateFontSize(size_t from, size_t to, SkScalar fontSize) {
@@ -181,6 +181,7 @@ public:
 
     void updateTextAlign(TextAlign textAlign) override;
     void updateText(size_t from, SkString text) override;
+    void replaceText(size_t from, size_t to, const SkString& text) override;
     void updateFontSize(size_t from, size_t to, SkScalar fontSize) override;
     void updateForegroundPaint(size_t from, size_t to, SkPaint paint) override;
     void updateBackgroundPaint(size_t from, size_t to, SkPaint paint) override;
@@ -215,6 +216,9 @@ private:
 
     bool calculateBidiRegions(SkTArray<BidiRegion>* regions);
 
+    SkRange<RunIndex> findRunsToReshape(TextRange edit) const;
+    bool reshapeRuns(SkRange<RunIndex> runs, TextRange edit, size_t inserted);
+
     // Input
     SkTArray<StyleBlock<SkScalar>> fLetterSpaceStyles;
     SkTArray<StyleBlock<SkScalar>> fWordSpaceStyles;
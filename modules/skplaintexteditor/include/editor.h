@@ -3,6 +3,7 @@
 #ifndef editor_DEFINED
 #define editor_DEFINED
 
+#include "modules/skplaintexteditor/include/rope.h"
 #include "modules/skplaintexteditor/include/stringslice.h"
 #include "modules/skplaintexteditor/include/stringview.h"
 
@@ -24,7 +25,8 @@ namespace SkPlainTextEditor {
 class Editor {
     struct TextLine;
 public:
-    // total height in canvas display units.
+    // total height in canvas display units.  Lines are shaped lazily, lines which have not been
+    // shaped yet are estimated to take up one line of text.
     int getHeight() const { return fHeight; }
 
     // set display width in canvas display units
@@ -35,9 +37,9 @@ public:
     void setFont(SkFont font);
 
     struct Text {
-        const std::vector<TextLine>& fLines;
+        const Rope<TextLine>& fLines;
         struct Iterator {
-            std::vector<TextLine>::const_iterator fPtr;
+            Rope<TextLine>::const_iterator fPtr;
             StringView operator*() { return fPtr->fText.view(); }
             void operator++() { ++fPtr; }
             bool operator!=(const Iterator& other) const { return fPtr != other.fPtr; }
@@ -52,7 +54,7 @@ public:
     //     }
     Text text() const { return Text{fLines}; }
 
-    // get size of line in canvas display units.
+    // get size of line in canvas display units (an estimate if the line has not been shaped yet).
     int lineHeight(size_t index) const { return fLines[index].fHeight; }
 
     struct TextPosition {
@@ -96,6 +98,7 @@ public:
         TextPosition fSelectionEnd;
         TextPosition fCursor;
     };
+    // Only the lines inside the canvas' clip are shaped and drawn.
     void paint(SkCanvas* canvas, PaintOpts);
 
 private:
@@ -113,15 +116,22 @@ private:
         TextLine(StringSlice t) : fText(std::move(t)) {}
         TextLine() {}
     };
-    std::vector<TextLine> fLines;
+    // Shaping results and line origins are caches, filled in as lines are needed.
+    mutable Rope<TextLine> fLines;
+    mutable int fHeight = 0;
+    mutable size_t fValidOrigins = 0;  // lines [0, fValidOrigins) have an up to date fOrigin.
     int fWidth = 0;
-    int fHeight = 0;
     SkFont fFont;
-    bool fNeedsReshape = false;
     const char* fLocale = "en";  // TODO: make this setable
 
-    void markDirty(TextLine*);
-    void reshapeAll();
+    int estimatedHeight() const;
+    void setLineHeight(size_t index, int height) const;
+    void markDirty(size_t index);
+    void insertLines(size_t index, size_t count);
+    void eraseLines(size_t begin, size_t end);
+    const TextLine& shapedLine(size_t index) const;
+    SkIPoint origin(size_t index) const;
+    size_t lineAt(int y) const;
 };
 }  // namespace SkPlainTextEditor
 
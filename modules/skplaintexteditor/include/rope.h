@@ -0,0 +1,161 @@
+// Copyright 2020 Google LLC.
+// Use of this source code is governed by a BSD-style license that can be found in the LICENSE file.
+#ifndef rope_DEFINED
+#define rope_DEFINED
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace SkPlainTextEditor {
+// A sequence of values kept in bounded chunks.  Inserting or erasing values in the middle of a
+// long sequence only moves the values of the chunks involved, and finding a value by index is a
+// binary search over the chunks.
+template <typename T>
+class Rope {
+    template <typename R, typename V>
+    struct Iter {
+        R* fRope;
+        std::size_t fChunk;
+        std::size_t fIndex;
+        V& operator*() const { return fRope->fChunks[fChunk][fIndex]; }
+        V* operator->() const { return &**this; }
+        void operator++() {
+            if (++fIndex == fRope->fChunks[fChunk].size()) {
+                ++fChunk;
+                fIndex = 0;
+            }
+        }
+        bool operator==(const Iter& other) const {
+            return fChunk == other.fChunk && fIndex == other.fIndex;
+        }
+        bool operator!=(const Iter& other) const { return !(*this == other); }
+    };
+
+public:
+    using iterator = Iter<Rope, T>;
+    using const_iterator = Iter<const Rope, const T>;
+
+    std::size_t size() const { return fSize; }
+    bool empty() const { return fSize == 0; }
+
+    T& operator[](std::size_t i) {
+        auto at = this->locate(i);
+        return fChunks[at.first][at.second];
+    }
+    const T& operator[](std::size_t i) const {
+        auto at = this->locate(i);
+        return fChunks[at.first][at.second];
+    }
+    T& back() { return fChunks.back().back(); }
+
+    iterator begin() { return iterator{this, 0, 0}; }
+    iterator end() { return iterator{this, fChunks.size(), 0}; }
+    const_iterator begin() const { return const_iterator{this, 0, 0}; }
+    const_iterator end() const { return const_iterator{this, fChunks.size(), 0}; }
+
+    // Inserts count default constructed values before index.
+    void insert(std::size_t index, std::size_t count) {
+        assert(index <= fSize);
+        if (count == 0) {
+            return;
+        }
+        if (fChunks.empty()) {
+            fChunks.emplace_back();
+            fStarts.push_back(0);
+        }
+        auto at = index == fSize ? std::make_pair(fChunks.size() - 1, fChunks.back().size())
+                                 : this->locate(index);
+        std::vector<T>& chunk = fChunks[at.first];
+        chunk.insert(chunk.begin() + at.second, count, T());
+        fSize += count;
+        if (chunk.size() > 2 * kChunkSize) {
+            this->split(at.first);
+        }
+        this->updateStarts(at.first);
+    }
+
+    void push_back(T value) {
+        this->insert(fSize, 1);
+        this->back() = std::move(value);
+    }
+
+    // Erases the values in [begin, end).
+    void erase(std::size_t begin, std::size_t end) {
+        assert(begin <= end && end <= fSize);
+        if (begin == end) {
+            return;
+        }
+        auto first = this->locate(begin);
+        std::size_t remaining = end - begin;
+        std::size_t c = first.first;
+        std::size_t i = first.second;
+        while (remaining > 0) {
+            std::vector<T>& chunk = fChunks[c];
+            std::size_t n = std::min(remaining, chunk.size() - i);
+            chunk.erase(chunk.begin() + i, chunk.begin() + i + n);
+            remaining -= n;
+            if (chunk.empty()) {
+                fChunks.erase(fChunks.begin() + c);
+                fStarts.erase(fStarts.begin() + c);
+            } else {
+                ++c;
+            }
+            i = 0;
+        }
+        fSize -= end - begin;
+        // Keep chunks from getting too small after repeated erasing.
+        c = first.first;
+        if (c > 0) {
+            --c;
+        }
+        if (c + 1 < fChunks.size() && fChunks[c].size() + fChunks[c + 1].size() <= kChunkSize) {
+            fChunks[c].insert(fChunks[c].end(),
+                              std::make_move_iterator(fChunks[c + 1].begin()),
+                              std::make_move_iterator(fChunks[c + 1].end()));
+            fChunks.erase(fChunks.begin() + c + 1);
+            fStarts.erase(fStarts.begin() + c + 1);
+        }
+        this->updateStarts(c);
+    }
+
+private:
+    static constexpr std::size_t kChunkSize = 256;
+
+    std::vector<std::vector<T>> fChunks;
+    std::vector<std::size_t> fStarts;  // Index of the first value of each chunk.
+    std::size_t fSize = 0;
+
+    // Returns the chunk holding value i and the value's index in that chunk.
+    std::pair<std::size_t, std::size_t> locate(std::size_t i) const {
+        assert(i < fSize);
+        std::size_t c = std::upper_bound(fStarts.begin(), fStarts.end(), i) - fStarts.begin() - 1;
+        return {c, i - fStarts[c]};
+    }
+
+    void split(std::size_t c) {
+        std::vector<T> chunk = std::move(fChunks[c]);
+        std::size_t pieces = (chunk.size() + kChunkSize - 1) / kChunkSize;
+        std::vector<std::vector<T>> split(pieces);
+        for (std::size_t p = 0; p < pieces; ++p) {
+            auto from = chunk.begin() + p * kChunkSize;
+            auto to = chunk.begin() + std::min(chunk.size(), (p + 1) * kChunkSize);
+            split[p].assign(std::make_move_iterator(from), std::make_move_iterator(to));
+        }
+        fChunks.erase(fChunks.begin() + c);
+        fChunks.insert(fChunks.begin() + c, std::make_move_iterator(split.begin()),
+                       std::make_move_iterator(split.end()));
+        fStarts.insert(fStarts.begin() + c, pieces - 1, 0);
+    }
+
+    void updateStarts(std::size_t c) {
+        for (; c < fChunks.size(); ++c) {
+            fStarts[c] = c == 0 ? 0 : fStarts[c - 1] + fChunks[c - 1].size();
+        }
+    }
+};
+}  // namespace SkPlainTextEditor
+#endif  // rope_DEFINED
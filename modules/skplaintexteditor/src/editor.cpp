@@ -4,13 +4,13 @@
 #include "modules/skplaintexteditor/include/editor.h"
 
 #include "include/core/SkCanvas.h"
-#include "include/core/SkExecutor.h"
 #include "include/core/SkPath.h"
 #include "src/utils/SkUTF.h"
 
 #include "modules/skplaintexteditor/src/shape.h"
 
 #include <algorithm>
+#include <cmath>
 
 using namespace SkPlainTextEditor;
 
@@ -44,54 +44,145 @@ static const StringSlice remove_newline(const char* str, size_t len) {
            StringSlice(str, (len > 0 && str[len - 1] == '\n') ? len - 1 : len);
 }
 
-void Editor::markDirty(TextLine* line) {
-    line->fBlob = nullptr;
-    line->fShaped = false;
-    line->fWordBoundaries = std::vector<bool>();
+int Editor::estimatedHeight() const { return (int)std::ceil(fFont.getSpacing()); }
+
+void Editor::setLineHeight(size_t index, int height) const {
+    TextLine& line = fLines[index];
+    if (line.fHeight != height) {
+        fHeight += height - line.fHeight;
+        line.fHeight = height;
+        fValidOrigins = std::min(fValidOrigins, index + 1);
+    }
+}
+
+void Editor::markDirty(size_t index) {
+    TextLine& line = fLines[index];
+    line.fBlob = nullptr;
+    line.fShaped = false;
+    line.fWordBoundaries = std::vector<bool>();
+    line.fCursorPos = std::vector<SkRect>();
+    line.fLineEndOffsets = std::vector<size_t>();
+    this->setLineHeight(index, this->estimatedHeight());
+}
+
+void Editor::insertLines(size_t index, size_t count) {
+    fLines.insert(index, count);
+    int height = this->estimatedHeight();
+    for (size_t i = index; i < index + count; ++i) {
+        fLines[i].fHeight = height;
+    }
+    fHeight += (int)count * height;
+    fValidOrigins = std::min(fValidOrigins, index);
+}
+
+void Editor::eraseLines(size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        fHeight -= fLines[i].fHeight;
+    }
+    fLines.erase(begin, end);
+    fValidOrigins = std::min(fValidOrigins, begin);
+}
+
+const Editor::TextLine& Editor::shapedLine(size_t index) const {
+    TextLine& line = fLines[index];
+    if (!line.fShaped) {
+        ShapeResult result = Shape(line.fText.begin(), line.fText.size(),
+                                   fFont, fLocale, (float)fWidth);
+        line.fBlob           = std::move(result.blob);
+        line.fLineEndOffsets = std::move(result.lineBreakOffsets);
+        line.fCursorPos      = std::move(result.glyphBounds);
+        line.fWordBoundaries = std::move(result.wordBreaks);
+        line.fShaped = true;
+        this->setLineHeight(index, result.verticalAdvance);
+    }
+    return line;
+}
+
+SkIPoint Editor::origin(size_t index) const {
+    SkASSERT(index < fLines.size());
+    for (; fValidOrigins <= index; ++fValidOrigins) {
+        int y = 0;
+        if (fValidOrigins > 0) {
+            const TextLine& prev = fLines[fValidOrigins - 1];
+            y = prev.fOrigin.y() + prev.fHeight;
+        }
+        fLines[fValidOrigins].fOrigin = {0, y};
+    }
+    return fLines[index].fOrigin;
+}
+
+// Returns the line covering y, clamped to the first and last lines.
+size_t Editor::lineAt(int y) const {
+    if (fLines.empty() || y < 0) {
+        return 0;
+    }
+    // Extend the known origins until they pass y, then search among them.
+    size_t last = fLines.size() - 1;
+    if (fValidOrigins == 0) {
+        this->origin(0);
+    }
+    while (fValidOrigins <= last && fLines[fValidOrigins - 1].fOrigin.y() <= y) {
+        this->origin(fValidOrigins);
+    }
+    size_t lo = 0, hi = fValidOrigins;  // fLines[lo].fOrigin.y() <= y
+    while (hi - lo > 1) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (fLines[mid].fOrigin.y() <= y) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
 }
 
 void Editor::setFont(SkFont font) {
     if (font != fFont) {
         fFont = std::move(font);
-        fNeedsReshape = true;
-        for (auto& l : fLines) { this->markDirty(&l); }
+        for (size_t i = 0; i < fLines.size(); ++i) { this->markDirty(i); }
     }
 }
 
 void Editor::setWidth(int w) {
     if (fWidth != w) {
         fWidth = w;
-        fNeedsReshape = true;
-        for (auto& l : fLines) { this->markDirty(&l); }
+        for (size_t i = 0; i < fLines.size(); ++i) { this->markDirty(i); }
     }
 }
 static SkPoint to_point(SkIPoint p) { return {(float)p.x(), (float)p.y()}; }
 
 Editor::TextPosition Editor::getPosition(SkIPoint xy) {
     Editor::TextPosition approximatePosition;
-    this->reshapeAll();
-    for (size_t j = 0; j < fLines.size(); ++j) {
-        const TextLine& line = fLines[j];
+    if (fLines.empty()) {
+        return approximatePosition;
+    }
+    // Text may extend past its line, so also look at the neighbors of the line under xy.
+    size_t center = this->lineAt(xy.y());
+    size_t first = center > 0 ? center - 1 : 0;
+    size_t last = std::min(center + 2, fLines.size());
+    for (size_t j = first; j < last; ++j) {
+        const TextLine& line = this->shapedLine(j);
+        SkIPoint lineOrigin = this->origin(j);
         SkIRect lineRect = {0,
-                            line.fOrigin.y(),
+                            lineOrigin.y(),
                             fWidth,
-                            j + 1 < fLines.size() ? fLines[j + 1].fOrigin.y() : INT_MAX};
+                            j + 1 < fLines.size() ? this->origin(j + 1).y() : INT_MAX};
         if (const SkTextBlob* b = line.fBlob.get()) {
             SkIRect r = b->bounds().roundOut();
-            r.offset(line.fOrigin);
+            r.offset(lineOrigin);
             lineRect.join(r);
         }
         if (!lineRect.contains(xy.x(), xy.y())) {
             continue;
         }
-        SkPoint pt = to_point(xy - line.fOrigin);
+        SkPoint pt = to_point(xy - lineOrigin);
         const std::vector<SkRect>& pos = line.fCursorPos;
         for (size_t i = 0; i < pos.size(); ++i) {
             if (pos[i] != kUnsetRect && pos[i].contains(pt.x(), pt.y())) {
                 return Editor::TextPosition{i, j};
             }
         }
-        approximatePosition = {xy.x() <= line.fOrigin.x() ? 0 : line.fText.size(), j};
+        approximatePosition = {xy.x() <= lineOrigin.x() ? 0 : line.fText.size(), j};
     }
     return approximatePosition;
 }
@@ -122,25 +213,22 @@ static const char* prev_utf8(const char* p, const char* begin) {
 }
 
 SkRect Editor::getLocation(Editor::TextPosition cursor) {
-    this->reshapeAll();
     cursor = this->move(Editor::Movement::kNowhere, cursor);
     if (fLines.size() > 0) {
-        const TextLine& cLine = fLines[cursor.fParagraphIndex];
+        const TextLine& cLine = this->shapedLine(cursor.fParagraphIndex);
         SkRect pos = {0, 0, 0, 0};
         if (cursor.fTextByteIndex < cLine.fCursorPos.size()) {
             pos = cLine.fCursorPos[cursor.fTextByteIndex];
         }
         pos.fRight = pos.fLeft + 1;
         pos.fLeft -= 1;
-        return offset(pos, cLine.fOrigin);
+        return offset(pos, this->origin(cursor.fParagraphIndex));
     }
     return SkRect{0, 0, 0, 0};
 }
 
-static size_t count_char(const StringSlice& string, char value) {
-    size_t count = 0;
-    for (char c : string) { if (c == value) { ++count; } }
-    return count;
+static size_t count_char(const char* text, size_t byteLen, char value) {
+    return std::count(text, text + byteLen, value);
 }
 
 Editor::TextPosition Editor::insert(TextPosition pos, const char* utf8Text, size_t byteLen) {
@@ -148,24 +236,23 @@ Editor::TextPosition Editor::insert(TextPosition pos, const char* utf8Text, size
         return pos;
     }
     pos = this->move(Editor::Movement::kNowhere, pos);
-    fNeedsReshape = true;
     if (pos.fParagraphIndex < fLines.size()) {
         fLines[pos.fParagraphIndex].fText.insert(pos.fTextByteIndex, utf8Text, byteLen);
-        this->markDirty(&fLines[pos.fParagraphIndex]);
+        this->markDirty(pos.fParagraphIndex);
     } else {
         SkASSERT(pos.fParagraphIndex == fLines.size());
         SkASSERT(pos.fTextByteIndex == 0);
-        fLines.push_back(Editor::TextLine(StringSlice(utf8Text, byteLen)));
+        this->insertLines(fLines.size(), 1);
+        fLines.back().fText = StringSlice(utf8Text, byteLen);
     }
     pos = Editor::TextPosition{pos.fTextByteIndex + byteLen, pos.fParagraphIndex};
-    size_t newlinecount = count_char(fLines[pos.fParagraphIndex].fText, '\n');
+    size_t newlinecount = count_char(utf8Text, byteLen, '\n');
     if (newlinecount > 0) {
         StringSlice src = std::move(fLines[pos.fParagraphIndex].fText);
-        std::vector<TextLine>::const_iterator next = fLines.begin() + pos.fParagraphIndex + 1;
-        fLines.insert(next, newlinecount, TextLine());
-        TextLine* line = &fLines[pos.fParagraphIndex];
-        readlines(src.begin(), src.size(), [&line](const char* str, size_t l) {
-            (line++)->fText = remove_newline(str, l);
+        this->insertLines(pos.fParagraphIndex + 1, newlinecount);
+        size_t index = pos.fParagraphIndex;
+        readlines(src.begin(), src.size(), [this, &index](const char* str, size_t l) {
+            fLines[index++].fText = remove_newline(str, l);
         });
     }
     return pos;
@@ -180,23 +267,22 @@ Editor::TextPosition Editor::remove(TextPosition pos1, TextPosition pos2) {
     if (start == end || start.fParagraphIndex == fLines.size()) {
         return start;
     }
-    fNeedsReshape = true;
     if (start.fParagraphIndex == end.fParagraphIndex) {
         SkASSERT(end.fTextByteIndex > start.fTextByteIndex);
         fLines[start.fParagraphIndex].fText.remove(
                 start.fTextByteIndex, end.fTextByteIndex - start.fTextByteIndex);
-        this->markDirty(&fLines[start.fParagraphIndex]);
+        this->markDirty(start.fParagraphIndex);
     } else {
         SkASSERT(end.fParagraphIndex < fLines.size());
         auto& line = fLines[start.fParagraphIndex];
+        const auto& endText = fLines[end.fParagraphIndex].fText;
         line.fText.remove(start.fTextByteIndex,
                           line.fText.size() - start.fTextByteIndex);
         line.fText.insert(start.fTextByteIndex,
-                          fLines[end.fParagraphIndex].fText.begin() + end.fTextByteIndex,
-                          fLines[end.fParagraphIndex].fText.size() - end.fTextByteIndex);
-        this->markDirty(&line);
-        fLines.erase(fLines.begin() + start.fParagraphIndex + 1,
-                     fLines.begin() + end.fParagraphIndex + 1);
+                          endText.begin() + end.fTextByteIndex,
+                          endText.size() - end.fTextByteIndex);
+        this->markDirty(start.fParagraphIndex);
+        this->eraseLines(start.fParagraphIndex + 1, end.fParagraphIndex + 1);
     }
     return start;
 }
@@ -227,15 +313,14 @@ size_t Editor::copy(TextPosition pos1, TextPosition pos2, char* dst) const {
         return size;
     }
     SkASSERT(end.fParagraphIndex < fLines.size());
-    const std::vector<TextLine>::const_iterator firstP = fLines.begin() + start.fParagraphIndex;
-    const std::vector<TextLine>::const_iterator lastP  = fLines.begin() + end.fParagraphIndex;
-    const auto& first = firstP->fText;
-    const auto& last  = lastP->fText;
+    const auto& first = fLines[start.fParagraphIndex].fText;
+    const auto& last  = fLines[end.fParagraphIndex].fText;
 
     append(&dst, &size, first.begin() + start.fTextByteIndex, first.size() - start.fTextByteIndex);
-    for (auto line = firstP + 1; line < lastP; ++line) {
+    for (size_t i = start.fParagraphIndex + 1; i < end.fParagraphIndex; ++i) {
+        const auto& line = fLines[i].fText;
         append(&dst, &size, "\n", 1);
-        append(&dst, &size, line->fText.begin(), line->fText.size());
+        append(&dst, &size, line.begin(), line.size());
     }
     append(&dst, &size, "\n", 1);
     append(&dst, &size, last.begin(), end.fTextByteIndex);
@@ -324,14 +409,16 @@ Editor::TextPosition Editor::move(Editor::Movement move, Editor::TextPosition po
             break;
         case Editor::Movement::kHome:
             {
-                const std::vector<size_t>& list = fLines[pos.fParagraphIndex].fLineEndOffsets;
+                const std::vector<size_t>& list =
+                        this->shapedLine(pos.fParagraphIndex).fLineEndOffsets;
                 size_t f = find_first_larger(list, pos.fTextByteIndex);
                 pos.fTextByteIndex = f > 0 ? list[f - 1] : 0;
             }
             break;
         case Editor::Movement::kEnd:
             {
-                const std::vector<size_t>& list = fLines[pos.fParagraphIndex].fLineEndOffsets;
+                const std::vector<size_t>& list =
+                        this->shapedLine(pos.fParagraphIndex).fLineEndOffsets;
                 size_t f = find_first_larger(list, pos.fTextByteIndex);
                 if (f < list.size()) {
                     pos.fTextByteIndex = list[f] > 0 ? list[f] - 1 : 0;
@@ -342,19 +429,20 @@ Editor::TextPosition Editor::move(Editor::Movement move, Editor::TextPosition po
             break;
         case Editor::Movement::kUp:
             {
-                SkASSERT(pos.fTextByteIndex < fLines[pos.fParagraphIndex].fCursorPos.size());
-                float x = fLines[pos.fParagraphIndex].fCursorPos[pos.fTextByteIndex].left();
-                const std::vector<size_t>& list = fLines[pos.fParagraphIndex].fLineEndOffsets;
+                const TextLine& line = this->shapedLine(pos.fParagraphIndex);
+                SkASSERT(pos.fTextByteIndex < line.fCursorPos.size());
+                float x = line.fCursorPos[pos.fTextByteIndex].left();
+                const std::vector<size_t>& list = line.fLineEndOffsets;
                 size_t f = find_first_larger(list, pos.fTextByteIndex);
                 // list[f] > value.  value > list[f-1]
                 if (f > 0) {
                     // not the first line in paragraph.
-                    pos.fTextByteIndex = find_closest_x(fLines[pos.fParagraphIndex].fCursorPos, x,
+                    pos.fTextByteIndex = find_closest_x(line.fCursorPos, x,
                                                         (f == 1) ? 0 : list[f - 2],
                                                         list[f - 1]);
                 } else if (pos.fParagraphIndex > 0) {
                     --pos.fParagraphIndex;
-                    const auto& newLine = fLines[pos.fParagraphIndex];
+                    const auto& newLine = this->shapedLine(pos.fParagraphIndex);
                     size_t r = newLine.fLineEndOffsets.size();
                     if (r > 0) {
                         pos.fTextByteIndex = find_closest_x(newLine.fCursorPos, x,
@@ -371,19 +459,21 @@ Editor::TextPosition Editor::move(Editor::Movement move, Editor::TextPosition po
             break;
         case Editor::Movement::kDown:
             {
-                const std::vector<size_t>& list = fLines[pos.fParagraphIndex].fLineEndOffsets;
-                float x = fLines[pos.fParagraphIndex].fCursorPos[pos.fTextByteIndex].left();
+                const TextLine& line = this->shapedLine(pos.fParagraphIndex);
+                const std::vector<size_t>& list = line.fLineEndOffsets;
+                float x = line.fCursorPos[pos.fTextByteIndex].left();
 
                 size_t f = find_first_larger(list, pos.fTextByteIndex);
                 if (f < list.size()) {
-                    const auto& bounds = fLines[pos.fParagraphIndex].fCursorPos;
+                    const auto& bounds = line.fCursorPos;
                     pos.fTextByteIndex = find_closest_x(bounds, x, list[f],
                                                         f + 1 < list.size() ? list[f + 1]
                                                                             : bounds.size());
                 } else if (pos.fParagraphIndex + 1 < fLines.size()) {
                     ++pos.fParagraphIndex;
-                    const auto& bounds = fLines[pos.fParagraphIndex].fCursorPos;
-                    const std::vector<size_t>& l2 = fLines[pos.fParagraphIndex].fLineEndOffsets;
+                    const TextLine& next = this->shapedLine(pos.fParagraphIndex);
+                    const auto& bounds = next.fCursorPos;
+                    const std::vector<size_t>& l2 = next.fLineEndOffsets;
                     pos.fTextByteIndex = find_closest_x(bounds, x, 0,
                                                         l2.size() > 0 ? l2[0] : bounds.size());
                 } else {
@@ -399,8 +489,9 @@ Editor::TextPosition Editor::move(Editor::Movement move, Editor::TextPosition po
                     pos = this->move(Editor::Movement::kLeft, pos);
                     break;
                 }
-                const std::vector<bool>& words = fLines[pos.fParagraphIndex].fWordBoundaries;
-                SkASSERT(words.size() == fLines[pos.fParagraphIndex].fText.size());
+                const TextLine& line = this->shapedLine(pos.fParagraphIndex);
+                const std::vector<bool>& words = line.fWordBoundaries;
+                SkASSERT(words.size() == line.fText.size());
                 do {
                     --pos.fTextByteIndex;
                 } while (pos.fTextByteIndex > 0 && !words[pos.fTextByteIndex]);
@@ -413,7 +504,8 @@ Editor::TextPosition Editor::move(Editor::Movement move, Editor::TextPosition po
                     pos = this->move(Editor::Movement::kRight, pos);
                     break;
                 }
-                const std::vector<bool>& words = fLines[pos.fParagraphIndex].fWordBoundaries;
+                const std::vector<bool>& words =
+                        this->shapedLine(pos.fParagraphIndex).fWordBoundaries;
                 SkASSERT(words.size() == text.size());
                 do {
                     ++pos.fTextByteIndex;
@@ -426,23 +518,43 @@ Editor::TextPosition Editor::move(Editor::Movement move, Editor::TextPosition po
 }
 
 void Editor::paint(SkCanvas* c, PaintOpts options) {
-    this->reshapeAll();
+    if (fLines.empty()) {
+        this->insertLines(0, 1);
+    }
     if (!c) {
         return;
     }
 
     c->drawPaint(SkPaint(options.fBackgroundColor));
 
+    // Shape the lines in view; shaping changes their heights, so walk down from the first one.
+    SkRect clip = c->getLocalClipBounds();
+    size_t firstLine = this->lineAt((int)std::floor(clip.top()));
+    firstLine = firstLine > 0 ? firstLine - 1 : 0;
+    size_t endLine = firstLine;
+    while (endLine < fLines.size() && (endLine == firstLine ||
+                                       this->origin(endLine).y() < clip.bottom())) {
+        this->shapedLine(endLine++);
+    }
+    if (endLine < fLines.size()) {
+        this->shapedLine(endLine++);
+    }
+
     SkPaint selection = SkPaint(options.fSelectionColor);
     auto cmp = [](const Editor::TextPosition& u, const Editor::TextPosition& v) { return u < v; };
-    for (TextPosition pos = std::min(options.fSelectionBegin, options.fSelectionEnd, cmp),
-                      end = std::max(options.fSelectionBegin, options.fSelectionEnd, cmp);
+    // Only the part of the selection which is in view is drawn.
+    TextPosition selectionBegin = std::min(options.fSelectionBegin, options.fSelectionEnd, cmp);
+    TextPosition selectionEnd = std::max(options.fSelectionBegin, options.fSelectionEnd, cmp);
+    for (TextPosition pos = std::max(selectionBegin, TextPosition{0, firstLine}, cmp),
+                      end = this->move(Editor::Movement::kNowhere,
+                                       std::min(selectionEnd, TextPosition{0, endLine}, cmp));
          pos < end;
          pos = this->move(Editor::Movement::kRight, pos))
     {
         SkASSERT(pos.fParagraphIndex < fLines.size());
         const TextLine& l = fLines[pos.fParagraphIndex];
-        c->drawRect(offset(l.fCursorPos[pos.fTextByteIndex], l.fOrigin), selection);
+        c->drawRect(offset(l.fCursorPos[pos.fTextByteIndex], this->origin(pos.fParagraphIndex)),
+                    selection);
     }
 
     if (fLines.size() > 0) {
@@ -450,63 +562,11 @@ void Editor::paint(SkCanvas* c, PaintOpts options) {
     }
 
     SkPaint foreground = SkPaint(options.fForegroundColor);
-    for (const TextLine& line : fLines) {
+    for (size_t i = firstLine; i < endLine; ++i) {
+        const TextLine& line = fLines[i];
         if (line.fBlob) {
-            c->drawTextBlob(line.fBlob.get(), line.fOrigin.x(), line.fOrigin.y(), foreground);
+            SkIPoint lineOrigin = this->origin(i);
+            c->drawTextBlob(line.fBlob.get(), lineOrigin.x(), lineOrigin.y(), foreground);
         }
     }
 }
-
-void Editor::reshapeAll() {
-    if (fNeedsReshape) {
-        if (fLines.empty()) {
-            fLines.push_back(TextLine());
-        }
-        float shape_width = (float)(fWidth);
-        #ifdef SK_EDITOR_GO_FAST
-        SkSemaphore semaphore;
-        std::unique_ptr<SkExecutor> executor = SkExecutor::MakeFIFOThreadPool(100);
-        int jobCount = 0;
-        for (TextLine& line : fLines) {
-            if (!line.fShaped) {
-                executor->add([&]() {
-                    ShapeResult result = Shape(line.fText.begin(), line.fText.size(),
-                                               fFont, fLocale, shape_width);
-                    line.fBlob           = std::move(result.blob);
-                    line.fLineEndOffsets = std::move(result.lineBreakOffsets);
-                    line.fCursorPos      = std::move(result.glyphBounds);
-                    line.fWordBoundaries = std::move(result.wordBreaks);
-                    line.fHeight         = result.verticalAdvance;
-                    line.fShaped = true;
-                    semaphore.signal();
-                }
-                ++jobCount;
-            });
-        }
-        while (jobCount-- > 0) { semaphore.wait(); }
-        #else
-        int i = 0;
-        for (TextLine& line : fLines) {
-            if (!line.fShaped) {
-                ShapeResult result = Shape(line.fText.begin(), line.fText.size(),
-                                           fFont, fLocale, shape_width);
-                line.fBlob           = std::move(result.blob);
-                line.fLineEndOffsets = std::move(result.lineBreakOffsets);
-                line.fCursorPos      = std::move(result.glyphBounds);
-                line.fWordBoundaries = std::move(result.wordBreaks);
-                line.fHeight         = result.verticalAdvance;
-                line.fShaped = true;
-            }
-            ++i;
-        }
-        #endif
-        int y = 0;
-        for (TextLine& line : fLines) {
-            line.fOrigin = {0, y};
-            y += line.fHeight;
-        }
-        fHeight = y;
-        fNeedsReshape = false;
-    }
-}
-
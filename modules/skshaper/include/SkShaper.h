@@ -13,6 +13,7 @@
 #include "include/core/SkRefCnt.h"
 #include "include/core/SkScalar.h"
 #include "include/core/SkTextBlob.h"
+#include "include/core/SkTypeface.h"
 #include "include/core/SkTypes.h"
 
 #include <memory>
@@ -48,11 +49,44 @@ class SkFontMgr;
  */
 class SKSHAPER_API SkShaper {
 public:
+    #ifdef SK_SHAPER_HARFBUZZ_AVAILABLE
+    /**
+     *  A thread safe, least recently used cache of shaped runs which may be shared by HarfBuzz
+     *  shapers. A run is keyed on its utf8 text and the surrounding context HarfBuzz looks at,
+     *  the font (typeface, size and all other settings), the features applying to it, script,
+     *  direction and language. Cached glyphs and positions are replayed through the RunHandler
+     *  exactly as if the run had been shaped again.
+     */
+    class SKSHAPER_API ShapeCache : public SkRefCnt {
+    public:
+        static constexpr int kDefaultMaxEntries = 4096;
+
+        explicit ShapeCache(int maxEntries = kDefaultMaxEntries);
+        ~ShapeCache() override;
+
+        /** Forgets all shaped runs. */
+        void purge();
+
+        int count() const;
+        int hits() const;
+        int misses() const;
+
+    private:
+        class Impl;
+        std::unique_ptr<Impl> fImpl;
+
+        friend class SkShapeCachePriv;
+    };
+    #endif
+
     static std::unique_ptr<SkShaper> MakePrimitive();
     #ifdef SK_SHAPER_HARFBUZZ_AVAILABLE
-    static std::unique_ptr<SkShaper> MakeShaperDrivenWrapper(sk_sp<SkFontMgr> = nullptr);
-    static std::unique_ptr<SkShaper> MakeShapeThenWrap(sk_sp<SkFontMgr> = nullptr);
-    static std::unique_ptr<SkShaper> MakeShapeDontWrapOrReorder(sk_sp<SkFontMgr> = nullptr);
+    static std::unique_ptr<SkShaper> MakeShaperDrivenWrapper(sk_sp<SkFontMgr> = nullptr,
+                                                             sk_sp<ShapeCache> = nullptr);
+    static std::unique_ptr<SkShaper> MakeShapeThenWrap(sk_sp<SkFontMgr> = nullptr,
+                                                       sk_sp<ShapeCache> = nullptr);
+    static std::unique_ptr<SkShaper> MakeShapeDontWrapOrReorder(sk_sp<SkFontMgr> = nullptr,
+                                                                sk_sp<ShapeCache> = nullptr);
     #endif
     // Returns nullptr if not supported
     static std::unique_ptr<SkShaper> MakeCoreText();
@@ -113,6 +147,38 @@ private:
     };
 
 public:
+    /**
+     *  A bounded, thread safe cache of SkFontMgr::matchFamilyStyleCharacter results.
+     *
+     *  Results are keyed on the font manager, requested family, style, languages and character,
+     *  so each is exactly what the font manager answered for that character. Font managers are
+     *  kept alive while the cache has entries for them; call purge() if a font manager's set of
+     *  fonts changes.
+     */
+    class SKSHAPER_API FontFallbackCache : public SkRefCnt {
+    public:
+        static constexpr int kDefaultMaxEntries = 1024;
+
+        explicit FontFallbackCache(int maxEntries = kDefaultMaxEntries);
+        ~FontFallbackCache() override;
+
+        sk_sp<SkTypeface> matchFamilyStyleCharacter(SkFontMgr*,
+                                                    const char familyName[], const SkFontStyle&,
+                                                    const char* bcp47[], int bcp47Count,
+                                                    SkUnichar character);
+
+        /** Forgets all results and releases the font managers they came from. */
+        void purge();
+
+        int count() const;
+        int hits() const;
+        int misses() const;
+
+    private:
+        class Impl;
+        std::unique_ptr<Impl> fImpl;
+    };
+
     static std::unique_ptr<FontRunIterator>
     MakeFontMgrRunIterator(const char* utf8, size_t utf8Bytes,
                            const SkFont& font, sk_sp<SkFontMgr> fallback);
@@ -121,6 +187,13 @@ public:
                            const SkFont& font, sk_sp<SkFontMgr> fallback,
                            const char* requestName, SkFontStyle requestStyle,
                            const SkShaper::LanguageRunIterator*);
+    /** As above, but fallback lookups go through the given cache when it is not null. */
+    static std::unique_ptr<SkShaper::FontRunIterator>
+    MakeFontMgrRunIterator(const char* utf8, size_t utf8Bytes,
+                           const SkFont& font, sk_sp<SkFontMgr> fallback,
+                           const char* requestName, SkFontStyle requestStyle,
+                           const SkShaper::LanguageRunIterator*,
+                           sk_sp<FontFallbackCache>);
     class TrivialFontRunIterator : public TrivialRunIterator<FontRunIterator> {
     public:
         TrivialFontRunIterator(const SkFont& font, size_t utf8Bytes)
@@ -11,11 +11,15 @@
 #include "include/core/SkFontStyle.h"
 #include "include/core/SkString.h"
 #include "include/core/SkTypeface.h"
+#include "include/private/SkMutex.h"
+#include "include/private/SkTArray.h"
 #include "include/private/SkTFitsIn.h"
 #include "modules/skshaper/include/SkShaper.h"
+#include "src/core/SkLRUCache.h"
 #include "src/core/SkTextBlobPriv.h"
 #include "src/utils/SkUTF.h"
 
+#include <algorithm>
 #include <limits.h>
 #include <string.h>
 #include <locale>
@@ -65,14 +69,128 @@ static inline SkUnichar utf8_next(const char** ptr, const char* end) {
     return val < 0 ? 0xFFFD : val;
 }
 
+class SkShaper::FontFallbackCache::Impl {
+public:
+    explicit Impl(int maxEntries) : fResults(maxEntries) {}
+
+    sk_sp<SkTypeface> match(SkFontMgr* fontMgr,
+                            const char familyName[], const SkFontStyle& style,
+                            const char* bcp47[], int bcp47Count,
+                            SkUnichar character)
+    {
+        // The font manager's address is part of the key, which is safe because the cache keeps
+        // every font manager it has results for alive.
+        SkString request;
+        request.appendf("%p|%d,%d,%d|", fontMgr, style.weight(), style.width(), style.slant());
+        for (int i = 0; i < bcp47Count; ++i) {
+            request.appendf("%s,", bcp47[i]);
+        }
+        request.appendf("|%c%s", familyName ? 'f' : 'n', familyName ? familyName : "");
+        // Only an answer for this very character is reused: a typeface found for a neighbor may
+        // cover it too, yet not be the one the font manager picks for it.
+        Key key{request, character};
+        {
+            SkAutoMutexExclusive lock(fMutex);
+            if (sk_sp<SkTypeface>* found = fResults.find(key)) {
+                ++fHits;
+                return *found;
+            }
+        }
+
+        sk_sp<SkTypeface> typeface(fontMgr->matchFamilyStyleCharacter(
+                familyName, style, bcp47, bcp47Count, character));
+
+        SkAutoMutexExclusive lock(fMutex);
+        ++fMisses;
+        if (std::none_of(fFontMgrs.begin(), fFontMgrs.end(),
+                         [fontMgr](const sk_sp<SkFontMgr>& mgr) { return mgr.get() == fontMgr; }))
+        {
+            fFontMgrs.push_back(sk_ref_sp(fontMgr));
+        }
+        this->insert(key, typeface);
+        return typeface;
+    }
+
+    void purge() {
+        SkAutoMutexExclusive lock(fMutex);
+        fResults.reset();
+        fFontMgrs.reset();
+    }
+
+    int count() const {
+        SkAutoMutexExclusive lock(fMutex);
+        return fResults.count();
+    }
+    int hits() const {
+        SkAutoMutexExclusive lock(fMutex);
+        return fHits;
+    }
+    int misses() const {
+        SkAutoMutexExclusive lock(fMutex);
+        return fMisses;
+    }
+
+private:
+    struct Key {
+        SkString fRequest;
+        SkUnichar fCharacter;
+
+        bool operator==(const Key& that) const {
+            return fCharacter == that.fCharacter && fRequest == that.fRequest;
+        }
+    };
+    struct KeyHash {
+        uint32_t operator()(const Key& key) const {
+            return SkGoodHash()(key.fRequest) ^ SkChecksum::Mix((uint32_t)key.fCharacter);
+        }
+    };
+
+    void insert(const Key& key, sk_sp<SkTypeface> typeface) {
+        fMutex.assertHeld();
+        // Another thread may have raced us here with the same answer.
+        if (!fResults.find(key)) {
+            fResults.insert(key, std::move(typeface));
+        }
+    }
+
+    mutable SkMutex fMutex;
+    // SkLRUCache::count() is not const.
+    mutable SkLRUCache<Key, sk_sp<SkTypeface>, KeyHash> fResults;
+    SkTArray<sk_sp<SkFontMgr>> fFontMgrs;
+    int fHits = 0;
+    int fMisses = 0;
+};
+
+SkShaper::FontFallbackCache::FontFallbackCache(int maxEntries)
+    : fImpl(std::make_unique<Impl>(maxEntries)) {}
+
+SkShaper::FontFallbackCache::~FontFallbackCache() = default;
+
+sk_sp<SkTypeface> SkShaper::FontFallbackCache::matchFamilyStyleCharacter(
+        SkFontMgr* fontMgr, const char familyName[], const SkFontStyle& style,
+        const char* bcp47[], int bcp47Count, SkUnichar character)
+{
+    if (!fontMgr) {
+        return nullptr;
+    }
+    return fImpl->match(fontMgr, familyName, style, bcp47, bcp47Count, character);
+}
+
+void SkShaper::FontFallbackCache::purge() { fImpl->purge(); }
+int SkShaper::FontFallbackCache::count() const { return fImpl->count(); }
+int SkShaper::FontFallbackCache::hits() const { return fImpl->hits(); }
+int SkShaper::FontFallbackCache::misses() const { return fImpl->misses(); }
+
 class FontMgrRunIterator final : public SkShaper::FontRunIterator {
 public:
     FontMgrRunIterator(const char* utf8, size_t utf8Bytes,
                        const SkFont& font, sk_sp<SkFontMgr> fallbackMgr,
                        const char* requestName, SkFontStyle requestStyle,
-                       const SkShaper::LanguageRunIterator* lang)
+                       const SkShaper::LanguageRunIterator* lang,
+                       sk_sp<SkShaper::FontFallbackCache> fallbackCache = nullptr)
         : fCurrent(utf8), fBegin(utf8), fEnd(fCurrent + utf8Bytes)
         , fFallbackMgr(std::move(fallbackMgr))
+        , fFallbackCache(std::move(fallbackCache))
         , fFont(font)
         , fFallbackFont(fFont)
         , fCurrentFont(nullptr)
@@ -84,9 +202,11 @@ public:
         fFallbackFont.setTypeface(nullptr);
     }
     FontMgrRunIterator(const char* utf8, size_t utf8Bytes,
-                       const SkFont& font, sk_sp<SkFontMgr> fallbackMgr)
+                       const SkFont& font, sk_sp<SkFontMgr> fallbackMgr,
+                       sk_sp<SkShaper::FontFallbackCache> fallbackCache = nullptr)
         : FontMgrRunIterator(utf8, utf8Bytes, font, std::move(fallbackMgr),
-                             nullptr, font.refTypefaceOrDefault()->fontStyle(), nullptr)
+                             nullptr, font.refTypefaceOrDefault()->fontStyle(), nullptr,
+                             std::move(fallbackCache))
     {}
 
     void consume() override {
@@ -101,10 +221,7 @@ public:
             fCurrentFont = &fFallbackFont;
         // If not, try to find a fallback typeface
         } else {
-            const char* language = fLanguage ? fLanguage->currentLanguage() : nullptr;
-            int languageCount = fLanguage ? 1 : 0;
-            sk_sp<SkTypeface> candidate(fFallbackMgr->matchFamilyStyleCharacter(
-                fRequestName, fRequestStyle, &language, languageCount, u));
+            sk_sp<SkTypeface> candidate(this->matchFallback(u));
             if (candidate) {
                 fFallbackFont.setTypeface(std::move(candidate));
                 fCurrentFont = &fFallbackFont;
@@ -125,10 +242,7 @@ public:
 
             // End run if current typeface does not have this character and some other font does.
             if (!fCurrentFont->unicharToGlyph(u)) {
-                const char* language = fLanguage ? fLanguage->currentLanguage() : nullptr;
-                int languageCount = fLanguage ? 1 : 0;
-                sk_sp<SkTypeface> candidate(fFallbackMgr->matchFamilyStyleCharacter(
-                    fRequestName, fRequestStyle, &language, languageCount, u));
+                sk_sp<SkTypeface> candidate(this->matchFallback(u));
                 if (candidate) {
                     fCurrent = prev;
                     return;
@@ -148,10 +262,22 @@ public:
     }
 
 private:
+    sk_sp<SkTypeface> matchFallback(SkUnichar u) const {
+        const char* language = fLanguage ? fLanguage->currentLanguage() : nullptr;
+        int languageCount = fLanguage ? 1 : 0;
+        if (fFallbackCache) {
+            return fFallbackCache->matchFamilyStyleCharacter(
+                fFallbackMgr.get(), fRequestName, fRequestStyle, &language, languageCount, u);
+        }
+        return sk_sp<SkTypeface>(fFallbackMgr->matchFamilyStyleCharacter(
+            fRequestName, fRequestStyle, &language, languageCount, u));
+    }
+
     char const * fCurrent;
     char const * const fBegin;
     char const * const fEnd;
     sk_sp<SkFontMgr> const fFallbackMgr;
+    sk_sp<SkShaper::FontFallbackCache> const fFallbackCache;
     SkFont fFont;
     SkFont fFallbackFont;
     SkFont* fCurrentFont;
@@ -177,6 +303,18 @@ SkShaper::MakeFontMgrRunIterator(const char* utf8, size_t utf8Bytes, const SkFon
                                                   requestName, requestStyle, language);
 }
 
+std::unique_ptr<SkShaper::FontRunIterator>
+SkShaper::MakeFontMgrRunIterator(const char* utf8, size_t utf8Bytes, const SkFont& font,
+                                 sk_sp<SkFontMgr> fallback,
+                                 const char* requestName, SkFontStyle requestStyle,
+                                 const SkShaper::LanguageRunIterator* language,
+                                 sk_sp<FontFallbackCache> fallbackCache)
+{
+    return std::make_unique<FontMgrRunIterator>(utf8, utf8Bytes, font, std::move(fallback),
+                                                  requestName, requestStyle, language,
+                                                  std::move(fallbackCache));
+}
+
 std::unique_ptr<SkShaper::LanguageRunIterator>
 SkShaper::MakeStdLanguageRunIterator(const char* utf8, size_t utf8Bytes) {
     return std::make_unique<TrivialLanguageRunIterator>(std::locale().name().c_str(), utf8Bytes);
@@ -16,15 +16,18 @@
 #include "include/core/SkRefCnt.h"
 #include "include/core/SkScalar.h"
 #include "include/core/SkStream.h"
+#include "include/core/SkString.h"
 #include "include/core/SkTypeface.h"
 #include "include/core/SkTypes.h"
 #include "include/private/SkBitmaskEnum.h"
 #include "include/private/SkMalloc.h"
+#include "include/private/SkMutex.h"
 #include "include/private/SkTArray.h"
 #include "include/private/SkTFitsIn.h"
 #include "include/private/SkTemplates.h"
 #include "include/private/SkTo.h"
 #include "modules/skshaper/include/SkShaper.h"
+#include "src/core/SkLRUCache.h"
 #include "src/core/SkSpan.h"
 #include "src/core/SkTDPQueue.h"
 #include "src/utils/SkUTF.h"
@@ -510,6 +513,81 @@ struct ShapedLine {
     SkVector fAdvance = { 0, 0 };
 };
 
+// The glyphs of a shaped run, with clusters relative to the start of the run.
+struct CachedRun : public SkNVRefCnt<CachedRun> {
+    std::unique_ptr<ShapedGlyph[]> fGlyphs;
+    size_t fNumGlyphs;
+    SkVector fAdvance;
+};
+
+}  // namespace
+
+class SkShaper::ShapeCache::Impl {
+public:
+    explicit Impl(int maxEntries) : fRuns(maxEntries) {}
+
+    sk_sp<CachedRun> find(const SkString& key) {
+        SkAutoMutexExclusive lock(fMutex);
+        if (sk_sp<CachedRun>* found = fRuns.find(key)) {
+            ++fHits;
+            return *found;
+        }
+        ++fMisses;
+        return nullptr;
+    }
+
+    void insert(const SkString& key, sk_sp<CachedRun> run) {
+        SkAutoMutexExclusive lock(fMutex);
+        // Another thread may have shaped the same run in the meantime.
+        if (!fRuns.find(key)) {
+            fRuns.insert(key, std::move(run));
+        }
+    }
+
+    void purge() {
+        SkAutoMutexExclusive lock(fMutex);
+        fRuns.reset();
+    }
+
+    int count() const {
+        SkAutoMutexExclusive lock(fMutex);
+        return fRuns.count();
+    }
+    int hits() const {
+        SkAutoMutexExclusive lock(fMutex);
+        return fHits;
+    }
+    int misses() const {
+        SkAutoMutexExclusive lock(fMutex);
+        return fMisses;
+    }
+
+private:
+    mutable SkMutex fMutex;
+    // SkLRUCache::count() is not const.
+    mutable SkLRUCache<SkString, sk_sp<CachedRun>> fRuns;
+    int fHits = 0;
+    int fMisses = 0;
+};
+
+class SkShapeCachePriv {
+public:
+    static SkShaper::ShapeCache::Impl* GetImpl(SkShaper::ShapeCache* cache) {
+        return cache->fImpl.get();
+    }
+};
+
+SkShaper::ShapeCache::ShapeCache(int maxEntries) : fImpl(std::make_unique<Impl>(maxEntries)) {}
+
+SkShaper::ShapeCache::~ShapeCache() = default;
+
+void SkShaper::ShapeCache::purge() { fImpl->purge(); }
+int SkShaper::ShapeCache::count() const { return fImpl->count(); }
+int SkShaper::ShapeCache::hits() const { return fImpl->hits(); }
+int SkShaper::ShapeCache::misses() const { return fImpl->misses(); }
+
+namespace {
+
 constexpr bool is_LTR(UBiDiLevel level) {
     return (level & 1) == 0;
 }
@@ -635,7 +713,8 @@ struct ShapedRunGlyphIterator {
 
 class ShaperHarfBuzz : public SkShaper {
 public:
-    ShaperHarfBuzz(HBBuffer, ICUBrk line, ICUBrk grapheme, sk_sp<SkFontMgr>);
+    ShaperHarfBuzz(HBBuffer, ICUBrk line, ICUBrk grapheme, sk_sp<SkFontMgr>,
+                   sk_sp<ShapeCache>);
 
 protected:
     ICUBrk fLineBreakIterator;
@@ -652,6 +731,10 @@ protected:
 private:
     const sk_sp<SkFontMgr> fFontMgr;
     HBBuffer               fBuffer;
+    // Fallback results are remembered across calls to shape.
+    const sk_sp<FontFallbackCache> fFallbackCache;
+    // May be null, in which case every run is shaped.
+    const sk_sp<ShapeCache> fShapeCache;
 
     void shape(const char* utf8, size_t utf8Bytes,
                const SkFont&,
@@ -732,7 +815,9 @@ private:
               RunHandler*) const override;
 };
 
-static std::unique_ptr<SkShaper> MakeHarfBuzz(sk_sp<SkFontMgr> fontmgr, bool correct) {
+static std::unique_ptr<SkShaper> MakeHarfBuzz(sk_sp<SkFontMgr> fontmgr,
+                                              sk_sp<SkShaper::ShapeCache> shapeCache,
+                                              bool correct) {
     #if defined(SK_USING_THIRD_PARTY_ICU)
     if (!SkLoadICU()) {
         SkDEBUGF("SkLoadICU() failed!\n");
@@ -762,21 +847,25 @@ static std::unique_ptr<SkShaper> MakeHarfBuzz(sk_sp<SkFontMgr> fontmgr, bool cor
         return std::make_unique<ShaperDrivenWrapper>(std::move(buffer),
                                                        std::move(lineBreakIterator),
                                                        std::move(graphemeBreakIterator),
-                                                       std::move(fontmgr));
+                                                       std::move(fontmgr),
+                                                       std::move(shapeCache));
     } else {
         return std::make_unique<ShapeThenWrap>(std::move(buffer),
                                                  std::move(lineBreakIterator),
                                                  std::move(graphemeBreakIterator),
-                                                 std::move(fontmgr));
+                                                 std::move(fontmgr),
+                                                 std::move(shapeCache));
     }
 }
 
 ShaperHarfBuzz::ShaperHarfBuzz(HBBuffer buffer, ICUBrk line, ICUBrk grapheme,
-                               sk_sp<SkFontMgr> fontmgr)
+                               sk_sp<SkFontMgr> fontmgr, sk_sp<ShapeCache> shapeCache)
     : fLineBreakIterator(std::move(line))
     , fGraphemeBreakIterator(std::move(grapheme))
     , fFontMgr(std::move(fontmgr))
     , fBuffer(std::move(buffer))
+    , fFallbackCache(sk_make_sp<FontFallbackCache>())
+    , fShapeCache(std::move(shapeCache))
 {}
 
 void ShaperHarfBuzz::shape(const char* utf8, size_t utf8Bytes,
@@ -804,7 +893,9 @@ void ShaperHarfBuzz::shape(const char* utf8, size_t utf8Bytes,
 
     std::unique_ptr<FontRunIterator> font(
                 MakeFontMgrRunIterator(utf8, utf8Bytes, srcFont,
-                                       fFontMgr ? fFontMgr : SkFontMgr::RefDefault()));
+                                       fFontMgr ? fFontMgr : SkFontMgr::RefDefault(),
+                                       nullptr, srcFont.refTypefaceOrDefault()->fontStyle(),
+                                       nullptr, fFallbackCache));
     if (!font) {
         return;
     }
@@ -1274,6 +1365,78 @@ void ShapeDontWrapOrReorder::wrap(char const * const utf8, size_t utf8Bytes,
     handler->commitLine();
 }
 
+template <typename T> void append_key(SkString* key, const T& value) {
+    key->append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void append_key_text(SkString* key, const char* begin, const char* end) {
+    append_key(key, SkToU32(end - begin));
+    key->append(begin, end - begin);
+}
+
+// Describes everything which can influence the result of shaping utf8Start to utf8End.
+SkString make_shape_key(const char* utf8, size_t utf8Bytes,
+                        const char* utf8Start, const char* utf8End,
+                        UBiDiLevel level, const char* language, SkFourByteTag script,
+                        const SkFont& font,
+                        const SkShaper::Feature* features, size_t featuresSize) {
+    // HarfBuzz looks at no more than this many code points on either side of the run.
+    constexpr int kContextLength = 5;  // HB_BUFFER_CONTEXT_LENGTH
+
+    const char* contextStart = utf8Start;
+    for (int i = 0; i < kContextLength && utf8 < contextStart; ++i) {
+        do {
+            --contextStart;
+        } while (utf8 < contextStart && (*contextStart & 0xC0) == 0x80);
+    }
+    const char* contextEnd = utf8End;
+    for (int i = 0; i < kContextLength && contextEnd < utf8 + utf8Bytes; ++i) {
+        utf8_next(&contextEnd, utf8 + utf8Bytes);
+    }
+
+    SkString key;
+    append_key_text(&key, utf8Start, utf8End);
+    append_key_text(&key, contextStart, utf8Start);
+    append_key_text(&key, utf8End, contextEnd);
+
+    append_key(&key, font.getTypefaceOrDefault()->uniqueID());
+    append_key(&key, font.getSize());
+    append_key(&key, font.getScaleX());
+    append_key(&key, font.getSkewX());
+    append_key(&key, font.getEdging());
+    append_key(&key, font.getHinting());
+    uint8_t flags = (font.isForceAutoHinting() << 0) |
+                    (font.isEmbeddedBitmaps()  << 1) |
+                    (font.isSubpixel()         << 2) |
+                    (font.isLinearMetrics()    << 3) |
+                    (font.isEmbolden()         << 4) |
+                    (font.isBaselineSnap()     << 5);
+    append_key(&key, flags);
+
+    append_key(&key, is_LTR(level));
+    append_key(&key, script);
+    key.append(language ? language : "");
+    key.append("", 1);
+
+    // Features are recorded the way shape() will hand them to HarfBuzz, relative to the run.
+    size_t runStart = utf8Start - utf8;
+    size_t runEnd = utf8End - utf8;
+    for (const auto& feature : SkMakeSpan(features, featuresSize)) {
+        if (feature.end < runStart || runEnd <= feature.start) {
+            continue;
+        }
+        append_key(&key, feature.tag);
+        append_key(&key, feature.value);
+        bool global = feature.start <= runStart && runEnd <= feature.end;
+        append_key(&key, global);
+        if (!global) {
+            append_key(&key, static_cast<int64_t>(feature.start - runStart));
+            append_key(&key, static_cast<int64_t>(feature.end - runStart));
+        }
+    }
+    return key;
+}
+
 ShapedRun ShaperHarfBuzz::shape(char const * const utf8,
                                   size_t const utf8Bytes,
                                   char const * const utf8Start,
@@ -1288,6 +1451,27 @@ ShapedRun ShaperHarfBuzz::shape(char const * const utf8,
     ShapedRun run(RunHandler::Range(utf8Start - utf8, utf8runLength),
                   font.currentFont(), bidi.currentLevel(), nullptr, 0);
 
+    SkShaper::ShapeCache::Impl* cache =
+            fShapeCache ? SkShapeCachePriv::GetImpl(fShapeCache.get()) : nullptr;
+    SkString cacheKey;
+    if (cache) {
+        cacheKey = make_shape_key(utf8, utf8Bytes, utf8Start, utf8End,
+                                  bidi.currentLevel(), language.currentLanguage(),
+                                  script.currentScript(), font.currentFont(),
+                                  features, featuresSize);
+        if (sk_sp<CachedRun> cached = cache->find(cacheKey)) {
+            run = ShapedRun(RunHandler::Range(utf8Start - utf8, utf8runLength),
+                            font.currentFont(), bidi.currentLevel(),
+                            std::unique_ptr<ShapedGlyph[]>(new ShapedGlyph[cached->fNumGlyphs]),
+                            cached->fNumGlyphs, cached->fAdvance);
+            for (size_t i = 0; i < cached->fNumGlyphs; ++i) {
+                run.fGlyphs[i] = cached->fGlyphs[i];
+                run.fGlyphs[i].fCluster += utf8Start - utf8;
+            }
+            return run;
+        }
+    }
+
     hb_buffer_t* buffer = fBuffer.get();
     SkAutoTCallVProc<hb_buffer_t, hb_buffer_clear_contents> autoClearBuffer(buffer);
     hb_buffer_set_content_type(buffer, HB_BUFFER_CONTENT_TYPE_UNICODE);
@@ -1389,6 +1573,18 @@ ShapedRun ShaperHarfBuzz::shape(char const * const utf8,
     }
     run.fAdvance = runAdvance;
 
+    if (cache) {
+        sk_sp<CachedRun> cached = sk_make_sp<CachedRun>();
+        cached->fGlyphs.reset(new ShapedGlyph[len]);
+        cached->fNumGlyphs = len;
+        cached->fAdvance = runAdvance;
+        for (unsigned i = 0; i < len; ++i) {
+            cached->fGlyphs[i] = run.fGlyphs[i];
+            cached->fGlyphs[i].fCluster -= utf8Start - utf8;
+        }
+        cache->insert(cacheKey, std::move(cached));
+    }
+
     return run;
 }
 
@@ -1439,13 +1635,16 @@ SkShaper::MakeHbIcuScriptRunIterator(const char* utf8, size_t utf8Bytes) {
     return std::make_unique<HbIcuScriptRunIterator>(utf8, utf8Bytes);
 }
 
-std::unique_ptr<SkShaper> SkShaper::MakeShaperDrivenWrapper(sk_sp<SkFontMgr> fontmgr) {
-    return MakeHarfBuzz(std::move(fontmgr), true);
+std::unique_ptr<SkShaper> SkShaper::MakeShaperDrivenWrapper(sk_sp<SkFontMgr> fontmgr,
+                                                           sk_sp<ShapeCache> shapeCache) {
+    return MakeHarfBuzz(std::move(fontmgr), std::move(shapeCache), true);
 }
-std::unique_ptr<SkShaper> SkShaper::MakeShapeThenWrap(sk_sp<SkFontMgr> fontmgr) {
-    return MakeHarfBuzz(std::move(fontmgr), false);
+std::unique_ptr<SkShaper> SkShaper::MakeShapeThenWrap(sk_sp<SkFontMgr> fontmgr,
+                                                     sk_sp<ShapeCache> shapeCache) {
+    return MakeHarfBuzz(std::move(fontmgr), std::move(shapeCache), false);
 }
-std::unique_ptr<SkShaper> SkShaper::MakeShapeDontWrapOrReorder(sk_sp<SkFontMgr> fontmgr) {
+std::unique_ptr<SkShaper> SkShaper::MakeShapeDontWrapOrReorder(sk_sp<SkFontMgr> fontmgr,
+                                                              sk_sp<ShapeCache> shapeCache) {
     #if defined(SK_USING_THIRD_PARTY_ICU)
     if (!SkLoadICU()) {
         SkDEBUGF("SkLoadICU() failed!\n");
@@ -1459,5 +1658,6 @@ std::unique_ptr<SkShaper> SkShaper::MakeShapeDontWrapOrReorder(sk_sp<SkFontMgr>
     }
 
     return std::make_unique<ShapeDontWrapOrReorder>(std::move(buffer), nullptr, nullptr,
-                                                      std::move(fontmgr));
+                                                      std::move(fontmgr),
+                                                      std::move(shapeCache));
 }
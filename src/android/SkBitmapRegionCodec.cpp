@@ -10,9 +10,11 @@
 #include "src/android/SkBitmapRegionDecoderPriv.h"
 #include "src/codec/SkCodecPriv.h"
 
-SkBitmapRegionCodec::SkBitmapRegionCodec(SkAndroidCodec* codec)
+SkBitmapRegionCodec::SkBitmapRegionCodec(SkAndroidCodec* codec,
+                                         std::unique_ptr<SkImageGenerator> tiles)
     : INHERITED(codec->getInfo().width(), codec->getInfo().height())
     , fCodec(codec)
+    , fTiles(std::move(tiles))
 {}
 
 bool SkBitmapRegionCodec::decodeRegion(SkBitmap* bitmap, SkBRDAllocator* allocator,
@@ -97,11 +99,17 @@ bool SkBitmapRegionCodec::decodeRegion(SkBitmap* bitmap, SkBRDAllocator* allocat
     }
 
     // Decode into the destination bitmap
+    void* dst = bitmap->getAddr(scaledOutX, scaledOutY);
+    // Tiles are premultiplied, so unpremultiplied regions are decoded directly.
+    if (fTiles && 1 == sampleSize && kUnpremul_SkAlphaType != dstAlphaType &&
+            fTiles->getPixels(decodeInfo, dst, bitmap->rowBytes(), subset.topLeft())) {
+        return true;
+    }
+
     SkAndroidCodec::AndroidOptions options;
     options.fSampleSize = sampleSize;
     options.fSubset = &subset;
     options.fZeroInitialized = zeroInit;
-    void* dst = bitmap->getAddr(scaledOutX, scaledOutY);
 
     SkCodec::Result result = fCodec->getAndroidPixels(decodeInfo, dst, bitmap->rowBytes(),
             &options);
@@ -11,6 +11,7 @@
 #include "include/android/SkBitmapRegionDecoder.h"
 #include "include/codec/SkAndroidCodec.h"
 #include "include/core/SkBitmap.h"
+#include "include/core/SkImageGenerator.h"
 
 /*
  * This class implements SkBitmapRegionDecoder using an SkAndroidCodec.
@@ -20,8 +21,10 @@ public:
 
     /*
      * Takes ownership of pointer to codec
+     *
+     * If tiles is not null, it decodes the unscaled regions.
      */
-    SkBitmapRegionCodec(SkAndroidCodec* codec);
+    SkBitmapRegionCodec(SkAndroidCodec* codec, std::unique_ptr<SkImageGenerator> tiles = nullptr);
 
     bool decodeRegion(SkBitmap* bitmap, SkBRDAllocator* allocator,
                       const SkIRect& desiredSubset, int sampleSize,
@@ -42,6 +45,7 @@ public:
 private:
 
     std::unique_ptr<SkAndroidCodec> fCodec;
+    std::unique_ptr<SkImageGenerator> fTiles;
 
     typedef SkBitmapRegionDecoder INHERITED;
 
@@ -10,6 +10,20 @@
 #include "include/codec/SkCodec.h"
 #include "src/android/SkBitmapRegionCodec.h"
 #include "src/codec/SkCodecPriv.h"
+#include "src/codec/SkTiledImageGenerator.h"
+#include "src/core/SkStreamPriv.h"
+
+static bool supports_regions(SkEncodedImageFormat format) {
+    switch (format) {
+        case SkEncodedImageFormat::kJPEG:
+        case SkEncodedImageFormat::kPNG:
+        case SkEncodedImageFormat::kWEBP:
+        case SkEncodedImageFormat::kHEIF:
+            return true;
+        default:
+            return false;
+    }
+}
 
 SkBitmapRegionDecoder* SkBitmapRegionDecoder::Create(
         sk_sp<SkData> data, Strategy strategy) {
@@ -28,18 +42,28 @@ SkBitmapRegionDecoder* SkBitmapRegionDecoder::Create(
                 return nullptr;
             }
 
-            switch ((SkEncodedImageFormat)codec->getEncodedFormat()) {
-                case SkEncodedImageFormat::kJPEG:
-                case SkEncodedImageFormat::kPNG:
-                case SkEncodedImageFormat::kWEBP:
-                case SkEncodedImageFormat::kHEIF:
-                    break;
-                default:
-                    return nullptr;
+            if (!supports_regions(codec->getEncodedFormat())) {
+                return nullptr;
             }
 
             return new SkBitmapRegionCodec(codec.release());
         }
+        case kTiledCache_Strategy: {
+            // The codec and the tiles each decode the data, so it must be in memory.
+            sk_sp<SkData> data = SkCopyStreamToData(streamDeleter.get());
+            auto codec = SkAndroidCodec::MakeFromData(data);
+            auto tiles = SkTiledImageGenerator::Make(data);
+            if (nullptr == codec || nullptr == tiles) {
+                SkCodecPrintf("Error: Failed to create codec.\n");
+                return nullptr;
+            }
+
+            if (!supports_regions(codec->getEncodedFormat())) {
+                return nullptr;
+            }
+
+            return new SkBitmapRegionCodec(codec.release(), std::move(tiles));
+        }
         default:
             SkASSERT(false);
             return nullptr;
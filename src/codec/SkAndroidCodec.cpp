@@ -11,6 +11,7 @@
 #include "src/codec/SkAndroidCodecAdapter.h"
 #include "src/codec/SkCodecPriv.h"
 #include "src/codec/SkSampledCodec.h"
+#include "src/codec/SkStreamingDownscaler.h"
 #include "src/core/SkPixmapPriv.h"
 
 static bool is_valid_sample_size(int sampleSize) {
@@ -386,13 +387,22 @@ SkCodec::Result SkAndroidCodec::getAndroidPixels(const SkImageInfo& requestInfo,
         }
     }
 
+    auto decodeOriented = [this, options](const SkPixmap& pm) {
+        if (DownscaleFilter::kPointSample != options->fDownscaleFilter) {
+            return SkStreamingDownscaler::Decode(fCodec.get(), pm, options->fSubset,
+                                                 options->fZeroInitialized,
+                                                 options->fDownscaleFilter);
+        }
+        return this->onGetAndroidPixels(pm.info(), pm.writable_addr(), pm.rowBytes(), *options);
+    };
+
     if (ExifOrientationBehavior::kIgnore == fOrientationBehavior) {
-        return this->onGetAndroidPixels(requestInfo, requestPixels, requestRowBytes, *options);
+        return decodeOriented(SkPixmap(requestInfo, requestPixels, requestRowBytes));
     }
 
     SkCodec::Result result;
-    auto decode = [this, options, &result](const SkPixmap& pm) {
-        result = this->onGetAndroidPixels(pm.info(), pm.writable_addr(), pm.rowBytes(), *options);
+    auto decode = [&decodeOriented, &result](const SkPixmap& pm) {
+        result = decodeOriented(pm);
         return acceptable_result(result);
     };
 
@@ -7,6 +7,7 @@
 
 #include "include/core/SkYUVAIndex.h"
 #include "src/codec/SkCodecImageGenerator.h"
+#include "src/codec/SkStreamingDownscaler.h"
 #include "src/core/SkPixmapPriv.h"
 
 std::unique_ptr<SkImageGenerator> SkCodecImageGenerator::MakeFromEncodedCodec(sk_sp<SkData> data) {
@@ -51,7 +52,15 @@ bool SkCodecImageGenerator::onGetPixels(const SkImageInfo& requestInfo, void* re
     SkPixmap dst(requestInfo, requestPixels, requestRowBytes);
 
     auto decode = [this](const SkPixmap& pm) {
-        SkCodec::Result result = fCodec->getPixels(pm);
+        // Smaller requests are filtered down as they decode, unless the codec scales natively.
+        const SkISize size = fCodec->dimensions();
+        const bool downscale = pm.dimensions() != size && pm.width() <= size.width()
+                                                       && pm.height() <= size.height();
+        SkCodec::Result result = downscale
+                ? SkStreamingDownscaler::Decode(fCodec.get(), pm, nullptr,
+                                                SkCodec::kNo_ZeroInitialized,
+                                                SkAndroidCodec::DownscaleFilter::kTriangle)
+                : fCodec->getPixels(pm);
         switch (result) {
             case SkCodec::kSuccess:
             case SkCodec::kIncompleteInput:
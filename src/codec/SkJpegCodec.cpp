@@ -8,6 +8,8 @@
 #include "src/codec/SkJpegCodec.h"
 
 #include "include/codec/SkCodec.h"
+#include "include/core/SkData.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkStream.h"
 #include "include/core/SkTypes.h"
 #include "include/private/SkColorData.h"
@@ -15,9 +17,14 @@
 #include "include/private/SkTo.h"
 #include "src/codec/SkCodecPriv.h"
 #include "src/codec/SkJpegDecoderMgr.h"
+#include "src/codec/SkJpegRestartIndex.h"
 #include "src/codec/SkParseEncodedOrigin.h"
+#include "src/core/SkTaskGroup.h"
 #include "src/pdf/SkJpegInfo.h"
 
+#include <algorithm>
+#include <atomic>
+
 // stdio is needed for libjpeg-turbo
 #include <stdio.h>
 #include "src/codec/SkJpegUtility.h"
@@ -444,44 +451,51 @@ bool SkJpegCodec::onDimensionsSupported(const SkISize& size) {
 
 int SkJpegCodec::readRows(const SkImageInfo& dstInfo, void* dst, size_t rowBytes, int count,
                           const Options& opts) {
+    return this->readRows(fDecoderMgr.get(), fSwizzleSrcRow, fColorXformSrcRow,
+                          dstInfo, dst, rowBytes, count, opts);
+}
+
+int SkJpegCodec::readRows(JpegDecoderMgr* decoderMgr, uint8_t* swizzleSrcRow,
+                          uint32_t* colorXformSrcRow, const SkImageInfo& dstInfo, void* dst,
+                          size_t rowBytes, int count, const Options& opts) {
     // Set the jump location for libjpeg-turbo errors
-    skjpeg_error_mgr::AutoPushJmpBuf jmp(fDecoderMgr->errorMgr());
+    skjpeg_error_mgr::AutoPushJmpBuf jmp(decoderMgr->errorMgr());
     if (setjmp(jmp)) {
         return 0;
     }
 
-    // When fSwizzleSrcRow is non-null, it means that we need to swizzle.  In this case,
-    // we will always decode into fSwizzlerSrcRow before swizzling into the next buffer.
+    // When swizzleSrcRow is non-null, it means that we need to swizzle.  In this case,
+    // we will always decode into swizzleSrcRow before swizzling into the next buffer.
     // We can never swizzle "in place" because the swizzler may perform sampling and/or
     // subsetting.
-    // When fColorXformSrcRow is non-null, it means that we need to color xform and that
+    // When colorXformSrcRow is non-null, it means that we need to color xform and that
     // we cannot color xform "in place" (many times we can, but not when the src and dst
     // are different sizes).
-    // In this case, we will color xform from fColorXformSrcRow into the dst.
+    // In this case, we will color xform from colorXformSrcRow into the dst.
     JSAMPLE* decodeDst = (JSAMPLE*) dst;
     uint32_t* swizzleDst = (uint32_t*) dst;
     size_t decodeDstRowBytes = rowBytes;
     size_t swizzleDstRowBytes = rowBytes;
     int dstWidth = opts.fSubset ? opts.fSubset->width() : dstInfo.width();
-    if (fSwizzleSrcRow && fColorXformSrcRow) {
-        decodeDst = (JSAMPLE*) fSwizzleSrcRow;
-        swizzleDst = fColorXformSrcRow;
+    if (swizzleSrcRow && colorXformSrcRow) {
+        decodeDst = (JSAMPLE*) swizzleSrcRow;
+        swizzleDst = colorXformSrcRow;
         decodeDstRowBytes = 0;
         swizzleDstRowBytes = 0;
         dstWidth = fSwizzler->swizzleWidth();
-    } else if (fColorXformSrcRow) {
-        decodeDst = (JSAMPLE*) fColorXformSrcRow;
-        swizzleDst = fColorXformSrcRow;
+    } else if (colorXformSrcRow) {
+        decodeDst = (JSAMPLE*) colorXformSrcRow;
+        swizzleDst = colorXformSrcRow;
         decodeDstRowBytes = 0;
         swizzleDstRowBytes = 0;
-    } else if (fSwizzleSrcRow) {
-        decodeDst = (JSAMPLE*) fSwizzleSrcRow;
+    } else if (swizzleSrcRow) {
+        decodeDst = (JSAMPLE*) swizzleSrcRow;
         decodeDstRowBytes = 0;
         dstWidth = fSwizzler->swizzleWidth();
     }
 
     for (int y = 0; y < count; y++) {
-        uint32_t lines = jpeg_read_scanlines(fDecoderMgr->dinfo(), &decodeDst, 1);
+        uint32_t lines = jpeg_read_scanlines(decoderMgr->dinfo(), &decodeDst, 1);
         if (0 == lines) {
             return y;
         }
@@ -557,6 +571,10 @@ SkCodec::Result SkJpegCodec::onGetPixels(const SkImageInfo& dstInfo,
         return kInternalError;
     }
 
+    if (options.fExecutor && this->decodeInParallel(dstInfo, dst, dstRowBytes, options)) {
+        return kSuccess;
+    }
+
     int rows = this->readRows(dstInfo, dst, dstRowBytes, dstInfo.height(), options);
     if (rows < dstInfo.height()) {
         *rowsDecoded = rows;
@@ -566,6 +584,118 @@ SkCodec::Result SkJpegCodec::onGetPixels(const SkImageInfo& dstInfo,
     return kSuccess;
 }
 
+bool SkJpegCodec::decodeInParallel(const SkImageInfo& dstInfo, void* dst, size_t rowBytes,
+                                   const Options& options) {
+    const jpeg_decompress_struct* dinfo = fDecoderMgr->dinfo();
+    if (0 == dinfo->restart_interval || dinfo->progressive_mode) {
+        return false;
+    }
+
+    // The bands are cut out of the encoded data, so it must all be in memory already.
+    SkStream* stream = this->stream();
+    if (!stream->hasLength() || !stream->getMemoryBase()) {
+        return false;
+    }
+    auto index = SkJpegRestartIndex::Make(
+            SkData::MakeWithoutCopy(stream->getMemoryBase(), stream->getLength()));
+    if (!index) {
+        return false;
+    }
+
+    // Output rows per row of MCUs, which must be whole for the bands to line up.
+    const int mcuHeight = index->mcuHeight() * dinfo->scale_num;
+    if (mcuHeight % dinfo->scale_denom) {
+        return false;
+    }
+    const int outputRows = mcuHeight / dinfo->scale_denom;
+
+    // Give each band enough units that decoding the extra unit on either side of it (below)
+    // costs little.
+    constexpr int kMinUnitsPerBand = 8;
+    constexpr int kMaxBands = 16;
+    const int unit = index->rowsPerUnit(),
+              units = (index->mcuRows() + unit - 1) / unit,
+              bandCount = std::min(units / kMinUnitsPerBand, kMaxBands);
+    if (bandCount < 2) {
+        return false;
+    }
+
+    std::atomic<bool> failed{false};
+    SkTaskGroup(*options.fExecutor).batch(bandCount, [&](int i) {
+        const int startRow = units *  i      / bandCount * unit,
+                  endRow   = std::min(units * (i + 1) / bandCount * unit, index->mcuRows());
+
+        // Fancy upsampling of the chroma rows at the edges of a band looks at the rows on the
+        // other side, so decode an extra unit above and below and only keep the rows in between.
+        const int decodeStart = std::max(startRow - unit, 0),
+                  decodeEnd   = std::min(endRow + unit, index->mcuRows());
+
+        const int dstTop    = startRow * outputRows,
+                  dstBottom = endRow == index->mcuRows() ? dstInfo.height() : endRow * outputRows;
+        if (!this->decodeBand(index->makeBand(decodeStart, decodeEnd),
+                              (startRow - decodeStart) * outputRows, dstInfo,
+                              SkTAddOffset<void>(dst, dstTop * rowBytes), rowBytes,
+                              dstBottom - dstTop, options)) {
+            failed = true;
+        }
+    });
+    return !failed;
+}
+
+bool SkJpegCodec::decodeBand(sk_sp<SkData> band, int skipRows, const SkImageInfo& dstInfo,
+                             void* dst, size_t rowBytes, int count, const Options& options) {
+    if (!band) {
+        return false;
+    }
+    jpeg_decompress_struct* settings = fDecoderMgr->dinfo();
+
+    // Each band decodes, swizzles and color xforms into its own rows.
+    const size_t decodeBytes = SkAlign4(get_row_bytes(settings));
+    size_t xformBytes = 0;
+    if (fColorXformSrcRow) {
+        xformBytes = (fSwizzler ? fSwizzler->swizzleWidth() : dstInfo.width()) * sizeof(uint32_t);
+    }
+    SkAutoTMalloc<uint8_t> storage(decodeBytes + xformBytes);
+    uint8_t* swizzleSrcRow = fSwizzleSrcRow ? storage.get() : nullptr;
+    uint32_t* colorXformSrcRow = fColorXformSrcRow ?
+            SkTAddOffset<uint32_t>(storage.get(), decodeBytes) : nullptr;
+
+    SkMemoryStream stream(std::move(band));
+    JpegDecoderMgr decoderMgr(&stream);
+
+    // Set the jump location for libjpeg errors
+    skjpeg_error_mgr::AutoPushJmpBuf jmp(decoderMgr.errorMgr());
+    if (setjmp(jmp)) {
+        return false;
+    }
+
+    decoderMgr.init();
+    jpeg_decompress_struct* dinfo = decoderMgr.dinfo();
+    if (JPEG_HEADER_OK != jpeg_read_header(dinfo, true)) {
+        return false;
+    }
+    dinfo->out_color_space = settings->out_color_space;
+    dinfo->scale_num = settings->scale_num;
+    dinfo->scale_denom = settings->scale_denom;
+    dinfo->dct_method = settings->dct_method;
+    dinfo->dither_mode = settings->dither_mode;
+    dinfo->do_fancy_upsampling = settings->do_fancy_upsampling;
+    if (!jpeg_start_decompress(dinfo) || dinfo->output_width != settings->output_width) {
+        return false;
+    }
+
+    // Read, rather than jpeg_skip_scanlines(), the rows above the band, so that they set up the
+    // upsampling context exactly as they would in a serial decode.
+    JSAMPLE* skipDst = storage.get();
+    for (int y = 0; y < skipRows; y++) {
+        if (0 == jpeg_read_scanlines(dinfo, &skipDst, 1)) {
+            return false;
+        }
+    }
+    return count == this->readRows(&decoderMgr, swizzleSrcRow, colorXformSrcRow, dstInfo, dst,
+                                   rowBytes, count, options);
+}
+
 bool SkJpegCodec::allocateStorage(const SkImageInfo& dstInfo) {
     int dstWidth = dstInfo.width();
 
@@ -108,6 +108,22 @@ private:
                             bool needsCMYKToRGB);
     bool SK_WARN_UNUSED_RESULT allocateStorage(const SkImageInfo& dstInfo);
     int readRows(const SkImageInfo& dstInfo, void* dst, size_t rowBytes, int count, const Options&);
+    int readRows(JpegDecoderMgr*, uint8_t* swizzleSrcRow, uint32_t* colorXformSrcRow,
+                 const SkImageInfo& dstInfo, void* dst, size_t rowBytes, int count,
+                 const Options&);
+
+    /*
+     * Splits the image into bands of rows at its restart markers and decodes them in parallel
+     * on options.fExecutor.  Expects jpeg_start_decompress() to have been called on
+     * fDecoderMgr, and the swizzler and storage to be set up for dstInfo.
+     *
+     * Returns false if the image cannot be split or a band fails to decode, in which case the
+     * caller should fall back to decoding all of dst serially.
+     */
+    bool decodeInParallel(const SkImageInfo& dstInfo, void* dst, size_t rowBytes,
+                          const Options& options);
+    bool decodeBand(sk_sp<SkData> band, int skipRows, const SkImageInfo& dstInfo, void* dst,
+                    size_t rowBytes, int count, const Options& options);
 
     /*
      * Scanline decoding.
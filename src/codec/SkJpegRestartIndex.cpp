@@ -0,0 +1,221 @@
+/*
+ * Copyright 2020 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "src/codec/SkJpegRestartIndex.h"
+
+#include "include/private/SkTo.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <numeric>
+
+namespace {
+    constexpr uint8_t kSOF0 = 0xC0,  // Baseline
+                      kSOF1 = 0xC1,  // Extended sequential, Huffman coded
+                      kDHT  = 0xC4,
+                      kRST0 = 0xD0,
+                      kRST7 = 0xD7,
+                      kSOI  = 0xD8,
+                      kEOI  = 0xD9,
+                      kSOS  = 0xDA,
+                      kDRI  = 0xDD,
+                      kAPP0 = 0xE0,  // JFIF, which may tell how to interpret the color channels.
+                      kAPP1 = 0xE1,
+                      kAPP13 = 0xED,
+                      kAPP14 = 0xEE, // Adobe, which may tell how to interpret the color channels.
+                      kAPP15 = 0xEF,
+                      kCOM  = 0xFE;
+
+    uint16_t read_be16(const uint8_t* p) { return (uint16_t)(p[0] << 8 | p[1]); }
+
+    std::atomic<int> gBandsMade{0};
+}  // namespace
+
+int SkJpegRestartIndex::BandsMadeForTesting() {
+    return gBandsMade.load(std::memory_order_relaxed);
+}
+
+std::unique_ptr<SkJpegRestartIndex> SkJpegRestartIndex::Make(sk_sp<SkData> data) {
+    if (!data) {
+        return nullptr;
+    }
+    const uint8_t* bytes = data->bytes();
+    const size_t size = data->size();
+    if (size < 4 || bytes[0] != 0xFF || bytes[1] != kSOI) {
+        return nullptr;
+    }
+
+    std::unique_ptr<SkJpegRestartIndex> index(new SkJpegRestartIndex);
+    index->fHeader.append(2, bytes);
+
+    // Copy the headers, remembering what we need from the SOF, DRI and SOS segments.
+    int width = 0, height = 0, components = 0, maxH = 1, maxV = 1, scanComponents = 0;
+    size_t pos = 2;
+    for (;;) {
+        if (pos >= size || bytes[pos] != 0xFF) {
+            return nullptr;
+        }
+        while (pos < size && bytes[pos] == 0xFF) {
+            pos++;  // Markers may be preceded by any number of fill bytes.
+        }
+        if (pos + 3 > size) {
+            return nullptr;
+        }
+        const uint8_t marker = bytes[pos++];
+        const size_t length = read_be16(bytes + pos);
+        if (length < 2 || pos + length > size) {
+            return nullptr;
+        }
+        const uint8_t* segment = bytes + pos + 2;
+        const size_t segmentSize = length - 2;
+
+        switch (marker) {
+            case kSOF0:
+            case kSOF1:
+                if (segmentSize < 6) {
+                    return nullptr;
+                }
+                height = read_be16(segment + 1);
+                width = read_be16(segment + 3);
+                components = segment[5];
+                if (segmentSize < 6 + 3 * (size_t)components) {
+                    return nullptr;
+                }
+                for (int i = 0; i < components; i++) {
+                    maxH = std::max(maxH, segment[6 + 3 * i + 1] >> 4);
+                    maxV = std::max(maxV, segment[6 + 3 * i + 1] & 0xF);
+                }
+                index->fHeightOffset = index->fHeader.count() + 5;
+                break;
+            case kDRI:
+                if (segmentSize < 2) {
+                    return nullptr;
+                }
+                index->fRestartInterval = read_be16(segment);
+                break;
+            case kSOS:
+                if (segmentSize < 1) {
+                    return nullptr;
+                }
+                scanComponents = segment[0];
+                break;
+            case kDHT:
+            case kAPP0:
+            case kAPP14:
+                break;
+            default:
+                if ((marker >= kAPP1 && marker <= kAPP13) || marker == kAPP15 || marker == kCOM) {
+                    // Metadata isn't needed to decode the band.
+                    pos += length;
+                    continue;
+                }
+                if (marker >= 0xC0 && marker <= 0xCF) {
+                    // Progressive, lossless, hierarchical and arithmetic coded images.
+                    return nullptr;
+                }
+                break;
+        }
+        index->fHeader.append(1, &bytes[pos - 2]);
+        index->fHeader.append(1, &marker);
+        index->fHeader.append(SkToInt(length), bytes + pos);
+        pos += length;
+        if (marker == kSOS) {
+            break;
+        }
+    }
+
+    // The whole image must be in a single scan, so the intervals cover every component.
+    if (!index->fHeightOffset || width <= 0 || height <= 0 || index->fRestartInterval <= 0 ||
+        scanComponents != components) {
+        return nullptr;
+    }
+    if (components == 1) {
+        // Single component scans are not interleaved; their MCU is one block.
+        maxH = maxV = 1;
+    }
+    index->fHeight = height;
+    index->fMCUHeight = 8 * maxV;
+    index->fMCUsPerRow = (width + 8 * maxH - 1) / (8 * maxH);
+    index->fMCURows = (height + index->fMCUHeight - 1) / index->fMCUHeight;
+    index->fRowsPerUnit = index->fRestartInterval /
+                          std::gcd(index->fRestartInterval, index->fMCUsPerRow);
+
+    // Find the restart markers in the entropy coded data.
+    size_t start = pos;
+    for (;;) {
+        const void* ff = memchr(bytes + pos, 0xFF, size - pos);
+        if (!ff) {
+            return nullptr;  // Truncated.
+        }
+        pos = (const uint8_t*)ff - bytes;
+        if (pos + 1 >= size) {
+            return nullptr;
+        }
+        const uint8_t marker = bytes[pos + 1];
+        if (marker == 0x00) {
+            pos += 2;  // A stuffed 0xFF data byte.
+        } else if (marker == 0xFF) {
+            pos += 1;  // A fill byte.
+        } else if (marker >= kRST0 && marker <= kRST7) {
+            if (marker != kRST0 + index->fStarts.count() % 8) {
+                return nullptr;
+            }
+            index->fStarts.push_back(start);
+            index->fEnds.push_back(pos);
+            pos += 2;
+            start = pos;
+        } else if (marker == kEOI) {
+            index->fStarts.push_back(start);
+            index->fEnds.push_back(pos);
+            break;
+        } else {
+            return nullptr;  // e.g. DNL, or another scan.
+        }
+    }
+
+    const int64_t mcus = (int64_t)index->fMCUsPerRow * index->fMCURows;
+    if (index->fStarts.count() != (mcus + index->fRestartInterval - 1) / index->fRestartInterval) {
+        return nullptr;
+    }
+    index->fData = std::move(data);
+    return index;
+}
+
+sk_sp<SkData> SkJpegRestartIndex::makeBand(int startRow, int endRow) const {
+    if (startRow < 0 || startRow >= endRow || endRow > fMCURows || startRow % fRowsPerUnit ||
+        (endRow % fRowsPerUnit && endRow != fMCURows)) {
+        return nullptr;
+    }
+    const int first = (int)((int64_t)startRow * fMCUsPerRow / fRestartInterval),
+              last  = endRow == fMCURows ? fStarts.count()
+                                         : (int)((int64_t)endRow * fMCUsPerRow / fRestartInterval);
+    const int height = std::min(endRow * fMCUHeight, fHeight) - startRow * fMCUHeight;
+
+    size_t size = fHeader.count() + 2 * (last - first);
+    for (int i = first; i < last; i++) {
+        size += fEnds[i] - fStarts[i];
+    }
+    sk_sp<SkData> band = SkData::MakeUninitialized(size);
+    uint8_t* dst = (uint8_t*)band->writable_data();
+
+    memcpy(dst, fHeader.begin(), fHeader.count());
+    dst[fHeightOffset + 0] = (uint8_t)(height >> 8);
+    dst[fHeightOffset + 1] = (uint8_t)(height & 0xFF);
+    dst += fHeader.count();
+
+    for (int i = first; i < last; i++) {
+        const size_t bytes = fEnds[i] - fStarts[i];
+        memcpy(dst, fData->bytes() + fStarts[i], bytes);
+        dst += bytes;
+        *dst++ = 0xFF;
+        *dst++ = i + 1 < last ? (uint8_t)(kRST0 + (i - first) % 8) : kEOI;
+    }
+    SkASSERT(dst == band->bytes() + size);
+    gBandsMade.fetch_add(1, std::memory_order_relaxed);
+    return band;
+}
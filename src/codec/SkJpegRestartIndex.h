@@ -0,0 +1,72 @@
+/*
+ * Copyright 2020 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkJpegRestartIndex_DEFINED
+#define SkJpegRestartIndex_DEFINED
+
+#include "include/core/SkData.h"
+#include "include/core/SkRefCnt.h"
+#include "include/private/SkTDArray.h"
+
+#include <memory>
+
+/*
+ * Indexes the restart intervals of a baseline JPEG.
+ *
+ * The entropy coder is reset at each restart marker, so a run of restart intervals can be decoded
+ * without the data before it.  When intervals start at the beginning of rows of MCUs, a band of
+ * those rows can be cut out of the image as a standalone JPEG: the original headers, with the
+ * height patched to the band's, followed by the band's intervals, renumbered from RST0.
+ */
+class SkJpegRestartIndex {
+public:
+    /*
+     * Returns nullptr unless data holds a complete, single scan, Huffman coded JPEG with restart
+     * intervals which can be split into bands of MCU rows.
+     */
+    static std::unique_ptr<SkJpegRestartIndex> Make(sk_sp<SkData> data);
+
+    // Number of rows of MCUs in the image.
+    int mcuRows() const { return fMCURows; }
+
+    // Height in pixels of a row of MCUs.
+    int mcuHeight() const { return fMCUHeight; }
+
+    // Bands must start and end on multiples of this many MCU rows (or at the end of the image).
+    int rowsPerUnit() const { return fRowsPerUnit; }
+
+    /*
+     * Returns a standalone JPEG of the MCU rows [startRow, endRow), or nullptr if the rows are
+     * not on restart interval boundaries.
+     */
+    sk_sp<SkData> makeBand(int startRow, int endRow) const;
+
+    // Number of bands made by any index so far, so tests can tell that a band decode ran.
+    static int BandsMadeForTesting();
+
+private:
+    SkJpegRestartIndex() = default;
+
+    sk_sp<SkData>  fData;
+    // The headers up to and including the SOS segment, less any metadata segments.
+    SkTDArray<uint8_t> fHeader;
+    // Offset in fHeader of the image height in the SOF segment.
+    size_t         fHeightOffset = 0;
+
+    int            fHeight = 0;
+    int            fMCUsPerRow = 0;
+    int            fMCURows = 0;
+    int            fMCUHeight = 0;
+    int            fRestartInterval = 0;
+    int            fRowsPerUnit = 0;
+
+    // The entropy coded data of interval i is [fStarts[i], fEnds[i]) in fData.
+    SkTDArray<size_t> fStarts;
+    SkTDArray<size_t> fEnds;
+};
+
+#endif
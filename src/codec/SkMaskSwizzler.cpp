@@ -8,6 +8,7 @@
 #include "include/private/SkColorData.h"
 #include "src/codec/SkCodecPriv.h"
 #include "src/codec/SkMaskSwizzler.h"
+#include "src/core/SkOpts.h"
 
 static void swizzle_mask16_to_rgba_opaque(
         void* dstRow, const uint8_t* srcRow, int width, SkMasks* masks,
@@ -379,6 +380,87 @@ static void swizzle_mask32_to_565(
     }
 }
 
+/*
+ *
+ * 32-bit masks which simply select the bytes of RGBA or BGRA pixels (the usual
+ * case) can use the SkOpts swizzles when we are not sampling
+ *
+ */
+using MaskRowProc = void (*)(void*, const uint8_t*, int, SkMasks*, uint32_t, uint32_t);
+
+template <MaskRowProc kSampledProc, bool kSwapRB>
+static void fast_swizzle_mask32_to_n32_opaque(
+        void* dstRow, const uint8_t* srcRow, int width, SkMasks* masks,
+        uint32_t startX, uint32_t sampleX) {
+    if (1 != sampleX) {
+        return kSampledProc(dstRow, srcRow, width, masks, startX, sampleX);
+    }
+
+    const uint32_t* srcPtr = ((const uint32_t*) srcRow) + startX;
+    uint32_t* dstPtr = (uint32_t*) dstRow;
+    if (kSwapRB) {
+        SkOpts::RGBA_to_BGRA(dstPtr, srcPtr, width);
+    } else {
+        memcpy(dstPtr, srcPtr, width * sizeof(uint32_t));
+    }
+    // The fourth byte is unused or ignored.
+    for (int i = 0; i < width; i++) {
+        dstPtr[i] |= 0xFF000000;
+    }
+}
+
+template <MaskRowProc kSampledProc, bool kSwapRB>
+static void fast_swizzle_mask32_to_n32_unpremul(
+        void* dstRow, const uint8_t* srcRow, int width, SkMasks* masks,
+        uint32_t startX, uint32_t sampleX) {
+    if (1 != sampleX) {
+        return kSampledProc(dstRow, srcRow, width, masks, startX, sampleX);
+    }
+
+    const uint32_t* srcPtr = ((const uint32_t*) srcRow) + startX;
+    if (kSwapRB) {
+        SkOpts::RGBA_to_BGRA((uint32_t*) dstRow, srcPtr, width);
+    } else {
+        memcpy(dstRow, srcPtr, width * sizeof(uint32_t));
+    }
+}
+
+template <MaskRowProc kSampledProc, bool kSwapRB>
+static void fast_swizzle_mask32_to_n32_premul(
+        void* dstRow, const uint8_t* srcRow, int width, SkMasks* masks,
+        uint32_t startX, uint32_t sampleX) {
+    if (1 != sampleX) {
+        return kSampledProc(dstRow, srcRow, width, masks, startX, sampleX);
+    }
+
+    const uint32_t* srcPtr = ((const uint32_t*) srcRow) + startX;
+    if (kSwapRB) {
+        SkOpts::RGBA_to_bgrA((uint32_t*) dstRow, srcPtr, width);
+    } else {
+        SkOpts::RGBA_to_rgbA((uint32_t*) dstRow, srcPtr, width);
+    }
+}
+
+template <MaskRowProc kOpaque, MaskRowProc kUnpremul, MaskRowProc kPremul>
+static MaskRowProc fast_mask32_proc(bool swapRB, bool srcIsOpaque, SkAlphaType dstAlphaType) {
+    if (srcIsOpaque) {
+        return swapRB ? &fast_swizzle_mask32_to_n32_opaque<kOpaque, true>
+                      : &fast_swizzle_mask32_to_n32_opaque<kOpaque, false>;
+    }
+    if (kPremul_SkAlphaType == dstAlphaType) {
+        return swapRB ? &fast_swizzle_mask32_to_n32_premul<kPremul, true>
+                      : &fast_swizzle_mask32_to_n32_premul<kPremul, false>;
+    }
+    return swapRB ? &fast_swizzle_mask32_to_n32_unpremul<kUnpremul, true>
+                  : &fast_swizzle_mask32_to_n32_unpremul<kUnpremul, false>;
+}
+
+static bool masks_are_bytes(const SkMasks& masks, uint32_t red, uint32_t green, uint32_t blue,
+                            bool srcIsOpaque) {
+    return masks.getRedMask() == red && masks.getGreenMask() == green &&
+           masks.getBlueMask() == blue && (srcIsOpaque || masks.getAlphaMask() == 0xFF000000);
+}
+
 /*
  *
  * Create a new mask swizzler
@@ -519,6 +601,26 @@ SkMaskSwizzler* SkMaskSwizzler::CreateMaskSwizzler(const SkImageInfo& dstInfo,
             return nullptr;
     }
 
+    if (32 == bitsPerPixel && proc && kRGB_565_SkColorType != dstInfo.colorType()) {
+        // Pixels are little-endian, so 0x000000FF selects the first byte.
+        const bool srcIsRGBA = masks_are_bytes(*masks, 0x000000FF, 0x0000FF00, 0x00FF0000,
+                                               srcIsOpaque);
+        const bool srcIsBGRA = masks_are_bytes(*masks, 0x00FF0000, 0x0000FF00, 0x000000FF,
+                                               srcIsOpaque);
+        if (srcIsRGBA || srcIsBGRA) {
+            const bool dstIsRGBA = kRGBA_8888_SkColorType == dstInfo.colorType();
+            const bool swapRB = srcIsRGBA != dstIsRGBA;
+            proc = dstIsRGBA ? fast_mask32_proc<swizzle_mask32_to_rgba_opaque,
+                                                swizzle_mask32_to_rgba_unpremul,
+                                                swizzle_mask32_to_rgba_premul>(
+                                           swapRB, srcIsOpaque, dstInfo.alphaType())
+                             : fast_mask32_proc<swizzle_mask32_to_bgra_opaque,
+                                                swizzle_mask32_to_bgra_unpremul,
+                                                swizzle_mask32_to_bgra_premul>(
+                                           swapRB, srcIsOpaque, dstInfo.alphaType());
+        }
+    }
+
     int srcOffset = 0;
     int srcWidth = dstInfo.width();
     if (options.fSubset) {
@@ -49,6 +49,11 @@ public:
         return fAlpha.mask;
      }
 
+    // Getters for the color masks, e.g. to spot pixels which are simply RGBA or BGRA bytes
+    uint32_t getRedMask() const { return fRed.mask; }
+    uint32_t getGreenMask() const { return fGreen.mask; }
+    uint32_t getBlueMask() const { return fBlue.mask; }
+
 private:
     const MaskInfo fRed;
     const MaskInfo fGreen;
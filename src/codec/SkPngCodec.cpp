@@ -510,10 +510,16 @@ public:
         GetDecoder(png_ptr)->rowCallback(row, rowNum);
     }
 
+    bool setRowProc(RowProc rowProc) override {
+        fRowProc = std::move(rowProc);
+        return true;
+    }
+
 private:
     int                         fRowsWrittenToOutput;
     void*                       fDst;
     size_t                      fRowBytes;
+    RowProc                     fRowProc;
 
     // Variables for partial decode
     int                         fFirstRow;  // FIXME: Move to baseclass?
@@ -595,7 +601,11 @@ private:
         // If there is no swizzler, all rows are needed.
         if (!this->swizzler() || this->swizzler()->rowNeeded(rowNum - fFirstRow)) {
             this->applyXformRow(fDst, row);
-            fDst = SkTAddOffset<void>(fDst, fRowBytes);
+            if (fRowProc) {
+                fRowProc(fDst);
+            } else {
+                fDst = SkTAddOffset<void>(fDst, fRowBytes);
+            }
             fRowsWrittenToOutput++;
         }
 
@@ -625,6 +635,9 @@ public:
         decoder->interlacedRowCallback(row, rowNum, pass);
     }
 
+    // No row is complete until the last pass.
+    bool setRowProc(RowProc) override { return false; }
+
 private:
     const int               fNumberPasses;
     int                     fFirstRow;
@@ -15,6 +15,8 @@
 #include "src/codec/SkColorTable.h"
 #include "src/codec/SkSwizzler.h"
 
+#include <functional>
+
 class SkStream;
 
 class SkPngCodec : public SkCodec {
@@ -28,6 +30,14 @@ public:
     // FIXME (scroggo): Temporarily needed by AutoCleanPng.
     void setIdatLength(size_t len) { fIdatLength = len; }
 
+    /**
+     *  While set (non-null), an incremental decode hands each decoded row to rowProc rather
+     *  than moving on to the next row of the destination, which then need only hold one row.
+     *  Returns false if rows can't be streamed like this, i.e. the image is interlaced.
+     */
+    using RowProc = std::function<void(const void* row)>;
+    virtual bool setRowProc(RowProc rowProc) = 0;
+
     ~SkPngCodec() override;
 
 protected:
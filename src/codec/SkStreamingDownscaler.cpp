@@ -0,0 +1,326 @@
+/*
+ * Copyright 2020 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "src/codec/SkStreamingDownscaler.h"
+
+#include "include/core/SkPixmap.h"
+#include "include/private/SkTemplates.h"
+#include "src/codec/SkSampler.h"
+#ifdef SK_CODEC_DECODES_PNG
+#include "src/codec/SkPngCodec.h"
+#endif
+#include "src/core/SkConvertPixels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using DownscaleFilter = SkAndroidCodec::DownscaleFilter;
+
+namespace {
+
+// Which source pixels (along one axis) contribute to each destination pixel, and how much.
+class FilterTable {
+public:
+    FilterTable(int srcLength, int dstLength, DownscaleFilter filter) {
+        SkASSERT(0 < dstLength && dstLength <= srcLength);
+        const double scale = (double)srcLength / dstLength;
+        fTaps.reserve(dstLength);
+        for (int dst = 0; dst < dstLength; dst++) {
+            double lo, hi;
+            if (DownscaleFilter::kBox == filter) {
+                lo = dst * scale;
+                hi = lo + scale;
+            } else {
+                // The tent is as wide as two destination pixels.
+                SkASSERT(DownscaleFilter::kTriangle == filter);
+                lo = (dst + 0.5) * scale - scale;
+                hi = lo + 2 * scale;
+            }
+            int begin = std::max(0, (int)std::floor(lo)),
+                end   = std::min(srcLength, (int)std::ceil(hi));
+
+            size_t first = fWeights.size();
+            float sum = 0;
+            for (int src = begin; src < end; src++) {
+                float weight;
+                if (DownscaleFilter::kBox == filter) {
+                    weight = (float)(std::min<double>(src + 1, hi) - std::max<double>(src, lo));
+                } else {
+                    double distance = std::abs(src + 0.5 - (dst + 0.5) * scale);
+                    weight = (float)std::max(0.0, 1 - distance / scale);
+                }
+                if (weight <= 0 && fWeights.size() == first) {
+                    begin++;  // Skip leading pixels which don't contribute.
+                    continue;
+                }
+                fWeights.push_back(weight);
+                sum += weight;
+            }
+            while (fWeights.size() > first + 1 && fWeights.back() <= 0) {
+                fWeights.pop_back();
+            }
+            SkASSERT(sum > 0);
+            for (size_t i = first; i < fWeights.size(); i++) {
+                fWeights[i] /= sum;
+            }
+            fTaps.push_back({begin, (int)(fWeights.size() - first), first});
+        }
+    }
+
+    int begin(int dst) const { return fTaps[dst].fBegin; }
+    int end(int dst) const { return fTaps[dst].fBegin + fTaps[dst].fCount; }
+    int count(int dst) const { return fTaps[dst].fCount; }
+    const float* weights(int dst) const { return &fWeights[fTaps[dst].fWeights]; }
+
+    // The most destination pixels which any one source pixel contributes to.
+    int maxOverlap() const {
+        int most = 1;
+        for (int dst = 0, first = 0; dst < (int)fTaps.size(); dst++) {
+            // Destinations [first, dst] all contain begin(dst) because the taps only move right.
+            while (this->end(first) <= this->begin(dst)) {
+                first++;
+            }
+            most = std::max(most, dst - first + 1);
+        }
+        return most;
+    }
+
+private:
+    struct Taps {
+        int    fBegin;
+        int    fCount;
+        size_t fWeights;
+    };
+    std::vector<Taps>  fTaps;
+    std::vector<float> fWeights;
+};
+
+// Filters rows of the source, in order, into dst.
+class Downscaler {
+public:
+    Downscaler(const SkPixmap& dst, const SkImageInfo& srcInfo, DownscaleFilter filter,
+               bool flipped)
+        : fDst(dst)
+        , fSrcRowInfo(srcInfo.makeWH(srcInfo.width(), 1))
+        , fSrcFloatInfo(fSrcRowInfo.makeColorType(kRGBA_F32_SkColorType))
+        , fDstFloatInfo(fSrcFloatInfo.makeWH(dst.width(), 1))
+        , fColumns(srcInfo.width(), dst.width(), filter)
+        , fRows(srcInfo.height(), dst.height(), filter)
+        , fOpenRows(fRows.maxOverlap())
+        , fFlipped(flipped)
+        , fSrcFloats(4 * srcInfo.width())
+        , fFiltered(4 * dst.width())
+        , fAccumulators(4 * dst.width() * fOpenRows) {}
+
+    bool done() const { return fFirstOpen == fDst.height(); }
+
+    void addRow(const void* src) {
+        const int srcY = fSrcY++;
+        if (this->done() || srcY < fRows.begin(fFirstOpen)) {
+            return;
+        }
+
+        SkConvertPixels(fSrcFloatInfo, fSrcFloats.get(), fSrcFloatInfo.minRowBytes(),
+                        fSrcRowInfo, src, fSrcRowInfo.minRowBytes());
+        const int dstWidth = fDst.width();
+        for (int x = 0; x < dstWidth; x++) {
+            const float* px = fSrcFloats.get() + 4 * fColumns.begin(x);
+            const float* weights = fColumns.weights(x);
+            float r = 0, g = 0, b = 0, a = 0;
+            for (int i = 0; i < fColumns.count(x); i++, px += 4) {
+                r += weights[i] * px[0];
+                g += weights[i] * px[1];
+                b += weights[i] * px[2];
+                a += weights[i] * px[3];
+            }
+            float* filtered = fFiltered.get() + 4 * x;
+            filtered[0] = r; filtered[1] = g; filtered[2] = b; filtered[3] = a;
+        }
+
+        for (int y = fFirstOpen; y < fDst.height() && fRows.begin(y) <= srcY; y++) {
+            float* acc = fAccumulators.get() + 4 * dstWidth * (y % fOpenRows);
+            const float weight = fRows.weights(y)[srcY - fRows.begin(y)];
+            if (srcY == fRows.begin(y)) {
+                for (int i = 0; i < 4 * dstWidth; i++) {
+                    acc[i] = weight * fFiltered[i];
+                }
+            } else {
+                for (int i = 0; i < 4 * dstWidth; i++) {
+                    acc[i] += weight * fFiltered[i];
+                }
+            }
+            if (srcY == fRows.end(y) - 1) {
+                SkASSERT(y == fFirstOpen);
+                SkConvertPixels(fDst.info().makeWH(dstWidth, 1), this->dstRow(y), fDst.rowBytes(),
+                                fDstFloatInfo, acc, fDstFloatInfo.minRowBytes());
+                fFirstOpen++;
+            }
+        }
+    }
+
+    // Fill the rows which haven't been written after an incomplete decode.
+    void fillRemaining(SkCodec::ZeroInitialized zeroInit) {
+        const SkImageInfo rowInfo = fDst.info().makeWH(fDst.width(), 1);
+        for (int y = fFirstOpen; y < fDst.height(); y++) {
+            SkSampler::Fill(rowInfo, this->dstRow(y), fDst.rowBytes(), zeroInit);
+        }
+    }
+
+private:
+    // Bottom up rows are filtered as if the image were flipped, which gives the same weights.
+    void* dstRow(int y) const {
+        return fDst.writable_addr(0, fFlipped ? fDst.height() - 1 - y : y);
+    }
+
+    const SkPixmap    fDst;
+    const SkImageInfo fSrcRowInfo;
+    const SkImageInfo fSrcFloatInfo;
+    const SkImageInfo fDstFloatInfo;
+    const FilterTable fColumns;
+    const FilterTable fRows;
+    const int         fOpenRows;  // Destination rows being accumulated at any one time.
+    const bool        fFlipped;
+
+    SkAutoTMalloc<float> fSrcFloats;
+    SkAutoTMalloc<float> fFiltered;
+    SkAutoTMalloc<float> fAccumulators;  // fOpenRows rows, indexed by y % fOpenRows.
+    int fSrcY = 0;
+    int fFirstOpen = 0;
+};
+
+#ifdef SK_CODEC_DECODES_PNG
+// libpng hands over rows through a callback, rather than as scanlines, so stream them from an
+// incremental decode instead.
+SkCodec::Result decode_png(SkPngCodec* codec, const SkImageInfo& decodeInfo,
+                           SkCodec::Options* options, const SkIRect& bounds,
+                           Downscaler* downscaler) {
+    SkAutoTMalloc<uint8_t> row(decodeInfo.minRowBytes());
+    if (!codec->setRowProc([downscaler](const void* src) { downscaler->addRow(src); })) {
+        return SkCodec::kUnimplemented;
+    }
+    SkIRect incrementalSubset = bounds;
+    options->fSubset = &incrementalSubset;
+    SkCodec::Result result = codec->startIncrementalDecode(decodeInfo, row.get(),
+                                                           decodeInfo.minRowBytes(), options);
+    if (SkCodec::kSuccess == result) {
+        result = codec->incrementalDecode();
+    }
+    codec->setRowProc(nullptr);
+    return result;
+}
+#endif
+
+// For codecs which can't stream rows (e.g. interlaced PNG and GIF), decode the whole image first.
+SkCodec::Result decode_whole_image(SkCodec* codec, const SkImageInfo& decodeInfo,
+                                   SkCodec::ZeroInitialized zeroInit, const SkIRect& bounds,
+                                   const SkPixmap& dst, DownscaleFilter filter) {
+    const size_t rowBytes = decodeInfo.minRowBytes();
+    SkAutoTMalloc<uint8_t> pixels(decodeInfo.computeByteSize(rowBytes));
+    SkCodec::Options options;
+    options.fZeroInitialized = SkCodec::kNo_ZeroInitialized;
+    const SkCodec::Result result = codec->getPixels(decodeInfo, pixels.get(), rowBytes, &options);
+    switch (result) {
+        case SkCodec::kSuccess:
+        case SkCodec::kIncompleteInput:
+        case SkCodec::kErrorInInput:
+            break;
+        default:
+            return result;
+    }
+
+    // An incomplete decode has already filled the rest of the image.
+    Downscaler downscaler(dst, decodeInfo.makeDimensions(bounds.size()), filter, false);
+    const size_t left = bounds.left() * decodeInfo.bytesPerPixel();
+    for (int y = bounds.top(); y < bounds.bottom() && !downscaler.done(); y++) {
+        downscaler.addRow(pixels.get() + y * rowBytes + left);
+    }
+    return result;
+}
+
+}  // namespace
+
+SkCodec::Result SkStreamingDownscaler::Decode(SkCodec* codec, const SkPixmap& dst,
+                                              const SkIRect* subset,
+                                              SkCodec::ZeroInitialized zeroInit,
+                                              DownscaleFilter filter) {
+    SkASSERT(DownscaleFilter::kPointSample != filter);
+    const SkIRect bounds = subset ? *subset : SkIRect::MakeSize(codec->dimensions());
+    if (dst.width() <= 0 || dst.height() <= 0 || dst.width() > bounds.width()
+            || dst.height() > bounds.height()) {
+        return SkCodec::kInvalidScale;
+    }
+
+    SkCodec::Options options;
+    options.fZeroInitialized = zeroInit;
+    if (!subset) {
+        // Use the codec's own scaling if it has any for these dimensions.
+        SkCodec::Result result = codec->getPixels(dst, &options);
+        if (SkCodec::kInvalidScale != result) {
+            return result;
+        }
+    }
+
+    // Filter premultiplied colors.  Rows are decoded into scratch memory, so are never zeroed.
+    const SkAlphaType decodeAlphaType = kUnpremul_SkAlphaType == dst.alphaType()
+                                      ? kPremul_SkAlphaType : dst.alphaType();
+    const SkImageInfo decodeInfo = codec->getInfo().makeColorType(dst.colorType())
+                                                   .makeAlphaType(decodeAlphaType)
+                                                   .makeColorSpace(dst.refColorSpace());
+    const SkImageInfo srcInfo = decodeInfo.makeDimensions(bounds.size());
+    options.fZeroInitialized = SkCodec::kNo_ZeroInitialized;
+
+#ifdef SK_CODEC_DECODES_PNG
+    if (SkEncodedImageFormat::kPNG == codec->getEncodedFormat()) {
+        Downscaler downscaler(dst, srcInfo, filter, false);
+        const SkCodec::Result result = decode_png(static_cast<SkPngCodec*>(codec), decodeInfo,
+                                                  &options, bounds, &downscaler);
+        if (SkCodec::kIncompleteInput == result || SkCodec::kErrorInInput == result) {
+            downscaler.fillRemaining(zeroInit);
+        }
+        if (SkCodec::kUnimplemented != result) {
+            return result;
+        }
+    }
+#endif
+
+    // The scanline decoder subsets only horizontally.
+    SkIRect scanlineSubset = SkIRect::MakeLTRB(bounds.left(), 0, bounds.right(),
+                                               codec->dimensions().height());
+    options.fSubset = subset ? &scanlineSubset : nullptr;
+    const SkCodec::Result result = codec->startScanlineDecode(decodeInfo, &options);
+    if (SkCodec::kUnimplemented == result) {
+        return decode_whole_image(codec, decodeInfo, zeroInit, bounds, dst, filter);
+    }
+    if (SkCodec::kSuccess != result) {
+        return result;
+    }
+
+    // Bottom up rows are only streamed for the whole height of the image, and rows out of order
+    // (e.g. RLE BMP) not at all; decode those images whole instead.
+    const bool flipped = SkCodec::kBottomUp_SkScanlineOrder == codec->getScanlineOrder();
+    if ((flipped && bounds.height() != codec->dimensions().height()) ||
+        (!flipped && SkCodec::kTopDown_SkScanlineOrder != codec->getScanlineOrder())) {
+        return decode_whole_image(codec, decodeInfo, zeroInit, bounds, dst, filter);
+    }
+    if (!flipped && !codec->skipScanlines(bounds.top())) {
+        SkSampler::Fill(dst.info(), dst.writable_addr(), dst.rowBytes(), zeroInit);
+        return SkCodec::kIncompleteInput;
+    }
+
+    Downscaler downscaler(dst, srcInfo, filter, flipped);
+    SkAutoTMalloc<uint8_t> row(srcInfo.minRowBytes());
+    for (int y = 0; y < bounds.height() && !downscaler.done(); y++) {
+        if (1 != codec->getScanlines(row.get(), 1, srcInfo.minRowBytes())) {
+            downscaler.fillRemaining(zeroInit);
+            return SkCodec::kIncompleteInput;
+        }
+        downscaler.addRow(row.get());
+    }
+    SkASSERT(downscaler.done());
+    return SkCodec::kSuccess;
+}
@@ -0,0 +1,33 @@
+/*
+ * Copyright 2020 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#ifndef SkStreamingDownscaler_DEFINED
+#define SkStreamingDownscaler_DEFINED
+
+#include "include/codec/SkAndroidCodec.h"
+#include "include/codec/SkCodec.h"
+
+class SkPixmap;
+
+/**
+ *  Decodes to arbitrary smaller dimensions by feeding each scanline, as it is decoded, through
+ *  a separable filter.  Only a few rows of the full sized image are held in memory at a time.
+ */
+namespace SkStreamingDownscaler {
+
+/**
+ *  Decode codec's image (or the subset of it) into dst, which may be no larger.  Codecs which
+ *  can scale natively to dst's dimensions do so (e.g. WebP), and so ignore filter.  Codecs
+ *  which can't hand over one row at a time (e.g. interlaced PNG) decode the whole image first.
+ *
+ *  filter must not be DownscaleFilter::kPointSample.
+ */
+SkCodec::Result Decode(SkCodec*, const SkPixmap& dst, const SkIRect* subset,
+                       SkCodec::ZeroInitialized, SkAndroidCodec::DownscaleFilter filter);
+
+}  // namespace SkStreamingDownscaler
+
+#endif  // SkStreamingDownscaler_DEFINED
@@ -0,0 +1,363 @@
+/*
+ * Copyright 2020 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "src/codec/SkTiledImageGenerator.h"
+
+#include "include/core/SkBitmap.h"
+#include "include/private/SkTemplates.h"
+#include "src/codec/SkSampler.h"
+#include "src/core/SkCachedData.h"
+#include "src/core/SkResourceCache.h"
+
+#ifdef SK_CODEC_DECODES_JPEG
+#include "src/codec/SkJpegRestartIndex.h"
+#endif
+
+#include <algorithm>
+#include <climits>
+#include <vector>
+
+namespace {
+
+static unsigned gTileKeyNamespaceLabel;
+
+// The widest iMCU of a JPEG, with 4x horizontal chroma subsampling.
+constexpr int kJpegCropMargin = 32;
+
+uint64_t tile_shared_id(uint32_t generatorID) {
+    uint64_t sharedID = SkSetFourByteTag('t', 'i', 'l', 'e');
+    return (sharedID << 32) | generatorID;
+}
+
+struct TileKey : public SkResourceCache::Key {
+    TileKey(uint32_t generatorID, int x, int y)
+        : fGeneratorID(generatorID)
+        , fX(x)
+        , fY(y)
+    {
+        this->init(&gTileKeyNamespaceLabel, tile_shared_id(generatorID),
+                   sizeof(fGeneratorID) + sizeof(fX) + sizeof(fY));
+    }
+
+    uint32_t fGeneratorID;
+    int32_t  fX;
+    int32_t  fY;
+};
+
+struct TileRec : public SkResourceCache::Rec {
+    TileRec(const TileKey& key, SkCachedData* data)
+        : fKey(key)
+        , fData(data)
+    {
+        fData->attachToCacheAndRef();
+    }
+    ~TileRec() override {
+        fData->detachFromCacheAndUnref();
+    }
+
+    TileKey       fKey;
+    SkCachedData* fData;
+
+    const Key& getKey() const override { return fKey; }
+    size_t bytesUsed() const override { return sizeof(*this) + fData->size(); }
+    const char* getCategory() const override { return "image-tile"; }
+    SkDiscardableMemory* diagnostic_only_getDiscardable() const override {
+        return fData->diagnostic_only_getDiscardable();
+    }
+
+    static bool Visitor(const SkResourceCache::Rec& baseRec, void* contextData) {
+        const TileRec& rec = static_cast<const TileRec&>(baseRec);
+        SkCachedData** result = static_cast<SkCachedData**>(contextData);
+
+        SkCachedData* tmpData = rec.fData;
+        tmpData->ref();
+        if (nullptr == tmpData->data()) {
+            tmpData->unref();
+            return false;
+        }
+        *result = tmpData;
+        return true;
+    }
+};
+
+sk_sp<SkCachedData> find_tile(uint32_t generatorID, int x, int y) {
+    SkCachedData* data = nullptr;
+    if (!SkResourceCache::Find(TileKey(generatorID, x, y), TileRec::Visitor, &data)) {
+        return nullptr;
+    }
+    return sk_sp<SkCachedData>(data);
+}
+
+bool acceptable_result(SkCodec::Result result) {
+    switch (result) {
+        case SkCodec::kSuccess:
+        case SkCodec::kIncompleteInput:
+        case SkCodec::kErrorInInput:
+            return true;
+        default:
+            return false;
+    }
+}
+
+}  // namespace
+
+std::unique_ptr<SkImageGenerator> SkTiledImageGenerator::Make(sk_sp<SkData> data, int tileSize) {
+    if (tileSize <= 0) {
+        return nullptr;
+    }
+    auto codec = SkCodec::MakeFromData(data);
+    if (nullptr == codec) {
+        return nullptr;
+    }
+
+    return std::unique_ptr<SkImageGenerator>(
+            new SkTiledImageGenerator(std::move(codec), std::move(data), tileSize));
+}
+
+static SkImageInfo adjust_info(SkCodec* codec) {
+    SkImageInfo info = codec->getInfo();
+    if (kUnpremul_SkAlphaType == info.alphaType()) {
+        info = info.makeAlphaType(kPremul_SkAlphaType);
+    }
+    return info;
+}
+
+SkTiledImageGenerator::SkTiledImageGenerator(std::unique_ptr<SkCodec> codec, sk_sp<SkData> data,
+                                             int tileSize)
+    : INHERITED(adjust_info(codec.get()))
+    , fCodec(std::move(codec))
+    , fData(std::move(data))
+    , fTileSize(tileSize)
+{
+    const skcms_ICCProfile* profile = fCodec->getICCProfile();
+    fTileColorSpace = profile ? SkColorSpace::Make(*profile) : SkColorSpace::MakeSRGB();
+    if (!fTileColorSpace) {
+        // Convert to the color space that the codec reports instead.
+        fTileColorSpace = fDecodeColorSpace = this->getInfo().refColorSpace();
+    }
+
+#ifdef SK_CODEC_DECODES_JPEG
+    if (SkEncodedImageFormat::kJPEG == fCodec->getEncodedFormat() && !fDecodeColorSpace) {
+        fJpegIndex = SkJpegRestartIndex::Make(fData);
+    }
+#endif
+}
+
+SkTiledImageGenerator::~SkTiledImageGenerator() {
+    SkResourceCache::PostPurgeSharedID(tile_shared_id(this->uniqueID()));
+}
+
+sk_sp<SkData> SkTiledImageGenerator::onRefEncodedData() {
+    return fData;
+}
+
+bool SkTiledImageGenerator::onGetPixels(const SkImageInfo& info, void* pixels, size_t rowBytes,
+                                        const Options&) {
+    // SkBitmapCache already keeps the whole image, so don't cache its tiles as well.
+    return acceptable_result(fCodec->getPixels(info, pixels, rowBytes));
+}
+
+bool SkTiledImageGenerator::onGetSubsetPixels(const SkImageInfo& info, void* pixels,
+                                              size_t rowBytes, const SkIPoint& origin) {
+    const SkIRect subset = SkIRect::MakeXYWH(origin.x(), origin.y(), info.width(), info.height());
+    if (kUnpremul_SkAlphaType == info.alphaType() && !this->getInfo().isOpaque()) {
+        // Tiles are premultiplied, which would lose precision here.
+        return this->decodeRows(subset, SkPixmap(info, pixels, rowBytes));
+    }
+    const SkImageInfo tileInfo = this->getInfo().makeColorSpace(fTileColorSpace);
+    const SkIRect bounds = SkIRect::MakeSize(tileInfo.dimensions());
+    const int left  = subset.left() / fTileSize,
+              right = (subset.right() - 1) / fTileSize + 1;
+
+    std::vector<sk_sp<SkCachedData>> tiles(right - left);
+    for (int y = subset.top() / fTileSize; y * fTileSize < subset.bottom(); y++) {
+        // Decode all of the missing tiles in this row at once.
+        int firstMissing = INT_MAX,
+            lastMissing  = -1;
+        for (int x = left; x < right; x++) {
+            tiles[x - left] = find_tile(this->uniqueID(), x, y);
+            if (!tiles[x - left]) {
+                firstMissing = std::min(firstMissing, x);
+                lastMissing  = x;
+            }
+        }
+        SkBitmap band;
+        if (lastMissing >= 0 && !this->decodeTiles(y, firstMissing, lastMissing + 1, &band)) {
+            return false;
+        }
+
+        for (int x = left; x < right; x++) {
+            SkIRect tile = SkIRect::MakeXYWH(x * fTileSize, y * fTileSize, fTileSize, fTileSize);
+            SkAssertResult(tile.intersect(bounds));
+
+            SkPixmap src;
+            if (tiles[x - left]) {
+                const SkImageInfo cachedInfo = tileInfo.makeDimensions(tile.size());
+                src.reset(cachedInfo, tiles[x - left]->data(), cachedInfo.minRowBytes());
+            } else {
+                SkAssertResult(band.pixmap().extractSubset(
+                        &src, tile.makeOffset(-firstMissing * fTileSize, -tile.top())));
+            }
+
+            SkIRect overlap = tile;
+            SkAssertResult(overlap.intersect(subset));
+            void* dst = SkTAddOffset<void>(pixels, (overlap.top() - subset.top()) * rowBytes
+                                           + (overlap.left() - subset.left()) * info.bytesPerPixel());
+            if (!src.readPixels(info.makeDimensions(overlap.size()), dst, rowBytes,
+                                overlap.left() - tile.left(), overlap.top() - tile.top())) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool SkTiledImageGenerator::decodeTiles(int row, int left, int right, SkBitmap* band) {
+    const SkImageInfo& info = this->getInfo();
+    SkIRect rect = SkIRect::MakeLTRB(left * fTileSize, row * fTileSize, right * fTileSize,
+                                     (row + 1) * fTileSize);
+    SkAssertResult(rect.intersect(SkIRect::MakeSize(info.dimensions())));
+
+    // Fancy upsampling repeats the edge of a horizontally cropped JPEG, rather than looking at
+    // the chroma beyond it, so decode at least an iMCU either side and discard it.
+    SkIRect decodeRect = rect;
+    if (SkEncodedImageFormat::kJPEG == fCodec->getEncodedFormat()) {
+        decodeRect.outset(kJpegCropMargin, 0);
+        SkAssertResult(decodeRect.intersect(SkIRect::MakeSize(info.dimensions())));
+    }
+
+    SkBitmap decoded;
+    if (!decoded.tryAllocPixels(info.makeDimensions(decodeRect.size())
+                                    .makeColorSpace(fTileColorSpace))) {
+        return false;
+    }
+    const SkPixmap dst(decoded.info().makeColorSpace(fDecodeColorSpace), decoded.getPixels(),
+                       decoded.rowBytes());
+    if (!this->decodeRows(decodeRect, dst)) {
+        return false;
+    }
+    SkAssertResult(decoded.extractSubset(band, rect.makeOffset(-decodeRect.left(),
+                                                              -decodeRect.top())));
+
+    for (int x = left; x < right; x++) {
+        SkIRect tile = SkIRect::MakeXYWH(x * fTileSize, rect.top(), fTileSize, rect.height());
+        SkAssertResult(tile.intersect(rect));
+        const size_t tileRowBytes = tile.width() * info.bytesPerPixel();
+        sk_sp<SkCachedData> data(SkResourceCache::NewCachedData(tileRowBytes * tile.height()));
+        if (!data) {
+            continue;
+        }
+        for (int y = 0; y < tile.height(); y++) {
+            memcpy(SkTAddOffset<void>(data->writable_data(), y * tileRowBytes),
+                   band->getAddr(tile.left() - rect.left(), y), tileRowBytes);
+        }
+        SkResourceCache::Add(new TileRec(TileKey(this->uniqueID(), x, row), data.get()));
+    }
+    return true;
+}
+
+bool SkTiledImageGenerator::decodeRows(const SkIRect& rect, const SkPixmap& dst) {
+#ifdef SK_CODEC_DECODES_JPEG
+    if (fJpegIndex && this->decodeJpegRows(rect, dst)) {
+        return true;
+    }
+#endif
+
+    const SkImageInfo decodeInfo = dst.info().makeDimensions(fCodec->dimensions());
+    SkCodec::Options options;
+
+    // Scanline decoders subset only horizontally, and skip the rows above.
+    SkIRect scanlineSubset = SkIRect::MakeLTRB(rect.left(), 0, rect.right(),
+                                               decodeInfo.height());
+    options.fSubset = &scanlineSubset;
+    if (SkCodec::kSuccess == fCodec->startScanlineDecode(decodeInfo, &options)
+            && SkCodec::kTopDown_SkScanlineOrder == fCodec->getScanlineOrder()) {
+        if (!fCodec->skipScanlines(rect.top())) {
+            return false;
+        }
+        // On a short read the codec fills the rest.
+        fCodec->getScanlines(dst.writable_addr(), rect.height(), dst.rowBytes());
+        return true;
+    }
+
+    // Incremental decoders (PNG) only decode up to the bottom of the rect.
+    SkIRect incrementalSubset = rect;
+    options.fSubset = &incrementalSubset;
+    if (SkCodec::kSuccess == fCodec->startIncrementalDecode(decodeInfo, dst.writable_addr(),
+                                                            dst.rowBytes(), &options)) {
+        int rowsDecoded = 0;
+        const SkCodec::Result result = fCodec->incrementalDecode(&rowsDecoded);
+        if (SkCodec::kSuccess != result) {
+            if (!acceptable_result(result)) {
+                return false;
+            }
+            const SkImageInfo rest = dst.info().makeWH(dst.width(), dst.height() - rowsDecoded);
+            SkSampler::Fill(rest, dst.writable_addr(0, rowsDecoded), dst.rowBytes(),
+                            SkCodec::kNo_ZeroInitialized);
+        }
+        return true;
+    }
+
+    // Some codecs (e.g. WebP) decode subsets directly.  Otherwise decode the whole image.
+    SkIRect subset = rect;
+    options.fSubset = &subset;
+    SkCodec::Result result = fCodec->getPixels(decodeInfo.makeDimensions(rect.size()),
+                                               dst.writable_addr(), dst.rowBytes(), &options);
+    if (SkCodec::kUnimplemented != result) {
+        return acceptable_result(result);
+    }
+    SkBitmap full;
+    if (!full.tryAllocPixels(decodeInfo) ||
+            !acceptable_result(fCodec->getPixels(full.pixmap()))) {
+        return false;
+    }
+    return full.readPixels(dst, rect.left(), rect.top());
+}
+
+#ifdef SK_CODEC_DECODES_JPEG
+bool SkTiledImageGenerator::decodeJpegRows(const SkIRect& rect, const SkPixmap& dst) {
+    const int mcuHeight = fJpegIndex->mcuHeight(),
+              unit      = fJpegIndex->rowsPerUnit(),
+              mcuRows   = fJpegIndex->mcuRows();
+    const int startRow = rect.top() / mcuHeight / unit * unit,
+              endRow   = std::min(((rect.bottom() + mcuHeight - 1) / mcuHeight + unit - 1)
+                                  / unit * unit, mcuRows);
+
+    // As with parallel decodes, decode an extra unit above and below, so that fancy upsampling
+    // sees the same neighbours as in a decode of the whole image.
+    const int decodeStart = std::max(startRow - unit, 0),
+              decodeEnd   = std::min(endRow + unit, mcuRows);
+    if (0 == decodeStart) {
+        // The band starts at the top anyway.
+        return false;
+    }
+
+    auto codec = SkCodec::MakeFromData(fJpegIndex->makeBand(decodeStart, decodeEnd));
+    if (!codec || codec->dimensions().width() != fCodec->dimensions().width()) {
+        return false;
+    }
+
+    const SkImageInfo decodeInfo = dst.info().makeDimensions(codec->dimensions());
+    SkIRect subset = SkIRect::MakeLTRB(rect.left(), 0, rect.right(), decodeInfo.height());
+    SkCodec::Options options;
+    options.fSubset = &subset;
+    if (SkCodec::kSuccess != codec->startScanlineDecode(decodeInfo, &options)) {
+        return false;
+    }
+
+    // Read, rather than skip, the rows above the rect, so that they set up the upsampling
+    // context exactly as they would in a decode of the whole image.
+    SkAutoTMalloc<uint8_t> skipped(dst.info().minRowBytes());
+    for (int y = decodeStart * mcuHeight; y < rect.top(); y++) {
+        if (1 != codec->getScanlines(skipped.get(), 1, dst.info().minRowBytes())) {
+            return false;
+        }
+    }
+    return rect.height() == codec->getScanlines(dst.writable_addr(), rect.height(),
+                                                dst.rowBytes());
+}
+#endif
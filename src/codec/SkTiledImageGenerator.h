@@ -0,0 +1,79 @@
+/*
+ * Copyright 2020 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#ifndef SkTiledImageGenerator_DEFINED
+#define SkTiledImageGenerator_DEFINED
+
+#include "include/codec/SkCodec.h"
+#include "include/core/SkColorSpace.h"
+#include "include/core/SkData.h"
+#include "include/core/SkImageGenerator.h"
+
+class SkBitmap;
+class SkJpegRestartIndex;
+
+/*
+ * An image generator for very large encoded images, of which only a region is needed at a time.
+ *
+ * The image is decoded in square tiles, as they are asked for, which are kept in SkResourceCache
+ * so that overlapping regions need not decode them again.  Decoding a tile of a JPEG with restart
+ * markers starts from the nearest restart interval above it, rather than from the top of the
+ * image.
+ *
+ * Tiles are in the encoded orientation, like SkBitmapRegionDecoder's regions.  They are
+ * premultiplied, so unpremultiplied regions are decoded directly, as is the whole image (which
+ * SkBitmapCache keeps instead).
+ */
+class SkTiledImageGenerator : public SkImageGenerator {
+public:
+    static constexpr int kDefaultTileSize = 256;
+
+    /*
+     * If this data represents an encoded image that we know how to decode,
+     * return an SkTiledImageGenerator.  Otherwise return nullptr.
+     */
+    static std::unique_ptr<SkImageGenerator> Make(sk_sp<SkData>,
+                                                  int tileSize = kDefaultTileSize);
+
+    ~SkTiledImageGenerator() override;
+
+protected:
+    sk_sp<SkData> onRefEncodedData() override;
+
+    bool onGetPixels(
+        const SkImageInfo& info, void* pixels, size_t rowBytes, const Options& opts) override;
+
+    bool onGetSubsetPixels(
+        const SkImageInfo& info, void* pixels, size_t rowBytes, const SkIPoint& origin) override;
+
+private:
+    SkTiledImageGenerator(std::unique_ptr<SkCodec>, sk_sp<SkData>, int tileSize);
+
+    /*
+     * Decodes the tiles [left, right) in row of tiles, adding them to the cache, into band
+     * (which holds all of them).
+     */
+    bool decodeTiles(int row, int left, int right, SkBitmap* band);
+    bool decodeRows(const SkIRect& rect, const SkPixmap& dst);
+#ifdef SK_CODEC_DECODES_JPEG
+    bool decodeJpegRows(const SkIRect& rect, const SkPixmap& dst);
+#endif
+
+    std::unique_ptr<SkCodec>            fCodec;
+    sk_sp<SkData>                       fData;
+    const int                           fTileSize;
+
+    // Tiles are decoded without color conversion when their encoded color space can be
+    // represented, so that tiles cut from a JPEG's restart intervals (which lack its ICC
+    // profile) match the rest.  In that case fDecodeColorSpace is null.
+    sk_sp<SkColorSpace>                 fTileColorSpace;
+    sk_sp<SkColorSpace>                 fDecodeColorSpace;
+
+    std::unique_ptr<SkJpegRestartIndex> fJpegIndex;
+
+    typedef SkImageGenerator INHERITED;
+};
+#endif  // SkTiledImageGenerator_DEFINED
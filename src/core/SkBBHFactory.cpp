@@ -16,3 +16,10 @@ void SkBBoxHierarchy::insert(const SkRect rects[], const Metadata[], int N) {
     // Ignore Metadata.
     this->insert(rects, N);
 }
+
+void SkBBoxHierarchy::searchBatch(const SkRect queries[], int count,
+                                  std::vector<int> results[]) const {
+    for (int i = 0; i < count; i++) {
+        this->search(queries[i], &results[i]);
+    }
+}
@@ -16,12 +16,14 @@ SkBigPicture::SkBigPicture(const SkRect& cull,
                            sk_sp<SkRecord> record,
                            std::unique_ptr<SnapshotArray> drawablePicts,
                            sk_sp<SkBBoxHierarchy> bbh,
-                           size_t approxBytesUsedBySubPictures)
+                           size_t approxBytesUsedBySubPictures,
+                           SkTDArray<Occluder> occluders)
     : fCullRect(cull)
     , fApproxBytesUsedBySubPictures(approxBytesUsedBySubPictures)
     , fRecord(std::move(record))
     , fDrawablePicts(std::move(drawablePicts))
     , fBBH(std::move(bbh))
+    , fOccluders(std::move(occluders))
 {}
 
 void SkBigPicture::playback(SkCanvas* canvas, AbortCallback* callback) const {
@@ -36,7 +38,9 @@ void SkBigPicture::playback(SkCanvas* canvas, AbortCallback* callback) const {
                  nullptr,
                  this->drawableCount(),
                  useBBH ? fBBH.get() : nullptr,
-                 callback);
+                 callback,
+                 fOccluders.begin(),
+                 fOccluders.count());
 }
 
 void SkBigPicture::partialPlayback(SkCanvas* canvas,
@@ -56,7 +60,8 @@ void SkBigPicture::partialPlayback(SkCanvas* canvas,
 SkRect SkBigPicture::cullRect()            const { return fCullRect; }
 int    SkBigPicture::approximateOpCount()   const { return fRecord->count(); }
 size_t SkBigPicture::approximateBytesUsed() const {
-    size_t bytes = sizeof(*this) + fRecord->bytesUsed() + fApproxBytesUsedBySubPictures;
+    size_t bytes = sizeof(*this) + fRecord->bytesUsed() + fApproxBytesUsedBySubPictures
+                 + fOccluders.count() * sizeof(Occluder);
     if (fBBH) { bytes += fBBH->bytesUsed(); }
     return bytes;
 }
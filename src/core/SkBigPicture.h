@@ -12,6 +12,7 @@
 #include "include/core/SkRect.h"
 #include "include/private/SkNoncopyable.h"
 #include "include/private/SkOnce.h"
+#include "include/private/SkTDArray.h"
 #include "include/private/SkTemplates.h"
 
 class SkBBoxHierarchy;
@@ -34,11 +35,18 @@ public:
         int fCount;
     };
 
+    // An op outside of any layer that paints every pixel of rect (in identity space) opaquely.
+    struct Occluder {
+        int    op;
+        SkRect rect;
+    };
+
     SkBigPicture(const SkRect& cull,
                  sk_sp<SkRecord>,
                  std::unique_ptr<SnapshotArray>,
                  sk_sp<SkBBoxHierarchy>,
-                 size_t approxBytesUsedBySubPictures);
+                 size_t approxBytesUsedBySubPictures,
+                 SkTDArray<Occluder> occluders = SkTDArray<Occluder>());
 
 
 // SkPicture overrides
@@ -66,6 +74,7 @@ private:
     sk_sp<const SkRecord>                fRecord;
     std::unique_ptr<const SnapshotArray> fDrawablePicts;
     sk_sp<const SkBBoxHierarchy>         fBBH;
+    const SkTDArray<Occluder>            fOccluders;
 };
 
 #endif//SkBigPicture_DEFINED
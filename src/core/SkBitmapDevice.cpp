@@ -19,6 +19,7 @@
 #include "src/core/SkGlyphRun.h"
 #include "src/core/SkImageFilterCache.h"
 #include "src/core/SkImageFilter_Base.h"
+#include "src/core/SkMatrixUtils.h"
 #include "src/core/SkRasterClip.h"
 #include "src/core/SkSpecialImage.h"
 #include "src/core/SkStrikeCache.h"
@@ -436,7 +437,12 @@ void SkBitmapDevice::drawImageRect(const SkImage* image,
     if (!as_IB(image)->getROPixels(&bitmap)) {
         return;
     }
+    this->drawBitmapRect(bitmap, src, dst, paint, constraint);
+}
 
+void SkBitmapDevice::drawBitmapRect(const SkBitmap& bitmap,
+                                    const SkRect* src, const SkRect& dst,
+                                    const SkPaint& paint, SkCanvas::SrcRectConstraint constraint) {
     SkMatrix    matrix;
     SkRect      bitmapBounds, tmpSrc, tmpDst;
     SkBitmap    tmpBitmap;
@@ -548,6 +554,97 @@ void SkBitmapDevice::drawImageRect(const SkImage* image,
     this->drawRect(*dstPtr, paintWithShader);
 }
 
+// Returns true if an image entry drawn from src to dst can be blitted as a sprite, the way
+// SkDraw::drawBitmap() would, and sets (x,y) to where src's top left corner lands on the device.
+static bool is_sprite_entry(const SkMatrix& localToDevice, const SkBitmap& bitmap,
+                            const SkRect& src, const SkRect& dst, const SkPaint& paint,
+                            int* x, int* y) {
+    if (bitmap.colorType() == kAlpha_8_SkColorType ||
+        src.width() != dst.width() || src.height() != dst.height() ||
+        SkRect::Make(src.round()) != src || !SkRect::Make(bitmap.bounds()).contains(src)) {
+        return false;
+    }
+    SkMatrix matrix = localToDevice;
+    matrix.preTranslate(dst.fLeft, dst.fTop);
+    if (!SkTreatAsSprite(matrix, src.round().size(), paint)) {
+        return false;
+    }
+    *x = SkScalarRoundToInt(matrix.getTranslateX());
+    *y = SkScalarRoundToInt(matrix.getTranslateY());
+    return true;
+}
+
+void SkBitmapDevice::drawEdgeAAImageSet(const SkCanvas::ImageSetEntry set[], int count,
+                                        const SkPoint dstClips[], const SkMatrix preViewMatrices[],
+                                        const SkPaint& paint,
+                                        SkCanvas::SrcRectConstraint constraint) {
+    SkASSERT(paint.getStyle() == SkPaint::kFill_Style);
+    SkASSERT(!paint.getPathEffect());
+
+    // Unlike the default, which draws each entry as its own drawImageRect() inside a save/restore,
+    // this decodes each image once for a run of entries drawing from it, only changes the matrix
+    // when an entry's pre-view matrix does, and blits unscaled, pixel aligned entries as sprites.
+    const SkMatrix baseLocalToDevice = this->localToDevice();
+    const bool spritesOK = !paint.getMaskFilter() && !SkDrawTiler::NeedsTiling(this);
+    SkPaint entryPaint = paint;
+
+    const SkImage* image = nullptr;
+    SkBitmap bitmap;
+    bool hasBitmap = false;
+    int matrixIndex = -1;
+    int clipIndex = 0;
+    for (int i = 0; i < count; ++i) {
+        const SkCanvas::ImageSetEntry& entry = set[i];
+
+        SkASSERT(!entry.fHasClip || dstClips);
+        if (entry.fHasClip) {
+            // Dst clips become real clips, which need the default's save and restore.
+            if (matrixIndex >= 0) {
+                this->setLocalToDevice(baseLocalToDevice);
+                matrixIndex = -1;
+            }
+            this->INHERITED::drawEdgeAAImageSet(&entry, 1, dstClips + clipIndex, preViewMatrices,
+                                                paint, constraint);
+            clipIndex += 4;
+            continue;
+        }
+
+        SkASSERT(entry.fMatrixIndex < 0 || preViewMatrices);
+        if (entry.fMatrixIndex != matrixIndex) {
+            matrixIndex = entry.fMatrixIndex;
+            this->setLocalToDevice(matrixIndex < 0 ? baseLocalToDevice
+                                                   : SkMatrix::Concat(baseLocalToDevice,
+                                                                      preViewMatrices[matrixIndex]));
+        }
+
+        if (entry.fImage.get() != image) {
+            image = entry.fImage.get();
+            hasBitmap = as_IB(image)->getROPixels(&bitmap);
+        }
+        if (!hasBitmap) {
+            continue;
+        }
+
+        // Same as the default: antialias only when all four edges ask for it.
+        entryPaint.setAntiAlias(entry.fAAFlags == SkCanvas::kAll_QuadAAFlags);
+        entryPaint.setAlphaf(paint.getAlphaf() * entry.fAlpha);
+
+        int x, y;
+        SkBitmap subset;
+        if (spritesOK &&
+            is_sprite_entry(this->localToDevice(), bitmap, entry.fSrcRect, entry.fDstRect,
+                            entryPaint, &x, &y) &&
+            bitmap.extractSubset(&subset, entry.fSrcRect.round())) {
+            BDDraw(this).drawSprite(subset, x, y, entryPaint);
+        } else {
+            this->drawBitmapRect(bitmap, &entry.fSrcRect, entry.fDstRect, entryPaint, constraint);
+        }
+    }
+    if (matrixIndex >= 0) {
+        this->setLocalToDevice(baseLocalToDevice);
+    }
+}
+
 void SkBitmapDevice::drawGlyphRunList(const SkGlyphRunList& glyphRunList) {
     LOOP_TILER( drawGlyphRunList(glyphRunList, &fGlyphPainter), nullptr )
 }
@@ -30,6 +30,32 @@ bool SkImageGenerator::getPixels(const SkImageInfo& info, void* pixels, size_t r
     return this->onGetPixels(info, pixels, rowBytes, defaultOpts);
 }
 
+bool SkImageGenerator::getPixels(const SkImageInfo& info, void* pixels, size_t rowBytes,
+                                 const SkIPoint& origin) {
+    const SkIRect bounds = SkIRect::MakeSize(fInfo.dimensions());
+    const SkIRect subset = SkIRect::MakeXYWH(origin.x(), origin.y(), info.width(), info.height());
+    if (!bounds.contains(subset)) {
+        return false;
+    }
+    if (subset == bounds) {
+        return this->getPixels(info, pixels, rowBytes);
+    }
+    if (kUnknown_SkColorType == info.colorType() || nullptr == pixels ||
+            rowBytes < info.minRowBytes()) {
+        return false;
+    }
+    if (this->onGetSubsetPixels(info, pixels, rowBytes, origin)) {
+        return true;
+    }
+
+    SkBitmap full;
+    if (!full.tryAllocPixels(info.makeDimensions(fInfo.dimensions())) ||
+            !this->getPixels(full.info(), full.getPixels(), full.rowBytes())) {
+        return false;
+    }
+    return full.readPixels(info, pixels, rowBytes, origin.x(), origin.y());
+}
+
 bool SkImageGenerator::queryYUVA8(SkYUVASizeInfo* sizeInfo,
                                   SkYUVAIndex yuvaIndices[SkYUVAIndex::kIndexCount],
                                   SkYUVColorSpace* colorSpace) const {
@@ -69,6 +69,17 @@ public:
         return fMap.count();
     }
 
+    /** Returns the value which would be evicted next, or nullptr if the cache is empty. */
+    V* leastRecentlyUsed() {
+        Entry* entry = fLRU.tail();
+        return entry ? &entry->fValue : nullptr;
+    }
+
+    void removeLeastRecentlyUsed() {
+        SkASSERT(fLRU.tail());
+        this->remove(fLRU.tail()->fKey);
+    }
+
     template <typename Fn>  // f(K*, V*)
     void foreach(Fn&& fn) {
         typename SkTInternalLList<Entry>::Iter iter;
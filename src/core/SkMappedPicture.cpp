@@ -0,0 +1,161 @@
+/*
+ * Copyright 2020 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "src/core/SkMappedPicture.h"
+
+#include "include/core/SkSerialProcs.h"
+#include "include/core/SkStream.h"
+#include "include/core/SkTextBlob.h"
+#include "include/core/SkTypeface.h"
+#include "include/core/SkVertices.h"
+#include "src/core/SkPictureData.h"
+#include "src/core/SkPictureFlat.h"
+#include "src/core/SkPicturePlayback.h"
+#include "src/core/SkPicturePriv.h"
+#include "src/core/SkPtrRecorder.h"
+#include "src/core/SkReadBuffer.h"
+#include "src/core/SkWriteBuffer.h"
+
+// A mapped picture is laid out as follows, every part starting 4-byte aligned:
+//   char[8]    kMagic
+//   uint32_t   kFormatVersion
+//   uint32_t   byte size of the typeface table
+//   typefaces  uint32_t count, then each SkTypeface::serialize()d, padded to 4 bytes
+//   picture    as written by SkPicturePriv::Flatten() with the typefaces above as its table
+//
+// The picture part is read in place by an SkReadBuffer. Its version travels in its own header,
+// kFormatVersion only covers the layout above.
+static const char kMagic[] = { 's', 'k', 'i', 'a', 'p', 'm', 'a', 'p' };
+static constexpr uint32_t kFormatVersion = 1;
+static constexpr size_t kHeaderSize = sizeof(kMagic) + 2 * sizeof(uint32_t);
+
+sk_sp<SkData> SkMappedPicture::Serialize(const SkPicture* picture, const SkSerialProcs* procs) {
+    SkBinaryWriteBuffer buffer;
+    if (procs) {
+        buffer.setSerialProcs(*procs);
+    }
+    auto typefaceSet = sk_make_sp<SkRefCntSet>();
+    buffer.setTypefaceRecorder(typefaceSet);
+    SkPicturePriv::Flatten(sk_ref_sp(picture), buffer);
+
+    SkDynamicMemoryWStream typefaces;
+    int count = typefaceSet->count();
+    typefaces.write32(count);
+    SkAutoSTMalloc<16, SkTypeface*> array(count);
+    typefaceSet->copyToArray((SkRefCnt**)array.get());
+    for (int i = 0; i < count; ++i) {
+        array[i]->serialize(&typefaces);
+    }
+    typefaces.padToAlign4();
+
+    SkDynamicMemoryWStream stream;
+    stream.write(kMagic, sizeof(kMagic));
+    stream.write32(kFormatVersion);
+    stream.write32(SkToU32(typefaces.bytesWritten()));
+    typefaces.writeToAndReset(&stream);
+    buffer.writeToStream(&stream);
+    return stream.detachAsData();
+}
+
+sk_sp<SkPicture> SkMappedPicture::Make(sk_sp<SkData> data, const SkDeserialProcs* procsPtr) {
+    // SkReadBuffer reads 4-byte aligned memory; mappings and SkData allocations always are.
+    if (!data || data->size() < kHeaderSize || !SkIsAlign4((uintptr_t)data->data()) ||
+        0 != memcmp(data->data(), kMagic, sizeof(kMagic))) {
+        return nullptr;
+    }
+    SkDeserialProcs procs;
+    if (procsPtr) {
+        procs = *procsPtr;
+    }
+
+    const uint8_t* bytes = data->bytes();
+    uint32_t version, typefaceSize;
+    memcpy(&version, bytes + sizeof(kMagic), sizeof(version));
+    memcpy(&typefaceSize, bytes + sizeof(kMagic) + sizeof(version), sizeof(typefaceSize));
+    if (version != kFormatVersion || !SkIsAlign4(typefaceSize) ||
+        typefaceSize > data->size() - kHeaderSize) {
+        return nullptr;
+    }
+
+    // Typefaces are few and small, they are created up front.
+    SkMemoryStream typefaceStream(bytes + kHeaderSize, typefaceSize, false);
+    uint32_t count;
+    if (!typefaceStream.readU32(&count) || count > typefaceSize) {
+        return nullptr;
+    }
+    SkTypefacePlayback typefaces;
+    typefaces.setCount(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        sk_sp<SkTypeface> tf = SkTypeface::MakeDeserialize(&typefaceStream);
+        typefaces[i] = tf ? std::move(tf) : SkTypeface::MakeDefault();
+    }
+
+    const size_t pictureOffset = kHeaderSize + typefaceSize;
+    SkReadBuffer buffer(bytes + pictureOffset, data->size() - pictureOffset);
+    buffer.setDeserialProcs(procs);
+    typefaces.setupBuffer(buffer);
+
+    SkPictInfo info;
+    if (!SkPicture::BufferIsSKP(&buffer, &info)) {
+        return nullptr;
+    }
+    if (buffer.read32() != 1) {
+        // Custom or empty pictures have nothing to play back in place.
+        SkReadBuffer fallback(bytes + pictureOffset, data->size() - pictureOffset);
+        fallback.setDeserialProcs(procs);
+        typefaces.setupBuffer(fallback);
+        return SkPicturePriv::MakeFromBuffer(fallback);
+    }
+
+    std::unique_ptr<SkPictureData> pictureData(
+            SkPictureData::CreateFromMappedBuffer(buffer, info, std::move(data)));
+    if (!pictureData || !pictureData->opData()) {
+        return nullptr;
+    }
+    return sk_sp<SkPicture>(new SkMappedPicture(info.fCullRect, std::move(pictureData)));
+}
+
+SkMappedPicture::SkMappedPicture(const SkRect& cull, std::unique_ptr<SkPictureData> data)
+    : fCullRect(cull)
+    , fData(std::move(data)) {}
+
+SkMappedPicture::~SkMappedPicture() = default;
+
+void SkMappedPicture::playback(SkCanvas* canvas, AbortCallback* callback) const {
+    SkPicturePlayback playback(fData.get());
+    playback.draw(canvas, callback, nullptr);
+}
+
+int SkMappedPicture::approximateOpCount() const {
+    // Walk the op headers the first time we're asked, without decoding the ops.
+    fOpCountOnce([this] {
+        SkReadBuffer reader(fData->opData()->data(), fData->opData()->size());
+        int count = 0;
+        while (!reader.eof() && reader.isValid()) {
+            uint32_t bits = reader.readUInt();
+            uint32_t size = bits & 0xffffff;
+            size_t consumed = 4;
+            if (size == 0xffffff) {
+                // SkPictureRecord::addDraw() adds 1 (not 4) to the size for the extra word.
+                size = reader.readUInt() + 3;
+                consumed = 8;
+            }
+            if (!reader.validate(size >= consumed && SkIsAlign4(size)) ||
+                !reader.skip(size - consumed)) {
+                break;
+            }
+            ++count;
+        }
+        fOpCount = count;
+    });
+    return fOpCount;
+}
+
+size_t SkMappedPicture::approximateBytesUsed() const {
+    // The ops themselves live in the mapping; count them anyway, they are paged in when drawn.
+    return sizeof(*this) + fData->opData()->size();
+}
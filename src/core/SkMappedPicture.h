@@ -0,0 +1,50 @@
+/*
+ * Copyright 2020 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkMappedPicture_DEFINED
+#define SkMappedPicture_DEFINED
+
+#include "include/core/SkData.h"
+#include "include/core/SkPicture.h"
+#include "include/core/SkRect.h"
+#include "include/private/SkOnce.h"
+
+#include <memory>
+
+class SkPictureData;
+struct SkDeserialProcs;
+struct SkSerialProcs;
+
+// An SkPicture which plays its drawing commands back straight from serialized data, typically a
+// memory mapped file. Commands are decoded as they are drawn rather than when the picture is
+// created, but the paints, paths, text blobs, images and pictures they refer to are decoded up
+// front; see SkPicture::MakeFromMappedData(). There is no SkBBoxHierarchy, playback walks the
+// whole command stream whatever the clip.
+class SkMappedPicture final : public SkPicture {
+public:
+    static sk_sp<SkData> Serialize(const SkPicture*, const SkSerialProcs*);
+    static sk_sp<SkPicture> Make(sk_sp<SkData>, const SkDeserialProcs*);
+
+    ~SkMappedPicture() override;
+
+// SkPicture overrides
+    void playback(SkCanvas*, AbortCallback*) const override;
+    SkRect cullRect() const override { return fCullRect; }
+    int approximateOpCount() const override;
+    size_t approximateBytesUsed() const override;
+
+private:
+    SkMappedPicture(const SkRect& cull, std::unique_ptr<SkPictureData>);
+
+    const SkRect                         fCullRect;
+    std::unique_ptr<const SkPictureData> fData;
+
+    mutable SkOnce fOpCountOnce;
+    mutable int    fOpCount = 0;
+};
+
+#endif
@@ -43,7 +43,16 @@ namespace SkOpts {
                            RGB_to_BGR1,     // i.e. swap RB and insert an opaque alpha
                            gray_to_RGB1,    // i.e. expand to color channels + an opaque alpha
                            grayA_to_RGBA,   // i.e. expand to color channels
-                           grayA_to_rgbA;   // i.e. expand to color channels and premultiply
+                           grayA_to_rgbA,   // i.e. expand to color channels and premultiply
+                           RGB16_to_RGB1,   // i.e. strip 16-bit components to 8 + an opaque alpha
+                           RGB16_to_BGR1,   // i.e. strip to 8 bits, swap RB + an opaque alpha
+                           RGBA16_to_RGBA,  // i.e. strip 16-bit components to 8
+                           RGBA16_to_BGRA;  // i.e. strip 16-bit components to 8 and swap RB
+
+    // Look up each index in a color table of 8888 pixels.
+    typedef void (*Swizzle_8888_index)(uint32_t*, const uint8_t*, int, const uint32_t ctable[]);
+    extern Swizzle_8888_index index8_to_8888,  // one index per byte, 256 colors
+                              index4_to_8888;  // two per byte, high nibble first, 16 colors
 
     extern void (*memset16)(uint16_t[], uint16_t, int);
     extern void SK_SPI(*memset32)(uint32_t[], uint32_t, int);
@@ -17,6 +17,7 @@
 #include "src/core/SkCubicClipper.h"
 #include "src/core/SkGeometry.h"
 #include "src/core/SkMatrixPriv.h"
+#include "src/core/SkOpts.h"
 #include "src/core/SkPathMakers.h"
 #include "src/core/SkPathPriv.h"
 #include "src/core/SkPointPriv.h"
@@ -3657,3 +3658,11 @@ bool SkPathPriv::PerspectiveClip(const SkPath& path, const SkMatrix& matrix, SkP
 int SkPathPriv::GenIDChangeListenersCount(const SkPath& path) {
     return path.fPathRef->genIDChangeListenerCount();
 }
+
+uint32_t SkPathPriv::ContentHash(const SkPath& path) {
+    const SkPathRef& ref = *path.fPathRef;
+    uint32_t hash = SkOpts::hash(ref.points(), ref.countPoints() * sizeof(SkPoint),
+                                 (uint32_t)path.getFillType());
+    hash = SkOpts::hash(ref.verbsBegin(), ref.countVerbs(), hash);
+    return SkOpts::hash(ref.conicWeights(), ref.countWeights() * sizeof(SkScalar), hash);
+}
@@ -335,6 +335,18 @@ public:
      * at some point during the execution of the function.
      */
     static int GenIDChangeListenersCount(const SkPath&);
+
+    /**
+     *  Returns a hash of the path's fill type, verbs, points and conic weights.  Unlike the
+     *  generation ID, paths built independently with the same contents (i.e. paths which are ==)
+     *  hash the same.
+     */
+    static uint32_t ContentHash(const SkPath&);
+
+    // Hashes paths by ContentHash(), for SkTHashMap and SkTHashSet.
+    struct ContentHasher {
+        uint32_t operator()(const SkPath& path) const { return ContentHash(path); }
+    };
 };
 
 // Lightweight variant of SkPath::Iter that only returns segments (e.g. lines/conics).
@@ -11,6 +11,7 @@
 #include "include/core/SkPictureRecorder.h"
 #include "include/core/SkSerialProcs.h"
 #include "include/private/SkTo.h"
+#include "src/core/SkMappedPicture.h"
 #include "src/core/SkMathPriv.h"
 #include "src/core/SkPictureCommon.h"
 #include "src/core/SkPictureData.h"
@@ -153,6 +154,11 @@ sk_sp<SkPicture> SkPicture::MakeFromData(const SkData* data, const SkDeserialPro
     return MakeFromStream(&stream, procs, nullptr);
 }
 
+sk_sp<SkPicture> SkPicture::MakeFromMappedData(sk_sp<SkData> data,
+                                               const SkDeserialProcs* procs) {
+    return SkMappedPicture::Make(std::move(data), procs);
+}
+
 sk_sp<SkPicture> SkPicture::MakeFromStream(SkStream* stream, const SkDeserialProcs* procsPtr,
                                            SkTypefacePlayback* typefaces) {
     SkPictInfo info;
@@ -233,6 +239,10 @@ sk_sp<SkData> SkPicture::serialize(const SkSerialProcs* procs) const {
     return stream.detachAsData();
 }
 
+sk_sp<SkData> SkPicture::serializeForMapping(const SkSerialProcs* procs) const {
+    return SkMappedPicture::Serialize(this, procs);
+}
+
 static sk_sp<SkData> custom_serialize(const SkPicture* picture, const SkSerialProcs& procs) {
     if (procs.fPictureProc) {
         auto data = procs.fPictureProc(const_cast<SkPicture*>(picture), procs.fPictureCtx);
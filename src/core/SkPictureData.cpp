@@ -11,6 +11,7 @@
 #include "include/core/SkTypeface.h"
 #include "include/private/SkTo.h"
 #include "src/core/SkAutoMalloc.h"
+#include "src/core/SkPathPriv.h"
 #include "src/core/SkPicturePriv.h"
 #include "src/core/SkPictureRecord.h"
 #include "src/core/SkReadBuffer.h"
@@ -429,15 +430,35 @@ void SkPictureData::parseBufferTag(SkReadBuffer& buffer, uint32_t tag, uint32_t
                 if (!buffer.validate(count >= 0)) {
                     return;
                 }
+                // Pictures written before paths were deduplicated by contents may hold many
+                // copies of the same path.  Those copies share the first one's SkPathRef.
+                SkTHashMap<SkPath, int, SkPathPriv::ContentHasher> unique;
                 for (int i = 0; i < count; i++) {
-                    buffer.readPath(&fPaths.push_back());
+                    SkPath& path = fPaths.push_back();
+                    buffer.readPath(&path);
                     if (!buffer.isValid()) {
                         return;
                     }
+                    if (int* first = unique.find(path)) {
+                        path = fPaths[*first];
+                    } else {
+                        unique.set(path, i);
+                    }
                 }
             } break;
         case SK_PICT_TEXTBLOB_BUFFER_TAG:
-            new_array_from_buffer(buffer, size, fTextBlobs, SkTextBlobPriv::MakeFromBuffer);
+            if (new_array_from_buffer(buffer, size, fTextBlobs, SkTextBlobPriv::MakeFromBuffer)) {
+                // Likewise, duplicate text blobs from older pictures are replaced by the first.
+                SkTHashMap<SkTextBlobContentKey, int, SkTextBlobContentKey::Hash> unique;
+                for (int i = 0; i < fTextBlobs.count(); i++) {
+                    SkTextBlobContentKey key{fTextBlobs[i]};
+                    if (int* first = unique.find(key)) {
+                        fTextBlobs[i] = fTextBlobs[*first];
+                    } else {
+                        unique.set(std::move(key), i);
+                    }
+                }
+            }
             break;
         case SK_PICT_VERTICES_BUFFER_TAG:
             new_array_from_buffer(buffer, size, fVertices, create_vertices_from_buffer);
@@ -446,6 +467,18 @@ void SkPictureData::parseBufferTag(SkReadBuffer& buffer, uint32_t tag, uint32_t
             new_array_from_buffer(buffer, size, fImages, create_image_from_buffer);
             break;
         case SK_PICT_READER_TAG: {
+            if (fMapping) {
+                // Refer to the ops where they are instead of copying them.
+                const uint32_t count = buffer.readUInt();
+                const uint8_t* ops = static_cast<const uint8_t*>(buffer.skip(size));
+                const uint8_t* base = fMapping->bytes();
+                if (!buffer.validate(count == size && ops && nullptr == fOpData &&
+                                     ops >= base && ops + size <= base + fMapping->size())) {
+                    return;
+                }
+                fOpData = SkData::MakeSubset(fMapping.get(), ops - base, size);
+                break;
+            }
             // Preflight check that we can initialize all data from the buffer
             // before allocating it.
             if (!buffer.validateCanReadN<uint8_t>(size)) {
@@ -497,6 +530,21 @@ SkPictureData* SkPictureData::CreateFromBuffer(SkReadBuffer& buffer,
     return data.release();
 }
 
+SkPictureData* SkPictureData::CreateFromMappedBuffer(SkReadBuffer& buffer,
+                                                     const SkPictInfo& info,
+                                                     sk_sp<SkData> mapping) {
+    std::unique_ptr<SkPictureData> data(new SkPictureData(info));
+    buffer.setVersion(info.getVersion());
+    data->fMapping = std::move(mapping);
+
+    bool success = data->parseBuffer(buffer);
+    data->fMapping = nullptr;
+    if (!success) {
+        return nullptr;
+    }
+    return data.release();
+}
+
 bool SkPictureData::parseStream(SkStream* stream,
                                 const SkDeserialProcs& procs,
                                 SkTypefacePlayback* topLevelTFPlayback) {
@@ -83,6 +83,10 @@ public:
                                            const SkDeserialProcs&,
                                            SkTypefacePlayback*);
     static SkPictureData* CreateFromBuffer(SkReadBuffer&, const SkPictInfo&);
+    // Like CreateFromBuffer(), for a buffer reading straight from mapping. The op data is not
+    // copied out of the mapping but refers to it.
+    static SkPictureData* CreateFromMappedBuffer(SkReadBuffer&, const SkPictInfo&,
+                                                 sk_sp<SkData> mapping);
 
     void serialize(SkWStream*, const SkSerialProcs&, SkRefCntSet*, bool textBlobsOnly=false) const;
     void flatten(SkWriteBuffer&) const;
@@ -146,6 +150,7 @@ private:
     SkTArray<SkPath>   fPaths;
 
     sk_sp<SkData>   fOpData;    // opcodes and parameters
+    sk_sp<SkData>   fMapping;   // set while parsing a mapped buffer, see CreateFromMappedBuffer
 
     const SkPath    fEmptyPath;
     const SkBitmap  fEmptyBitmap;
@@ -968,7 +968,14 @@ void SkPictureRecord::addText(const void* text, size_t byteLength) {
 
 void SkPictureRecord::addTextBlob(const SkTextBlob* blob) {
     // follow the convention of recording a 1-based index
-    this->addInt(find_or_append(fTextBlobs, blob) + 1);
+    SkTextBlobContentKey key{sk_ref_sp(blob)};
+    if (int* n = fTextBlobIndices.find(key)) {
+        this->addInt(*n);
+        return;
+    }
+    fTextBlobs.push_back(key.fBlob);
+    fTextBlobIndices.set(std::move(key), fTextBlobs.count());
+    this->addInt(fTextBlobs.count());
 }
 
 void SkPictureRecord::addVertices(const SkVertices* vertices) {
@@ -17,7 +17,9 @@
 #include "include/private/SkTDArray.h"
 #include "include/private/SkTHash.h"
 #include "include/private/SkTo.h"
+#include "src/core/SkPathPriv.h"
 #include "src/core/SkPictureData.h"
+#include "src/core/SkTextBlobPriv.h"
 #include "src/core/SkWriter32.h"
 
 // These macros help with packing and unpacking a single byte value and
@@ -234,10 +236,9 @@ protected:
 private:
     SkTArray<SkPaint>  fPaints;
 
-    struct PathHash {
-        uint32_t operator()(const SkPath& p) { return p.getGenerationID(); }
-    };
-    SkTHashMap<SkPath, int, PathHash> fPaths;
+    // Paths and text blobs are written once per distinct contents, however many copies of them
+    // were drawn.
+    SkTHashMap<SkPath, int, SkPathPriv::ContentHasher> fPaths;
 
     SkWriter32 fWriter;
 
@@ -245,6 +246,7 @@ private:
     SkTArray<sk_sp<const SkPicture>>  fPictures;
     SkTArray<sk_sp<SkDrawable>>       fDrawables;
     SkTArray<sk_sp<const SkTextBlob>> fTextBlobs;
+    SkTHashMap<SkTextBlobContentKey, int, SkTextBlobContentKey::Hash> fTextBlobIndices;
     SkTArray<sk_sp<const SkVertices>> fVertices;
 
     uint32_t fRecordFlags;
@@ -34,6 +34,16 @@ SkCanvas* SkPictureRecorder::beginRecording(const SkRect& userCullRect,
     fFlags = recordFlags;
     fBBH = std::move(bbh);
 
+    if (!fRecord && (recordFlags & kRecycleRecord_RecordFlag)) {
+        // A record only we refer to belongs to a picture which has since been destroyed.
+        for (sk_sp<SkRecord>& recycled : fRecycled) {
+            if (recycled && recycled->unique()) {
+                fRecord = std::move(recycled);
+                fRecord->reset();
+                break;
+            }
+        }
+    }
     if (!fRecord) {
         fRecord.reset(new SkRecord);
     }
@@ -41,6 +51,14 @@ SkCanvas* SkPictureRecorder::beginRecording(const SkRect& userCullRect,
         ? SkRecorder::Playback_DrawPictureMode
         : SkRecorder::Record_DrawPictureMode;
     fRecorder->reset(fRecord.get(), cullRect, dpm, fMiniRecorder.get());
+    fRecorder->setDeduplicate(recordFlags & kDeduplicate_RecordFlag);
+    if (fBBH) {
+        if (!fBoundsTracker) {
+            fBoundsTracker.reset(new SkRecordBoundsTracker);
+        }
+        fBoundsTracker->reset(*fRecord, cullRect, recordFlags & kConservativeBounds_RecordFlag);
+        fRecorder->setBoundsTracker(fBoundsTracker.get());
+    }
     fActivelyRecording = true;
     return this->getRecordingCanvas();
 }
@@ -58,6 +76,7 @@ SkCanvas* SkPictureRecorder::getRecordingCanvas() {
 sk_sp<SkPicture> SkPictureRecorder::finishRecordingAsPicture(uint32_t finishFlags) {
     fActivelyRecording = false;
     fRecorder->restoreToCount(1);  // If we were missing any restores, add them now.
+    fRecorder->setDeduplicate(false);
 
     if (fRecord->count() == 0) {
         auto pic = fMiniRecorder->detachAsPicture(fBBH ? nullptr : &fCullRect);
@@ -71,29 +90,66 @@ sk_sp<SkPicture> SkPictureRecorder::finishRecordingAsPicture(uint32_t finishFlag
         return pic;
     }
 
+    // The bounds tracked while recording are only good for the cull rect they were tracked with.
+    SkRecordBoundsTracker* tracker = fBBH && fCullRect == fBoundsTracker->cullRect()
+                                   ? fBoundsTracker.get() : nullptr;
+
     // TODO: delay as much of this work until just before first playback?
-    SkRecordOptimize(fRecord.get());
+    if (tracker) {
+        tracker->finish();
+        SkRecordOptimize(fRecord.get(), tracker->bounds(), tracker->meta());
+    } else {
+        SkRecordOptimize(fRecord.get());
+    }
 
     SkDrawableList* drawableList = fRecorder->getDrawableList();
     std::unique_ptr<SkBigPicture::SnapshotArray> pictList{
         drawableList ? drawableList->newDrawableSnapshot() : nullptr
     };
 
-    if (fBBH.get()) {
-        SkAutoTMalloc<SkRect> bounds(fRecord->count());
-        SkAutoTMalloc<SkBBoxHierarchy::Metadata> meta(fRecord->count());
-        SkRecordFillBounds(fCullRect, *fRecord, bounds, meta);
+    const bool cullOccludedOps = finishFlags & kCullOccludedOps_FinishFlag;
+    SkTDArray<SkBigPicture::Occluder> occluders;
+    if (fBBH.get() || cullOccludedOps) {
+        SkAutoTMalloc<SkRect> filledBounds;
+        SkAutoTMalloc<SkBBoxHierarchy::Metadata> filledMeta;
+        SkRect* bounds = tracker ? tracker->bounds() : nullptr;
+        SkBBoxHierarchy::Metadata* meta = tracker ? tracker->meta() : nullptr;
+        if (!tracker) {
+            bounds = filledBounds.reset(fRecord->count());
+            meta = filledMeta.reset(fRecord->count());
+            SkRecordFillBounds(fCullRect, *fRecord, bounds, meta,
+                               fFlags & kConservativeBounds_RecordFlag);
+        }
 
-        fBBH->insert(bounds, meta, fRecord->count());
+        if (cullOccludedOps) {
+            SkAutoTMalloc<SkRect> occluderRects(fRecord->count());
+            SkAutoTMalloc<bool> barriers(fRecord->count());
+            SkRecordFillOccluders(*fRecord, occluderRects, barriers);
+            SkRecordNoopOccludedDraws(fRecord.get(), bounds, occluderRects, barriers);
+            for (int i = 0; i < fRecord->count(); i++) {
+                if (!occluderRects[i].isEmpty()) {
+                    occluders.push_back({i, occluderRects[i]});
+                }
+            }
+        }
 
-        // Now that we've calculated content bounds, we can update fCullRect, often trimming it.
-        SkRect bbhBound = SkRect::MakeEmpty();
-        for (int i = 0; i < fRecord->count(); i++) {
-            bbhBound.join(bounds[i]);
+        if (fBBH.get()) {
+            fBBH->insert(bounds, meta, fRecord->count());
+
+            // Now that we've calculated content bounds, we can update fCullRect, often trimming it.
+            SkRect bbhBound = SkRect::MakeEmpty();
+            for (int i = 0; i < fRecord->count(); i++) {
+                bbhBound.join(bounds[i]);
+            }
+            SkASSERT((bbhBound.isEmpty() || fCullRect.contains(bbhBound))
+                  || (bbhBound.isEmpty() && fCullRect.isEmpty()));
+            fCullRect = bbhBound;
         }
-        SkASSERT((bbhBound.isEmpty() || fCullRect.contains(bbhBound))
-              || (bbhBound.isEmpty() && fCullRect.isEmpty()));
-        fCullRect = bbhBound;
+    }
+
+    if (fFlags & kRecycleRecord_RecordFlag) {
+        fRecycled[0] = std::move(fRecycled[1]);
+        fRecycled[1] = fRecord;
     }
 
     size_t subPictureBytes = fRecorder->approxBytesUsedBySubPictures();
@@ -104,7 +160,8 @@ sk_sp<SkPicture> SkPictureRecorder::finishRecordingAsPicture(uint32_t finishFlag
                                     std::move(fRecord),
                                     std::move(pictList),
                                     std::move(fBBH),
-                                    subPictureBytes);
+                                    subPictureBytes,
+                                    std::move(occluders));
 }
 
 sk_sp<SkPicture> SkPictureRecorder::finishRecordingAsPictureWithCull(const SkRect& cullRect,
@@ -133,13 +190,15 @@ sk_sp<SkDrawable> SkPictureRecorder::finishRecordingAsDrawable(uint32_t finishFl
     fActivelyRecording = false;
     fRecorder->flushMiniRecorder();
     fRecorder->restoreToCount(1);  // If we were missing any restores, add them now.
+    fRecorder->setDeduplicate(false);
 
     SkRecordOptimize(fRecord.get());
 
     if (fBBH.get()) {
         SkAutoTMalloc<SkRect> bounds(fRecord->count());
         SkAutoTMalloc<SkBBoxHierarchy::Metadata> meta(fRecord->count());
-        SkRecordFillBounds(fCullRect, *fRecord, bounds, meta);
+        SkRecordFillBounds(fCullRect, *fRecord, bounds, meta,
+                           fFlags & kConservativeBounds_RecordFlag);
         fBBH->insert(bounds, meta, fRecord->count());
     }
 
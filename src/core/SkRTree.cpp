@@ -7,159 +7,224 @@
 
 #include "src/core/SkRTree.h"
 
+#include "include/private/SkNx.h"
+#include "src/core/SkRectPriv.h"
+
+#include <algorithm>
+
 SkRTree::SkRTree() : fCount(0) {}
 
+// Returns the distance of (x,y) along the Hilbert curve filling a 2^16 x 2^16 grid.
+static uint32_t hilbert_index(uint32_t x, uint32_t y) {
+    static constexpr uint32_t kSize = 1 << 16;
+    uint32_t d = 0;
+    for (uint32_t s = kSize / 2; s > 0; s /= 2) {
+        uint32_t rx = (x & s) ? 1 : 0,
+                 ry = (y & s) ? 1 : 0;
+        d += s * s * ((3 * rx) ^ ry);
+        // Rotate the quadrant so the curve inside it starts where the previous one ended.
+        if (ry == 0) {
+            if (rx == 1) {
+                x = kSize - 1 - x;
+                y = kSize - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return d;
+}
+
+static void set_empty(float* l, float* t, float* r, float* b) {
+    *l = *t = SK_ScalarInfinity;
+    *r = *b = SK_ScalarNegativeInfinity;
+}
+
 void SkRTree::insert(const SkRect boundsArray[], int N) {
     SkASSERT(0 == fCount);
 
-    std::vector<Branch> branches;
-    branches.reserve(N);
+    // Sort the non-empty rects along the Hilbert curve through their centers.  The op index
+    // breaks ties, keeping rects with the same center in their original order.
+    SkRect centers = SkRectPriv::MakeLargestInverted();
+    for (int i = 0; i < N; i++) {
+        const SkRect& bounds = boundsArray[i];
+        if (!bounds.isEmpty()) {
+            centers.fLeft   = std::min(centers.fLeft,   bounds.centerX());
+            centers.fTop    = std::min(centers.fTop,    bounds.centerY());
+            centers.fRight  = std::max(centers.fRight,  bounds.centerX());
+            centers.fBottom = std::max(centers.fBottom, bounds.centerY());
+        }
+    }
+    const float scaleX = centers.width()  > 0 ? 65535 / centers.width()  : 0,
+                scaleY = centers.height() > 0 ? 65535 / centers.height() : 0;
 
+    std::vector<uint64_t> keys;
+    keys.reserve(N);
     for (int i = 0; i < N; i++) {
         const SkRect& bounds = boundsArray[i];
         if (bounds.isEmpty()) {
             continue;
         }
-
-        Branch b;
-        b.fBounds = bounds;
-        b.fOpIndex = i;
-        branches.push_back(b);
-    }
-
-    fCount = (int)branches.size();
-    if (fCount) {
-        if (1 == fCount) {
-            fNodes.reserve(1);
-            Node* n = this->allocateNodeAtLevel(0);
-            n->fNumChildren = 1;
-            n->fChildren[0] = branches[0];
-            fRoot.fSubtree = n;
-            fRoot.fBounds  = branches[0].fBounds;
-        } else {
-            fNodes.reserve(CountNodes(fCount));
-            fRoot = this->bulkLoad(&branches);
-        }
+        float x = SkTPin((bounds.centerX() - centers.fLeft) * scaleX, 0.0f, 65535.0f),
+              y = SkTPin((bounds.centerY() - centers.fTop ) * scaleY, 0.0f, 65535.0f);
+        keys.push_back((uint64_t)hilbert_index((uint32_t)x, (uint32_t)y) << 32 | (uint32_t)i);
     }
-}
+    std::sort(keys.begin(), keys.end());
 
-SkRTree::Node* SkRTree::allocateNodeAtLevel(uint16_t level) {
-    SkDEBUGCODE(Node* p = fNodes.data());
-    fNodes.push_back(Node{});
-    Node& out = fNodes.back();
-    SkASSERT(fNodes.data() == p);  // If this fails, we didn't reserve() enough.
-    out.fNumChildren = 0;
-    out.fLevel = level;
-    return &out;
-}
+    fCount = (int)keys.size();
+    if (fCount == 0) {
+        return;
+    }
 
-// This function parallels bulkLoad, but just counts how many nodes bulkLoad would allocate.
-int SkRTree::CountNodes(int branches) {
-    if (branches == 1) {
-        return 1;
-    }
-    int numBranches = branches / kMaxChildren;
-    int remainder   = branches % kMaxChildren;
-    if (remainder > 0) {
-        numBranches++;
-        if (remainder >= kMinChildren) {
-            remainder = 0;
-        } else {
-            remainder = kMinChildren - remainder;
+    int nodes = 0;
+    for (int count = fCount; ; ) {
+        count = (count + kFanout - 1) / kFanout;
+        nodes += count;
+        if (count == 1) {
+            break;
         }
     }
-    int currentBranch = 0;
-    int nodes = 0;
-    while (currentBranch < branches) {
-        int incrementBy = kMaxChildren;
-        if (remainder != 0) {
-            if (remainder <= kMaxChildren - kMinChildren) {
-                incrementBy -= remainder;
-                remainder = 0;
-            } else {
-                incrementBy = kMinChildren;
-                remainder -= kMaxChildren - kMinChildren;
-            }
+    fNodes.resize(nodes);
+    for (Node& node : fNodes) {
+        for (int i = 0; i < kFanout; i++) {
+            set_empty(&node.fLeft[i], &node.fTop[i], &node.fRight[i], &node.fBottom[i]);
         }
-        nodes++;
-        currentBranch++;
-        for (int k = 1; k < incrementBy && currentBranch < branches; ++k) {
-            currentBranch++;
+    }
+
+    // Pack the sorted rects into the leaves...
+    fOpIndices.resize(fCount);
+    for (int i = 0; i < fCount; i++) {
+        const int op = (int)(uint32_t)keys[i];
+        const SkRect& bounds = boundsArray[op];
+        Node& node = fNodes[i / kFanout];
+        node.fLeft  [i % kFanout] = bounds.fLeft;
+        node.fTop   [i % kFanout] = bounds.fTop;
+        node.fRight [i % kFanout] = bounds.fRight;
+        node.fBottom[i % kFanout] = bounds.fBottom;
+        fOpIndices[i] = op;
+    }
+    fLevels.push_back(0);
+
+    // ...then pack the bounds of each level's nodes into the level above, up to a single root.
+    int levelCount = (fCount + kFanout - 1) / kFanout;
+    while (levelCount > 1) {
+        const int below = fLevels.back(),
+                  above = below + levelCount;
+        for (int i = 0; i < levelCount; i++) {
+            const Node& child = fNodes[below + i];
+            Node& node = fNodes[above + i / kFanout];
+            float* l = &node.fLeft  [i % kFanout];
+            float* t = &node.fTop   [i % kFanout];
+            float* r = &node.fRight [i % kFanout];
+            float* b = &node.fBottom[i % kFanout];
+            for (int j = 0; j < kFanout; j++) {
+                *l = std::min(*l, child.fLeft  [j]);
+                *t = std::min(*t, child.fTop   [j]);
+                *r = std::max(*r, child.fRight [j]);
+                *b = std::max(*b, child.fBottom[j]);
+            }
         }
+        fLevels.push_back(above);
+        levelCount = (levelCount + kFanout - 1) / kFanout;
     }
-    return nodes + CountNodes(nodes);
+    SkASSERT(fLevels.back() == nodes - 1);
 }
 
-SkRTree::Branch SkRTree::bulkLoad(std::vector<Branch>* branches, int level) {
-    if (branches->size() == 1) { // Only one branch.  It will be the root.
-        return (*branches)[0];
-    }
-
-    // We might sort our branches here, but we expect Blink gives us a reasonable x,y order.
-    // Skipping a call to sort (in Y) here resulted in a 17% win for recording with negligible
-    // difference in playback speed.
-    int numBranches = (int)branches->size() / kMaxChildren;
-    int remainder   = (int)branches->size() % kMaxChildren;
-    int newBranches = 0;
-
-    if (remainder > 0) {
-        ++numBranches;
-        // If the remainder isn't enough to fill a node, we'll add fewer nodes to other branches.
-        if (remainder >= kMinChildren) {
-            remainder = 0;
-        } else {
-            remainder = kMinChildren - remainder;
-        }
+uint32_t SkRTree::Intersections(const Node& node, const SkRect& query) {
+    // This is SkRect::Intersects() for each child: the overlap must have a positive size.
+    Sk8f w = Sk8f::Min(Sk8f::Load(node.fRight ), query.fRight )
+           - Sk8f::Max(Sk8f::Load(node.fLeft  ), query.fLeft  ),
+         h = Sk8f::Min(Sk8f::Load(node.fBottom), query.fBottom)
+           - Sk8f::Max(Sk8f::Load(node.fTop   ), query.fTop   );
+    Sk8f hit = Sk8f::Min(w, h) > 0;
+    if (!hit.anyTrue()) {
+        return 0;
+    }
+    float lanes[kFanout];
+    hit.thenElse(1.0f, 0.0f).store(lanes);
+    uint32_t bits = 0;
+    for (int i = 0; i < kFanout; i++) {
+        bits |= (lanes[i] != 0) << i;
+    }
+    return bits;
+}
+
+void SkRTree::search(const SkRect& query, std::vector<int>* results) const {
+    if (fCount == 0 || query.isEmpty()) {
+        return;
     }
+    const size_t first = results->size();
+    this->search((int)fLevels.size() - 1, 0, query, results);
+    // Ops must be drawn in order, but were packed by position.
+    std::sort(results->begin() + first, results->end());
+}
 
-    int currentBranch = 0;
-    while (currentBranch < (int)branches->size()) {
-        int incrementBy = kMaxChildren;
-        if (remainder != 0) {
-            // if need be, omit some nodes to make up for remainder
-            if (remainder <= kMaxChildren - kMinChildren) {
-                incrementBy -= remainder;
-                remainder = 0;
+void SkRTree::search(int level, int node, const SkRect& query, std::vector<int>* results) const {
+    uint32_t hits = Intersections(fNodes[fLevels[level] + node], query);
+    for (int child = node * kFanout; hits; child++, hits >>= 1) {
+        if (hits & 1) {
+            if (0 == level) {
+                results->push_back(fOpIndices[child]);
             } else {
-                incrementBy = kMinChildren;
-                remainder -= kMaxChildren - kMinChildren;
+                this->search(level - 1, child, query, results);
             }
         }
-        Node* n = allocateNodeAtLevel(level);
-        n->fNumChildren = 1;
-        n->fChildren[0] = (*branches)[currentBranch];
-        Branch b;
-        b.fBounds = (*branches)[currentBranch].fBounds;
-        b.fSubtree = n;
-        ++currentBranch;
-        for (int k = 1; k < incrementBy && currentBranch < (int)branches->size(); ++k) {
-            b.fBounds.join((*branches)[currentBranch].fBounds);
-            n->fChildren[k] = (*branches)[currentBranch];
-            ++n->fNumChildren;
-            ++currentBranch;
-        }
-        (*branches)[newBranches] = b;
-        ++newBranches;
     }
-    branches->resize(newBranches);
-    return this->bulkLoad(branches, level + 1);
 }
 
-void SkRTree::search(const SkRect& query, std::vector<int>* results) const {
-    if (fCount > 0 && SkRect::Intersects(fRoot.fBounds, query)) {
-        this->search(fRoot.fSubtree, query, results);
+void SkRTree::searchBatch(const SkRect queries[], int count, std::vector<int> results[]) const {
+    if (fCount == 0) {
+        return;
+    }
+    std::vector<size_t> firsts(count);
+    std::vector<Active> active;
+    for (int i = 0; i < count; i++) {
+        firsts[i] = results[i].size();
+        if (!queries[i].isEmpty()) {
+            active.push_back({i, 0});
+        }
+    }
+    this->searchBatch((int)fLevels.size() - 1, 0, queries, &active, 0, (int)active.size(),
+                      results);
+    for (int i = 0; i < count; i++) {
+        std::sort(results[i].begin() + firsts[i], results[i].end());
     }
 }
 
-void SkRTree::search(Node* node, const SkRect& query, std::vector<int>* results) const {
-    for (int i = 0; i < node->fNumChildren; ++i) {
-        if (SkRect::Intersects(node->fChildren[i].fBounds, query)) {
-            if (0 == node->fLevel) {
-                results->push_back(node->fChildren[i].fOpIndex);
-            } else {
-                this->search(node->fChildren[i].fSubtree, query, results);
+void SkRTree::searchBatch(int level, int node, const SkRect queries[], std::vector<Active>* active,
+                          int activeStart, int activeEnd, std::vector<int> results[]) const {
+    // Each node is loaded once for all of the queries that reached it.
+    const Node& n = fNodes[fLevels[level] + node];
+    uint32_t anyHits = 0;
+    for (int i = activeStart; i < activeEnd; i++) {
+        Active& a = (*active)[i];
+        a.hits = Intersections(n, queries[a.query]);
+        anyHits |= a.hits;
+    }
+
+    for (int j = 0; j < kFanout; j++) {
+        if (!(anyHits & (1 << j))) {
+            continue;
+        }
+        const int child = node * kFanout + j;
+        if (0 == level) {
+            for (int i = activeStart; i < activeEnd; i++) {
+                const Active& a = (*active)[i];
+                if (a.hits & (1 << j)) {
+                    results[a.query].push_back(fOpIndices[child]);
+                }
+            }
+            continue;
+        }
+        // Queue the queries hitting this child after ours and recurse with just those.
+        const int childStart = (int)active->size();
+        for (int i = activeStart; i < activeEnd; i++) {
+            if ((*active)[i].hits & (1 << j)) {
+                active->push_back({(*active)[i].query, 0});
             }
         }
+        this->searchBatch(level - 1, child, queries, active, childStart, (int)active->size(),
+                          results);
+        active->resize(childStart);
     }
 }
 
@@ -167,6 +232,8 @@ size_t SkRTree::bytesUsed() const {
     size_t byteCount = sizeof(SkRTree);
 
     byteCount += fNodes.capacity() * sizeof(Node);
+    byteCount += fLevels.capacity() * sizeof(int);
+    byteCount += fOpIndices.capacity() * sizeof(int);
 
     return byteCount;
 }
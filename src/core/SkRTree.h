@@ -16,16 +16,16 @@
  * bounding rectangles.
  *
  * It only supports bulk-loading, i.e. creation from a batch of bounding rectangles.
- * This performs a bottom-up bulk load using the STR (sort-tile-recursive) algorithm.
+ * The rectangles are sorted along the Hilbert curve through their centers and then packed
+ * bottom-up, so every node is full except the last one of each level.  A packed tree needs no
+ * pointers: the children of node i are nodes [i*kFanout, (i+1)*kFanout) of the level below.
  *
- * TODO: Experiment with other bulk-load algorithms (in particular the Hilbert pack variant,
- * which groups rects by position on the Hilbert curve, is probably worth a look). There also
- * exist top-down bulk load variants (VAMSplit, TopDownGreedy, etc).
+ * Each node stores the bounds of its children as four arrays of floats (lefts, tops, rights,
+ * bottoms), so a query is tested against all children of a node with a handful of SIMD compares.
  *
  * For more details see:
  *
- *  Beckmann, N.; Kriegel, H. P.; Schneider, R.; Seeger, B. (1990). "The R*-tree:
- *      an efficient and robust access method for points and rectangles"
+ *  Kamel, I.; Faloutsos, C. (1993). "On packing R-trees"
  */
 class SkRTree : public SkBBoxHierarchy {
 public:
@@ -33,50 +33,49 @@ public:
 
     void insert(const SkRect[], int N) override;
     void search(const SkRect& query, std::vector<int>* results) const override;
+    void searchBatch(const SkRect queries[], int count,
+                     std::vector<int> results[]) const override;
     size_t bytesUsed() const override;
 
     // Methods and constants below here are only public for tests.
 
     // Return the depth of the tree structure.
-    int getDepth() const { return fCount ? fRoot.fSubtree->fLevel + 1 : 0; }
+    int getDepth() const { return (int)fLevels.size(); }
     // Insertion count (not overall node count, which may be greater).
     int getCount() const { return fCount; }
 
-    // These values were empirically determined to produce reasonable performance in most cases.
-    static const int kMinChildren = 6,
-                     kMaxChildren = 11;
+    // Eight children lets us test a node with one Sk8f compare per side.
+    static constexpr int kFanout = 8;
 
 private:
-    struct Node;
-
-    struct Branch {
-        union {
-            Node* fSubtree;
-            int fOpIndex;
-        };
-        SkRect fBounds;
-    };
-
     struct Node {
-        uint16_t fNumChildren;
-        uint16_t fLevel;
-        Branch fChildren[kMaxChildren];
+        // Unused children have inverted bounds, which never intersect anything.
+        float fLeft  [kFanout],
+              fTop   [kFanout],
+              fRight [kFanout],
+              fBottom[kFanout];
     };
 
-    void search(Node* root, const SkRect& query, std::vector<int>* results) const;
-
-    // Consumes the input array.
-    Branch bulkLoad(std::vector<Branch>* branches, int level = 0);
+    // A query still being searched for in a batch, and which children of the current node it hits.
+    struct Active {
+        int      query;
+        uint32_t hits;
+    };
 
-    // How many times will bulkLoad() call allocateNodeAtLevel()?
-    static int CountNodes(int branches);
+    // Returns a bit per child of node which intersects query.
+    static uint32_t Intersections(const Node& node, const SkRect& query);
 
-    Node* allocateNodeAtLevel(uint16_t level);
+    void search(int level, int node, const SkRect& query, std::vector<int>* results) const;
+    void searchBatch(int level, int node, const SkRect queries[], std::vector<Active>* active,
+                     int activeStart, int activeEnd, std::vector<int> results[]) const;
 
     // This is the count of data elements (rather than total nodes in the tree)
     int fCount;
-    Branch fRoot;
+    // The index in fNodes of the first node of each level, leaves first.  The root is last.
+    std::vector<int>  fLevels;
     std::vector<Node> fNodes;
+    // The op index of each leaf child, in the order they were packed.
+    std::vector<int>  fOpIndices;
 };
 
 #endif
@@ -35,3 +35,21 @@ void SkRecord::defrag() {
                                    [](Record op) { return op.type() == SkRecords::NoOp_Type; });
     fCount = noops - fRecords.get();
 }
+
+void SkRecord::reset() {
+    Destroyer destroyer;
+    for (int i = 0; i < this->count(); i++) {
+        this->mutate(i, destroyer);
+    }
+    fCount = 0;
+
+    // Everything in fAlloc is trivially destructible (see alloc()), so we can simply start over,
+    // first growing fRetained to hold all the bytes the last recording needed, with some slack.
+    fAlloc.~SkArenaAlloc();
+    if (fApproxBytesAllocated > fRetainedSize) {
+        fRetainedSize = fApproxBytesAllocated + fApproxBytesAllocated / 4;
+        fRetained.reset(fRetainedSize);
+    }
+    new (&fAlloc) SkArenaAlloc(fRetained.get(), fRetainedSize, 256);
+    fApproxBytesAllocated = 0;
+}
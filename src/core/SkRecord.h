@@ -106,6 +106,10 @@ public:
     // May change count() and the indices of ops, but preserves their order.
     void defrag();
 
+    // Destroy all commands, leaving this SkRecord empty but holding on to its storage, so
+    // recording about as much again allocates nothing new.
+    void reset();
+
 private:
     // An SkRecord is structured as an array of pointers into a big chunk of memory where
     // records representing each canvas draw call are stored:
@@ -185,6 +189,11 @@ private:
         fReserved{0};
     SkAutoTMalloc<Record> fRecords;
 
+    // After a reset(), fAlloc starts in this block, sized to hold what was allocated before.
+    // It must outlive fAlloc.
+    SkAutoTMalloc<char> fRetained;
+    size_t              fRetainedSize{0};
+
     // fAlloc needs to be a data structure which can append variable length data in contiguous
     // chunks, returning a stable handle to that data for later retrieval.
     SkArenaAlloc fAlloc{256};
@@ -8,18 +8,51 @@
 #include "include/core/SkBBHFactory.h"
 #include "include/core/SkImage.h"
 #include "src/core/SkCanvasPriv.h"
+#include "src/core/SkPaintPriv.h"
 #include "src/core/SkRecordDraw.h"
+#include "src/core/SkRectPriv.h"
 #include "src/utils/SkPatchUtils.h"
 
+// Returns the index of the last occluder op covering every pixel in the canvas' clip.  Nothing
+// drawn before that op can show through it, so those draws may be skipped.
+static int first_visible_op(SkCanvas* canvas,
+                            const SkBigPicture::Occluder occluders[], int occluderCount) {
+    if (occluderCount == 0) {
+        return 0;
+    }
+    const SkMatrix ctm = canvas->getTotalMatrix();
+    if (!ctm.isScaleTranslate()) {
+        return 0;
+    }
+    // Pixels entirely inside an occluder are fully covered, antialiased or not.
+    const SkRect clip = SkRect::Make(canvas->getDeviceClipBounds());
+    if (clip.isEmpty()) {
+        return 0;
+    }
+    for (int i = occluderCount - 1; i >= 0; i--) {
+        SkRect devRect;
+        ctm.mapRectScaleTranslate(&devRect, occluders[i].rect);
+        if (devRect.contains(clip)) {
+            return occluders[i].op;
+        }
+    }
+    return 0;
+}
+
 void SkRecordDraw(const SkRecord& record,
                   SkCanvas* canvas,
                   SkPicture const* const drawablePicts[],
                   SkDrawable* const drawables[],
                   int drawableCount,
                   const SkBBoxHierarchy* bbh,
-                  SkPicture::AbortCallback* callback) {
+                  SkPicture::AbortCallback* callback,
+                  const SkBigPicture::Occluder occluders[],
+                  int occluderCount) {
     SkAutoCanvasRestore saveRestore(canvas, true /*save now, restore at exit*/);
 
+    // Draws before this op are hidden.  Control ops before it must still be played back.
+    const int firstVisibleOp = first_visible_op(canvas, occluders, occluderCount);
+
     if (bbh) {
         // Draw only ops that affect pixels in the canvas's current clip.
         // The SkRecord and BBH were recorded in identity space.  This canvas
@@ -36,6 +69,9 @@ void SkRecordDraw(const SkRecord& record,
             if (callback && callback->abort()) {
                 return;
             }
+            if (ops[i] < firstVisibleOp && record.visit(ops[i], SkRecords::MayDraw())) {
+                continue;
+            }
             // This visit call uses the SkRecords::Draw::operator() to call
             // methods on the |canvas|, wrapped by methods defined with the
             // DRAW() macro.
@@ -48,6 +84,9 @@ void SkRecordDraw(const SkRecord& record,
             if (callback && callback->abort()) {
                 return;
             }
+            if (i < firstVisibleOp && record.visit(i, SkRecords::MayDraw())) {
+                continue;
+            }
             // This visit call uses the SkRecords::Draw::operator() to call
             // methods on the |canvas|, wrapped by methods defined with the
             // DRAW() macro.
@@ -175,17 +214,21 @@ template <> void Draw::draw(const DrawDrawable& r) {
 // the block, and control ops are stashed away for later.  When we finish the
 // block with a Restore, our bounds are complete, and we go back and fill them
 // in for all the control ops we stashed away.
+//
+// In conservative mode, ops whose bounds depend on an image filter, mask filter or path effect,
+// their own or one of an enclosing layer, skip computing them and are bounded by the cull.
 class FillBounds : SkNoncopyable {
 public:
     FillBounds(const SkRect& cullRect, const SkRecord& record,
-               SkRect bounds[], SkBBoxHierarchy::Metadata meta[])
+               SkRect bounds[], SkBBoxHierarchy::Metadata meta[], bool conservative = false)
         : fCullRect(cullRect)
+        , fConservative(conservative)
         , fBounds(bounds)
         , fMeta(meta) {
         fCTM = SkMatrix::I();
 
         // We push an extra save block to track the bounds of any top-level control operations.
-        fSaveStack.push_back({ 0, Bounds::MakeEmpty(), nullptr, fCTM });
+        fSaveStack.push_back({ 0, Bounds::MakeEmpty(), nullptr, fCTM, false, true, SkMatrix::I() });
     }
 
     ~FillBounds() {
@@ -203,6 +246,12 @@ public:
 
     void setCurrentOp(int currentOp) { fCurrentOp = currentOp; }
 
+    // Used when the bounds are filled one op at a time into storage that may move as it grows.
+    void setStorage(SkRect bounds[], SkBBoxHierarchy::Metadata meta[]) {
+        fBounds = bounds;
+        fMeta   = meta;
+    }
+
 
     template <typename T> void operator()(const T& op) {
         this->updateCTM(op);
@@ -217,6 +266,10 @@ public:
         // Inverted rectangles really confuse our BBHs.
         rect.sort();
 
+        if (fConservative && (fLayersAffectingBounds > 0 || PaintAffectsBounds(paint, true))) {
+            return fCullRect;
+        }
+
         // Adjust the rect for its own paint.
         if (!AdjustForPaint(paint, &rect)) {
             // The paint could do anything to our bounds.  The only safe answer is the cull.
@@ -224,7 +277,7 @@ public:
         }
 
         // Adjust rect for all the paints from the SaveLayers we're inside.
-        if (!this->adjustForSaveLayerPaints(&rect)) {
+        if (fLayersAffectingBounds > 0 && !this->adjustForSaveLayerPaints(&rect)) {
             // Same deal as above.
             return fCullRect;
         }
@@ -246,6 +299,9 @@ private:
         Bounds bounds;         // Bounds of everything in the block.
         const SkPaint* paint;  // Unowned.  If set, adjusts the bounds of all ops in this block.
         SkMatrix ctm;
+        bool affectsBounds;    // If paint may change the bounds of what's drawn in this block,
+        bool invertible;       // whether ctm is invertible and
+        SkMatrix inverse;      // its inverse, to map those bounds into the layer's space.
     };
 
     // Only Restore, SetMatrix, Concat, and Translate change the CTM.
@@ -297,11 +353,26 @@ private:
             PaintMayAffectTransparentBlack(paint) ? fCullRect : Bounds::MakeEmpty();
         sb.paint = paint;
         sb.ctm = this->fCTM;
+        // Layer paints which just fill don't affect bounds, and we needn't map rects through them.
+        sb.affectsBounds = PaintAffectsBounds(paint, false);
+        sb.invertible = !sb.affectsBounds || sb.ctm.invert(&sb.inverse);
+        if (sb.affectsBounds) {
+            fLayersAffectingBounds++;
+        }
 
         fSaveStack.push_back(sb);
         this->pushControl();
     }
 
+    // Returns true if paint may draw outside the geometry it's applied to.  Stroking is cheap to
+    // account for, so when cheapStrokes is set only effects are considered.
+    static bool PaintAffectsBounds(const SkPaint* paint, bool cheapStrokes) {
+        return paint && (paint->getImageFilter() ||
+                         paint->getMaskFilter()  ||
+                         paint->getPathEffect()  ||
+                         (!cheapStrokes && paint->getStyle() != SkPaint::kFill_Style));
+    }
+
     static bool PaintMayAffectTransparentBlack(const SkPaint* paint) {
         if (paint) {
             // FIXME: this is very conservative
@@ -339,6 +410,9 @@ private:
         // We're done the Save block.  Apply the block's bounds to all control ops inside it.
         SaveBounds sb;
         fSaveStack.pop(&sb);
+        if (sb.affectsBounds) {
+            fLayersAffectingBounds--;
+        }
 
         while (sb.controlOps --> 0) {
             this->popControl(sb.bounds);
@@ -503,11 +577,13 @@ private:
 
     bool adjustForSaveLayerPaints(SkRect* rect, int savesToIgnore = 0) const {
         for (int i = fSaveStack.count() - 1 - savesToIgnore; i >= 0; i--) {
-            SkMatrix inverse;
-            if (!fSaveStack[i].ctm.invert(&inverse)) {
+            if (!fSaveStack[i].affectsBounds) {
+                continue;
+            }
+            if (!fSaveStack[i].invertible) {
                 return false;
             }
-            inverse.mapRect(rect);
+            fSaveStack[i].inverse.mapRect(rect);
             if (!AdjustForPaint(fSaveStack[i].paint, rect)) {
                 return false;
             }
@@ -518,6 +594,10 @@ private:
 
     // We do not guarantee anything for operations outside of the cull rect
     const SkRect fCullRect;
+    const bool fConservative;
+
+    // How many save blocks on fSaveStack have affectsBounds set.
+    int fLayersAffectingBounds = 0;
 
     // Conservative identity-space bounds for each op in the SkRecord.
     Bounds* fBounds;
@@ -535,12 +615,186 @@ private:
     SkTDArray<int>   fControlIndices;
 };
 
+// FillOccluders finds the ops which paint every pixel of some rect opaquely, the occluders that
+// let us skip the draws they hide.  Like FillBounds it walks the record tracking the CTM, and it
+// additionally tracks an identity space rect that the clip is known to contain.  A draw inside a
+// layer only reaches the canvas through the layer's paint, so only draws outside of any layer are
+// considered.
+class FillOccluders : SkNoncopyable {
+public:
+    FillOccluders(SkRect occluders[], bool barriers[])
+        : fOccluders(occluders)
+        , fBarriers(barriers) {
+        fStateStack.push_back({ SkMatrix::I(), SkRectPriv::MakeLargeS32(), 0 });
+    }
+
+    void setCurrentOp(int currentOp) {
+        fCurrentOp = currentOp;
+        fOccluders[fCurrentOp].setEmpty();
+        fBarriers [fCurrentOp] = false;
+    }
+
+    template <typename T> void operator()(const T& op) { this->track(op); }
+
+private:
+    struct State {
+        SkMatrix ctm;
+        SkRect   clip;        // The clip contains this identity space rect.
+        int      layerDepth;  // Number of SaveLayers and SaveBehinds we're inside.
+    };
+
+    State& state() { return fStateStack.top(); }
+
+    template <typename T> void track(const T&) {}
+
+    void track(const Save&) { fStateStack.push_back(this->state()); }
+    void track(const SaveLayer& op) {
+        this->pushLayer();
+        // A backdrop filter or a layer initialized with the previous contents reads back pixels.
+        fBarriers[fCurrentOp] = op.backdrop ||
+                                (op.saveLayerFlags & SkCanvas::kInitWithPrevious_SaveLayerFlag);
+    }
+    void track(const SaveBehind&) {
+        this->pushLayer();
+        fBarriers[fCurrentOp] = true;
+    }
+    void track(const Restore& op) {
+        if (fStateStack.count() > 1) {
+            fStateStack.pop();
+        }
+        this->state().ctm = op.matrix;
+    }
+
+    void track(const SetMatrix& op) { this->state().ctm = op.matrix; }
+    void track(const Concat44& op)  { this->state().ctm.preConcat(op.matrix.asM33()); }
+    void track(const Concat& op)    { this->state().ctm.preConcat(op.matrix); }
+    void track(const Scale& op)     { this->state().ctm.preScale(op.sx, op.sy); }
+    void track(const Translate& op) { this->state().ctm.preTranslate(op.dx, op.dy); }
+
+    void track(const ClipRect& op) { this->clipRect(op.rect, op.opAA.op()); }
+    void track(const ClipRRect& op) {
+        this->checkClipOp(op.opAA.op());
+        if (op.rrect.isRect()) {
+            this->clipRect(op.rrect.rect(), op.opAA.op());
+        } else {
+            this->clipUnknown();
+        }
+    }
+    void track(const ClipPath& op) {
+        this->checkClipOp(op.opAA.op());
+        SkRect rect;
+        if (!op.path.isInverseFillType() && op.path.isRect(&rect)) {
+            this->clipRect(rect, op.opAA.op());
+        } else {
+            this->clipUnknown();
+        }
+    }
+    void track(const ClipRegion& op) {
+        // Regions are in device space, which is identity space here.
+        this->checkClipOp(op.op);
+        SkRect& clip = this->state().clip;
+        if (op.op != SkClipOp::kIntersect || !op.region.isRect() ||
+            !clip.intersect(SkRect::Make(op.region.getBounds()))) {
+            clip.setEmpty();
+        }
+    }
+    void track(const ClipShader& op) {
+        this->checkClipOp(op.op);
+        this->clipUnknown();
+    }
+
+    // Nested pictures and drawables may contain backdrop filters.
+    void track(const DrawPicture&)  { fBarriers[fCurrentOp] = true; }
+    void track(const DrawDrawable&) { fBarriers[fCurrentOp] = true; }
+
+    void track(const DrawPaint& op) {
+        if (this->canOcclude(&op.paint, SkPaintPriv::kNone_ShaderOverrideOpacity)) {
+            fOccluders[fCurrentOp] = this->state().clip;
+        }
+    }
+    void track(const DrawRect& op) {
+        this->occlude(op.rect.makeSorted(), &op.paint, SkPaintPriv::kNone_ShaderOverrideOpacity);
+    }
+    void track(const DrawImage& op) {
+        const SkImage* image = op.image.get();
+        this->occlude(SkRect::MakeXYWH(op.left, op.top, image->width(), image->height()),
+                      op.paint, ImageOpacity(image));
+    }
+    void track(const DrawImageRect& op) {
+        // Any part of dst mapped from outside the image would be left transparent.
+        if (op.src && !SkRect::Make(op.image->bounds()).contains(*op.src)) {
+            return;
+        }
+        this->occlude(op.dst.makeSorted(), op.paint, ImageOpacity(op.image.get()));
+    }
+
+    static SkPaintPriv::ShaderOverrideOpacity ImageOpacity(const SkImage* image) {
+        return image->isOpaque() ? SkPaintPriv::kOpaque_ShaderOverrideOpacity
+                                 : SkPaintPriv::kNotOpaque_ShaderOverrideOpacity;
+    }
+
+    void pushLayer() {
+        fStateStack.push_back(this->state());
+        this->state().layerDepth++;
+    }
+
+    // Draws after a clip that may grow past the canvas' clip can land outside of the clip that
+    // playback checks occluders against, so we stop looking for occluders altogether.
+    void checkClipOp(SkClipOp op) {
+        fClipMayExpand |= op != SkClipOp::kIntersect && op != SkClipOp::kDifference;
+    }
+
+    void clipRect(const SkRect& rect, SkClipOp op) {
+        this->checkClipOp(op);
+        State& state = this->state();
+        if (op != SkClipOp::kIntersect || !state.ctm.rectStaysRect() ||
+            !state.clip.intersect(state.ctm.mapRect(rect.makeSorted()))) {
+            state.clip.setEmpty();
+        }
+    }
+    void clipUnknown() { this->state().clip.setEmpty(); }
+
+    // Returns true if a draw with this paint replaces every pixel it covers.
+    bool canOcclude(const SkPaint* paint, SkPaintPriv::ShaderOverrideOpacity opacity) {
+        if (fClipMayExpand || this->state().layerDepth > 0) {
+            return false;
+        }
+        if (paint) {
+            if (paint->getStyle() == SkPaint::kStroke_Style) {
+                return false;
+            }
+            if (paint->getMaskFilter() || paint->getPathEffect() || paint->getImageFilter()) {
+                return false;
+            }
+        }
+        return SkPaintPriv::Overwrites(paint, opacity);
+    }
+
+    void occlude(const SkRect& rect, const SkPaint* paint,
+                 SkPaintPriv::ShaderOverrideOpacity opacity) {
+        const State& state = this->state();
+        if (!state.ctm.rectStaysRect() || !this->canOcclude(paint, opacity)) {
+            return;
+        }
+        SkRect occluder = state.ctm.mapRect(rect);
+        if (occluder.intersect(state.clip)) {
+            fOccluders[fCurrentOp] = occluder;
+        }
+    }
+
+    SkRect* fOccluders;
+    bool*   fBarriers;
+    int     fCurrentOp;
+    bool    fClipMayExpand = false;
+    SkTDArray<State> fStateStack;
+};
+
 }  // namespace SkRecords
 
 void SkRecordFillBounds(const SkRect& cullRect, const SkRecord& record,
-                        SkRect bounds[], SkBBoxHierarchy::Metadata meta[]) {
+                        SkRect bounds[], SkBBoxHierarchy::Metadata meta[], bool conservative) {
     {
-        SkRecords::FillBounds visitor(cullRect, record, bounds, meta);
+        SkRecords::FillBounds visitor(cullRect, record, bounds, meta, conservative);
         for (int i = 0; i < record.count(); i++) {
             visitor.setCurrentOp(i);
             record.visit(i, visitor);
@@ -548,3 +802,40 @@ void SkRecordFillBounds(const SkRect& cullRect, const SkRecord& record,
     }
 }
 
+SkRecordBoundsTracker::SkRecordBoundsTracker() : fCullRect(SkRect::MakeEmpty()) {}
+
+SkRecordBoundsTracker::~SkRecordBoundsTracker() {}
+
+void SkRecordBoundsTracker::reset(const SkRecord& record, const SkRect& cullRect,
+                                  bool conservative) {
+    SkASSERT(record.count() == 0);
+    fCullRect = cullRect;
+    fBounds.rewind();
+    fMeta.rewind();
+    fVisitor.reset(new SkRecords::FillBounds(cullRect, record, nullptr, nullptr, conservative));
+}
+
+void SkRecordBoundsTracker::track(const SkRecord& record, int op) {
+    SkASSERT(fVisitor && op == fBounds.count());
+    fBounds.append();
+    fMeta.append();
+    // The bounds of earlier control ops are filled in later, so always point at the latest storage.
+    fVisitor->setStorage(fBounds.begin(), fMeta.begin());
+    fVisitor->setCurrentOp(op);
+    record.visit(op, *fVisitor);
+}
+
+void SkRecordBoundsTracker::finish() {
+    if (fVisitor) {
+        fVisitor->setStorage(fBounds.begin(), fMeta.begin());
+    }
+    fVisitor.reset();  // ~FillBounds() fills in the bounds of any unfinished save blocks.
+}
+
+void SkRecordFillOccluders(const SkRecord& record, SkRect occluders[], bool barriers[]) {
+    SkRecords::FillOccluders visitor(occluders, barriers);
+    for (int i = 0; i < record.count(); i++) {
+        visitor.setCurrentOp(i);
+        record.visit(i, visitor);
+    }
+}
@@ -11,15 +11,50 @@
 #include "include/core/SkBBHFactory.h"
 #include "include/core/SkCanvas.h"
 #include "include/core/SkMatrix.h"
+#include "include/private/SkNoncopyable.h"
+#include "include/private/SkTDArray.h"
 #include "src/core/SkBigPicture.h"
 #include "src/core/SkRecord.h"
 
+#include <memory>
+
 class SkDrawable;
 class SkLayerInfo;
 
 // Calculate conservative identity space bounds for each op in the record.
+// If conservative is set, ops whose bounds depend on image filters, mask filters or path effects
+// are simply bounded by cullRect, which is faster but makes for a less selective BBH.
 void SkRecordFillBounds(const SkRect& cullRect, const SkRecord&,
-                        SkRect bounds[], SkBBoxHierarchy::Metadata[]);
+                        SkRect bounds[], SkBBoxHierarchy::Metadata[], bool conservative = false);
+
+namespace SkRecords { class FillBounds; }
+
+// Calculates the same bounds as SkRecordFillBounds(), one op at a time as they are recorded.
+class SkRecordBoundsTracker : SkNoncopyable {
+public:
+    SkRecordBoundsTracker();
+    ~SkRecordBoundsTracker();
+
+    // Starts tracking the ops to be recorded into an empty record.
+    void reset(const SkRecord&, const SkRect& cullRect, bool conservative);
+
+    // Call for each op right after it is appended to the record.
+    void track(const SkRecord&, int op);
+
+    // Finishes the bounds of any ops still waiting for the end of their save block.  After this,
+    // bounds() and meta() hold an entry for each tracked op.
+    void finish();
+
+    const SkRect& cullRect() const { return fCullRect; }
+    SkRect* bounds() { return fBounds.begin(); }
+    SkBBoxHierarchy::Metadata* meta() { return fMeta.begin(); }
+
+private:
+    std::unique_ptr<SkRecords::FillBounds> fVisitor;
+    SkRect                                 fCullRect;
+    SkTDArray<SkRect>                      fBounds;
+    SkTDArray<SkBBoxHierarchy::Metadata>   fMeta;
+};
 
 // SkRecordFillBounds(), and gathers information about saveLayers and stores it for later
 // use (e.g., layer hoisting). The gathered information is sufficient to determine
@@ -27,10 +62,17 @@ void SkRecordFillBounds(const SkRect& cullRect, const SkRecord&,
 void SkRecordComputeLayers(const SkRect& cullRect, const SkRecord&, SkRect bounds[],
                            const SkBigPicture::SnapshotArray*, SkLayerInfo* data);
 
+// For each op outside of any layer, calculate an identity space rect that the op is guaranteed to
+// paint opaquely, or set it empty.  barriers[i] is set for ops which may read back the pixels of
+// the ops before them, e.g. backdrop filtered layers and nested pictures.
+void SkRecordFillOccluders(const SkRecord&, SkRect occluders[], bool barriers[]);
+
 // Draw an SkRecord into an SkCanvas.  A convenience wrapper around SkRecords::Draw.
+// If occluders are given, draws hidden by the last of them covering the canvas' clip are skipped.
 void SkRecordDraw(const SkRecord&, SkCanvas*, SkPicture const* const drawablePicts[],
                   SkDrawable* const drawables[], int drawableCount,
-                  const SkBBoxHierarchy*, SkPicture::AbortCallback*);
+                  const SkBBoxHierarchy*, SkPicture::AbortCallback*,
+                  const SkBigPicture::Occluder occluders[] = nullptr, int occluderCount = 0);
 
 // Draw a portion of an SkRecord into an SkCanvas.
 // When drawing a portion of an SkRecord the CTM on the passed in canvas must be
@@ -43,6 +85,11 @@ void SkRecordPartialDraw(const SkRecord&, SkCanvas*,
 
 namespace SkRecords {
 
+// Returns true for ops which may draw something.
+struct MayDraw {
+    template <typename T> bool operator()(const T&) const { return T::kTags & kDraw_Tag; }
+};
+
 // This is an SkRecord visitor that will draw that SkRecord to an SkCanvas.
 class Draw : SkNoncopyable {
 public:
@@ -9,9 +9,12 @@
 
 #include "include/private/SkTDArray.h"
 #include "src/core/SkCanvasPriv.h"
+#include "src/core/SkRecordDraw.h"
 #include "src/core/SkRecordPattern.h"
 #include "src/core/SkRecords.h"
 
+#include <algorithm>
+
 using namespace SkRecords;
 
 // Most of the optimizations in this file are pattern-based.  These are all defined as structs with:
@@ -286,7 +289,56 @@ void SkRecordMergeSvgOpacityAndFilterLayers(SkRecord* record) {
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
-void SkRecordOptimize(SkRecord* record) {
+void SkRecordNoopOccludedDraws(SkRecord* record, SkRect bounds[],
+                               const SkRect occluders[], const bool barriers[]) {
+    // Walking backwards, we remember the largest few occluders drawn after the current op.
+    static constexpr int kMaxOccluders = 8;
+    SkRect later[kMaxOccluders];
+    int laterCount = 0;
+
+    for (int i = record->count() - 1; i >= 0; i--) {
+        if (record->visit(i, MayDraw()) && !bounds[i].isEmpty()) {
+            const SkRect outset = bounds[i].makeOutset(1, 1);
+            bool hidden = false;
+            for (int j = 0; j < laterCount && !hidden; j++) {
+                hidden = later[j].contains(outset);
+            }
+            if (hidden) {
+                record->replace<NoOp>(i);
+                bounds[i].setEmpty();
+                continue;
+            }
+        }
+        // Ops before a barrier may show through anything after it.
+        if (barriers[i]) {
+            laterCount = 0;
+        }
+        if (occluders[i].isEmpty()) {
+            continue;
+        }
+        if (laterCount < kMaxOccluders) {
+            later[laterCount++] = occluders[i];
+        } else {
+            SkRect* smallest = std::min_element(later, later + laterCount,
+                                                [](const SkRect& a, const SkRect& b) {
+                return a.width() * a.height() < b.width() * b.height();
+            });
+            const SkRect& occluder = occluders[i];
+            if (smallest->width() * smallest->height() < occluder.width() * occluder.height()) {
+                *smallest = occluder;
+            }
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct IsNoOp {
+    template <typename T>
+    bool operator()(const T&) const { return T::kType == NoOp_Type; }
+};
+
+void SkRecordOptimize(SkRecord* record, SkRect bounds[], SkBBoxHierarchy::Metadata meta[]) {
     // This might be useful  as a first pass in the future if we want to weed
     // out junk for other optimization passes.  Right now, nothing needs it,
     // and the bounding box hierarchy will do the work of skipping no-op
@@ -304,6 +356,18 @@ void SkRecordOptimize(SkRecord* record) {
 #endif
     SkRecordMergeSvgOpacityAndFilterLayers(record);
 
+    if (bounds) {
+        // Drop the same entries defrag() is about to drop.
+        SkASSERT(meta);
+        int kept = 0;
+        for (int i = 0; i < record->count(); i++) {
+            if (!record->visit(i, IsNoOp())) {
+                bounds[kept] = bounds[i];
+                meta  [kept] = meta  [i];
+                kept++;
+            }
+        }
+    }
     record->defrag();
 }
 
@@ -8,10 +8,14 @@
 #ifndef SkRecordOpts_DEFINED
 #define SkRecordOpts_DEFINED
 
+#include "include/core/SkBBHFactory.h"
 #include "src/core/SkRecord.h"
 
 // Run all optimizations in recommended order.
-void SkRecordOptimize(SkRecord*);
+// If bounds and meta are given for each op, they're kept in step as ops are removed.  None of
+// these optimizations change the bounds of the ops they keep.
+void SkRecordOptimize(SkRecord*, SkRect bounds[] = nullptr,
+                      SkBBoxHierarchy::Metadata meta[] = nullptr);
 
 // Turns logical no-op Save-[non-drawing command]*-Restore patterns into actual no-ops.
 void SkRecordNoopSaveRestores(SkRecord*);
@@ -26,6 +30,13 @@ void SkRecordNoopSaveLayerDrawRestores(SkRecord*);
 // the alpha of the first SaveLayer to the second SaveLayer.
 void SkRecordMergeSvgOpacityAndFilterLayers(SkRecord*);
 
+// Turns draws that are entirely covered by later opaque draws (as found by SkRecordFillOccluders)
+// into no-ops, and empties their bounds (as found by SkRecordFillBounds).  Antialiased edges are
+// accounted for by requiring a one unit margin, which is exact as long as the record is drawn
+// without downscaling or rotation.
+void SkRecordNoopOccludedDraws(SkRecord*, SkRect bounds[],
+                               const SkRect occluders[], const bool barriers[]);
+
 // Experimental optimizers
 void SkRecordOptimize2(SkRecord*);
 
@@ -13,6 +13,7 @@
 #include "include/private/SkTo.h"
 #include "src/core/SkBigPicture.h"
 #include "src/core/SkCanvasPriv.h"
+#include "src/core/SkRecordDraw.h"
 #include "src/utils/SkPatchUtils.h"
 
 #include <new>
@@ -63,6 +64,8 @@ void SkRecorder::reset(SkRecord* record, const SkRect& bounds,
 }
 
 void SkRecorder::forgetRecord() {
+    fBoundsTracker = nullptr;
+    this->setDeduplicate(false);
     fDrawableList.reset(nullptr);
     fApproxBytesUsedBySubPictures = 0;
     fRecord = nullptr;
@@ -75,6 +78,39 @@ void SkRecorder::append(Args&&... args) {
         this->flushMiniRecorder();
     }
     new (fRecord->append<T>()) T{std::forward<Args>(args)...};
+    if (fBoundsTracker) {
+        fBoundsTracker->track(*fRecord, fRecord->count() - 1);
+    }
+}
+
+void SkRecorder::setDeduplicate(bool deduplicate) {
+    fDeduplicate = deduplicate;
+    fPaths.reset();
+    fTextBlobs.reset();
+}
+
+const SkPath& SkRecorder::dedup(const SkPath& path) {
+    // Volatile paths are about to change, so they are unlikely to be drawn again as they are.
+    if (!fDeduplicate || path.isVolatile()) {
+        return path;
+    }
+    if (const SkPath* first = fPaths.find(path)) {
+        return *first;
+    }
+    fPaths.add(path);
+    return path;
+}
+
+sk_sp<const SkTextBlob> SkRecorder::dedup(const SkTextBlob* blob) {
+    if (!fDeduplicate) {
+        return sk_ref_sp(blob);
+    }
+    SkTextBlobContentKey key{sk_ref_sp(blob)};
+    if (const SkTextBlobContentKey* first = fTextBlobs.find(key)) {
+        return first->fBlob;
+    }
+    fTextBlobs.add(key);
+    return key.fBlob;
 }
 
 #define TRY_MINIRECORDER(method, ...) \
@@ -189,8 +225,9 @@ void SkRecorder::onDrawDrawable(SkDrawable* drawable, const SkMatrix* matrix) {
 }
 
 void SkRecorder::onDrawPath(const SkPath& path, const SkPaint& paint) {
-    TRY_MINIRECORDER(drawPath, path, paint);
-    this->append<SkRecords::DrawPath>(paint, path);
+    const SkPath& dedupedPath = this->dedup(path);
+    TRY_MINIRECORDER(drawPath, dedupedPath, paint);
+    this->append<SkRecords::DrawPath>(paint, dedupedPath);
 }
 
 void SkRecorder::onDrawImage(const SkImage* image, SkScalar left, SkScalar top,
@@ -221,8 +258,9 @@ void SkRecorder::onDrawImageLattice(const SkImage* image, const Lattice& lattice
 
 void SkRecorder::onDrawTextBlob(const SkTextBlob* blob, SkScalar x, SkScalar y,
                                 const SkPaint& paint) {
-    TRY_MINIRECORDER(drawTextBlob, blob, x, y, paint);
-    this->append<SkRecords::DrawTextBlob>(paint, sk_ref_sp(blob), x, y);
+    sk_sp<const SkTextBlob> dedupedBlob = this->dedup(blob);
+    TRY_MINIRECORDER(drawTextBlob, dedupedBlob.get(), x, y, paint);
+    this->append<SkRecords::DrawTextBlob>(paint, std::move(dedupedBlob), x, y);
 }
 
 void SkRecorder::onDrawPicture(const SkPicture* pic, const SkMatrix* matrix, const SkPaint* paint) {
@@ -275,7 +313,7 @@ void SkRecorder::onDrawAtlas(const SkImage* atlas, const SkRSXform xform[], cons
 }
 
 void SkRecorder::onDrawShadowRec(const SkPath& path, const SkDrawShadowRec& rec) {
-    this->append<SkRecords::DrawShadowRec>(path, rec);
+    this->append<SkRecords::DrawShadowRec>(this->dedup(path), rec);
 }
 
 void SkRecorder::onDrawAnnotation(const SkRect& rect, const char key[], SkData* value) {
@@ -366,7 +404,7 @@ void SkRecorder::onClipRRect(const SkRRect& rrect, SkClipOp op, ClipEdgeStyle ed
 void SkRecorder::onClipPath(const SkPath& path, SkClipOp op, ClipEdgeStyle edgeStyle) {
     INHERITED(onClipPath, path, op, edgeStyle);
     SkRecords::ClipOpAndAA opAA(op, kSoft_ClipEdgeStyle == edgeStyle);
-    this->append<SkRecords::ClipPath>(path, opAA);
+    this->append<SkRecords::ClipPath>(this->dedup(path), opAA);
 }
 
 void SkRecorder::onClipShader(sk_sp<SkShader> cs, SkClipOp op) {
@@ -10,13 +10,17 @@
 
 #include "include/core/SkCanvasVirtualEnforcer.h"
 #include "include/private/SkTDArray.h"
+#include "include/private/SkTHash.h"
 #include "include/utils/SkNoDrawCanvas.h"
 #include "src/core/SkBigPicture.h"
 #include "src/core/SkMiniRecorder.h"
+#include "src/core/SkPathPriv.h"
 #include "src/core/SkRecord.h"
 #include "src/core/SkRecords.h"
+#include "src/core/SkTextBlobPriv.h"
 
 class SkBBHFactory;
+class SkRecordBoundsTracker;
 
 class SkDrawableList : SkNoncopyable {
 public:
@@ -123,6 +127,13 @@ public:
 
     void flushMiniRecorder();
 
+    // If set, each op is passed to tracker as it is recorded.  Cleared by reset().
+    void setBoundsTracker(SkRecordBoundsTracker* tracker) { fBoundsTracker = tracker; }
+
+    // If true, paths and text blobs are recorded as the first copy with the same contents seen
+    // since this was set, sharing its storage.  Cleared by reset().
+    void setDeduplicate(bool deduplicate);
+
 private:
     template <typename T>
     T* copy(const T*);
@@ -133,12 +144,20 @@ private:
     template<typename T, typename... Args>
     void append(Args&&...);
 
+    const SkPath& dedup(const SkPath&);
+    sk_sp<const SkTextBlob> dedup(const SkTextBlob*);
+
     DrawPictureMode fDrawPictureMode;
     size_t fApproxBytesUsedBySubPictures;
     SkRecord* fRecord;
     std::unique_ptr<SkDrawableList> fDrawableList;
 
     SkMiniRecorder* fMiniRecorder;
+    SkRecordBoundsTracker* fBoundsTracker = nullptr;
+
+    bool fDeduplicate = false;
+    SkTHashSet<SkPath, SkPathPriv::ContentHasher> fPaths;
+    SkTHashSet<SkTextBlobContentKey, SkTextBlobContentKey::Hash> fTextBlobs;
 };
 
 #endif//SkRecorder_DEFINED
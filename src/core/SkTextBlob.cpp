@@ -10,6 +10,7 @@
 #include "include/core/SkTypeface.h"
 #include "src/core/SkFontPriv.h"
 #include "src/core/SkGlyphRun.h"
+#include "src/core/SkOpts.h"
 #include "src/core/SkPaintPriv.h"
 #include "src/core/SkReadBuffer.h"
 #include "src/core/SkSafeMath.h"
@@ -679,6 +680,57 @@ void SkTextBlobPriv::Flatten(const SkTextBlob& blob, SkWriteBuffer& buffer) {
     buffer.write32(0);
 }
 
+bool SkTextBlobPriv::ContentEquals(const SkTextBlob& a, const SkTextBlob& b) {
+    if (&a == &b) {
+        return true;
+    }
+    if (a.bounds() != b.bounds()) {
+        return false;
+    }
+    SkTextBlobRunIterator itA(&a), itB(&b);
+    for (; !itA.done() && !itB.done(); itA.next(), itB.next()) {
+        const uint32_t count = itA.glyphCount();
+        if (count != itB.glyphCount() ||
+            itA.positioning() != itB.positioning() ||
+            itA.offset() != itB.offset() ||
+            itA.textSize() != itB.textSize() ||
+            itA.font() != itB.font()) {
+            return false;
+        }
+        const size_t posSize = count * sizeof(SkScalar) * SkTextBlob::ScalarsPerGlyph(
+                SkTo<SkTextBlob::GlyphPositioning>(itA.positioning()));
+        if (0 != memcmp(itA.glyphs(), itB.glyphs(), count * sizeof(uint16_t)) ||
+            0 != memcmp(itA.pos(), itB.pos(), posSize)) {
+            return false;
+        }
+        if (itA.textSize() > 0 &&
+            (0 != memcmp(itA.clusters(), itB.clusters(), count * sizeof(uint32_t)) ||
+             0 != memcmp(itA.text(), itB.text(), itA.textSize()))) {
+            return false;
+        }
+    }
+    return itA.done() && itB.done();
+}
+
+uint32_t SkTextBlobPriv::ContentHash(const SkTextBlob& blob) {
+    // Glyphs and positions tell blobs apart well enough; the rest is left to ContentEquals().
+    uint32_t hash = 0;
+    for (SkTextBlobRunIterator it(&blob); !it.done(); it.next()) {
+        const uint32_t count = it.glyphCount();
+        const SkFont& font = it.font();
+        const uint32_t fontKey[] = {
+            font.getTypeface() ? font.getTypeface()->uniqueID() : 0,
+            SkFloat2Bits(font.getSize()),
+            (uint32_t)it.positioning(),
+        };
+        hash = SkOpts::hash(fontKey, sizeof(fontKey), hash);
+        hash = SkOpts::hash(it.glyphs(), count * sizeof(uint16_t), hash);
+        hash = SkOpts::hash(it.pos(), count * sizeof(SkScalar) * SkTextBlob::ScalarsPerGlyph(
+                                SkTo<SkTextBlob::GlyphPositioning>(it.positioning())), hash);
+    }
+    return hash;
+}
+
 sk_sp<SkTextBlob> SkTextBlobPriv::MakeFromBuffer(SkReadBuffer& reader) {
     SkRect bounds;
     reader.readRect(&bounds);
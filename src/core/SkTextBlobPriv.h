@@ -37,6 +37,32 @@ public:
      *          invalid.
      */
     static sk_sp<SkTextBlob> MakeFromBuffer(SkReadBuffer&);
+
+    /**
+     *  Returns true if a and b have the same bounds and runs: the same glyphs, positions, fonts
+     *  and text.  Unlike comparing unique IDs, this matches blobs built independently.
+     */
+    static bool ContentEquals(const SkTextBlob& a, const SkTextBlob& b);
+
+    /** Returns a hash of the blob's runs, the same for any two blobs which are ContentEquals(). */
+    static uint32_t ContentHash(const SkTextBlob&);
+};
+
+/**
+ *  Wraps a text blob to be compared and hashed by its contents, e.g. as a SkTHashMap key.
+ */
+struct SkTextBlobContentKey {
+    sk_sp<const SkTextBlob> fBlob;
+
+    bool operator==(const SkTextBlobContentKey& that) const {
+        return SkTextBlobPriv::ContentEquals(*fBlob, *that.fBlob);
+    }
+
+    struct Hash {
+        uint32_t operator()(const SkTextBlobContentKey& key) const {
+            return SkTextBlobPriv::ContentHash(*key.fBlob);
+        }
+    };
 };
 
 class SkTextBlobBuilderPriv {
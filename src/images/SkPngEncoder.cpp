@@ -9,6 +9,7 @@
 
 #ifdef SK_ENCODE_PNG
 
+#include "include/core/SkExecutor.h"
 #include "include/core/SkStream.h"
 #include "include/core/SkString.h"
 #include "include/encode/SkPngEncoder.h"
@@ -16,10 +17,14 @@
 #include "src/codec/SkColorTable.h"
 #include "src/codec/SkPngPriv.h"
 #include "src/core/SkMSAN.h"
+#include "src/core/SkTaskGroup.h"
 #include "src/images/SkImageEncoderFns.h"
+#include <algorithm>
+#include <atomic>
 #include <vector>
 
 #include "png.h"
+#include "zlib.h"
 
 static_assert(PNG_FILTER_NONE  == (int)SkPngEncoder::FilterFlag::kNone,  "Skia libpng filter err.");
 static_assert(PNG_FILTER_SUB   == (int)SkPngEncoder::FilterFlag::kSub,   "Skia libpng filter err.");
@@ -59,6 +64,18 @@ public:
     bool writeInfo(const SkImageInfo& srcInfo);
     void chooseProc(const SkImageInfo& srcInfo);
 
+    /*
+     * Returns true if src is large enough to split into bands, and its rows are written to the
+     * png exactly as fProc produces them.  Call after chooseProc().
+     */
+    bool canEncodeInParallel(const SkPixmap& src);
+
+    /*
+     * Writes the image data and the end of the png, splitting the work into bands of rows on
+     * options.fExecutor.  Call after writeInfo().
+     */
+    bool encodeInParallel(const SkPixmap& src, const SkPngEncoder::Options& options);
+
     png_structp pngPtr() { return fPngPtr; }
     png_infop infoPtr() { return fInfoPtr; }
     int pngBytesPerPixel() const { return fPngBytesPerPixel; }
@@ -392,6 +409,258 @@ void SkPngEncoderMgr::chooseProc(const SkImageInfo& srcInfo) {
     fProc = choose_proc(srcInfo);
 }
 
+// Bands are large enough that starting a deflate stream for each of them costs little.
+static constexpr size_t kParallelBandBytes = 256 * 1024;
+
+// The size of the deflate window, and so the most of the data before a band that helps compress it.
+static constexpr size_t kDeflateWindowBytes = 32 * 1024;
+
+static int rows_per_band(size_t rowBytes) {
+    return (int)std::max<size_t>(1, kParallelBandBytes / rowBytes);
+}
+
+bool SkPngEncoderMgr::canEncodeInParallel(const SkPixmap& src) {
+    // libpng may transform our rows further, e.g. dropping the filler from opaque F16.
+    const size_t rowBytes = (size_t)fPngBytesPerPixel * src.width();
+    return fProc && png_get_rowbytes(fPngPtr, fInfoPtr) == rowBytes &&
+           src.height() > rows_per_band(rowBytes);
+}
+
+static inline int paeth_predictor(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = abs(p - a),
+        pb = abs(p - b),
+        pc = abs(p - c);
+    return (pa <= pb && pa <= pc) ? a : (pb <= pc) ? b : c;
+}
+
+static inline int filter_cost(int filtered) {
+    return abs((int)(int8_t)(uint8_t)filtered);
+}
+
+/*
+ * Returns the png filter type (PNG_FILTER_VALUE_*) to use for row.
+ *
+ * Like libpng, we pick the allowed filter whose output has the smallest sum of absolute values,
+ * treating bytes as signed.  To save time, only every kSampleStride-th pixel is looked at.
+ */
+static int choose_filter(int filters, const uint8_t* row, const uint8_t* prev, size_t rowBytes,
+                         int bpp) {
+    if (0 == filters) {
+        filters = PNG_FILTER_NONE;
+    }
+    for (int type = 0; type < PNG_FILTER_VALUE_LAST; type++) {
+        if (filters == (PNG_FILTER_NONE << type)) {
+            return type;
+        }
+    }
+
+    constexpr int kSampleStride = 4;
+    int costs[PNG_FILTER_VALUE_LAST] = { 0 };
+    for (size_t p = 0; p < rowBytes; p += kSampleStride * bpp) {
+        for (size_t i = p; i < p + bpp; i++) {
+            int x = row[i],
+                b = prev[i],
+                a = i >= (size_t)bpp ? row [i - bpp] : 0,
+                c = i >= (size_t)bpp ? prev[i - bpp] : 0;
+            costs[PNG_FILTER_VALUE_NONE]  += filter_cost(x);
+            costs[PNG_FILTER_VALUE_SUB]   += filter_cost(x - a);
+            costs[PNG_FILTER_VALUE_UP]    += filter_cost(x - b);
+            costs[PNG_FILTER_VALUE_AVG]   += filter_cost(x - ((a + b) >> 1));
+            costs[PNG_FILTER_VALUE_PAETH] += filter_cost(x - paeth_predictor(a, b, c));
+        }
+    }
+
+    int best = -1;
+    for (int type = 0; type < PNG_FILTER_VALUE_LAST; type++) {
+        if ((filters & (PNG_FILTER_NONE << type)) && (best < 0 || costs[type] < costs[best])) {
+            best = type;
+        }
+    }
+    return best;
+}
+
+// Writes the filter type, then row filtered with it, to dst.
+static void filter_row(int type, const uint8_t* row, const uint8_t* prev, size_t rowBytes,
+                       int bpp, uint8_t* dst) {
+    *dst++ = (uint8_t)type;
+    const size_t n = rowBytes;
+    switch (type) {
+        case PNG_FILTER_VALUE_NONE:
+            memcpy(dst, row, n);
+            break;
+        case PNG_FILTER_VALUE_SUB:
+            memcpy(dst, row, bpp);
+            for (size_t i = bpp; i < n; i++) {
+                dst[i] = row[i] - row[i - bpp];
+            }
+            break;
+        case PNG_FILTER_VALUE_UP:
+            for (size_t i = 0; i < n; i++) {
+                dst[i] = row[i] - prev[i];
+            }
+            break;
+        case PNG_FILTER_VALUE_AVG:
+            for (int i = 0; i < bpp; i++) {
+                dst[i] = row[i] - (prev[i] >> 1);
+            }
+            for (size_t i = bpp; i < n; i++) {
+                dst[i] = row[i] - ((row[i - bpp] + prev[i]) >> 1);
+            }
+            break;
+        case PNG_FILTER_VALUE_PAETH:
+            for (int i = 0; i < bpp; i++) {
+                dst[i] = row[i] - prev[i];
+            }
+            for (size_t i = bpp; i < n; i++) {
+                dst[i] = row[i] - paeth_predictor(row[i - bpp], prev[i], prev[i - bpp]);
+            }
+            break;
+        default:
+            SkASSERT(false);
+            break;
+    }
+}
+
+namespace {
+    struct PngBand {
+        std::vector<uint8_t> fDeflated;
+        uLong                fAdler = 0;
+        uLong                fLength = 0;  // Of the filtered rows.
+    };
+}  // namespace
+
+/*
+ * Filters and deflates the rows [top, bottom) of src into band->fDeflated, after prefixBytes
+ * left for the zlib header.  The deflate stream is raw, and ends with a sync flush so the next
+ * band can be appended to it, unless last is set.
+ */
+static bool encode_band(const SkPixmap& src, transform_scanline_proc proc, int bpp,
+                        int filters, int zlibLevel, int strategy, int top, int bottom, bool last,
+                        size_t prefixBytes, PngBand* band) {
+    const size_t rowBytes = (size_t)bpp * src.width(),
+                 filteredRowBytes = rowBytes + 1;
+
+    // Also filter enough of the rows above the band to fill the deflate window.  Seeding the
+    // window with them gives the same matches a serial encode would find at the band's start.
+    const int dictRows = std::min<int>(top, (kDeflateWindowBytes + rowBytes) / filteredRowBytes);
+    const int first = top - dictRows;
+
+    std::vector<uint8_t> filtered((bottom - first) * filteredRowBytes);
+    std::vector<uint8_t> rows(2 * rowBytes, 0);
+    uint8_t* prev = rows.data();
+    uint8_t* curr = prev + rowBytes;
+    const int srcBpp = SkColorTypeBytesPerPixel(src.colorType());
+    if (first > 0) {
+        proc((char*)prev, (const char*)src.addr(0, first - 1), src.width(), srcBpp);
+    }
+    for (int y = first; y < bottom; y++) {
+        proc((char*)curr, (const char*)src.addr(0, y), src.width(), srcBpp);
+        filter_row(choose_filter(filters, curr, prev, rowBytes, bpp), curr, prev, rowBytes, bpp,
+                   filtered.data() + (y - first) * filteredRowBytes);
+        std::swap(prev, curr);
+    }
+
+    const uint8_t* data = filtered.data() + dictRows * filteredRowBytes;
+    band->fLength = (uLong)((bottom - top) * filteredRowBytes);
+    band->fAdler = adler32(adler32(0, nullptr, 0), data, band->fLength);
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (Z_OK != deflateInit2(&stream, zlibLevel, Z_DEFLATED, -MAX_WBITS, 8, strategy)) {
+        return false;
+    }
+    if (dictRows > 0) {
+        const size_t dictBytes = std::min(kDeflateWindowBytes, dictRows * filteredRowBytes);
+        deflateSetDictionary(&stream, data - dictBytes, (uInt)dictBytes);
+    }
+
+    // deflateBound() assumes Z_FINISH; leave room for the sync flush's empty stored block too.
+    constexpr size_t kFlushBytes = 16;
+    band->fDeflated.resize(prefixBytes + deflateBound(&stream, band->fLength) + kFlushBytes);
+    stream.next_in = const_cast<Bytef*>(data);
+    stream.avail_in = (uInt)band->fLength;
+    stream.next_out = band->fDeflated.data() + prefixBytes;
+    stream.avail_out = (uInt)(band->fDeflated.size() - prefixBytes);
+    const int result = deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+    const bool success = (last ? Z_STREAM_END == result : Z_OK == result) &&
+                         0 == stream.avail_in && stream.avail_out > 0;
+    band->fDeflated.resize(band->fDeflated.size() - stream.avail_out);
+    deflateEnd(&stream);
+    return success;
+}
+
+static void write_be32(uint8_t* dst, uint32_t value) {
+    dst[0] = (uint8_t)(value >> 24);
+    dst[1] = (uint8_t)(value >> 16);
+    dst[2] = (uint8_t)(value >>  8);
+    dst[3] = (uint8_t)(value >>  0);
+}
+
+static bool write_chunk(SkWStream* stream, const char type[4], const uint8_t* data,
+                        size_t length) {
+    SkASSERT(length <= PNG_UINT_31_MAX);
+    uint8_t header[8], crc[4];
+    write_be32(header, (uint32_t)length);
+    memcpy(header + 4, type, 4);
+    uLong checksum = crc32(crc32(0, nullptr, 0), header + 4, 4);
+    if (length) {
+        checksum = crc32(checksum, data, (uInt)length);
+    }
+    write_be32(crc, (uint32_t)checksum);
+    return stream->write(header, sizeof(header)) &&
+           (0 == length || stream->write(data, length)) &&
+           stream->write(crc, sizeof(crc));
+}
+
+bool SkPngEncoderMgr::encodeInParallel(const SkPixmap& src, const SkPngEncoder::Options& options) {
+    const int filters = (int)options.fFilterFlags & (int)SkPngEncoder::FilterFlag::kAll;
+    const int zlibLevel = std::min(std::max(0, options.fZLibLevel), 9);
+    // Like libpng, use Z_FILTERED unless the rows are unfiltered.
+    const int strategy = (0 == filters || PNG_FILTER_NONE == filters) ? Z_DEFAULT_STRATEGY
+                                                                      : Z_FILTERED;
+
+    const int bandRows = rows_per_band((size_t)fPngBytesPerPixel * src.width()),
+              bandCount = (src.height() + bandRows - 1) / bandRows;
+    constexpr size_t kZLibHeaderBytes = 2;
+    std::vector<PngBand> bands(bandCount);
+    std::atomic<bool> failed{false};
+    SkTaskGroup(*options.fExecutor).batch(bandCount, [&](int i) {
+        if (!encode_band(src, fProc, fPngBytesPerPixel, filters, zlibLevel, strategy,
+                         i * bandRows, std::min((i + 1) * bandRows, src.height()),
+                         i == bandCount - 1, 0 == i ? kZLibHeaderBytes : 0, &bands[i])) {
+            failed = true;
+        }
+    });
+    if (failed) {
+        return false;
+    }
+
+    // Wrap the bands' deflate streams into one zlib stream, with a 32K window.
+    const int cmf = 0x78,
+              flevel = zlibLevel < 2 ? 0 : zlibLevel < 6 ? 1 : zlibLevel == 6 ? 2 : 3;
+    int flg = flevel << 6;
+    flg += 31 - (cmf * 256 + flg) % 31;
+    bands.front().fDeflated[0] = (uint8_t)cmf;
+    bands.front().fDeflated[1] = (uint8_t)flg;
+
+    uLong adler = bands.front().fAdler;
+    for (int i = 1; i < bandCount; i++) {
+        adler = adler32_combine(adler, bands[i].fAdler, bands[i].fLength);
+    }
+    uint8_t trailer[4];
+    write_be32(trailer, (uint32_t)adler);
+    bands.back().fDeflated.insert(bands.back().fDeflated.end(), trailer, trailer + 4);
+
+    SkWStream* stream = (SkWStream*)png_get_io_ptr(fPngPtr);
+    for (const PngBand& band : bands) {
+        if (!write_chunk(stream, "IDAT", band.fDeflated.data(), band.fDeflated.size())) {
+            return false;
+        }
+    }
+    return write_chunk(stream, "IEND", nullptr, 0);
+}
+
 std::unique_ptr<SkEncoder> SkPngEncoder::Make(SkWStream* dst, const SkPixmap& src,
                                               const Options& options) {
     if (!SkPixmapIsValid(src)) {
@@ -455,6 +724,18 @@ bool SkPngEncoder::onEncodeRows(int numRows) {
 }
 
 bool SkPngEncoder::Encode(SkWStream* dst, const SkPixmap& src, const Options& options) {
+    if (options.fExecutor && SkPixmapIsValid(src)) {
+        std::unique_ptr<SkPngEncoderMgr> encoderMgr = SkPngEncoderMgr::Make(dst);
+        if (encoderMgr && encoderMgr->setHeader(src.info(), options) &&
+                encoderMgr->setColorSpace(src.info())) {
+            encoderMgr->chooseProc(src.info());
+            if (encoderMgr->canEncodeInParallel(src)) {
+                return encoderMgr->writeInfo(src.info()) &&
+                       encoderMgr->encodeInParallel(src, options);
+            }
+        }
+    }
+
     auto encoder = SkPngEncoder::Make(dst, src, options);
     return encoder.get() && encoder->encodeRows(src.height());
 }
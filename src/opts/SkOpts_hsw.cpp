@@ -12,6 +12,7 @@
 #include "src/opts/SkBitmapProcState_opts.h"
 #include "src/opts/SkBlitRow_opts.h"
 #include "src/opts/SkRasterPipeline_opts.h"
+#include "src/opts/SkSwizzler_opts.h"
 #include "src/opts/SkUtils_opts.h"
 #include "src/opts/SkVM_opts.h"
 
@@ -22,6 +23,12 @@ namespace SkOpts {
 
         S32_alpha_D32_filter_DX  = hsw::S32_alpha_D32_filter_DX;
 
+        RGB16_to_RGB1  = hsw::RGB16_to_RGB1;
+        RGB16_to_BGR1  = hsw::RGB16_to_BGR1;
+        RGBA16_to_RGBA = hsw::RGBA16_to_RGBA;
+        RGBA16_to_BGRA = hsw::RGBA16_to_BGRA;
+        index8_to_8888 = hsw::index8_to_8888;
+
         cubic_solver = SK_OPTS_NS::cubic_solver;
 
     #define M(st) stages_highp[SkRasterPipeline::st] = (StageFn)SK_OPTS_NS::st;
@@ -818,6 +818,294 @@ static void inverted_cmyk_to(uint32_t* dst, const uint32_t* src, int count) {
 
 #endif
 
+// PNG stores 16-bit components big-endian, so stripping them to 8 bits keeps their first byte.
+
+static void RGB16_to_RGB1_portable(uint32_t dst[], const uint8_t* src, int count) {
+    for (int i = 0; i < count; i++) {
+        uint8_t r = src[0],
+                g = src[2],
+                b = src[4];
+        src += 6;
+        dst[i] = (uint32_t)0xFF << 24
+               | (uint32_t)b    << 16
+               | (uint32_t)g    <<  8
+               | (uint32_t)r    <<  0;
+    }
+}
+
+static void RGB16_to_BGR1_portable(uint32_t dst[], const uint8_t* src, int count) {
+    for (int i = 0; i < count; i++) {
+        uint8_t r = src[0],
+                g = src[2],
+                b = src[4];
+        src += 6;
+        dst[i] = (uint32_t)0xFF << 24
+               | (uint32_t)r    << 16
+               | (uint32_t)g    <<  8
+               | (uint32_t)b    <<  0;
+    }
+}
+
+static void RGBA16_to_RGBA_portable(uint32_t dst[], const uint8_t* src, int count) {
+    for (int i = 0; i < count; i++) {
+        uint8_t r = src[0],
+                g = src[2],
+                b = src[4],
+                a = src[6];
+        src += 8;
+        dst[i] = (uint32_t)a << 24
+               | (uint32_t)b << 16
+               | (uint32_t)g <<  8
+               | (uint32_t)r <<  0;
+    }
+}
+
+static void RGBA16_to_BGRA_portable(uint32_t dst[], const uint8_t* src, int count) {
+    for (int i = 0; i < count; i++) {
+        uint8_t r = src[0],
+                g = src[2],
+                b = src[4],
+                a = src[6];
+        src += 8;
+        dst[i] = (uint32_t)a << 24
+               | (uint32_t)r << 16
+               | (uint32_t)g <<  8
+               | (uint32_t)b <<  0;
+    }
+}
+
+static void index8_to_8888_portable(uint32_t dst[], const uint8_t* src, int count,
+                                    const uint32_t ctable[]) {
+    for (int i = 0; i < count; i++) {
+        dst[i] = ctable[src[i]];
+    }
+}
+
+static void index4_to_8888_portable(uint32_t dst[], const uint8_t* src, int count,
+                                    const uint32_t ctable[]) {
+    for (int i = 0; i < count; i++) {
+        uint8_t index = (i & 1) ? (src[i >> 1] & 0xF) : (src[i >> 1] >> 4);
+        dst[i] = ctable[index];
+    }
+}
+
+#if SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_SSSE3
+
+// Keeps the high (first) byte of each 16-bit component of 4 pixels, shuffled by lo and hi.
+// lo picks the bytes of the first two pixels from src, hi the last two from src + 8.
+template <bool kSwapRB>
+static void strip_rgb16(uint32_t dst[], const uint8_t* src, int count) {
+    const uint8_t X = 0xFF; // Used a placeholder.  The value of X is irrelevant.
+    const __m128i alphaMask = _mm_set1_epi32(0xFF000000);
+    __m128i lo, hi;
+    if (kSwapRB) {
+        lo = _mm_setr_epi8(4,2,0,X, 10,8,6,X, X,X,X,X,   X, X, X,X);
+        hi = _mm_setr_epi8(X,X,X,X,  X,X,X,X, 8,6,4,X,  14,12,10,X);
+    } else {
+        lo = _mm_setr_epi8(0,2,4,X, 6,8,10,X, X,X,X,X,   X, X, X,X);
+        hi = _mm_setr_epi8(X,X,X,X, X,X, X,X, 4,6,8,X,  10,12,14,X);
+    }
+
+#if SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_AVX2
+    // The same shuffles work on 8 pixels, with pixels 4-7 loaded into the upper lanes.
+    const __m256i lo8 = _mm256_broadcastsi128_si256(lo),
+                  hi8 = _mm256_broadcastsi128_si256(hi),
+                  alphaMask8 = _mm256_set1_epi32(0xFF000000);
+    auto load2 = [](const uint8_t* p0, const uint8_t* p1) {
+        return _mm256_inserti128_si256(
+                _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)p0)),
+                _mm_loadu_si128((const __m128i*)p1), 1);
+    };
+    while (count >= 8) {
+        __m256i first = load2(src +  0, src + 24),
+                 last = load2(src +  8, src + 32);
+        __m256i rgba = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(first, lo8),
+                                                       _mm256_shuffle_epi8( last, hi8)),
+                                       alphaMask8);
+        _mm256_storeu_si256((__m256i*)dst, rgba);
+
+        src += 8*6;
+        dst += 8;
+        count -= 8;
+    }
+#endif
+
+    while (count >= 4) {
+        __m128i first = _mm_loadu_si128((const __m128i*) (src + 0)),
+                 last = _mm_loadu_si128((const __m128i*) (src + 8));
+        __m128i rgba = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(first, lo),
+                                                 _mm_shuffle_epi8( last, hi)),
+                                    alphaMask);
+        _mm_storeu_si128((__m128i*) dst, rgba);
+
+        src += 4*6;
+        dst += 4;
+        count -= 4;
+    }
+
+    auto proc = kSwapRB ? RGB16_to_BGR1_portable : RGB16_to_RGB1_portable;
+    proc(dst, src, count);
+}
+
+template <bool kSwapRB>
+static void strip_rgba16(uint32_t dst[], const uint8_t* src, int count) {
+    const uint8_t X = 0xFF; // Used a placeholder.  The value of X is irrelevant.
+    __m128i lo, hi;
+    if (kSwapRB) {
+        lo = _mm_setr_epi8(4,2,0,6, 12,10,8,14, X,X,X,X, X, X,X, X);
+        hi = _mm_setr_epi8(X,X,X,X,  X, X,X, X, 4,2,0,6, 12,10,8,14);
+    } else {
+        lo = _mm_setr_epi8(0,2,4,6, 8,10,12,14, X,X,X,X, X, X, X, X);
+        hi = _mm_setr_epi8(X,X,X,X, X, X, X, X, 0,2,4,6, 8,10,12,14);
+    }
+
+#if SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_AVX2
+    const __m256i lo8 = _mm256_broadcastsi128_si256(lo),
+                  hi8 = _mm256_broadcastsi128_si256(hi);
+    while (count >= 8) {
+        // Each lane of first holds 2 of pixels 0-3, each lane of last 2 of pixels 4-7.
+        __m256i first = _mm256_loadu_si256((const __m256i*) (src +  0)),
+                 last = _mm256_loadu_si256((const __m256i*) (src + 32));
+        __m256i rgba = _mm256_or_si256(_mm256_shuffle_epi8(first, lo8),
+                                       _mm256_shuffle_epi8( last, hi8));
+        // Now 64-bit lanes hold pixels {0,1}, {4,5}, {2,3}, {6,7}.
+        _mm256_storeu_si256((__m256i*)dst, _mm256_permute4x64_epi64(rgba, 0xD8));
+
+        src += 8*8;
+        dst += 8;
+        count -= 8;
+    }
+#endif
+
+    while (count >= 4) {
+        __m128i first = _mm_loadu_si128((const __m128i*) (src +  0)),
+                 last = _mm_loadu_si128((const __m128i*) (src + 16));
+        __m128i rgba = _mm_or_si128(_mm_shuffle_epi8(first, lo),
+                                    _mm_shuffle_epi8( last, hi));
+        _mm_storeu_si128((__m128i*) dst, rgba);
+
+        src += 4*8;
+        dst += 4;
+        count -= 4;
+    }
+
+    auto proc = kSwapRB ? RGBA16_to_BGRA_portable : RGBA16_to_RGBA_portable;
+    proc(dst, src, count);
+}
+
+/*not static*/ inline void RGB16_to_RGB1(uint32_t dst[], const uint8_t* src, int count) {
+    strip_rgb16<false>(dst, src, count);
+}
+
+/*not static*/ inline void RGB16_to_BGR1(uint32_t dst[], const uint8_t* src, int count) {
+    strip_rgb16<true>(dst, src, count);
+}
+
+/*not static*/ inline void RGBA16_to_RGBA(uint32_t dst[], const uint8_t* src, int count) {
+    strip_rgba16<false>(dst, src, count);
+}
+
+/*not static*/ inline void RGBA16_to_BGRA(uint32_t dst[], const uint8_t* src, int count) {
+    strip_rgba16<true>(dst, src, count);
+}
+
+/*not static*/ inline void index8_to_8888(uint32_t dst[], const uint8_t* src, int count,
+                                          const uint32_t ctable[]) {
+#if SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_AVX2
+    while (count >= 8) {
+        __m256i indices = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*) src));
+        _mm256_storeu_si256((__m256i*) dst,
+                            _mm256_i32gather_epi32((const int*) ctable, indices, 4));
+        src += 8;
+        dst += 8;
+        count -= 8;
+    }
+#endif
+    index8_to_8888_portable(dst, src, count, ctable);
+}
+
+/*not static*/ inline void index4_to_8888(uint32_t dst[], const uint8_t* src, int count,
+                                          const uint32_t ctable[]) {
+    if (count < 16) {
+        index4_to_8888_portable(dst, src, count, ctable);
+        return;
+    }
+
+    // Transpose the 16 colors into 4 planes, one per byte, so pshufb can look up each byte.
+    const __m128i bytesToPlanes = _mm_setr_epi8(0,4,8,12, 1,5,9,13, 2,6,10,14, 3,7,11,15);
+    __m128i c0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) (ctable +  0)), bytesToPlanes),
+            c1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) (ctable +  4)), bytesToPlanes),
+            c2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) (ctable +  8)), bytesToPlanes),
+            c3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) (ctable + 12)), bytesToPlanes);
+    __m128i c01_lo = _mm_unpacklo_epi32(c0, c1),
+            c23_lo = _mm_unpacklo_epi32(c2, c3),
+            c01_hi = _mm_unpackhi_epi32(c0, c1),
+            c23_hi = _mm_unpackhi_epi32(c2, c3);
+    const __m128i plane0 = _mm_unpacklo_epi64(c01_lo, c23_lo),
+                  plane1 = _mm_unpackhi_epi64(c01_lo, c23_lo),
+                  plane2 = _mm_unpacklo_epi64(c01_hi, c23_hi),
+                  plane3 = _mm_unpackhi_epi64(c01_hi, c23_hi);
+
+    const __m128i lowNibbles = _mm_set1_epi8(0x0F);
+    while (count >= 16) {
+        __m128i packed = _mm_loadl_epi64((const __m128i*) src);
+        // The first index of each pair is in the high nibble.
+        __m128i indices = _mm_unpacklo_epi8(_mm_and_si128(_mm_srli_epi16(packed, 4), lowNibbles),
+                                            _mm_and_si128(packed, lowNibbles));
+
+        __m128i b0 = _mm_shuffle_epi8(plane0, indices),
+                b1 = _mm_shuffle_epi8(plane1, indices),
+                b2 = _mm_shuffle_epi8(plane2, indices),
+                b3 = _mm_shuffle_epi8(plane3, indices);
+
+        __m128i b01_lo = _mm_unpacklo_epi8(b0, b1),
+                b01_hi = _mm_unpackhi_epi8(b0, b1),
+                b23_lo = _mm_unpacklo_epi8(b2, b3),
+                b23_hi = _mm_unpackhi_epi8(b2, b3);
+
+        _mm_storeu_si128((__m128i*) (dst +  0), _mm_unpacklo_epi16(b01_lo, b23_lo));
+        _mm_storeu_si128((__m128i*) (dst +  4), _mm_unpackhi_epi16(b01_lo, b23_lo));
+        _mm_storeu_si128((__m128i*) (dst +  8), _mm_unpacklo_epi16(b01_hi, b23_hi));
+        _mm_storeu_si128((__m128i*) (dst + 12), _mm_unpackhi_epi16(b01_hi, b23_hi));
+
+        src += 16/2;
+        dst += 16;
+        count -= 16;
+    }
+
+    index4_to_8888_portable(dst, src, count, ctable);
+}
+
+#else
+
+/*not static*/ inline void RGB16_to_RGB1(uint32_t dst[], const uint8_t* src, int count) {
+    RGB16_to_RGB1_portable(dst, src, count);
+}
+
+/*not static*/ inline void RGB16_to_BGR1(uint32_t dst[], const uint8_t* src, int count) {
+    RGB16_to_BGR1_portable(dst, src, count);
+}
+
+/*not static*/ inline void RGBA16_to_RGBA(uint32_t dst[], const uint8_t* src, int count) {
+    RGBA16_to_RGBA_portable(dst, src, count);
+}
+
+/*not static*/ inline void RGBA16_to_BGRA(uint32_t dst[], const uint8_t* src, int count) {
+    RGBA16_to_BGRA_portable(dst, src, count);
+}
+
+/*not static*/ inline void index8_to_8888(uint32_t dst[], const uint8_t* src, int count,
+                                          const uint32_t ctable[]) {
+    index8_to_8888_portable(dst, src, count, ctable);
+}
+
+/*not static*/ inline void index4_to_8888(uint32_t dst[], const uint8_t* src, int count,
+                                          const uint32_t ctable[]) {
+    index4_to_8888_portable(dst, src, count, ctable);
+}
+
+#endif
+
 }
 
 #endif // SkSwizzler_opts_DEFINED
@@ -8,13 +8,19 @@
 #include "src/pdf/SkDeflate.h"
 
 #include "include/core/SkData.h"
+#include "include/core/SkExecutor.h"
 #include "include/private/SkMalloc.h"
+#include "include/private/SkSemaphore.h"
 #include "include/private/SkTo.h"
 #include "src/core/SkTraceEvent.h"
 
 #include "zlib.h"
 
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <vector>
 
 namespace {
 
@@ -56,41 +62,256 @@ static void do_deflate(int flush,
                  : returnValue == Z_OK);
 }
 
+// With an executor, input is split into blocks of this size, compressed in parallel.
+#define SKDEFLATEWSTREAM_PARALLEL_BLOCK_SIZE (128 * 1024)
+// Each block is primed with this much of the input before it: all of deflate's window.
+#define SKDEFLATEWSTREAM_DICTIONARY_SIZE (32 * 1024)
+
+static void init_zstream(z_stream* zStream, int compressionLevel, int windowBits) {
+    zStream->next_in = nullptr;
+    zStream->zalloc = &skia_alloc_func;
+    zStream->zfree = &skia_free_func;
+    zStream->opaque = nullptr;
+    SkDEBUGCODE(int r =) deflateInit2(zStream, compressionLevel,
+                                      Z_DEFLATED, windowBits,
+                                      8, Z_DEFAULT_STRATEGY);
+    SkASSERT(Z_OK == r);
+}
+
+namespace {
+// A block of input compressed as a run of raw deflate blocks.  All but the
+// last end on a byte boundary, so they can be concatenated.
+//
+// Whichever of the executor's task and finalize() claims a block first
+// compresses it.  The stream is often written from a task already running on
+// the same executor, so finalize() must not wait for tasks which may never get
+// a thread; it only waits for blocks another thread is busy compressing.
+struct DeflateBlock {
+    std::vector<unsigned char> fInput;
+    std::vector<unsigned char> fDictionary;
+    std::vector<unsigned char> fOutput;
+    uLong fInputSize = 0;
+    uLong fCheck = 0;  // Adler-32 or CRC-32 of fInput.
+    bool fLast = false;
+    std::atomic<bool> fClaimed{false};
+    SkSemaphore fDone;  // Signaled once a task has compressed the block.
+};
+}  // namespace
+
+// Returns true if the bytes are close to uniformly distributed, as they are
+// in already compressed (or encrypted) data, which deflate can't shrink.
+static bool looks_incompressible(const unsigned char* data, size_t size) {
+    static constexpr double kIncompressibleBitsPerByte = 7.95;
+    size_t counts[256] = {0};
+    for (size_t i = 0; i < size; ++i) {
+        counts[data[i]]++;
+    }
+    double bits = 0;
+    for (size_t count : counts) {
+        if (count) {
+            bits -= count * std::log2((double)count / size);
+        }
+    }
+    return bits >= kIncompressibleBitsPerByte * size;
+}
+
+// Appends data as stored (uncompressed) deflate blocks.
+static void append_stored(const unsigned char* data, size_t size, bool last,
+                          std::vector<unsigned char>* out) {
+    do {
+        size_t n = std::min<size_t>(size, 0xFFFF);
+        // BFINAL and BTYPE=00, padded to a byte, then LEN and NLEN.
+        unsigned char header[5] = {
+            (unsigned char)(last && n == size ? 1 : 0),
+            (unsigned char)(n & 0xFF), (unsigned char)(n >> 8),
+            (unsigned char)(~n & 0xFF), (unsigned char)((~n >> 8) & 0xFF),
+        };
+        out->insert(out->end(), header, header + sizeof(header));
+        out->insert(out->end(), data, data + n);
+        data += n;
+        size -= n;
+    } while (size > 0);
+}
+
+static void compress_block(DeflateBlock* block, int compressionLevel, bool gzip) {
+    TRACE_EVENT0("skia", TRACE_FUNC);
+    const unsigned char* input = block->fInput.data();
+    const size_t size = block->fInput.size();
+    block->fInputSize = (uLong)size;
+    block->fCheck = gzip ? crc32(crc32(0, nullptr, 0), input, SkToUInt(size))
+                         : adler32(adler32(0, nullptr, 0), input, SkToUInt(size));
+
+    if (compressionLevel != 0 && !looks_incompressible(input, size)) {
+        z_stream zStream;
+        init_zstream(&zStream, compressionLevel, -MAX_WBITS);
+        if (!block->fDictionary.empty()) {
+            deflateSetDictionary(&zStream, block->fDictionary.data(),
+                                 SkToUInt(block->fDictionary.size()));
+        }
+        // deflateBound() assumes Z_FINISH; leave room for a sync flush.
+        block->fOutput.resize(deflateBound(&zStream, (uLong)size) + 16);
+        zStream.next_in = const_cast<unsigned char*>(input);
+        zStream.avail_in = SkToUInt(size);
+        zStream.next_out = block->fOutput.data();
+        zStream.avail_out = SkToUInt(block->fOutput.size());
+        int result = deflate(&zStream, block->fLast ? Z_FINISH : Z_SYNC_FLUSH);
+        bool complete = (block->fLast ? Z_STREAM_END == result : Z_OK == result) &&
+                        0 == zStream.avail_in && zStream.avail_out > 0;
+        block->fOutput.resize(block->fOutput.size() - zStream.avail_out);
+        (void)deflateEnd(&zStream);
+        if (complete && block->fOutput.size() < size) {
+            block->fInput = std::vector<unsigned char>();
+            block->fDictionary = std::vector<unsigned char>();
+            return;
+        }
+        block->fOutput.clear();
+    }
+    append_stored(input, size, block->fLast, &block->fOutput);
+    block->fInput = std::vector<unsigned char>();
+    block->fDictionary = std::vector<unsigned char>();
+}
+
 // Hide all zlib impl details.
 struct SkDeflateWStream::Impl {
     SkWStream* fOut;
     unsigned char fInBuffer[SKDEFLATEWSTREAM_INPUT_BUFFER_SIZE];
     size_t fInBufferIndex;
     z_stream fZStream;
+
+    int fCompressionLevel;
+    bool fGzip;
+
+    // Only used with an executor.
+    SkExecutor* fExecutor;
+    std::vector<unsigned char> fBlock;       // Not yet handed to a task.
+    std::vector<unsigned char> fDictionary;  // The end of the last block handed out.
+    std::vector<std::shared_ptr<DeflateBlock>> fBlocks;
+    size_t fBytesIn;
 };
 
 SkDeflateWStream::SkDeflateWStream(SkWStream* out,
                                    int compressionLevel,
-                                   bool gzip)
+                                   bool gzip,
+                                   SkExecutor* executor)
     : fImpl(std::make_unique<SkDeflateWStream::Impl>()) {
     fImpl->fOut = out;
     fImpl->fInBufferIndex = 0;
+    fImpl->fExecutor = executor;
+    fImpl->fBytesIn = 0;
     if (!fImpl->fOut) {
         return;
     }
-    fImpl->fZStream.next_in = nullptr;
-    fImpl->fZStream.zalloc = &skia_alloc_func;
-    fImpl->fZStream.zfree = &skia_free_func;
-    fImpl->fZStream.opaque = nullptr;
     SkASSERT(compressionLevel <= 9 && compressionLevel >= -1);
-    SkDEBUGCODE(int r =) deflateInit2(&fImpl->fZStream, compressionLevel,
-                                      Z_DEFLATED, gzip ? 0x1F : 0x0F,
-                                      8, Z_DEFAULT_STRATEGY);
-    SkASSERT(Z_OK == r);
+    fImpl->fCompressionLevel = compressionLevel;
+    fImpl->fGzip = gzip;
+    if (fImpl->fExecutor) {
+        // Small streams are still compressed serially, once finalize() knows
+        // they fit in a single block.
+        fImpl->fBlock.reserve(SKDEFLATEWSTREAM_PARALLEL_BLOCK_SIZE);
+        return;
+    }
+    init_zstream(&fImpl->fZStream, compressionLevel, gzip ? 0x1F : 0x0F);
 }
 
 SkDeflateWStream::~SkDeflateWStream() { this->finalize(); }
 
+void SkDeflateWStream::dispatchBlock(bool last) {
+    auto block = std::make_shared<DeflateBlock>();
+    block->fInput.swap(fImpl->fBlock);
+    block->fDictionary.swap(fImpl->fDictionary);
+    block->fLast = last;
+    if (!last) {
+        size_t n = std::min<size_t>(block->fInput.size(), SKDEFLATEWSTREAM_DICTIONARY_SIZE);
+        fImpl->fDictionary.assign(block->fInput.end() - n, block->fInput.end());
+        fImpl->fBlock.reserve(SKDEFLATEWSTREAM_PARALLEL_BLOCK_SIZE);
+    }
+    // The last block is compressed by finalize() straight away.
+    if (!last) {
+        int compressionLevel = fImpl->fCompressionLevel;
+        bool gzip = fImpl->fGzip;
+        // The task keeps the block alive: it may run after finalize() is done with it.
+        fImpl->fExecutor->add([block, compressionLevel, gzip]() {
+            if (!block->fClaimed.exchange(true)) {
+                compress_block(block.get(), compressionLevel, gzip);
+                block->fDone.signal();
+            }
+        });
+    }
+    fImpl->fBlocks.push_back(std::move(block));
+}
+
+static void write_be32(SkWStream* out, uint32_t value) {
+    unsigned char bytes[4] = {
+        (unsigned char)(value >> 24), (unsigned char)(value >> 16),
+        (unsigned char)(value >> 8), (unsigned char)value,
+    };
+    out->write(bytes, sizeof(bytes));
+}
+
+static void write_le32(SkWStream* out, uint32_t value) {
+    unsigned char bytes[4] = {
+        (unsigned char)value, (unsigned char)(value >> 8),
+        (unsigned char)(value >> 16), (unsigned char)(value >> 24),
+    };
+    out->write(bytes, sizeof(bytes));
+}
+
 void SkDeflateWStream::finalize() {
     TRACE_EVENT0("skia", TRACE_FUNC);
     if (!fImpl->fOut) {
         return;
     }
+    if (fImpl->fExecutor && fImpl->fBlocks.empty()) {
+        init_zstream(&fImpl->fZStream, fImpl->fCompressionLevel, fImpl->fGzip ? 0x1F : 0x0F);
+        do_deflate(Z_FINISH, &fImpl->fZStream, fImpl->fOut, fImpl->fBlock.data(),
+                   fImpl->fBlock.size());
+        (void)deflateEnd(&fImpl->fZStream);
+        fImpl->fOut = nullptr;
+        return;
+    }
+    if (fImpl->fExecutor) {
+        this->dispatchBlock(true);
+        for (const auto& block : fImpl->fBlocks) {
+            if (!block->fClaimed.exchange(true)) {
+                compress_block(block.get(), fImpl->fCompressionLevel, fImpl->fGzip);
+            } else {
+                block->fDone.wait();
+            }
+        }
+
+        SkWStream* out = fImpl->fOut;
+        int level = fImpl->fCompressionLevel < 0 ? 6 : fImpl->fCompressionLevel;
+        if (fImpl->fGzip) {
+            // No name, no timestamp; XFL as zlib sets it; OS unknown.
+            unsigned char xfl = level == 9 ? 2 : level < 2 ? 4 : 0;
+            unsigned char header[10] = { 0x1F, 0x8B, 8, 0, 0, 0, 0, 0, xfl, 0xFF };
+            out->write(header, sizeof(header));
+        } else {
+            // Deflate with a 32K window, and FLEVEL as zlib sets it.
+            int cmf = 0x78,
+                flg = (level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3) << 6;
+            flg += 31 - (cmf * 256 + flg) % 31;
+            unsigned char header[2] = { (unsigned char)cmf, (unsigned char)flg };
+            out->write(header, sizeof(header));
+        }
+
+        uLong check = fImpl->fGzip ? crc32(0, nullptr, 0) : adler32(0, nullptr, 0);
+        for (const auto& block : fImpl->fBlocks) {
+            out->write(block->fOutput.data(), block->fOutput.size());
+            block->fOutput = std::vector<unsigned char>();
+            check = fImpl->fGzip ? crc32_combine(check, block->fCheck, block->fInputSize)
+                                 : adler32_combine(check, block->fCheck, block->fInputSize);
+        }
+        if (fImpl->fGzip) {
+            write_le32(out, SkToU32(check));
+            write_le32(out, (uint32_t)fImpl->fBytesIn);
+        } else {
+            write_be32(out, SkToU32(check));
+        }
+        fImpl->fBlocks.clear();
+        fImpl->fOut = nullptr;
+        return;
+    }
     do_deflate(Z_FINISH, &fImpl->fZStream, fImpl->fOut, fImpl->fInBuffer,
                fImpl->fInBufferIndex);
     (void)deflateEnd(&fImpl->fZStream);
@@ -103,6 +324,22 @@ bool SkDeflateWStream::write(const void* void_buffer, size_t len) {
         return false;
     }
     const char* buffer = (const char*)void_buffer;
+    if (fImpl->fExecutor) {
+        fImpl->fBytesIn += len;
+        while (len > 0) {
+            // Only hand out a full block once there's more input, so the
+            // last block is always the one finalize() hands out.
+            if (fImpl->fBlock.size() == SKDEFLATEWSTREAM_PARALLEL_BLOCK_SIZE) {
+                this->dispatchBlock(false);
+            }
+            size_t tocopy = std::min(
+                    len, SKDEFLATEWSTREAM_PARALLEL_BLOCK_SIZE - fImpl->fBlock.size());
+            fImpl->fBlock.insert(fImpl->fBlock.end(), buffer, buffer + tocopy);
+            len -= tocopy;
+            buffer += tocopy;
+        }
+        return true;
+    }
     while (len > 0) {
         size_t tocopy =
                 std::min(len, sizeof(fImpl->fInBuffer) - fImpl->fInBufferIndex);
@@ -123,5 +360,8 @@ bool SkDeflateWStream::write(const void* void_buffer, size_t len) {
 }
 
 size_t SkDeflateWStream::bytesWritten() const {
+    if (fImpl->fExecutor) {
+        return fImpl->fBytesIn;
+    }
     return fImpl->fZStream.total_in + fImpl->fInBufferIndex;
 }
@@ -11,6 +11,8 @@
 
 #include "include/core/SkStream.h"
 
+class SkExecutor;
+
 /**
   * Wrap a stream in this class to compress the information written to
   * this stream using the Deflate algorithm.
@@ -29,10 +31,20 @@ public:
         a wrapper, documented in RFC 1952, around a deflate stream."
         gzip adds a header with a magic number to the beginning of the
         stream, allowing a client to identify a gzip file.
+
+        @param executor if not null, and more than one block (128KB) is
+        written, the blocks are compressed in parallel on the executor.
+        Each block is primed with the end of the block before it, so
+        the output is only slightly larger.  Blocks which look already
+        compressed are stored rather than deflated.  The compressed
+        output is then written to the stream in finalize(), which
+        compresses any block no thread has started on itself, so it is
+        safe to use the executor the caller is running on.
      */
     SkDeflateWStream(SkWStream*,
                      int compressionLevel = -1,
-                     bool gzip = false);
+                     bool gzip = false,
+                     SkExecutor* executor = nullptr);
 
     /** The destructor calls finalize(). */
     ~SkDeflateWStream() override;
@@ -46,6 +58,8 @@ public:
     size_t bytesWritten() const override;
 
 private:
+    void dispatchBlock(bool last);
+
     struct Impl;
     std::unique_ptr<Impl> fImpl;
 };
@@ -13,6 +13,11 @@ class SkPDFArray {};
 
 sk_sp<SkDocument> SkPDF::MakeDocument(SkWStream*, const SkPDF::Metadata&) { return nullptr; }
 
+size_t SkPDF::SetSharedCacheLimit(size_t) { return 0; }
+size_t SkPDF::GetSharedCacheLimit() { return 0; }
+size_t SkPDF::GetSharedCacheBytesUsed() { return 0; }
+void SkPDF::PurgeSharedCache() {}
+
 void SkPDF::SetNodeId(SkCanvas* c, int n) {
     c->drawAnnotation({0, 0, 0, 0}, "PDF_Node_Key", SkData::MakeWithCopy(&n, sizeof(n)).get());
 }
@@ -10,6 +10,7 @@
 #include "include/core/SkData.h"
 #include "include/core/SkExecutor.h"
 #include "include/core/SkImage.h"
+#include "include/core/SkImageGenerator.h"
 #include "include/core/SkStream.h"
 #include "include/private/SkColorData.h"
 #include "include/private/SkImageInfoPriv.h"
@@ -17,6 +18,7 @@
 #include "src/pdf/SkDeflate.h"
 #include "src/pdf/SkJpegInfo.h"
 #include "src/pdf/SkPDFDocumentPriv.h"
+#include "src/pdf/SkPDFSharedCache.h"
 #include "src/pdf/SkPDFTypes.h"
 #include "src/pdf/SkPDFUtils.h"
 
@@ -65,20 +67,15 @@ static SkColor get_neighbor_avg_color(const SkPixmap& bm, int xOrig, int yOrig)
                  : SK_ColorTRANSPARENT;
 }
 
-template <typename T>
 static void emit_image_stream(SkPDFDocument* doc,
                               SkPDFIndirectReference ref,
-                              T writeStream,
-                              SkISize size,
-                              const char* colorSpace,
-                              SkPDFIndirectReference sMask,
-                              int length,
-                              bool isJpeg) {
+                              const SkPDFImageStream& image,
+                              SkPDFIndirectReference sMask) {
     SkPDFDict pdfDict("XObject");
     pdfDict.insertName("Subtype", "Image");
-    pdfDict.insertInt("Width", size.width());
-    pdfDict.insertInt("Height", size.height());
-    pdfDict.insertName("ColorSpace", colorSpace);
+    pdfDict.insertInt("Width", image.fSize.width());
+    pdfDict.insertInt("Height", image.fSize.height());
+    pdfDict.insertName("ColorSpace", image.fColorSpace);
     if (sMask) {
         pdfDict.insertRef("SMask", sMask);
     }
@@ -86,21 +83,37 @@ static void emit_image_stream(SkPDFDocument* doc,
     #ifdef SK_PDF_BASE85_BINARY
     auto filters = SkPDFMakeArray();
     filters->appendName("ASCII85Decode");
-    filters->appendName(isJpeg ? "DCTDecode" : "FlateDecode");
+    filters->appendName(image.fIsJpeg ? "DCTDecode" : "FlateDecode");
     pdfDict.insertObject("Filter", std::move(filters));
     #else
-    pdfDict.insertName("Filter", isJpeg ? "DCTDecode" : "FlateDecode");
+    pdfDict.insertName("Filter", image.fIsJpeg ? "DCTDecode" : "FlateDecode");
     #endif
-    if (isJpeg) {
+    if (image.fIsJpeg) {
         pdfDict.insertInt("ColorTransform", 0);
     }
-    pdfDict.insertInt("Length", length);
-    doc->emitStream(pdfDict, std::move(writeStream), ref);
+    pdfDict.insertInt("Length", SkToInt(image.fData->size()));
+    doc->emitStream(pdfDict,
+                    [&image](SkWStream* dst) { dst->write(image.fData->data(),
+                                                          image.fData->size()); },
+                    ref);
 }
 
-static void do_deflated_alpha(const SkPixmap& pm, SkPDFDocument* doc, SkPDFIndirectReference ref) {
+static void emit_image(SkPDFDocument* doc,
+                       SkPDFIndirectReference ref,
+                       const SkPDFEncodedImage& image) {
+    SkPDFIndirectReference sMask;
+    if (image.fSMask.fData) {
+        sMask = doc->reserveRef();
+    }
+    emit_image_stream(doc, ref, image.fImage, sMask);
+    if (sMask) {
+        emit_image_stream(doc, sMask, image.fSMask, SkPDFIndirectReference());
+    }
+}
+
+static SkPDFImageStream deflated_alpha(const SkPixmap& pm, SkExecutor* executor) {
     SkDynamicMemoryWStream buffer;
-    SkDeflateWStream deflateWStream(&buffer);
+    SkDeflateWStream deflateWStream(&buffer, -1, false, executor);
     if (kAlpha_8_SkColorType == pm.colorType()) {
         SkASSERT(pm.rowBytes() == (size_t)pm.width());
         buffer.write(pm.addr8(), pm.width() * pm.height());
@@ -128,29 +141,19 @@ static void do_deflated_alpha(const SkPixmap& pm, SkPDFDocument* doc, SkPDFIndir
     #ifdef SK_PDF_BASE85_BINARY
     SkPDFUtils::Base85Encode(buffer.detachAsStream(), &buffer);
     #endif
-    int length = SkToInt(buffer.bytesWritten());
-    emit_image_stream(doc, ref, [&buffer](SkWStream* stream) { buffer.writeToAndReset(stream); },
-                      pm.info().dimensions(), "DeviceGray", SkPDFIndirectReference(),
-                      length, false);
+    return {buffer.detachAsData(), pm.info().dimensions(), "DeviceGray", false};
 }
 
-static void do_deflated_image(const SkPixmap& pm,
-                              SkPDFDocument* doc,
-                              bool isOpaque,
-                              SkPDFIndirectReference ref) {
-    SkPDFIndirectReference sMask;
-    if (!isOpaque) {
-        sMask = doc->reserveRef();
-    }
+static SkPDFEncodedImage deflated_image(const SkPixmap& pm, bool isOpaque, SkExecutor* executor) {
     SkDynamicMemoryWStream buffer;
-    SkDeflateWStream deflateWStream(&buffer);
+    SkDeflateWStream deflateWStream(&buffer, -1, false, executor);
     const char* colorSpace = "DeviceGray";
     switch (pm.colorType()) {
         case kAlpha_8_SkColorType:
             fill_stream(&deflateWStream, '\x00', pm.width() * pm.height());
             break;
         case kGray_8_SkColorType:
-            SkASSERT(sMask.fValue = -1);
+            SkASSERT(isOpaque);
             SkASSERT(pm.rowBytes() == (size_t)pm.width());
             deflateWStream.write(pm.addr8(), pm.width() * pm.height());
             break;
@@ -185,16 +188,15 @@ static void do_deflated_image(const SkPixmap& pm,
     #ifdef SK_PDF_BASE85_BINARY
     SkPDFUtils::Base85Encode(buffer.detachAsStream(), &buffer);
     #endif
-    int length = SkToInt(buffer.bytesWritten());
-    emit_image_stream(doc, ref, [&buffer](SkWStream* stream) { buffer.writeToAndReset(stream); },
-                      pm.info().dimensions(), colorSpace, sMask, length, false);
+    SkPDFEncodedImage image;
+    image.fImage = {buffer.detachAsData(), pm.info().dimensions(), colorSpace, false};
     if (!isOpaque) {
-        do_deflated_alpha(pm, doc, sMask);
+        image.fSMask = deflated_alpha(pm, executor);
     }
+    return image;
 }
 
-static bool do_jpeg(sk_sp<SkData> data, SkPDFDocument* doc, SkISize size,
-                    SkPDFIndirectReference ref) {
+static bool jpeg_stream(sk_sp<SkData> data, SkISize size, SkPDFImageStream* stream) {
     SkISize jpegSize;
     SkEncodedInfo::Color jpegColorType;
     SkEncodedOrigin exifOrientation;
@@ -215,10 +217,7 @@ static bool do_jpeg(sk_sp<SkData> data, SkPDFDocument* doc, SkISize size,
     data = buffer.detachAsData();
     #endif
 
-    emit_image_stream(doc, ref,
-                      [&data](SkWStream* dst) { dst->write(data->data(), data->size()); },
-                      jpegSize, yuv ? "DeviceRGB" : "DeviceGray",
-                      SkPDFIndirectReference(), SkToInt(data->size()), true);
+    *stream = {std::move(data), jpegSize, yuv ? "DeviceRGB" : "DeviceGray", true};
     return true;
 }
 
@@ -245,6 +244,28 @@ static SkBitmap to_pixels(const SkImage* image) {
     return bm;
 }
 
+static SkPDFEncodedImage encode_pixels(const SkImage* img,
+                                       const SkPixmap& pm,
+                                       int encodingQuality,
+                                       SkExecutor* executor) {
+    bool isOpaque = pm.isOpaque() || pm.computeIsOpaque();
+    if (encodingQuality <= 100 && isOpaque) {
+        sk_sp<SkData> data = img->encodeToData(SkEncodedImageFormat::kJPEG, encodingQuality);
+        SkPDFEncodedImage image;
+        if (data && jpeg_stream(std::move(data), img->dimensions(), &image.fImage)) {
+            return image;
+        }
+    }
+    return deflated_image(pm, isOpaque, executor);
+}
+
+// A lazy image's subsets and color converted copies share its encoded data, which then only
+// identifies the image if it is the whole, unconverted decode of that data.
+static bool is_decode_of(const SkImage* img, sk_sp<SkData> data) {
+    std::unique_ptr<SkImageGenerator> gen = SkImageGenerator::MakeFromEncoded(std::move(data));
+    return gen && gen->getInfo() == img->imageInfo();
+}
+
 void serialize_image(const SkImage* img,
                      int encodingQuality,
                      SkPDFDocument* doc,
@@ -253,20 +274,37 @@ void serialize_image(const SkImage* img,
     SkASSERT(doc);
     SkASSERT(encodingQuality >= 0);
     SkISize dimensions = img->dimensions();
+    SkPDFEncodedImage image;
     sk_sp<SkData> data = img->refEncodedData();
-    if (data && do_jpeg(std::move(data), doc, dimensions, ref)) {
+    if (data && jpeg_stream(data, dimensions, &image.fImage)) {
+        emit_image(doc, ref, image);
         return;
     }
-    SkBitmap bm = to_pixels(img);
-    SkPixmap pm = bm.pixmap();
-    bool isOpaque = pm.isOpaque() || pm.computeIsOpaque();
-    if (encodingQuality <= 100 && isOpaque) {
-        sk_sp<SkData> data = img->encodeToData(SkEncodedImageFormat::kJPEG, encodingQuality);
-        if (data && do_jpeg(std::move(data), doc, dimensions, ref)) {
+    // Decoding and encoding the pixels is the expensive part, which other documents may have
+    // already done.  Look the image up by its encoded data if it has some, to skip the decode.
+    const bool useSharedCache = doc->metadata().fUseSharedCache;
+    SkPDFSharedCache::Key key;
+    SkBitmap bm;
+    if (useSharedCache) {
+        if (data && is_decode_of(img, data)) {
+            key = SkPDFSharedCache::EncodedImageKey(*data, dimensions, encodingQuality);
+        } else {
+            bm = to_pixels(img);
+            key = SkPDFSharedCache::PixelsImageKey(bm.pixmap(), encodingQuality);
+        }
+        if (SkPDFSharedCache::FindImage(key, &image)) {
+            emit_image(doc, ref, image);
             return;
         }
     }
-    do_deflated_image(pm, doc, isOpaque, ref);
+    if (bm.isNull()) {
+        bm = to_pixels(img);
+    }
+    image = encode_pixels(img, bm.pixmap(), encodingQuality, doc->executor());
+    if (useSharedCache) {
+        SkPDFSharedCache::AddImage(key, image);
+    }
+    emit_image(doc, ref, image);
 }
 
 SkPDFIndirectReference SkPDFSerializeImage(const SkImage* img,
@@ -144,9 +144,15 @@ sk_sp<SkImage> alpha_image_to_greyscale_image(const SkImage* mask) {
     return SkImage::MakeFromBitmap(greyBitmap);
 }
 
+static int resource_key(SkPDFIndirectReference ref) {
+    // Placeholders are named by their index.
+    return SkPDFDeferredResources::IsPlaceholder(ref) ? SkPDFDeferredResources::Index(ref)
+                                                       : ref.fValue;
+}
+
 static int add_resource(SkTHashSet<SkPDFIndirectReference>& resources, SkPDFIndirectReference ref) {
     resources.add(ref);
-    return ref.fValue;
+    return resource_key(ref);
 }
 
 static void draw_points(SkCanvas::PointMode mode,
@@ -226,7 +232,7 @@ SkBaseDevice* SkPDFDevice::onCreateDevice(const CreateInfo& cinfo, const SkPaint
         // need to return a raster device, which we will detect in drawDevice()
         return SkBitmapDevice::Create(cinfo.fInfo, SkSurfaceProps(0, kUnknown_SkPixelGeometry));
     }
-    return new SkPDFDevice(cinfo.fInfo.dimensions(), fDocument);
+    return new SkPDFDevice(cinfo.fInfo.dimensions(), fDocument, SkMatrix::I(), fDeferred);
 }
 
 // A helper class to automatically finish a ContentEntry at the end of a
@@ -311,12 +317,14 @@ private:
 
 ////////////////////////////////////////////////////////////////////////////////
 
-SkPDFDevice::SkPDFDevice(SkISize pageSize, SkPDFDocument* doc, const SkMatrix& transform)
+SkPDFDevice::SkPDFDevice(SkISize pageSize, SkPDFDocument* doc, const SkMatrix& transform,
+                         SkPDFDeferredResources* deferred)
     : INHERITED(SkImageInfo::MakeUnknown(pageSize.width(), pageSize.height()),
                 SkSurfaceProps(0, kUnknown_SkPixelGeometry))
     , fInitialTransform(transform)
     , fNodeId(0)
     , fDocument(doc)
+    , fDeferred(deferred)
 {
     SkASSERT(!pageSize.isEmpty());
 }
@@ -339,7 +347,8 @@ void SkPDFDevice::drawAnnotation(const SkRect& rect, const char key[], SkData* v
     // Annotations are specified in absolute coordinates, so the page xform maps from device space
     // to the global space, and applies the document transform.
     SkMatrix pageXform = this->deviceToGlobal();
-    pageXform.postConcat(fDocument->currentPageTransform());
+    pageXform.postConcat(fDeferred ? fDeferred->fPageTransform
+                                   : fDocument->currentPageTransform());
     if (rect.isEmpty()) {
         if (!strcmp(key, SkPDFGetNodeIdKey())) {
             int nodeID;
@@ -351,8 +360,10 @@ void SkPDFDevice::drawAnnotation(const SkRect& rect, const char key[], SkData* v
         if (!strcmp(SkAnnotationKeys::Define_Named_Dest_Key(), key)) {
             SkPoint p = this->localToDevice().mapXY(rect.x(), rect.y());
             pageXform.mapPoints(&p, 1);
-            auto pg = fDocument->currentPage();
-            fDocument->fNamedDestinations.push_back(SkPDFNamedDestination{sk_ref_sp(value), p, pg});
+            auto pg = fDeferred ? fDeferred->fPage : fDocument->currentPage();
+            auto& namedDestinations = fDeferred ? fDeferred->fNamedDestinations
+                                                : fDocument->fNamedDestinations;
+            namedDestinations.push_back(SkPDFNamedDestination{sk_ref_sp(value), p, pg});
         }
         return;
     }
@@ -378,7 +389,7 @@ void SkPDFDevice::drawAnnotation(const SkRect& rect, const char key[], SkData* v
     if (linkType != SkPDFLink::Type::kNone) {
         std::unique_ptr<SkPDFLink> link = std::make_unique<SkPDFLink>(
             linkType, value, transformedRect, fNodeId);
-        fDocument->fCurrentPageLinks.push_back(std::move(link));
+        (fDeferred ? fDeferred->fLinks : fDocument->fCurrentPageLinks).push_back(std::move(link));
     }
 }
 
@@ -501,6 +512,19 @@ void SkPDFDevice::drawPath(const SkPath& path, const SkPaint& paint, bool pathIs
     this->internalDrawPath(this->cs(), this->localToDevice(), path, paint, pathIsMutable);
 }
 
+static SkPDFIndirectReference get_smask_graphic_state(SkPDFDocument* doc,
+                                                     SkPDFDeferredResources* deferred,
+                                                     SkPDFIndirectReference sMask,
+                                                     bool invert,
+                                                     SkPDFGraphicState::SkPDFSMaskMode mode) {
+    if (!deferred) {
+        return SkPDFGraphicState::GetSMaskGraphicState(sMask, invert, mode, doc);
+    }
+    return deferred->defer([deferred, sMask, invert, mode](SkPDFDocument* doc) {
+        return SkPDFGraphicState::GetSMaskGraphicState(deferred->lookup(sMask), invert, mode, doc);
+    });
+}
+
 void SkPDFDevice::internalDrawPathWithFilter(const SkClipStack& clipStack,
                                              const SkMatrix& ctm,
                                              const SkPath& origPath,
@@ -543,9 +567,9 @@ void SkPDFDevice::internalDrawPathWithFilter(const SkClipStack& clipStack,
     if (!content) {
         return;
     }
-    this->setGraphicState(SkPDFGraphicState::GetSMaskGraphicState(
-            maskDevice->makeFormXObjectFromDevice(dstMaskBounds, true), false,
-            SkPDFGraphicState::kLuminosity_SMaskMode, fDocument), content.stream());
+    this->setGraphicState(get_smask_graphic_state(
+            fDocument, fDeferred, maskDevice->makeFormXObjectFromDevice(dstMaskBounds, true),
+            false, SkPDFGraphicState::kLuminosity_SMaskMode), content.stream());
     SkPDFUtils::AppendRectangle(SkRect::Make(dstMaskBounds), content.stream());
     SkPDFUtils::PaintPath(SkPaint::kFill_Style, path.getFillType(), content.stream());
     this->clearMaskOnGraphicState(content.stream());
@@ -555,15 +579,27 @@ void SkPDFDevice::setGraphicState(SkPDFIndirectReference gs, SkDynamicMemoryWStr
     SkPDFUtils::ApplyGraphicState(add_resource(fGraphicStateResources, gs), content);
 }
 
-void SkPDFDevice::clearMaskOnGraphicState(SkDynamicMemoryWStream* contentStream) {
+static SkPDFIndirectReference no_smask_graphic_state(SkPDFDocument* doc) {
     // The no-softmask graphic state is used to "turn off" the mask for later draw calls.
-    SkPDFIndirectReference& noSMaskGS = fDocument->fNoSmaskGraphicState;
+    SkPDFIndirectReference& noSMaskGS = doc->fNoSmaskGraphicState;
     if (!noSMaskGS) {
         SkPDFDict tmp("ExtGState");
         tmp.insertName("SMask", "None");
-        noSMaskGS = fDocument->emit(tmp);
+        noSMaskGS = doc->emit(tmp);
+    }
+    return noSMaskGS;
+}
+
+void SkPDFDevice::clearMaskOnGraphicState(SkDynamicMemoryWStream* contentStream) {
+    if (fDeferred) {
+        SkPDFIndirectReference& noSMaskGS = fDeferred->fNoSmaskGraphicState;
+        if (!noSMaskGS) {
+            noSMaskGS = fDeferred->defer(no_smask_graphic_state);
+        }
+        this->setGraphicState(noSMaskGS, contentStream);
+        return;
     }
-    this->setGraphicState(noSMaskGS, contentStream);
+    this->setGraphicState(no_smask_graphic_state(fDocument), contentStream);
 }
 
 void SkPDFDevice::internalDrawPath(const SkClipStack& clipStack,
@@ -939,7 +975,7 @@ void SkPDFDevice::internalDrawGlyphRun(
             }
             if (needs_new_font(font, glyphs[index], fontType)) {
                 // Not yet specified font or need to switch font.
-                font = SkPDFFont::GetFontResource(fDocument, glyphs[index], typeface);
+                font = SkPDFFont::GetFontResource(fDocument, glyphs[index], typeface, fDeferred);
                 SkASSERT(font);  // All preconditions for SkPDFFont::GetFontResource are met.
                 glyphPositioner.flush();
                 glyphPositioner.setWideChars(font->multiByteGlyphs());
@@ -1025,8 +1061,9 @@ static std::vector<SkPDFIndirectReference> sort(const SkTHashSet<SkPDFIndirectRe
     std::vector<SkPDFIndirectReference> dst;
     dst.reserve(src.count());
     src.foreach([&dst](SkPDFIndirectReference ref) { dst.push_back(ref); } );
-    std::sort(dst.begin(), dst.end(),
-            [](SkPDFIndirectReference a, SkPDFIndirectReference b) { return a.fValue < b.fValue; });
+    std::sort(dst.begin(), dst.end(), [](SkPDFIndirectReference a, SkPDFIndirectReference b) {
+        return resource_key(a) < resource_key(b);
+    });
     return dst;
 }
 
@@ -1034,7 +1071,8 @@ std::unique_ptr<SkPDFDict> SkPDFDevice::makeResourceDict() {
     return SkPDFMakeResourceDict(sort(fGraphicStateResources),
                                  sort(fShaderResources),
                                  sort(fXObjectResources),
-                                 sort(fFontResources));
+                                 sort(fFontResources),
+                                 fDeferred);
 }
 
 std::unique_ptr<SkStreamAsset> SkPDFDevice::content() {
@@ -1133,6 +1171,27 @@ SkPDFIndirectReference SkPDFDevice::makeFormXObjectFromDevice(SkIRect bounds, bo
     }
     const char* colorSpace = alpha ? "DeviceGray" : nullptr;
 
+    if (fDeferred) {
+        // The resource dictionary can only be made once its placeholders are resolved.
+        std::shared_ptr<SkStreamAsset> content = this->content();
+        SkPDFDeferredResources* deferred = fDeferred;
+        SkPDFIndirectReference xobject = fDeferred->defer(
+                [content, bounds, colorSpace, inverseTransform, deferred,
+                 graphicStates = sort(fGraphicStateResources),
+                 shaders = sort(fShaderResources),
+                 xObjects = sort(fXObjectResources),
+                 fonts = sort(fFontResources)](SkPDFDocument* doc) {
+            return SkPDFMakeFormXObject(doc, content->duplicate(),
+                                        SkPDFMakeArray(bounds.left(), bounds.top(),
+                                                       bounds.right(), bounds.bottom()),
+                                        SkPDFMakeResourceDict(graphicStates, shaders, xObjects,
+                                                              fonts, deferred),
+                                        inverseTransform, colorSpace);
+        });
+        this->reset();
+        return xobject;
+    }
+
     SkPDFIndirectReference xobject =
         SkPDFMakeFormXObject(fDocument, this->content(),
                              SkPDFMakeArray(bounds.left(), bounds.top(),
@@ -1160,9 +1219,9 @@ void SkPDFDevice::drawFormXObjectWithMask(SkPDFIndirectReference xObject,
     if (!content) {
         return;
     }
-    this->setGraphicState(SkPDFGraphicState::GetSMaskGraphicState(
-            sMask, invertClip, SkPDFGraphicState::kAlpha_SMaskMode,
-            fDocument), content.stream());
+    this->setGraphicState(get_smask_graphic_state(
+            fDocument, fDeferred, sMask, invertClip, SkPDFGraphicState::kAlpha_SMaskMode),
+            content.stream());
     this->drawFormXObject(xObject, content.stream());
     this->clearMaskOnGraphicState(content.stream());
 }
@@ -1174,6 +1233,7 @@ static bool treat_as_regular_pdf_blend_mode(SkBlendMode blendMode) {
 
 static void populate_graphic_state_entry_from_paint(
         SkPDFDocument* doc,
+        SkPDFDeferredResources* deferred,
         const SkMatrix& matrix,
         const SkClipStack* clipStack,
         SkIRect deviceBounds,
@@ -1225,8 +1285,16 @@ static void populate_graphic_state_entry_from_paint(
             SkIRect bounds;
             clipStackBounds.roundOut(&bounds);
 
-            SkPDFIndirectReference pdfShader
-                = SkPDFMakeShader(doc, shader, transform, bounds, paint.getColor4f());
+            SkPDFIndirectReference pdfShader;
+            if (!deferred) {
+                pdfShader = SkPDFMakeShader(doc, shader, transform, bounds, paint.getColor4f());
+            } else if (!bounds.isEmpty() ||
+                       SkShader::kNone_GradientType != shader->asAGradient(nullptr)) {
+                pdfShader = deferred->defer([shader = sk_ref_sp(shader), transform, bounds,
+                                             color = paint.getColor4f()](SkPDFDocument* doc) {
+                    return SkPDFMakeShader(doc, shader.get(), transform, bounds, color);
+                });
+            }
 
             if (pdfShader) {
                 // pdfShader has been canonicalized so we can directly compare pointers.
@@ -1235,14 +1303,13 @@ static void populate_graphic_state_entry_from_paint(
         }
     }
 
-    SkPDFIndirectReference newGraphicState;
-    if (color == paint.getColor4f()) {
-        newGraphicState = SkPDFGraphicState::GetGraphicStateForPaint(doc, paint);
-    } else {
-        SkPaint newPaint = paint;
-        newPaint.setColor4f(color, nullptr);
-        newGraphicState = SkPDFGraphicState::GetGraphicStateForPaint(doc, newPaint);
+    SkTCopyOnFirstWrite<SkPaint> gsPaint(paint);
+    if (color != paint.getColor4f()) {
+        gsPaint.writable()->setColor4f(color, nullptr);
     }
+    SkPDFIndirectReference newGraphicState =
+            deferred ? SkPDFGraphicState::GetGraphicStateForPaint(deferred, *gsPaint)
+                     : SkPDFGraphicState::GetGraphicStateForPaint(doc, *gsPaint);
     entry->fGraphicStateIndex = add_resource(*graphicStateResources, newGraphicState);
     entry->fTextScaleX = textScale;
 }
@@ -1294,6 +1361,7 @@ SkDynamicMemoryWStream* SkPDFDevice::setUpContentEntry(const SkClipStack* clipSt
     SkPDFGraphicStackState::Entry entry;
     populate_graphic_state_entry_from_paint(
             fDocument,
+            fDeferred,
             matrix,
             clipStack,
             this->bounds(),
@@ -1394,7 +1462,7 @@ void SkPDFDevice::finishContentEntry(const SkClipStack* clipStack,
             filledPaint.setColor(SK_ColorBLACK);
             filledPaint.setStyle(SkPaint::kFill_Style);
             SkClipStack empty;
-            SkPDFDevice shapeDev(this->size(), fDocument, fInitialTransform);
+            SkPDFDevice shapeDev(this->size(), fDocument, fInitialTransform, fDeferred);
             shapeDev.internalDrawPath(clipStack ? *clipStack : empty,
                                       SkMatrix::I(), *shape, filledPaint, true);
             this->drawFormXObjectWithMask(dst, shapeDev.makeFormXObjectFromDevice(),
@@ -1479,6 +1547,18 @@ static bool is_integral(const SkRect& r) {
            is_integer(r.bottom());
 }
 
+static SkPDFIndirectReference get_image(SkPDFDocument* doc, SkImage* image, SkBitmapKey key) {
+    SkPDFIndirectReference* pdfimagePtr = doc->fPDFBitmapMap.find(key);
+    if (pdfimagePtr) {
+        return *pdfimagePtr;
+    }
+    SkPDFIndirectReference pdfimage =
+            SkPDFSerializeImage(image, doc, doc->metadata().fEncodingQuality);
+    SkASSERT((key != SkBitmapKey{{0, 0, 0, 0}, 0}));
+    doc->fPDFBitmapMap.set(key, pdfimage);
+    return pdfimage;
+}
+
 void SkPDFDevice::internalDrawImageRect(SkKeyedImage imageSubset,
                                         const SkRect* src,
                                         const SkRect& dst,
@@ -1580,9 +1660,9 @@ void SkPDFDevice::internalDrawImageRect(SkKeyedImage imageSubset,
         if (!content) {
             return;
         }
-        this->setGraphicState(SkPDFGraphicState::GetSMaskGraphicState(
-                maskDevice->makeFormXObjectFromDevice(maskDeviceBounds, true), false,
-                SkPDFGraphicState::kLuminosity_SMaskMode, fDocument), content.stream());
+        this->setGraphicState(get_smask_graphic_state(
+                fDocument, fDeferred, maskDevice->makeFormXObjectFromDevice(maskDeviceBounds, true),
+                false, SkPDFGraphicState::kLuminosity_SMaskMode), content.stream());
         SkPDFUtils::AppendRectangle(SkRect::Make(this->size()), content.stream());
         SkPDFUtils::PaintPath(SkPaint::kFill_Style, SkPathFillType::kWinding, content.stream());
         this->clearMaskOnGraphicState(content.stream());
@@ -1706,14 +1786,20 @@ void SkPDFDevice::internalDrawImageRect(SkKeyedImage imageSubset,
     }
 
     SkBitmapKey key = imageSubset.key();
-    SkPDFIndirectReference* pdfimagePtr = fDocument->fPDFBitmapMap.find(key);
-    SkPDFIndirectReference pdfimage = pdfimagePtr ? *pdfimagePtr : SkPDFIndirectReference();
-    if (!pdfimagePtr) {
+    SkPDFIndirectReference pdfimage;
+    if (fDeferred) {
+        SkPDFIndirectReference* pdfimagePtr = fDeferred->fPDFBitmapMap.find(key);
+        if (pdfimagePtr) {
+            pdfimage = *pdfimagePtr;
+        } else {
+            pdfimage = fDeferred->defer([image = imageSubset.image(), key](SkPDFDocument* doc) {
+                return get_image(doc, image.get(), key);
+            });
+            fDeferred->fPDFBitmapMap.set(key, pdfimage);
+        }
+    } else {
         SkASSERT(imageSubset);
-        pdfimage = SkPDFSerializeImage(imageSubset.image().get(), fDocument,
-                                       fDocument->metadata().fEncodingQuality);
-        SkASSERT((key != SkBitmapKey{{0, 0, 0, 0}, 0}));
-        fDocument->fPDFBitmapMap.set(key, pdfimage);
+        pdfimage = get_image(fDocument, imageSubset.image().get(), key);
     }
     SkASSERT(pdfimage != SkPDFIndirectReference());
     this->drawFormXObject(pdfimage, content.stream());
@@ -28,6 +28,7 @@
 class SkGlyphRunList;
 class SkKeyedImage;
 class SkPDFArray;
+class SkPDFDeferredResources;
 class SkPDFDevice;
 class SkPDFDict;
 class SkPDFDocument;
@@ -54,12 +55,15 @@ public:
      *         for early serializing of large immutable objects, such
      *         as images (via SkPDFDocument::serialize()).
      *  @param initialTransform Transform to be applied to the entire page.
+     *  @param deferred  If not nullptr, the page is drawn in parallel with
+     *         others, and every resource is a placeholder made by deferred.
      */
     SkPDFDevice(SkISize pageSize, SkPDFDocument* document,
-                const SkMatrix& initialTransform = SkMatrix::I());
+                const SkMatrix& initialTransform = SkMatrix::I(),
+                SkPDFDeferredResources* deferred = nullptr);
 
     sk_sp<SkPDFDevice> makeCongruentDevice() {
-        return sk_make_sp<SkPDFDevice>(this->size(), fDocument);
+        return sk_make_sp<SkPDFDevice>(this->size(), fDocument, SkMatrix::I(), fDeferred);
     }
 
     ~SkPDFDevice() override;
@@ -135,6 +139,7 @@ private:
     bool fNeedsExtraSave = false;
     SkPDFGraphicStackState fActiveStackState;
     SkPDFDocument* fDocument;
+    SkPDFDeferredResources* fDeferred;
 
     ////////////////////////////////////////////////////////////////////////////
 
@@ -11,6 +11,11 @@
 #include "include/core/SkStream.h"
 #include "include/docs/SkPDFDocument.h"
 #include "include/private/SkTo.h"
+#include "src/core/SkBigPicture.h"
+#include "src/core/SkRecord.h"
+#include "src/core/SkRecordDraw.h"
+#include "src/core/SkRecorder.h"
+#include "src/core/SkTaskGroup.h"
 #include "src/pdf/SkPDFDevice.h"
 #include "src/pdf/SkPDFFont.h"
 #include "src/pdf/SkPDFGradientShader.h"
@@ -20,6 +25,8 @@
 #include "src/pdf/SkPDFUtils.h"
 #include "src/utils/SkUTF.h"
 
+#include <algorithm>
+#include <thread>
 #include <utility>
 
 // For use in SkCanvas::drawAnnotation
@@ -135,68 +142,101 @@ static void serialize_footer(const SkPDFOffsetMap& offsetMap,
     wStream->writeText("\n%%EOF");
 }
 
+// PDF wants a tree describing all the pages in the document.  We arbitrary
+// choose 8 (kMaxPageTreeNodeSize) as the number of allowed children.  The
+// internal nodes have type "Pages" with an array of children, a parent pointer,
+// and the number of leaves below the node as "Count."  The leaves have type
+// "Page" and need a parent pointer.
+static constexpr size_t kMaxPageTreeNodeSize = 8;
+
+namespace {
+struct PageTreeNode {
+    std::unique_ptr<SkPDFDict> fNode;
+    SkPDFIndirectReference fReservedRef;
+    int fPageObjectDescendantCount;
+
+    static std::vector<PageTreeNode> Layer(std::vector<PageTreeNode> vec, SkPDFDocument* doc) {
+        std::vector<PageTreeNode> result;
+        const size_t n = vec.size();
+        SkASSERT(n >= 1);
+        const size_t result_len = (n - 1) / kMaxPageTreeNodeSize + 1;
+        SkASSERT(result_len >= 1);
+        SkASSERT(n == 1 || result_len < n);
+        result.reserve(result_len);
+        size_t index = 0;
+        for (size_t i = 0; i < result_len; ++i) {
+            if (n != 1 && index + 1 == n) {  // No need to create a new node.
+                result.push_back(std::move(vec[index++]));
+                continue;
+            }
+            SkPDFIndirectReference parent = doc->reserveRef();
+            auto kids_list = SkPDFMakeArray();
+            int descendantCount = 0;
+            for (size_t j = 0; j < kMaxPageTreeNodeSize && index < n; ++j) {
+                PageTreeNode& node = vec[index++];
+                node.fNode->insertRef("Parent", parent);
+                kids_list->appendRef(doc->emit(*node.fNode, node.fReservedRef));
+                descendantCount += node.fPageObjectDescendantCount;
+            }
+            auto next = SkPDFMakeDict("Pages");
+            next->insertInt("Count", descendantCount);
+            next->insertObject("Kids", std::move(kids_list));
+            result.push_back(PageTreeNode{std::move(next), parent, descendantCount});
+        }
+        return result;
+    }
+};
+}  // namespace
+
+// Builds the rest of the tree bottom up, and returns its root.
+static SkPDFIndirectReference emit_page_tree(SkPDFDocument* doc,
+                                             std::vector<PageTreeNode> currentLayer) {
+    while (currentLayer.size() > 1) {
+        currentLayer = PageTreeNode::Layer(std::move(currentLayer), doc);
+    }
+    SkASSERT(currentLayer.size() == 1);
+    const PageTreeNode& root = currentLayer[0];
+    return doc->emit(*root.fNode, root.fReservedRef);
+}
+
 static SkPDFIndirectReference generate_page_tree(
         SkPDFDocument* doc,
         std::vector<std::unique_ptr<SkPDFDict>> pages,
         const std::vector<SkPDFIndirectReference>& pageRefs) {
-    // PDF wants a tree describing all the pages in the document.  We arbitrary
-    // choose 8 (kNodeSize) as the number of allowed children.  The internal
-    // nodes have type "Pages" with an array of children, a parent pointer, and
-    // the number of leaves below the node as "Count."  The leaves are passed
-    // into the method, have type "Page" and need a parent pointer. This method
-    // builds the tree bottom up, skipping internal nodes that would have only
+    // The tree is built bottom up, skipping internal nodes that would have only
     // one child.
     SkASSERT(pages.size() > 0);
-    struct PageTreeNode {
-        std::unique_ptr<SkPDFDict> fNode;
-        SkPDFIndirectReference fReservedRef;
-        int fPageObjectDescendantCount;
-
-        static std::vector<PageTreeNode> Layer(std::vector<PageTreeNode> vec, SkPDFDocument* doc) {
-            std::vector<PageTreeNode> result;
-            static constexpr size_t kMaxNodeSize = 8;
-            const size_t n = vec.size();
-            SkASSERT(n >= 1);
-            const size_t result_len = (n - 1) / kMaxNodeSize + 1;
-            SkASSERT(result_len >= 1);
-            SkASSERT(n == 1 || result_len < n);
-            result.reserve(result_len);
-            size_t index = 0;
-            for (size_t i = 0; i < result_len; ++i) {
-                if (n != 1 && index + 1 == n) {  // No need to create a new node.
-                    result.push_back(std::move(vec[index++]));
-                    continue;
-                }
-                SkPDFIndirectReference parent = doc->reserveRef();
-                auto kids_list = SkPDFMakeArray();
-                int descendantCount = 0;
-                for (size_t j = 0; j < kMaxNodeSize && index < n; ++j) {
-                    PageTreeNode& node = vec[index++];
-                    node.fNode->insertRef("Parent", parent);
-                    kids_list->appendRef(doc->emit(*node.fNode, node.fReservedRef));
-                    descendantCount += node.fPageObjectDescendantCount;
-                }
-                auto next = SkPDFMakeDict("Pages");
-                next->insertInt("Count", descendantCount);
-                next->insertObject("Kids", std::move(kids_list));
-                result.push_back(PageTreeNode{std::move(next), parent, descendantCount});
-            }
-            return result;
-        }
-    };
     std::vector<PageTreeNode> currentLayer;
     currentLayer.reserve(pages.size());
     SkASSERT(pages.size() == pageRefs.size());
     for (size_t i = 0; i < pages.size(); ++i) {
         currentLayer.push_back(PageTreeNode{std::move(pages[i]), pageRefs[i], 1});
     }
-    currentLayer = PageTreeNode::Layer(std::move(currentLayer), doc);
-    while (currentLayer.size() > 1) {
-        currentLayer = PageTreeNode::Layer(std::move(currentLayer), doc);
+    return emit_page_tree(doc, PageTreeNode::Layer(std::move(currentLayer), doc));
+}
+
+// When pages are streamed, each page has already been written with one of leaves as its parent,
+// in runs of kMaxPageTreeNodeSize pages.
+static SkPDFIndirectReference generate_streamed_page_tree(
+        SkPDFDocument* doc,
+        const std::vector<SkPDFIndirectReference>& leaves,
+        const std::vector<SkPDFIndirectReference>& pageRefs) {
+    SkASSERT(leaves.size() == (pageRefs.size() - 1) / kMaxPageTreeNodeSize + 1);
+    std::vector<PageTreeNode> currentLayer;
+    currentLayer.reserve(leaves.size());
+    for (size_t i = 0; i < leaves.size(); ++i) {
+        const size_t first = i * kMaxPageTreeNodeSize;
+        const size_t last = std::min(first + kMaxPageTreeNodeSize, pageRefs.size());
+        auto kids_list = SkPDFMakeArray();
+        for (size_t j = first; j < last; ++j) {
+            kids_list->appendRef(pageRefs[j]);
+        }
+        auto leaf = SkPDFMakeDict("Pages");
+        leaf->insertInt("Count", SkToInt(last - first));
+        leaf->insertObject("Kids", std::move(kids_list));
+        currentLayer.push_back(PageTreeNode{std::move(leaf), leaves[i], SkToInt(last - first)});
     }
-    SkASSERT(currentLayer.size() == 1);
-    const PageTreeNode& root = currentLayer[0];
-    return doc->emit(*root.fNode, root.fReservedRef);
+    return emit_page_tree(doc, std::move(currentLayer));
 }
 
 template<typename T, typename... Args>
@@ -207,6 +247,71 @@ static void reset_object(T* dst, Args&&... args) {
 
 ////////////////////////////////////////////////////////////////////////////////
 
+SkPDFDeferredResources::SkPDFDeferredResources(SkPDFIndirectReference page,
+                                               const SkMatrix& pageTransform)
+    : fPage(page)
+    , fPageTransform(pageTransform) {}
+
+SkPDFDeferredResources::~SkPDFDeferredResources() = default;
+
+SkPDFIndirectReference SkPDFDeferredResources::defer(Resolver resolver) {
+    fResolvers.push_back(std::move(resolver));
+    return SkPDFIndirectReference{-1 - SkToInt(fResolvers.size())};
+}
+
+bool SkPDFDeferredResources::resolve(SkPDFDocument* doc) {
+    SkASSERT(fResolved.empty());
+    fResolved.reserve(fResolvers.size());
+    for (const Resolver& resolver : fResolvers) {
+        SkPDFIndirectReference ref = resolver(doc);
+        if (!ref) {
+            return false;
+        }
+        fResolved.push_back(ref);
+    }
+    fResolvers.clear();
+    return true;
+}
+
+// A page being drawn by fExecutor.
+struct SkPDFDocument::DeferredPage {
+    DeferredPage(SkISize size, const SkMatrix& initialTransform, SkPDFIndirectReference ref,
+                 SkExecutor* executor)
+        : fSize(size)
+        , fInitialTransform(initialTransform)
+        , fResources(ref, initialTransform)
+        , fTasks(*executor) {}
+
+    // The ops are played back as recorded, without SkRecordOptimize(), which could change the
+    // content of the page from what drawing it directly would make.
+    void playback(SkCanvas* canvas) const {
+        SkRecordDraw(*fRecord, canvas, fDrawables ? fDrawables->begin() : nullptr, nullptr,
+                     fDrawables ? fDrawables->count() : 0, nullptr, nullptr);
+    }
+
+    const SkISize fSize;
+    const SkMatrix fInitialTransform;
+    sk_sp<SkRecord> fRecord = sk_make_sp<SkRecord>();
+    std::unique_ptr<SkBigPicture::SnapshotArray> fDrawables;
+    SkPDFDeferredResources fResources;
+    sk_sp<SkPDFDevice> fDevice;
+    std::unique_ptr<SkStreamAsset> fContent;
+    SkTaskGroup fTasks;  // Last, so it waits before the rest are destroyed.
+};
+
+std::atomic<bool> gSkPDFForceParallelPages{false};
+
+// Bounds the memory held by pages drawn ahead of the page being written.
+static constexpr size_t kMaxPagesInFlight = 32;
+
+// When streaming, fonts no page has used for this many pages are written.
+static constexpr size_t kMaxFontIdlePages = 8;
+
+// When streaming, bounds the shading patterns and images remembered for reuse by later pages.
+static constexpr int kMaxStreamedResources = 1024;
+
+////////////////////////////////////////////////////////////////////////////////
+
 SkPDFDocument::SkPDFDocument(SkWStream* stream,
                              SkPDF::Metadata metadata)
     : SkDocument(stream)
@@ -220,6 +325,10 @@ SkPDFDocument::SkPDFDocument(SkWStream* stream,
         fTagTree.init(fMetadata.fStructureElementTreeRoot);
     }
     fExecutor = metadata.fExecutor;
+    // Tagged pages look up their marked content while they are drawn, so they are drawn serially.
+    // With a single core, recording the pages and playing them back is only extra work.
+    fDrawPagesInParallel = fExecutor && !fMetadata.fStructureElementTreeRoot &&
+                           (std::thread::hardware_concurrency() > 1 || gSkPDFForceParallelPages);
 }
 
 SkPDFDocument::~SkPDFDocument() {
@@ -248,7 +357,8 @@ static SkSize operator*(SkSize u, SkScalar s) { return SkSize{u.width() * s, u.h
 
 SkCanvas* SkPDFDocument::onBeginPage(SkScalar width, SkScalar height) {
     SkASSERT(fCanvas.imageInfo().dimensions().isZero());
-    if (fPages.empty()) {
+    SkASSERT(!fRecordingPage);
+    if (fPageRefs.empty()) {
         // if this is the first page if the document.
         {
             SkAutoMutexExclusive autoMutexAcquire(fMutex);
@@ -277,10 +387,18 @@ SkCanvas* SkPDFDocument::onBeginPage(SkScalar width, SkScalar height) {
     // bottom left. This matrix corrects for that, as well as the raster scale.
     initialTransform.setScaleTranslate(fInverseRasterScale, -fInverseRasterScale,
                                        0, fInverseRasterScale * pageSize.height());
+    fPageRefs.push_back(this->reserveRef());
+    if (fDrawPagesInParallel) {
+        fRecordingPage = std::make_unique<DeferredPage>(pageSize, initialTransform,
+                                                        fPageRefs.back(), fExecutor);
+        fRecorder = std::make_unique<SkRecorder>(fRecordingPage->fRecord.get(),
+                                                 SkRect::Make(pageSize));
+        fRecorder->scale(fRasterScale, fRasterScale);
+        return fRecorder.get();
+    }
     fPageDevice = sk_make_sp<SkPDFDevice>(pageSize, this, initialTransform);
     reset_object(&fCanvas, fPageDevice);
     fCanvas.scale(fRasterScale, fRasterScale);
-    fPageRefs.push_back(this->reserveRef());
     return &fCanvas;
 }
 
@@ -344,18 +462,81 @@ std::unique_ptr<SkPDFArray> SkPDFDocument::getAnnotations() {
 }
 
 void SkPDFDocument::onEndPage() {
+    if (fRecordingPage) {
+        DeferredPage* page = fRecordingPage.get();
+        fRecorder->restoreToCount(1);  // If we were missing any restores, add them now.
+        if (SkDrawableList* drawables = fRecorder->getDrawableList()) {
+            page->fDrawables.reset(drawables->newDrawableSnapshot());
+        }
+        fRecorder = nullptr;
+        page->fTasks.add([this, page]() {
+            page->fDevice = sk_make_sp<SkPDFDevice>(page->fSize, this, page->fInitialTransform,
+                                                    &page->fResources);
+            {
+                SkCanvas canvas(page->fDevice);
+                page->playback(&canvas);
+            }
+            page->fContent = page->fDevice->content();
+        });
+        fDeferredPages.push_back(std::move(fRecordingPage));
+        this->finishDeferredPages(kMaxPagesInFlight);
+        return;
+    }
     SkASSERT(!fCanvas.imageInfo().dimensions().isZero());
     reset_object(&fCanvas);
     SkASSERT(fPageDevice);
 
-    auto page = SkPDFMakeDict("Page");
-
     SkSize mediaSize = fPageDevice->imageInfo().dimensions() * fInverseRasterScale;
     std::unique_ptr<SkStreamAsset> pageContent = fPageDevice->content();
     auto resourceDict = fPageDevice->makeResourceDict();
     SkASSERT(fPageRefs.size() > 0);
     fPageDevice = nullptr;
 
+    this->finishPage(mediaSize, std::move(pageContent), std::move(resourceDict));
+}
+
+void SkPDFDocument::finishDeferredPages(size_t maxPagesInFlight) {
+    // Pages are finished in order, and a fixed number of pages behind the one being recorded,
+    // whether or not they are done sooner, so the objects they make are numbered the same way
+    // however the pages were scheduled.
+    while (fDeferredPages.size() > maxPagesInFlight) {
+        std::unique_ptr<DeferredPage> page = std::move(fDeferredPages.front());
+        fDeferredPages.pop_front();
+        page->fTasks.wait();
+        this->finishDeferredPage(page.get());
+    }
+}
+
+void SkPDFDocument::finishDeferredPage(DeferredPage* page) {
+    SkSize mediaSize = page->fSize * fInverseRasterScale;
+    if (page->fResources.resolve(this)) {
+        for (std::unique_ptr<SkPDFLink>& link : page->fResources.fLinks) {
+            fCurrentPageLinks.push_back(std::move(link));
+        }
+        fNamedDestinations.insert(fNamedDestinations.end(),
+                                  page->fResources.fNamedDestinations.begin(),
+                                  page->fResources.fNamedDestinations.end());
+        this->finishPage(mediaSize, std::move(page->fContent), page->fDevice->makeResourceDict());
+        return;
+    }
+    // A resource could not be made (e.g. an unsupported shader), which the page can only find
+    // out by drawing it without placeholders.
+    fPageDevice = sk_make_sp<SkPDFDevice>(page->fSize, this, page->fInitialTransform);
+    {
+        SkCanvas canvas(fPageDevice);
+        page->playback(&canvas);
+    }
+    std::unique_ptr<SkStreamAsset> pageContent = fPageDevice->content();
+    auto resourceDict = fPageDevice->makeResourceDict();
+    fPageDevice = nullptr;
+    this->finishPage(mediaSize, std::move(pageContent), std::move(resourceDict));
+}
+
+void SkPDFDocument::finishPage(SkSize mediaSize,
+                               std::unique_ptr<SkStreamAsset> pageContent,
+                               std::unique_ptr<SkPDFDict> resourceDict) {
+    auto page = SkPDFMakeDict("Page");
+
     page->insertObject("Resources", std::move(resourceDict));
     page->insertObject("MediaBox", SkPDFUtils::RectToArray(SkRect::MakeSize(mediaSize)));
 
@@ -368,10 +549,55 @@ void SkPDFDocument::onEndPage() {
     // The StructParents unique identifier for each page is just its
     // 0-based page index.
     page->insertInt("StructParents", SkToInt(this->currentPageIndex()));
-    fPages.emplace_back(std::move(page));
+    if (!fMetadata.fStreamPages) {
+        fPages.emplace_back(std::move(page));
+        fFinishedPageCount++;
+        return;
+    }
+    if (fFinishedPageCount % kMaxPageTreeNodeSize == 0) {
+        fPageTreeLeaves.push_back(this->reserveRef());
+    }
+    page->insertRef("Parent", fPageTreeLeaves.back());
+    this->emit(*page, fPageRefs[fFinishedPageCount]);
+    fFinishedPageCount++;
+
+    // The keys of the shader maps include where the shader was drawn, and a document can draw
+    // any number of distinct images, so these can grow with every page.  Forgetting them only
+    // costs writing a pattern or image again.
+    if (fGradientPatternMap.count() > kMaxStreamedResources) {
+        fGradientPatternMap.reset();
+    }
+    if (fImageShaderMap.count() > kMaxStreamedResources) {
+        fImageShaderMap.reset();
+    }
+    if (fPDFBitmapMap.count() > kMaxStreamedResources) {
+        fPDFBitmapMap.reset();
+    }
+    this->writeIdleFonts();
+}
+
+void SkPDFDocument::writeIdleFonts() {
+    std::vector<std::pair<SkPDFIndirectReference, uint64_t>> idle;
+    fFontMap.foreach([&idle, this](uint64_t fontID, SkPDFFont* font) {
+        if (font->lastPageUsed() + kMaxFontIdlePages < fFinishedPageCount) {
+            idle.push_back({font->indirectReference(), fontID});
+        }
+    });
+    // Sort so the output PDF is reproducible.
+    std::sort(idle.begin(), idle.end(), [](const auto& u, const auto& v) {
+        return u.first.fValue < v.first.fValue;
+    });
+    for (const auto& entry : idle) {
+        // The font's glyphs are final: another page using it will get a new font.
+        fFontMap.find(entry.second)->emitSubset(this);
+        fFontMap.remove(entry.second);
+    }
 }
 
 void SkPDFDocument::onAbort() {
+    fRecorder = nullptr;
+    fRecordingPage = nullptr;
+    fDeferredPages.clear();  // Waits for the pages being drawn.
     this->waitForJobs();
 }
 
@@ -536,7 +762,8 @@ static std::vector<const SkPDFFont*> get_fonts(const SkPDFDocument& canon) {
 
 void SkPDFDocument::onClose(SkWStream* stream) {
     SkASSERT(fCanvas.imageInfo().dimensions().isZero());
-    if (fPages.empty()) {
+    this->finishDeferredPages(0);
+    if (fPageRefs.empty()) {
         this->waitForJobs();
         return;
     }
@@ -549,7 +776,9 @@ void SkPDFDocument::onClose(SkWStream* stream) {
         docCatalog->insertObject("OutputIntents", make_srgb_output_intents(this));
     }
 
-    docCatalog->insertRef("Pages", generate_page_tree(this, std::move(fPages), fPageRefs));
+    docCatalog->insertRef("Pages", fMetadata.fStreamPages
+                                 ? generate_streamed_page_tree(this, fPageTreeLeaves, fPageRefs)
+                                 : generate_page_tree(this, std::move(fPages), fPageRefs));
 
     if (!fNamedDestinations.empty()) {
         docCatalog->insertRef("Dests", append_destinations(this, fNamedDestinations));
@@ -16,12 +16,15 @@
 #include "src/pdf/SkPDFTag.h"
 
 #include <atomic>
+#include <deque>
+#include <functional>
 #include <vector>
 #include <memory>
 
 class SkExecutor;
 class SkPDFDevice;
 class SkPDFFont;
+class SkRecorder;
 struct SkAdvancedTypefaceMetrics;
 struct SkBitmapKey;
 struct SkPDFFillGraphicState;
@@ -48,6 +51,10 @@ private:
 };
 
 
+// Pages of a document with an executor are only drawn in parallel on machines with more than
+// one core.  Tests set this to draw them in parallel on any machine.
+extern std::atomic<bool> gSkPDFForceParallelPages;
+
 struct SkPDFNamedDestination {
     sk_sp<SkData> fName;
     SkPoint fPoint;
@@ -75,6 +82,56 @@ struct SkPDFLink {
 };
 
 
+/** Logically part of SkPDFDocument.  The document's canonicalized objects may only be used on
+    the thread which owns the document, so a page drawn on another thread gets placeholder
+    references for the resources it uses, along with the means to make them.  The placeholders
+    are resolved on the document's thread, in the order they were handed out, and pages are
+    resolved in page order, so the objects and their numbering do not depend on scheduling.
+
+    Placeholders name their resources in content streams by their index; the resource
+    dictionaries map those names to the resolved objects.
+*/
+class SkPDFDeferredResources {
+public:
+    SkPDFDeferredResources(SkPDFIndirectReference page, const SkMatrix& pageTransform);
+    ~SkPDFDeferredResources();
+
+    using Resolver = std::function<SkPDFIndirectReference(SkPDFDocument*)>;
+
+    /** Returns a placeholder for the object resolver will find or make. */
+    SkPDFIndirectReference defer(Resolver resolver);
+
+    /** Finds or makes the objects of all placeholders.  Returns false if any resolver failed to
+        make its object. */
+    bool resolve(SkPDFDocument*);
+
+    /** Returns the object a placeholder resolved to.  Other references are returned unchanged.
+        Resolvers may look up placeholders handed out before their own. */
+    SkPDFIndirectReference lookup(SkPDFIndirectReference ref) const {
+        return IsPlaceholder(ref) ? fResolved[Index(ref)] : ref;
+    }
+
+    static bool IsPlaceholder(SkPDFIndirectReference ref) { return ref.fValue < -1; }
+    static int Index(SkPDFIndirectReference ref) { return -2 - ref.fValue; }
+
+    const SkPDFIndirectReference fPage;
+    const SkMatrix fPageTransform;
+    std::vector<std::unique_ptr<SkPDFLink>> fLinks;
+    std::vector<SkPDFNamedDestination> fNamedDestinations;
+
+    // Canonicalized within the page.
+    SkTHashMap<SkPDFFillGraphicState, SkPDFIndirectReference> fFillGSMap;
+    SkTHashMap<SkPDFStrokeGraphicState, SkPDFIndirectReference> fStrokeGSMap;
+    SkTHashMap<SkBitmapKey, SkPDFIndirectReference> fPDFBitmapMap;
+    SkTHashMap<uint64_t, SkPDFFont> fFontMap;
+    SkPDFIndirectReference fNoSmaskGraphicState;
+
+private:
+    std::vector<Resolver> fResolvers;
+    std::vector<SkPDFIndirectReference> fResolved;
+};
+
+
 /** Concrete implementation of SkDocument that creates PDF files. This
     class does not produced linearized or optimized PDFs; instead it
     it attempts to use a minimum amount of RAM. */
@@ -113,9 +170,7 @@ public:
     const SkPDF::Metadata& metadata() const { return fMetadata; }
 
     SkPDFIndirectReference getPage(size_t pageIndex) const;
-    SkPDFIndirectReference currentPage() const {
-        return SkASSERT(!fPageRefs.empty()), fPageRefs.back();
-    }
+    SkPDFIndirectReference currentPage() const { return this->getPage(fFinishedPageCount); }
     // Returns -1 if no mark ID.
     int getMarkIdForNodeId(int nodeId);
 
@@ -126,7 +181,7 @@ public:
     SkExecutor* executor() const { return fExecutor; }
     void incrementJobCount();
     void signalJobComplete();
-    size_t currentPageIndex() { return fPages.size(); }
+    size_t currentPageIndex() const { return fFinishedPageCount; }
     size_t pageCount() { return fPageRefs.size(); }
 
     const SkMatrix& currentPageTransform() const;
@@ -138,7 +193,9 @@ public:
     SkTHashMap<SkBitmapKey, SkPDFIndirectReference> fPDFBitmapMap;
     SkTHashMap<uint32_t, std::unique_ptr<SkAdvancedTypefaceMetrics>> fTypefaceMetrics;
     SkTHashMap<uint32_t, std::vector<SkString>> fType1GlyphNames;
-    SkTHashMap<uint32_t, std::vector<SkUnichar>> fToUnicodeMap;
+    SkTHashMap<uint32_t, std::unique_ptr<std::vector<SkUnichar>>> fToUnicodeMap;
+    // Pages drawn in parallel share fTypefaceMetrics and fToUnicodeMap.
+    SkMutex fTypefaceMutex;
     SkTHashMap<uint32_t, SkPDFIndirectReference> fFontDescriptors;
     SkTHashMap<uint32_t, SkPDFIndirectReference> fType3FontDescriptors;
     SkTHashMap<uint64_t, SkPDFFont> fFontMap;
@@ -150,10 +207,20 @@ public:
     std::vector<SkPDFNamedDestination> fNamedDestinations;
 
 private:
+    struct DeferredPage;
+
     SkPDFOffsetMap fOffsetMap;
     SkCanvas fCanvas;
+    // When pages are drawn in parallel, they are recorded, and drawn by fExecutor.
+    bool fDrawPagesInParallel = false;
+    std::unique_ptr<SkRecorder> fRecorder;
+    std::unique_ptr<DeferredPage> fRecordingPage;
+    std::deque<std::unique_ptr<DeferredPage>> fDeferredPages;
     std::vector<std::unique_ptr<SkPDFDict>> fPages;
     std::vector<SkPDFIndirectReference> fPageRefs;
+    size_t fFinishedPageCount = 0;
+    // When streaming, pages are written with these "Pages" nodes as their parents.
+    std::vector<SkPDFIndirectReference> fPageTreeLeaves;
 
     sk_sp<SkPDFDevice> fPageDevice;
     std::atomic<int> fNextObjectNumber = {1};
@@ -173,6 +240,10 @@ private:
     SkSemaphore fSemaphore;
 
     void waitForJobs();
+    void finishPage(SkSize mediaSize, std::unique_ptr<SkStreamAsset>, std::unique_ptr<SkPDFDict>);
+    void finishDeferredPages(size_t maxPagesInFlight);
+    void finishDeferredPage(DeferredPage*);
+    void writeIdleFonts();
     SkWStream* beginObject(SkPDFIndirectReference);
     void endObject();
 };
@@ -38,6 +38,7 @@
 #include "src/pdf/SkPDFFont.h"
 #include "src/pdf/SkPDFMakeCIDGlyphWidthsArray.h"
 #include "src/pdf/SkPDFMakeToUnicodeCmap.h"
+#include "src/pdf/SkPDFSharedCache.h"
 #include "src/pdf/SkPDFSubsetFont.h"
 #include "src/pdf/SkPDFType1Font.h"
 #include "src/pdf/SkPDFUtils.h"
@@ -106,6 +107,7 @@ static bool can_embed(const SkAdvancedTypefaceMetrics& metrics) {
 const SkAdvancedTypefaceMetrics* SkPDFFont::GetMetrics(const SkTypeface* typeface,
                                                        SkPDFDocument* canon) {
     SkASSERT(typeface);
+    SkAutoMutexExclusive lock(canon->fTypefaceMutex);
     SkFontID id = typeface->uniqueID();
     if (std::unique_ptr<SkAdvancedTypefaceMetrics>* ptr = canon->fTypefaceMetrics.find(id)) {
         return ptr->get();  // canon retains ownership.
@@ -157,13 +159,14 @@ const std::vector<SkUnichar>& SkPDFFont::GetUnicodeMap(const SkTypeface* typefac
                                                        SkPDFDocument* canon) {
     SkASSERT(typeface);
     SkASSERT(canon);
+    SkAutoMutexExclusive lock(canon->fTypefaceMutex);
     SkFontID id = typeface->uniqueID();
-    if (std::vector<SkUnichar>* ptr = canon->fToUnicodeMap.find(id)) {
-        return *ptr;
+    if (std::unique_ptr<std::vector<SkUnichar>>* ptr = canon->fToUnicodeMap.find(id)) {
+        return **ptr;  // canon retains ownership.
     }
-    std::vector<SkUnichar> buffer(typeface->countGlyphs());
-    typeface->getGlyphToUnicodeMap(buffer.data());
-    return *canon->fToUnicodeMap.set(id, std::move(buffer));
+    auto buffer = std::make_unique<std::vector<SkUnichar>>(typeface->countGlyphs());
+    typeface->getGlyphToUnicodeMap(buffer->data());
+    return **canon->fToUnicodeMap.set(id, std::move(buffer));
 }
 
 SkAdvancedTypefaceMetrics::FontType SkPDFFont::FontType(const SkAdvancedTypefaceMetrics& metrics) {
@@ -181,7 +184,8 @@ static SkGlyphID first_nonzero_glyph_for_single_byte_encoding(SkGlyphID gid) {
 
 SkPDFFont* SkPDFFont::GetFontResource(SkPDFDocument* doc,
                                       const SkGlyph* glyph,
-                                      SkTypeface* face) {
+                                      SkTypeface* face,
+                                      SkPDFDeferredResources* deferred) {
     SkASSERT(doc);
     SkASSERT(face);  // All SkPDFDevice::internalDrawText ensures this.
     const SkAdvancedTypefaceMetrics* fontMetrics = SkPDFFont::GetMetrics(face, doc);
@@ -197,8 +201,12 @@ SkPDFFont* SkPDFFont::GetFontResource(SkPDFDocument* doc,
             multibyte ? 0 : first_nonzero_glyph_for_single_byte_encoding(glyph->getGlyphID());
     uint64_t fontID = (static_cast<uint64_t>(SkTypeface::UniqueID(face)) << 16) | subsetCode;
 
-    if (SkPDFFont* found = doc->fFontMap.find(fontID)) {
+    SkTHashMap<uint64_t, SkPDFFont>& fontMap = deferred ? deferred->fFontMap : doc->fFontMap;
+    if (SkPDFFont* found = fontMap.find(fontID)) {
         SkASSERT(multibyte == found->multiByteGlyphs());
+        if (!deferred) {
+            found->fLastPageUsed = doc->currentPageIndex();
+        }
         return found;
     }
 
@@ -217,9 +225,34 @@ SkPDFFont* SkPDFFont::GetFontResource(SkPDFDocument* doc,
         firstNonZeroGlyph = subsetCode;
         lastGlyph = SkToU16(std::min<int>((int)lastGlyph, 254 + (int)subsetCode));
     }
-    auto ref = doc->reserveRef();
-    return doc->fFontMap.set(
+    SkPDFIndirectReference ref;
+    if (deferred) {
+        ref = deferred->defer([deferred, fontID](SkPDFDocument* doc) {
+            // Add the glyphs the page used to the document's font.
+            const SkPDFFont& pageFont = *deferred->fFontMap.find(fontID);
+            SkPDFFont* font = doc->fFontMap.find(fontID);
+            if (!font) {
+                font = doc->fFontMap.set(fontID, SkPDFFont(pageFont.refTypeface(),
+                                                           pageFont.firstGlyphID(),
+                                                           pageFont.lastGlyphID(),
+                                                           pageFont.getType(),
+                                                           doc->reserveRef()));
+            }
+            pageFont.glyphUsage().getSetValues([font](unsigned gid) {
+                font->noteGlyphUsage(SkToU16(gid));
+            });
+            font->fLastPageUsed = doc->currentPageIndex();
+            return font->indirectReference();
+        });
+    } else {
+        ref = doc->reserveRef();
+    }
+    SkPDFFont* font = fontMap.set(
             fontID, SkPDFFont(std::move(typeface), firstNonZeroGlyph, lastGlyph, type, ref));
+    if (!deferred) {
+        font->fLastPageUsed = doc->currentPageIndex();
+    }
+    return font;
 }
 
 SkPDFFont::SkPDFFont(sk_sp<SkTypeface> typeface,
@@ -280,6 +313,29 @@ static sk_sp<SkData> stream_to_data(std::unique_ptr<SkStreamAsset> stream) {
     return SkData::MakeFromStream(stream.get(), size);
 }
 
+// Subsetting is slow, so with fUseSharedCache the subset is kept for other documents which use
+// the same glyphs of the same typeface.
+static sk_sp<SkData> subset_font(const SkTypeface& face,
+                                 std::unique_ptr<SkStreamAsset> fontAsset,
+                                 int ttcIndex,
+                                 const SkPDFGlyphUse& glyphUsage,
+                                 const char* fontName,
+                                 const SkPDF::Metadata& metadata) {
+    if (!metadata.fUseSharedCache) {
+        return SkPDFSubsetFont(stream_to_data(std::move(fontAsset)), glyphUsage,
+                               metadata.fSubsetter, fontName, ttcIndex);
+    }
+    SkPDFSharedCache::Key key = SkPDFSharedCache::FontSubsetKey(
+            face.uniqueID(), ttcIndex, metadata.fSubsetter, glyphUsage);
+    if (sk_sp<SkData> subset = SkPDFSharedCache::FindFontSubset(key)) {
+        return subset;
+    }
+    sk_sp<SkData> subset = SkPDFSubsetFont(stream_to_data(std::move(fontAsset)), glyphUsage,
+                                           metadata.fSubsetter, fontName, ttcIndex);
+    SkPDFSharedCache::AddFontSubset(key, subset);
+    return subset;
+}
+
 static void emit_subset_type0(const SkPDFFont& font, SkPDFDocument* doc) {
     const SkAdvancedTypefaceMetrics* metricsPtr =
         SkPDFFont::GetMetrics(font.typeface(), doc);
@@ -308,10 +364,9 @@ static void emit_subset_type0(const SkPDFFont& font, SkPDFDocument* doc) {
                 if (!SkToBool(metrics.fFlags &
                               SkAdvancedTypefaceMetrics::kNotSubsettable_FontFlag)) {
                     SkASSERT(font.firstGlyphID() == 1);
-                    sk_sp<SkData> subsetFontData = SkPDFSubsetFont(
-                            stream_to_data(std::move(fontAsset)), font.glyphUsage(),
-                            doc->metadata().fSubsetter,
-                            metrics.fFontName.c_str(), ttcIndex);
+                    sk_sp<SkData> subsetFontData = subset_font(
+                            *face, std::move(fontAsset), ttcIndex, font.glyphUsage(),
+                            metrics.fFontName.c_str(), doc->metadata());
                     if (subsetFontData) {
                         std::unique_ptr<SkPDFDict> tmp = SkPDFMakeDict();
                         tmp->insertInt("Length1", SkToInt(subsetFontData->size()));
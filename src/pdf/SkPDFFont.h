@@ -17,6 +17,7 @@
 
 #include <vector>
 
+class SkPDFDeferredResources;
 class SkPDFDocument;
 class SkString;
 
@@ -79,6 +80,9 @@ public:
 
     SkPDFIndirectReference indirectReference() const { return fIndirectReference; }
 
+    /** Returns the index of the last page which used this font. */
+    size_t lastPageUsed() const { return fLastPageUsed; }
+
     /** Get the font resource for the passed typeface and glyphID. The
      *  reference count of the object is incremented and it is the caller's
      *  responsibility to unreference it when done.  This is needed to
@@ -86,10 +90,13 @@ public:
      *  is new and has no other references.
      *  @param typeface  The typeface to find, not nullptr.
      *  @param glyphID   Specify which section of a large font is of interest.
+     *  @param deferred  If not nullptr, the font is local to a page drawn in
+     *                   parallel, and its reference is a placeholder.
      */
     static SkPDFFont* GetFontResource(SkPDFDocument* doc,
                                       const SkGlyph* glyphs,
-                                      SkTypeface* typeface);
+                                      SkTypeface* typeface,
+                                      SkPDFDeferredResources* deferred = nullptr);
 
     /** Gets SkAdvancedTypefaceMetrics, and caches the result.
      *  @param typeface can not be nullptr.
@@ -124,6 +131,7 @@ private:
     SkPDFGlyphUse fGlyphUsage;
     SkPDFIndirectReference fIndirectReference;
     SkAdvancedTypefaceMetrics::FontType fFontType = (SkAdvancedTypefaceMetrics::FontType)(-1);
+    size_t fLastPageUsed = 0;
 
     SkPDFFont(sk_sp<SkTypeface>,
               SkGlyphID firstGlyphID,
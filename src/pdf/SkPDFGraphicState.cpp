@@ -53,48 +53,91 @@ static uint8_t pdf_blend_mode(SkBlendMode mode) {
     return SkToU8((unsigned)mode);
 }
 
+static SkPDFFillGraphicState make_fill_key(const SkPaint& p) {
+    return {p.getColor4f().fA, pdf_blend_mode(p.getBlendMode())};
+}
+
+static SkPDFStrokeGraphicState make_stroke_key(const SkPaint& p) {
+    return {
+        p.getStrokeWidth(),
+        p.getStrokeMiter(),
+        p.getColor4f().fA,
+        SkToU8(p.getStrokeCap()),
+        SkToU8(p.getStrokeJoin()),
+        pdf_blend_mode(p.getBlendMode())
+    };
+}
+
+static SkPDFIndirectReference get_fill_state(SkPDFDocument* doc,
+                                             const SkPDFFillGraphicState& fillKey) {
+    auto& fillMap = doc->fFillGSMap;
+    if (SkPDFIndirectReference* statePtr = fillMap.find(fillKey)) {
+        return *statePtr;
+    }
+    SkPDFDict state;
+    state.reserve(2);
+    state.insertColorComponentF("ca", fillKey.fAlpha);
+    state.insertName("BM", as_pdf_blend_mode_name((SkBlendMode)fillKey.fBlendMode));
+    SkPDFIndirectReference ref = doc->emit(state);
+    fillMap.set(fillKey, ref);
+    return ref;
+}
+
+static SkPDFIndirectReference get_stroke_state(SkPDFDocument* doc,
+                                               const SkPDFStrokeGraphicState& strokeKey) {
+    auto& sMap = doc->fStrokeGSMap;
+    if (SkPDFIndirectReference* statePtr = sMap.find(strokeKey)) {
+        return *statePtr;
+    }
+    SkPDFDict state;
+    state.reserve(8);
+    state.insertColorComponentF("CA", strokeKey.fAlpha);
+    state.insertColorComponentF("ca", strokeKey.fAlpha);
+    state.insertInt("LC", to_stroke_cap(strokeKey.fStrokeCap));
+    state.insertInt("LJ", to_stroke_join(strokeKey.fStrokeJoin));
+    state.insertScalar("LW", strokeKey.fStrokeWidth);
+    state.insertScalar("ML", strokeKey.fStrokeMiter);
+    state.insertBool("SA", true);  // SA = Auto stroke adjustment.
+    state.insertName("BM", as_pdf_blend_mode_name((SkBlendMode)strokeKey.fBlendMode));
+    SkPDFIndirectReference ref = doc->emit(state);
+    sMap.set(strokeKey, ref);
+    return ref;
+}
+
 SkPDFIndirectReference SkPDFGraphicState::GetGraphicStateForPaint(SkPDFDocument* doc,
                                                                   const SkPaint& p) {
     SkASSERT(doc);
     if (SkPaint::kFill_Style == p.getStyle()) {
-        SkPDFFillGraphicState fillKey = {p.getColor4f().fA, pdf_blend_mode(p.getBlendMode())};
-        auto& fillMap = doc->fFillGSMap;
-        if (SkPDFIndirectReference* statePtr = fillMap.find(fillKey)) {
-            return *statePtr;
-        }
-        SkPDFDict state;
-        state.reserve(2);
-        state.insertColorComponentF("ca", fillKey.fAlpha);
-        state.insertName("BM", as_pdf_blend_mode_name((SkBlendMode)fillKey.fBlendMode));
-        SkPDFIndirectReference ref = doc->emit(state);
-        fillMap.set(fillKey, ref);
-        return ref;
+        return get_fill_state(doc, make_fill_key(p));
     } else {
-        SkPDFStrokeGraphicState strokeKey = {
-            p.getStrokeWidth(),
-            p.getStrokeMiter(),
-            p.getColor4f().fA,
-            SkToU8(p.getStrokeCap()),
-            SkToU8(p.getStrokeJoin()),
-            pdf_blend_mode(p.getBlendMode())
-        };
-        auto& sMap = doc->fStrokeGSMap;
-        if (SkPDFIndirectReference* statePtr = sMap.find(strokeKey)) {
-            return *statePtr;
-        }
-        SkPDFDict state;
-        state.reserve(8);
-        state.insertColorComponentF("CA", strokeKey.fAlpha);
-        state.insertColorComponentF("ca", strokeKey.fAlpha);
-        state.insertInt("LC", to_stroke_cap(strokeKey.fStrokeCap));
-        state.insertInt("LJ", to_stroke_join(strokeKey.fStrokeJoin));
-        state.insertScalar("LW", strokeKey.fStrokeWidth);
-        state.insertScalar("ML", strokeKey.fStrokeMiter);
-        state.insertBool("SA", true);  // SA = Auto stroke adjustment.
-        state.insertName("BM", as_pdf_blend_mode_name((SkBlendMode)strokeKey.fBlendMode));
-        SkPDFIndirectReference ref = doc->emit(state);
-        sMap.set(strokeKey, ref);
-        return ref;
+        return get_stroke_state(doc, make_stroke_key(p));
+    }
+}
+
+template <typename Key>
+static SkPDFIndirectReference defer_state(
+        SkPDFDeferredResources* deferred,
+        SkTHashMap<Key, SkPDFIndirectReference>* map,
+        const Key& key,
+        SkPDFIndirectReference (*getState)(SkPDFDocument*, const Key&)) {
+    if (SkPDFIndirectReference* statePtr = map->find(key)) {
+        return *statePtr;
+    }
+    SkPDFIndirectReference ref = deferred->defer([key, getState](SkPDFDocument* doc) {
+        return getState(doc, key);
+    });
+    map->set(key, ref);
+    return ref;
+}
+
+SkPDFIndirectReference SkPDFGraphicState::GetGraphicStateForPaint(SkPDFDeferredResources* deferred,
+                                                                  const SkPaint& p) {
+    SkASSERT(deferred);
+    if (SkPaint::kFill_Style == p.getStyle()) {
+        return defer_state(deferred, &deferred->fFillGSMap, make_fill_key(p), get_fill_state);
+    } else {
+        return defer_state(deferred, &deferred->fStrokeGSMap, make_stroke_key(p),
+                           get_stroke_state);
     }
 }
 
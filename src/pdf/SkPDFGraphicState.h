@@ -13,6 +13,7 @@
 #include "src/core/SkOpts.h"
 #include "src/pdf/SkPDFTypes.h"
 
+class SkPDFDeferredResources;
 class SkPaint;
 
 
@@ -31,6 +32,10 @@ namespace SkPDFGraphicState {
      */
     SkPDFIndirectReference GetGraphicStateForPaint(SkPDFDocument*, const SkPaint&);
 
+    /** As above, for a page drawn in parallel: returns a placeholder.
+     */
+    SkPDFIndirectReference GetGraphicStateForPaint(SkPDFDeferredResources*, const SkPaint&);
+
     /** Make a graphic state that only sets the passed soft mask.
      *  @param sMask     The form xobject to use as a soft mask.
      *  @param invert    Indicates if the alpha of the sMask should be inverted.
@@ -6,6 +6,7 @@
  */
 
 #include "include/core/SkStream.h"
+#include "src/pdf/SkPDFDocumentPriv.h"
 #include "src/pdf/SkPDFResourceDict.h"
 #include "src/pdf/SkPDFTypes.h"
 
@@ -61,11 +62,18 @@ static SkString resource(SkPDFResourceType type, int index) {
 
 static void add_subdict(const std::vector<SkPDFIndirectReference>& resourceList,
                         SkPDFResourceType type,
+                        const SkPDFDeferredResources* deferred,
                         SkPDFDict* dst) {
     if (!resourceList.empty()) {
         auto resources = SkPDFMakeDict();
         for (SkPDFIndirectReference ref : resourceList) {
-            resources->insertRef(resource(type, ref.fValue), ref);
+            if (deferred) {
+                SkASSERT(SkPDFDeferredResources::IsPlaceholder(ref));
+                resources->insertRef(resource(type, SkPDFDeferredResources::Index(ref)),
+                                     deferred->lookup(ref));
+            } else {
+                resources->insertRef(resource(type, ref.fValue), ref);
+            }
         }
         dst->insertObject(resource_name(type), std::move(resources));
     }
@@ -85,12 +93,13 @@ std::unique_ptr<SkPDFDict> SkPDFMakeResourceDict(
         const std::vector<SkPDFIndirectReference>& graphicStateResources,
         const std::vector<SkPDFIndirectReference>& shaderResources,
         const std::vector<SkPDFIndirectReference>& xObjectResources,
-        const std::vector<SkPDFIndirectReference>& fontResources) {
+        const std::vector<SkPDFIndirectReference>& fontResources,
+        const SkPDFDeferredResources* deferred) {
     auto dict = SkPDFMakeDict();
     dict->insertObject("ProcSet", make_proc_set());
-    add_subdict(graphicStateResources, SkPDFResourceType::kExtGState, dict.get());
-    add_subdict(shaderResources,       SkPDFResourceType::kPattern,   dict.get());
-    add_subdict(xObjectResources,      SkPDFResourceType::kXObject,   dict.get());
-    add_subdict(fontResources,         SkPDFResourceType::kFont,      dict.get());
+    add_subdict(graphicStateResources, SkPDFResourceType::kExtGState, deferred, dict.get());
+    add_subdict(shaderResources,       SkPDFResourceType::kPattern,   deferred, dict.get());
+    add_subdict(xObjectResources,      SkPDFResourceType::kXObject,   deferred, dict.get());
+    add_subdict(fontResources,         SkPDFResourceType::kFont,      deferred, dict.get());
     return dict;
 }
@@ -12,6 +12,7 @@
 
 #include <vector>
 
+class SkPDFDeferredResources;
 class SkPDFDict;
 class SkPDFObject;
 class SkWStream;
@@ -31,12 +32,15 @@ enum class SkPDFResourceType {
  *  compatibility, as recommended by the PDF spec.
  *
  *  Any arguments can be nullptr.
+ *
+ *  If deferred is not nullptr, the resources are its resolved placeholders.
  */
 std::unique_ptr<SkPDFDict> SkPDFMakeResourceDict(
         const std::vector<SkPDFIndirectReference>& graphicStateResources,
         const std::vector<SkPDFIndirectReference>& shaderResources,
         const std::vector<SkPDFIndirectReference>& xObjectResources,
-        const std::vector<SkPDFIndirectReference>& fontResources);
+        const std::vector<SkPDFIndirectReference>& fontResources,
+        const SkPDFDeferredResources* deferred = nullptr);
 
 /**
  * Writes the name for the resource that will be generated by the resource
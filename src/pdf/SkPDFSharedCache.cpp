@@ -0,0 +1,211 @@
+/*
+ * Copyright 2020 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "src/pdf/SkPDFSharedCache.h"
+
+#include "include/core/SkPixmap.h"
+#include "include/docs/SkPDFDocument.h"
+#include "include/private/SkMutex.h"
+#include "src/core/SkLRUCache.h"
+#include "src/core/SkOpts.h"
+#include "src/pdf/SkPDFGlyphUse.h"
+
+#include <climits>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+enum KeyType : uint32_t {
+    kFontSubset_KeyType = 1,
+    kEncodedImage_KeyType,
+    kPixelsImage_KeyType,
+};
+
+constexpr size_t kDefaultLimit = 32 * 1024 * 1024;
+
+// Two independent 32-bit hashes, so that entries from unrelated documents practically never
+// collide.
+void hash_contents(const void* data, size_t length, SkPDFSharedCache::Key* key) {
+    key->fLength = (uint32_t)length;
+    key->fHash[0] = SkOpts::hash(data, length, 0);
+    key->fHash[1] = SkOpts::hash(data, length, 0x9E3779B9);
+}
+
+struct KeyHash {
+    uint32_t operator()(const SkPDFSharedCache::Key& key) const {
+        return SkOpts::hash(&key, sizeof(key));
+    }
+};
+
+struct Value {
+    sk_sp<SkData>     fFontSubset;
+    SkPDFEncodedImage fImage;
+
+    size_t bytes() const {
+        return (fFontSubset ? fFontSubset->size() : 0) +
+               (fImage.fImage.fData ? fImage.fImage.fData->size() : 0) +
+               (fImage.fSMask.fData ? fImage.fSMask.fData->size() : 0);
+    }
+};
+
+class SharedCache {
+public:
+    bool find(const SkPDFSharedCache::Key& key, Value* value) {
+        SkAutoMutexExclusive lock(fMutex);
+        if (Value* found = fLRU.find(key)) {
+            *value = *found;
+            return true;
+        }
+        return false;
+    }
+
+    void add(const SkPDFSharedCache::Key& key, Value value) {
+        SkAutoMutexExclusive lock(fMutex);
+        const size_t bytes = value.bytes();
+        // Another document may have added the same entry in the meantime.
+        if (bytes > fLimit || fLRU.find(key)) {
+            return;
+        }
+        fLRU.insert(key, std::move(value));
+        fUsed += bytes;
+        this->purge(fLimit);
+    }
+
+    size_t setLimit(size_t limit) {
+        SkAutoMutexExclusive lock(fMutex);
+        size_t previous = fLimit;
+        fLimit = limit;
+        this->purge(fLimit);
+        return previous;
+    }
+
+    size_t limit() {
+        SkAutoMutexExclusive lock(fMutex);
+        return fLimit;
+    }
+
+    size_t used() {
+        SkAutoMutexExclusive lock(fMutex);
+        return fUsed;
+    }
+
+    void purgeAll() {
+        SkAutoMutexExclusive lock(fMutex);
+        this->purge(0);
+    }
+
+private:
+    void purge(size_t limit) {
+        while (fUsed > limit) {
+            Value* lru = fLRU.leastRecentlyUsed();
+            SkASSERT(lru);
+            fUsed -= lru->bytes();
+            fLRU.removeLeastRecentlyUsed();
+        }
+    }
+
+    SkMutex fMutex;
+    // Entries are limited by their size rather than their number.
+    SkLRUCache<SkPDFSharedCache::Key, Value, KeyHash> fLRU{INT_MAX};
+    size_t fLimit = kDefaultLimit;
+    size_t fUsed = 0;
+};
+
+SharedCache& shared_cache() {
+    static SharedCache& cache = *(new SharedCache);
+    return cache;
+}
+
+}  // namespace
+
+bool SkPDFSharedCache::Key::operator==(const Key& that) const {
+    return 0 == memcmp(this, &that, sizeof(Key));
+}
+
+SkPDFSharedCache::Key SkPDFSharedCache::FontSubsetKey(uint32_t typefaceID, int ttcIndex,
+                                                      int subsetter,
+                                                      const SkPDFGlyphUse& glyphUse) {
+    static_assert(sizeof(Key) == 9 * sizeof(uint32_t), "Key must not have padding.");
+    Key key = {};
+    key.fType = kFontSubset_KeyType;
+    key.fID = typefaceID;
+    key.fParams = (uint32_t)subsetter << 16 | (uint16_t)ttcIndex;
+    key.fWidth = glyphUse.firstNonZero();
+    key.fHeight = glyphUse.lastGlyph();
+    std::vector<uint16_t> glyphs;
+    glyphUse.getSetValues([&glyphs](unsigned gid) { glyphs.push_back((uint16_t)gid); });
+    hash_contents(glyphs.data(), glyphs.size() * sizeof(uint16_t), &key);
+    return key;
+}
+
+SkPDFSharedCache::Key SkPDFSharedCache::EncodedImageKey(const SkData& encoded, SkISize size,
+                                                        int encodingQuality) {
+    Key key = {};
+    key.fType = kEncodedImage_KeyType;
+    key.fParams = (uint32_t)encodingQuality;
+    key.fWidth = (uint32_t)size.width();
+    key.fHeight = (uint32_t)size.height();
+    hash_contents(encoded.data(), encoded.size(), &key);
+    return key;
+}
+
+SkPDFSharedCache::Key SkPDFSharedCache::PixelsImageKey(const SkPixmap& pixels,
+                                                       int encodingQuality) {
+    SkASSERT(pixels.rowBytes() == pixels.info().minRowBytes());
+    Key key = {};
+    key.fType = kPixelsImage_KeyType;
+    key.fParams = (uint32_t)encodingQuality;
+    key.fWidth = (uint32_t)pixels.width();
+    key.fHeight = (uint32_t)pixels.height();
+    key.fFormat = (uint32_t)pixels.colorType() << 8 | (uint32_t)pixels.alphaType();
+    hash_contents(pixels.addr(), pixels.computeByteSize(), &key);
+    return key;
+}
+
+sk_sp<SkData> SkPDFSharedCache::FindFontSubset(const Key& key) {
+    SkASSERT(key.fType == kFontSubset_KeyType);
+    Value value;
+    return shared_cache().find(key, &value) ? std::move(value.fFontSubset) : nullptr;
+}
+
+void SkPDFSharedCache::AddFontSubset(const Key& key, sk_sp<SkData> subset) {
+    SkASSERT(key.fType == kFontSubset_KeyType);
+    if (subset) {
+        Value value;
+        value.fFontSubset = std::move(subset);
+        shared_cache().add(key, std::move(value));
+    }
+}
+
+bool SkPDFSharedCache::FindImage(const Key& key, SkPDFEncodedImage* image) {
+    SkASSERT(key.fType != kFontSubset_KeyType);
+    Value value;
+    if (!shared_cache().find(key, &value)) {
+        return false;
+    }
+    *image = std::move(value.fImage);
+    return true;
+}
+
+void SkPDFSharedCache::AddImage(const Key& key, const SkPDFEncodedImage& image) {
+    SkASSERT(key.fType != kFontSubset_KeyType);
+    SkASSERT(image.fImage.fData);
+    Value value;
+    value.fImage = image;
+    shared_cache().add(key, std::move(value));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+size_t SkPDF::SetSharedCacheLimit(size_t bytes) { return shared_cache().setLimit(bytes); }
+
+size_t SkPDF::GetSharedCacheLimit() { return shared_cache().limit(); }
+
+size_t SkPDF::GetSharedCacheBytesUsed() { return shared_cache().used(); }
+
+void SkPDF::PurgeSharedCache() { shared_cache().purgeAll(); }
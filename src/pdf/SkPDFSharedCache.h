@@ -0,0 +1,73 @@
+/*
+ * Copyright 2020 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#ifndef SkPDFSharedCache_DEFINED
+#define SkPDFSharedCache_DEFINED
+
+#include "include/core/SkData.h"
+#include "include/core/SkRefCnt.h"
+#include "include/core/SkSize.h"
+
+#include <cstdint>
+
+class SkPDFGlyphUse;
+class SkPixmap;
+
+/** The contents of an image XObject's stream, and what its dictionary says about them. */
+struct SkPDFImageStream {
+    sk_sp<SkData> fData;                 // Filtered (and ASCII85 encoded) stream contents.
+    SkISize       fSize = {0, 0};
+    const char*   fColorSpace = nullptr; // A string literal.
+    bool          fIsJpeg = false;
+};
+
+/** An encoded image, and its soft mask if it isn't opaque (otherwise fSMask.fData is null). */
+struct SkPDFEncodedImage {
+    SkPDFImageStream fImage;
+    SkPDFImageStream fSMask;
+};
+
+/**
+ *  The cache behind SkPDF::Metadata::fUseSharedCache: font subsets and encoded images which
+ *  documents can reuse, shared by every document in the process.  The least recently used
+ *  entries are purged to keep the size of their data within SkPDF::GetSharedCacheLimit().
+ *  All of these may be called from any thread.
+ */
+namespace SkPDFSharedCache {
+
+struct Key {
+    uint32_t fType;
+    uint32_t fID;      // Typeface unique ID.
+    uint32_t fParams;  // Subsetter and TTC index, or encoding quality.
+    uint32_t fWidth;
+    uint32_t fHeight;
+    uint32_t fFormat;  // Color and alpha type of the pixels.
+    uint32_t fLength;  // Number of glyphs or bytes hashed.
+    uint32_t fHash[2];
+
+    bool operator==(const Key& that) const;
+};
+
+/** Key for the subset of a font with the glyphs in glyphUse. */
+Key FontSubsetKey(uint32_t typefaceID, int ttcIndex, int subsetter,
+                  const SkPDFGlyphUse& glyphUse);
+
+/** Key for an image which is the whole, unconverted decode of this encoded data; subsets and
+    color converted copies of it must use PixelsImageKey(). */
+Key EncodedImageKey(const SkData& encoded, SkISize size, int encodingQuality);
+
+/** Key for an image with these pixels, which must be tightly packed. */
+Key PixelsImageKey(const SkPixmap& pixels, int encodingQuality);
+
+sk_sp<SkData> FindFontSubset(const Key&);
+void AddFontSubset(const Key&, sk_sp<SkData> subset);
+
+bool FindImage(const Key&, SkPDFEncodedImage*);
+void AddImage(const Key&, const SkPDFEncodedImage&);
+
+}  // namespace SkPDFSharedCache
+
+#endif  // SkPDFSharedCache_DEFINED
@@ -435,7 +435,7 @@ static void serialize_stream(SkPDFDict* origDict,
     static const size_t kMinimumSavings = strlen("/Filter_/FlateDecode_");
     if (deflate && stream->getLength() > kMinimumSavings) {
         SkDynamicMemoryWStream compressedData;
-        SkDeflateWStream deflateWStream(&compressedData);
+        SkDeflateWStream deflateWStream(&compressedData, -1, false, doc->executor());
         SkStreamCopy(&deflateWStream, stream);
         deflateWStream.finalize();
         #ifdef SK_PDF_BASE85_BINARY
@@ -26,6 +26,7 @@
 #include "src/core/SkMaskGamma.h"
 #include "src/core/SkScalerContext.h"
 #include "src/ports/SkFontHost_FreeType_common.h"
+#include "src/ports/SkFontIndex.h"
 #include "src/sfnt/SkOTUtils.h"
 #include "src/utils/SkCallableTraits.h"
 #include "src/utils/SkMatrix22.h"
@@ -1952,6 +1953,29 @@ bool SkTypeface_FreeType::Scanner::scanFont(
     return success;
 }
 
+bool SkTypeface_FreeType::Scanner::scanCoverage(SkStreamAsset* stream, int ttcIndex,
+                                                SkData* coverage) const
+{
+    SkAutoMutexExclusive libraryLock(fLibraryMutex);
+
+    FT_StreamRec streamRec;
+    FT_Face face = this->openFace(stream, ttcIndex, &streamRec);
+    if (nullptr == face) {
+        return false;
+    }
+
+    FT_UInt glyphIndex;
+    FT_ULong charCode = FT_Get_First_Char(face, &glyphIndex);
+    while (glyphIndex) {
+        SkFontIndex::Coverage::Add(coverage, charCode);
+        // Every code point in a page maps to the same bit, skip the rest of the page.
+        charCode = FT_Get_Next_Char(face, charCode | 0xFF, &glyphIndex);
+    }
+
+    FT_Done_Face(face);
+    return true;
+}
+
 bool SkTypeface_FreeType::Scanner::GetAxes(FT_Face face, AxisDefinitions* axes) {
     if (axes && face->face_flags & FT_FACE_FLAG_MULTIPLE_MASTERS) {
         FT_MM_Var* variations = nullptr;
@@ -73,6 +73,8 @@ public:
         bool scanFont(SkStreamAsset* stream, int ttcIndex,
                       SkString* name, SkFontStyle* style, bool* isFixedPitch,
                       AxisDefinitions* axes) const;
+        /** Records the Unicode pages mapped by the face, see SkFontIndex::Coverage. */
+        bool scanCoverage(SkStreamAsset* stream, int ttcIndex, SkData* coverage) const;
         static void computeAxisValues(
             AxisDefinitions axisDefinitions,
             const SkFontArguments::VariationPosition position,
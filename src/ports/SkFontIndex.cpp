@@ -0,0 +1,232 @@
+/*
+ * Copyright 2020 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "include/core/SkStream.h"
+#include "src/core/SkAutoMalloc.h"
+#include "src/core/SkReadBuffer.h"
+#include "src/core/SkWriteBuffer.h"
+#include "src/ports/SkFontIndex.h"
+
+#include <stdio.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+namespace {
+
+static constexpr uint32_t kMagic = SkSetFourByteTag('S', 'k', 'F', 'I');
+
+// Bump this whenever the serialized layout changes; older indices are then simply rebuilt.
+static constexpr uint32_t kVersion = 1;
+
+void write_u64(SkWriteBuffer& buffer, uint64_t value) {
+    buffer.writeUInt(static_cast<uint32_t>(value));
+    buffer.writeUInt(static_cast<uint32_t>(value >> 32));
+}
+
+uint64_t read_u64(SkReadBuffer& buffer) {
+    uint64_t lo = buffer.readUInt();
+    uint64_t hi = buffer.readUInt();
+    return lo | (hi << 32);
+}
+
+}  // namespace
+
+bool SkFontIndex::Stamp(const char path[], FileStamp* stamp) {
+#ifdef SK_BUILD_FOR_WIN
+    struct _stat64 status;
+    if (0 != _stat64(path, &status)) {
+        return false;
+    }
+#else
+    struct stat status;
+    if (0 != stat(path, &status)) {
+        return false;
+    }
+#endif
+    stamp->fSize = static_cast<uint64_t>(status.st_size);
+    stamp->fModTime = static_cast<int64_t>(status.st_mtime);
+    return true;
+}
+
+SkFontIndex::SkFontIndex() = default;
+
+SkFontIndex::SkFontIndex(sk_sp<SkData> serialized) {
+    if (!serialized) {
+        return;
+    }
+    SkReadBuffer buffer(serialized->data(), serialized->size());
+    if (buffer.readUInt() != kMagic || buffer.readUInt() != kVersion) {
+        fDirty = true;
+        return;
+    }
+
+    // Only the path and stamp of each record are read up front, the faces are decoded on demand.
+    uint32_t count = buffer.readUInt();
+    for (uint32_t i = 0; i < count && buffer.isValid(); ++i) {
+        SkString path;
+        buffer.readString(&path);
+        Record record;
+        record.fStamp.fSize = read_u64(buffer);
+        record.fStamp.fModTime = read_u64(buffer);
+        record.fLength = buffer.readUInt();
+        record.fOffset = buffer.offset();
+        buffer.skip(record.fLength);
+        fRecords.set(std::move(path), std::move(record));
+    }
+    if (!buffer.isValid()) {
+        fRecords.reset();
+        fDirty = true;
+        return;
+    }
+    fSerialized = std::move(serialized);
+}
+
+SkFontIndex SkFontIndex::MakeFromFile(const char path[]) {
+    return SkFontIndex(SkData::MakeFromFileName(path));
+}
+
+bool SkFontIndex::decode(Record* record) const {
+    if (record->fDecoded) {
+        return true;
+    }
+    SkASSERT(fSerialized && record->fOffset + record->fLength <= fSerialized->size());
+    SkReadBuffer buffer(fSerialized->bytes() + record->fOffset, record->fLength);
+
+    uint32_t faceCount = buffer.readUInt();
+    if (!buffer.validateCanReadN<uint32_t>(faceCount)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < faceCount && buffer.isValid(); ++i) {
+        Face& face = record->fFaces.push_back();
+        buffer.readString(&face.fFamilyName);
+        int weight = buffer.readInt();
+        int width = buffer.readInt();
+        auto slant = buffer.read32LE(SkFontStyle::kOblique_Slant);
+        face.fStyle = SkFontStyle(weight, width, slant);
+        face.fIsFixedPitch = buffer.readBool();
+        face.fIndex = buffer.readInt();
+        if (buffer.readBool()) {
+            // Copy the coverage out of the mapping, the index file may be rewritten while the
+            // faces are still alive.
+            face.fCoverage = SkData::MakeUninitialized(Coverage::kByteSize);
+            buffer.readPad32(face.fCoverage->writable_data(), Coverage::kByteSize);
+        }
+    }
+    if (!buffer.isValid()) {
+        record->fFaces.reset();
+        return false;
+    }
+    record->fDecoded = true;
+    return true;
+}
+
+bool SkFontIndex::findFaces(const char path[], const FileStamp& stamp,
+                            SkTArray<Face>* faces) const {
+    Record* record = fRecords.find(SkString(path));
+    if (!record) {
+        return false;
+    }
+    record->fUsed = true;
+    if (record->fStamp != stamp || !this->decode(record)) {
+        return false;
+    }
+    for (const Face& face : record->fFaces) {
+        faces->push_back(face);
+    }
+    return true;
+}
+
+void SkFontIndex::addFaces(const char path[], const FileStamp& stamp,
+                           const SkTArray<Face>& faces) {
+    Record record;
+    record.fStamp = stamp;
+    record.fDecoded = true;
+    record.fUsed = true;
+    record.fFaces = faces;
+    fRecords.set(SkString(path), std::move(record));
+    fDirty = true;
+}
+
+void SkFontIndex::removeUnused() {
+    SkTArray<SkString> unused;
+    fRecords.foreach([&unused](const SkString& path, Record* record) {
+        if (!record->fUsed) {
+            unused.push_back(path);
+        }
+    });
+    for (const SkString& path : unused) {
+        fRecords.remove(path);
+    }
+    fDirty |= !unused.empty();
+}
+
+sk_sp<SkData> SkFontIndex::serialize() const {
+    SkBinaryWriteBuffer buffer;
+    buffer.writeUInt(kMagic);
+    buffer.writeUInt(kVersion);
+    buffer.writeUInt(fRecords.count());
+    fRecords.foreach([this, &buffer](const SkString& path, Record* record) {
+        buffer.writeString(path.c_str());
+        write_u64(buffer, record->fStamp.fSize);
+        write_u64(buffer, record->fStamp.fModTime);
+
+        // Records which were never looked at are copied through without decoding them.
+        if (!record->fDecoded) {
+            buffer.writeUInt(SkToU32(record->fLength));
+            buffer.writePad32(fSerialized->bytes() + record->fOffset, record->fLength);
+            return;
+        }
+
+        SkBinaryWriteBuffer faces;
+        faces.writeUInt(record->fFaces.count());
+        for (const Face& face : record->fFaces) {
+            faces.writeString(face.fFamilyName.c_str());
+            faces.writeInt(face.fStyle.weight());
+            faces.writeInt(face.fStyle.width());
+            faces.writeInt(face.fStyle.slant());
+            faces.writeBool(face.fIsFixedPitch);
+            faces.writeInt(face.fIndex);
+            faces.writeBool(SkToBool(face.fCoverage));
+            if (face.fCoverage) {
+                SkASSERT(face.fCoverage->size() == Coverage::kByteSize);
+                faces.writePad32(face.fCoverage->data(), Coverage::kByteSize);
+            }
+        }
+        size_t length = faces.bytesWritten();
+        SkAutoMalloc storage(length);
+        faces.writeToMemory(storage.get());
+        buffer.writeUInt(SkToU32(length));
+        buffer.writePad32(storage.get(), length);
+    });
+
+    sk_sp<SkData> data = SkData::MakeUninitialized(buffer.bytesWritten());
+    buffer.writeToMemory(data->writable_data());
+    return data;
+}
+
+bool SkFontIndex::writeToStream(SkWStream* stream) const {
+    sk_sp<SkData> data = this->serialize();
+    return stream->write(data->data(), data->size());
+}
+
+bool SkFontIndex::writeToFile(const char path[]) const {
+    // The file at path may be the one currently mapped, so never truncate it in place. Write a
+    // sibling and move it over the old index instead, which leaves existing mappings intact.
+    SkString tempPath = SkStringPrintf("%s.tmp", path);
+    {
+        SkFILEWStream stream(tempPath.c_str());
+        if (!stream.isValid() || !this->writeToStream(&stream)) {
+            remove(tempPath.c_str());
+            return false;
+        }
+    }
+    if (0 != rename(tempPath.c_str(), path)) {
+        remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
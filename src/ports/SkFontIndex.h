@@ -0,0 +1,145 @@
+/*
+ * Copyright 2020 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkFontIndex_DEFINED
+#define SkFontIndex_DEFINED
+
+#include "include/core/SkData.h"
+#include "include/core/SkFontStyle.h"
+#include "include/core/SkRefCnt.h"
+#include "include/core/SkString.h"
+#include "include/core/SkTypes.h"
+#include "include/private/SkTArray.h"
+#include "include/private/SkTHash.h"
+
+class SkWStream;
+
+/**
+ *  SkFontIndex is a persistent record of what was found when font files were scanned.
+ *
+ *  Scanning a font file means opening it with FreeType, which dominates the construction time of
+ *  font managers that walk a directory. The index remembers, per file, the faces it contains
+ *  along with the file's size and modification time. A serialized index is mapped read-only and
+ *  a file's record is only decoded when that file is looked up; a record whose size or time no
+ *  longer matches the file on disk is ignored, so only changed files need to be rescanned.
+ */
+class SkFontIndex {
+public:
+    /** Unicode coverage of a face, at the granularity of 256 code point pages. */
+    class Coverage {
+    public:
+        static constexpr int kPageShift = 8;
+        static constexpr int kPageCount = (0x10FFFF >> kPageShift) + 1;
+        static constexpr size_t kByteSize = kPageCount / 8;
+
+        /** Returns a zeroed coverage buffer. */
+        static sk_sp<SkData> Make() {
+            sk_sp<SkData> data = SkData::MakeUninitialized(kByteSize);
+            sk_bzero(data->writable_data(), kByteSize);
+            return data;
+        }
+
+        static void Add(SkData* coverage, SkUnichar uni) {
+            SkASSERT(coverage && coverage->size() == kByteSize);
+            if (0 <= uni && uni <= 0x10FFFF) {
+                int page = uni >> kPageShift;
+                static_cast<uint8_t*>(coverage->writable_data())[page >> 3] |= 1 << (page & 7);
+            }
+        }
+
+        /** Returns false only if the face is known to have no glyphs in uni's page. */
+        static bool MayContain(const SkData* coverage, SkUnichar uni) {
+            if (!coverage) {
+                return true;
+            }
+            if (uni < 0 || 0x10FFFF < uni) {
+                return false;
+            }
+            int page = uni >> kPageShift;
+            return SkToBool(coverage->bytes()[page >> 3] & (1 << (page & 7)));
+        }
+    };
+
+    struct Face {
+        SkString fFamilyName;
+        SkFontStyle fStyle;
+        bool fIsFixedPitch = false;
+        int fIndex = 0;
+        sk_sp<SkData> fCoverage;  // May be null if coverage was not computed.
+    };
+
+    /** The identity of a file's contents as far as the index is concerned. */
+    struct FileStamp {
+        uint64_t fSize = 0;
+        int64_t fModTime = 0;
+
+        bool operator==(const FileStamp& that) const {
+            return fSize == that.fSize && fModTime == that.fModTime;
+        }
+        bool operator!=(const FileStamp& that) const { return !(*this == that); }
+    };
+
+    /** Returns false if nothing could be found at path. */
+    static bool Stamp(const char path[], FileStamp* stamp);
+
+    /** Creates an empty index. */
+    SkFontIndex();
+
+    /**
+     *  Creates an index from previously serialized data. If the data is not a valid index of the
+     *  current version it is ignored and the index starts out empty.
+     */
+    explicit SkFontIndex(sk_sp<SkData> serialized);
+
+    /** Maps the index stored at path. A missing or invalid file results in an empty index. */
+    static SkFontIndex MakeFromFile(const char path[]);
+
+    SkFontIndex(SkFontIndex&&) = default;
+    SkFontIndex& operator=(SkFontIndex&&) = default;
+
+    /**
+     *  If the index has a record for the file at path made with the given stamp, appends the
+     *  faces found in the file to 'faces' and returns true. A file which contains no usable faces
+     *  still has a record, so this can return true without appending anything.
+     */
+    bool findFaces(const char path[], const FileStamp&, SkTArray<Face>* faces) const;
+
+    /** Records the faces found in the file at path, replacing any previous record. */
+    void addFaces(const char path[], const FileStamp&, const SkTArray<Face>& faces);
+
+    /** Drops records for files which were not looked up or added since this index was created. */
+    void removeUnused();
+
+    /** Returns true if the serialized form would differ from the one this index was made from. */
+    bool isDirty() const { return fDirty; }
+
+    int count() const { return fRecords.count(); }
+
+    sk_sp<SkData> serialize() const;
+    bool writeToStream(SkWStream*) const;
+    bool writeToFile(const char path[]) const;
+
+private:
+    struct Record {
+        FileStamp fStamp;
+        // Exactly one of these is in use: either the record still lives in fSerialized or it was
+        // added (or has already been decoded) and lives in fFaces.
+        size_t fOffset = 0;
+        size_t fLength = 0;
+        bool fDecoded = false;
+        bool fUsed = false;
+        SkTArray<Face> fFaces;
+    };
+
+    bool decode(Record*) const;
+
+    sk_sp<SkData> fSerialized;
+    mutable SkTHashMap<SkString, Record> fRecords;
+    bool fDirty = false;
+};
+
+#endif
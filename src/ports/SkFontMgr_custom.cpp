@@ -18,6 +18,7 @@
 #include "src/core/SkFontDescriptor.h"
 #include "src/ports/SkFontHost_FreeType_common.h"
 #include "src/ports/SkFontMgr_custom.h"
+#include "src/ports/SkFontIndex.h"
 
 #include <limits>
 #include <memory>
@@ -86,9 +87,11 @@ sk_sp<SkTypeface> SkTypeface_Stream::onMakeClone(const SkFontArguments& args) co
 }
 
 SkTypeface_File::SkTypeface_File(const SkFontStyle& style, bool isFixedPitch, bool sysFont,
-                                 const SkString familyName, const char path[], int index)
+                                 const SkString familyName, const char path[], int index,
+                                 sk_sp<SkData> coverage)
     : INHERITED(style, isFixedPitch, sysFont, familyName, index)
     , fPath(path)
+    , fCoverage(std::move(coverage))
 { }
 
 std::unique_ptr<SkStreamAsset> SkTypeface_File::onOpenStream(int* ttcIndex) const {
@@ -205,10 +208,44 @@ SkTypeface* SkFontMgr_Custom::onMatchFamilyStyle(const char familyName[],
 }
 
 SkTypeface* SkFontMgr_Custom::onMatchFamilyStyleCharacter(const char familyName[],
-                                                          const SkFontStyle&,
+                                                          const SkFontStyle& style,
                                                           const char* bcp47[], int bcp47Count,
                                                           SkUnichar character) const
 {
+    // Only faces with known coverage (from an SkFontIndex) take part in fallback, finding out
+    // about any other face would mean opening its font file.
+    auto matches = [&](SkFontStyleSet_Custom* family) -> SkTypeface* {
+        sk_sp<SkTypeface> tf(family->matchStyle(style));
+        if (!tf) {
+            return nullptr;
+        }
+        const SkData* coverage = static_cast<SkTypeface_Custom*>(tf.get())->getCoverage();
+        if (!coverage || !SkFontIndex::Coverage::MayContain(coverage, character) ||
+            0 == tf->unicharToGlyph(character))
+        {
+            return nullptr;
+        }
+        return tf.release();
+    };
+
+    SkFontStyleSet_Custom* requested = nullptr;
+    if (familyName) {
+        sk_sp<SkFontStyleSet_Custom> family(this->onMatchFamily(familyName));
+        if (family) {
+            if (SkTypeface* tf = matches(family.get())) {
+                return tf;
+            }
+            requested = family.get();
+        }
+    }
+    for (int i = 0; i < fFamilies.count(); ++i) {
+        if (fFamilies[i].get() == requested) {
+            continue;
+        }
+        if (SkTypeface* tf = matches(fFamilies[i].get())) {
+            return tf;
+        }
+    }
     return nullptr;
 }
 
@@ -8,6 +8,7 @@
 #ifndef SkFontMgr_custom_DEFINED
 #define SkFontMgr_custom_DEFINED
 
+#include "include/core/SkData.h"
 #include "include/core/SkFontMgr.h"
 #include "include/core/SkFontStyle.h"
 #include "include/core/SkRefCnt.h"
@@ -16,7 +17,6 @@
 #include "include/private/SkTArray.h"
 #include "src/ports/SkFontHost_FreeType_common.h"
 
-class SkData;
 class SkFontDescriptor;
 class SkStreamAsset;
 class SkTypeface;
@@ -28,6 +28,9 @@ public:
                       bool sysFont, const SkString familyName, int index);
     bool isSysFont() const;
 
+    /** The Unicode coverage of this face if it is known, see SkFontIndex::Coverage. */
+    virtual const SkData* getCoverage() const { return nullptr; }
+
 protected:
     void onGetFamilyName(SkString* familyName) const override;
     void onGetFontDescriptor(SkFontDescriptor* desc, bool* isLocal) const override;
@@ -78,7 +81,10 @@ private:
 class SkTypeface_File : public SkTypeface_Custom {
 public:
     SkTypeface_File(const SkFontStyle& style, bool isFixedPitch, bool sysFont,
-                    const SkString familyName, const char path[], int index);
+                    const SkString familyName, const char path[], int index,
+                    sk_sp<SkData> coverage = nullptr);
+
+    const SkData* getCoverage() const override { return fCoverage.get(); }
 
 protected:
     std::unique_ptr<SkStreamAsset> onOpenStream(int* ttcIndex) const override;
@@ -86,6 +92,7 @@ protected:
 
 private:
     SkString fPath;
+    sk_sp<SkData> fCoverage;
 
     typedef SkTypeface_Custom INHERITED;
 };
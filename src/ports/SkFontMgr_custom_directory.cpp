@@ -8,20 +8,36 @@
 #include "include/core/SkStream.h"
 #include "include/ports/SkFontMgr_directory.h"
 #include "src/core/SkOSFile.h"
+#include "src/ports/SkFontIndex.h"
 #include "src/ports/SkFontMgr_custom.h"
 #include "src/utils/SkOSPath.h"
 
+#include <memory>
+
 class DirectorySystemFontLoader : public SkFontMgr_Custom::SystemFontLoader {
 public:
-    DirectorySystemFontLoader(const char* dir) : fBaseDirectory(dir) { }
+    DirectorySystemFontLoader(const char* dir, const char* indexPath)
+        : fBaseDirectory(dir), fIndexPath(indexPath) { }
 
     void loadSystemFonts(const SkTypeface_FreeType::Scanner& scanner,
                          SkFontMgr_Custom::Families* families) const override
     {
-        load_directory_fonts(scanner, fBaseDirectory, ".ttf", families);
-        load_directory_fonts(scanner, fBaseDirectory, ".ttc", families);
-        load_directory_fonts(scanner, fBaseDirectory, ".otf", families);
-        load_directory_fonts(scanner, fBaseDirectory, ".pfb", families);
+        std::unique_ptr<SkFontIndex> index;
+        if (!fIndexPath.isEmpty()) {
+            index.reset(new SkFontIndex(SkFontIndex::MakeFromFile(fIndexPath.c_str())));
+        }
+
+        load_directory_fonts(scanner, fBaseDirectory, ".ttf", index.get(), families);
+        load_directory_fonts(scanner, fBaseDirectory, ".ttc", index.get(), families);
+        load_directory_fonts(scanner, fBaseDirectory, ".otf", index.get(), families);
+        load_directory_fonts(scanner, fBaseDirectory, ".pfb", index.get(), families);
+
+        if (index) {
+            index->removeUnused();
+            if (index->isDirty()) {
+                index->writeToFile(fIndexPath.c_str());
+            }
+        }
 
         if (families->empty()) {
             SkFontStyleSet_Custom* family = new SkFontStyleSet_Custom(SkString());
@@ -42,47 +58,75 @@ private:
         return nullptr;
     }
 
+    /** Opens the file with FreeType and appends the faces it contains. Coverage is only computed
+     *  when the results will be kept in an index.
+     */
+    static void scan_file(const SkTypeface_FreeType::Scanner& scanner, const SkString& filename,
+                          bool scanCoverage, SkTArray<SkFontIndex::Face>* faces)
+    {
+        std::unique_ptr<SkStreamAsset> stream = SkStream::MakeFromFile(filename.c_str());
+        if (!stream) {
+            // SkDebugf("---- failed to open <%s>\n", filename.c_str());
+            return;
+        }
+
+        int numFaces;
+        if (!scanner.recognizedFont(stream.get(), &numFaces)) {
+            // SkDebugf("---- failed to open <%s> as a font\n", filename.c_str());
+            return;
+        }
+
+        for (int faceIndex = 0; faceIndex < numFaces; ++faceIndex) {
+            SkFontIndex::Face face;
+            face.fIndex = faceIndex;
+            if (!scanner.scanFont(stream.get(), faceIndex,
+                                  &face.fFamilyName, &face.fStyle, &face.fIsFixedPitch, nullptr))
+            {
+                // SkDebugf("---- failed to open <%s> <%d> as a font\n",
+                //          filename.c_str(), faceIndex);
+                continue;
+            }
+            if (scanCoverage) {
+                face.fCoverage = SkFontIndex::Coverage::Make();
+                if (!scanner.scanCoverage(stream.get(), faceIndex, face.fCoverage.get())) {
+                    face.fCoverage.reset();
+                }
+            }
+            faces->push_back(std::move(face));
+        }
+    }
+
     static void load_directory_fonts(const SkTypeface_FreeType::Scanner& scanner,
                                      const SkString& directory, const char* suffix,
-                                     SkFontMgr_Custom::Families* families)
+                                     SkFontIndex* index, SkFontMgr_Custom::Families* families)
     {
         SkOSFile::Iter iter(directory.c_str(), suffix);
         SkString name;
 
         while (iter.next(&name, false)) {
             SkString filename(SkOSPath::Join(directory.c_str(), name.c_str()));
-            std::unique_ptr<SkStreamAsset> stream = SkStream::MakeFromFile(filename.c_str());
-            if (!stream) {
-                // SkDebugf("---- failed to open <%s>\n", filename.c_str());
-                continue;
-            }
 
-            int numFaces;
-            if (!scanner.recognizedFont(stream.get(), &numFaces)) {
-                // SkDebugf("---- failed to open <%s> as a font\n", filename.c_str());
-                continue;
-            }
-
-            for (int faceIndex = 0; faceIndex < numFaces; ++faceIndex) {
-                bool isFixedPitch;
-                SkString realname;
-                SkFontStyle style = SkFontStyle(); // avoid uninitialized warning
-                if (!scanner.scanFont(stream.get(), faceIndex,
-                                      &realname, &style, &isFixedPitch, nullptr))
-                {
-                    // SkDebugf("---- failed to open <%s> <%d> as a font\n",
-                    //          filename.c_str(), faceIndex);
-                    continue;
+            // Files whose size and modification time match the index are not opened at all.
+            SkTArray<SkFontIndex::Face> faces;
+            SkFontIndex::FileStamp stamp;
+            bool stamped = index && SkFontIndex::Stamp(filename.c_str(), &stamp);
+            if (!stamped || !index->findFaces(filename.c_str(), stamp, &faces)) {
+                scan_file(scanner, filename, stamped, &faces);
+                if (stamped) {
+                    index->addFaces(filename.c_str(), stamp, faces);
                 }
+            }
 
-                SkFontStyleSet_Custom* addTo = find_family(*families, realname.c_str());
+            for (SkFontIndex::Face& face : faces) {
+                SkFontStyleSet_Custom* addTo = find_family(*families, face.fFamilyName.c_str());
                 if (nullptr == addTo) {
-                    addTo = new SkFontStyleSet_Custom(realname);
+                    addTo = new SkFontStyleSet_Custom(face.fFamilyName);
                     families->push_back().reset(addTo);
                 }
-                addTo->appendTypeface(sk_make_sp<SkTypeface_File>(style, isFixedPitch, true,
-                                                                  realname, filename.c_str(),
-                                                                  faceIndex));
+                addTo->appendTypeface(sk_make_sp<SkTypeface_File>(face.fStyle, face.fIsFixedPitch,
+                                                                  true, face.fFamilyName,
+                                                                  filename.c_str(), face.fIndex,
+                                                                  std::move(face.fCoverage)));
             }
         }
 
@@ -92,13 +136,18 @@ private:
                 continue;
             }
             SkString dirname(SkOSPath::Join(directory.c_str(), name.c_str()));
-            load_directory_fonts(scanner, dirname, suffix, families);
+            load_directory_fonts(scanner, dirname, suffix, index, families);
         }
     }
 
     SkString fBaseDirectory;
+    SkString fIndexPath;
 };
 
 SK_API sk_sp<SkFontMgr> SkFontMgr_New_Custom_Directory(const char* dir) {
-    return sk_make_sp<SkFontMgr_Custom>(DirectorySystemFontLoader(dir));
+    return SkFontMgr_New_Custom_Directory(dir, nullptr);
+}
+
+SK_API sk_sp<SkFontMgr> SkFontMgr_New_Custom_Directory(const char* dir, const char* indexPath) {
+    return sk_make_sp<SkFontMgr_Custom>(DirectorySystemFontLoader(dir, indexPath));
 }
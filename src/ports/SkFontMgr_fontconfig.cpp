@@ -20,6 +20,7 @@
 #include "include/private/SkTemplates.h"
 #include "src/core/SkAdvancedTypefaceMetrics.h"
 #include "src/core/SkFontDescriptor.h"
+#include "src/core/SkLRUCache.h"
 #include "src/core/SkOSFile.h"
 #include "src/core/SkTypefaceCache.h"
 #include "src/ports/SkFontHost_FreeType_common.h"
@@ -696,12 +697,57 @@ class SkFontMgr_fontconfig : public SkFontMgr {
         return face;
     }
 
+    /** Family and style requests repeat constantly while matching through FcFontMatch is costly,
+     *  so remember the answers, including the lack of one.
+     *
+     *  The answers depend on the fonts fFC holds, which change when the application adds fonts to
+     *  it, clears them, or rebuilds its font sets after a rescan. The cache is dropped whenever
+     *  the font sets differ from those it was filled from.
+     */
+    static constexpr int kMatchCacheCount = 256;
+
+    struct FontSetsStamp {
+        FcFontSet* fSets[2] = {nullptr, nullptr};
+        int fCounts[2] = {0, 0};
+
+        bool operator==(const FontSetsStamp& that) const {
+            return fSets[0] == that.fSets[0] && fSets[1] == that.fSets[1] &&
+                   fCounts[0] == that.fCounts[0] && fCounts[1] == that.fCounts[1];
+        }
+        bool operator!=(const FontSetsStamp& that) const { return !(*this == that); }
+    };
+
+    FontSetsStamp currentFontSets() const {
+        FCLocker lock;
+        FontSetsStamp stamp;
+        FcSetName fcNameSet[] = { FcSetSystem, FcSetApplication };
+        for (int setIndex = 0; setIndex < (int)SK_ARRAY_COUNT(fcNameSet); ++setIndex) {
+            // Return value of FcConfigGetFonts must not be destroyed.
+            if (FcFontSet* set = FcConfigGetFonts(fFC, fcNameSet[setIndex])) {
+                stamp.fSets[setIndex] = set;
+                stamp.fCounts[setIndex] = set->nfont;
+            }
+        }
+        return stamp;
+    }
+
+    mutable SkMutex fMatchCacheMutex;
+    mutable SkLRUCache<SkString, sk_sp<SkTypeface>> fMatchCache;
+    mutable FontSetsStamp fMatchCacheStamp;
+
+    static SkString MatchCacheKey(const char familyName[], const SkFontStyle& style) {
+        // Keep a null family distinct from an empty one.
+        return SkStringPrintf("%d %d %d %c%s", style.weight(), style.width(), style.slant(),
+                              familyName ? 'f' : 'n', familyName ? familyName : "");
+    }
+
 public:
     /** Takes control of the reference to 'config'. */
     explicit SkFontMgr_fontconfig(FcConfig* config)
         : fFC(config ? config : FcInitLoadConfigAndFonts())
         , fSysroot(reinterpret_cast<const char*>(FcConfigGetSysRoot(fFC)))
-        , fFamilyNames(GetFamilyNames(fFC)) { }
+        , fFamilyNames(GetFamilyNames(fFC))
+        , fMatchCache(kMatchCacheCount) { }
 
     ~SkFontMgr_fontconfig() override {
         // Hold the lock while unrefing the config.
@@ -852,6 +898,30 @@ protected:
     SkTypeface* onMatchFamilyStyle(const char familyName[],
                                    const SkFontStyle& style) const override
     {
+        SkString key = MatchCacheKey(familyName, style);
+        const FontSetsStamp stamp = this->currentFontSets();
+        {
+            SkAutoMutexExclusive ama(fMatchCacheMutex);
+            if (stamp != fMatchCacheStamp) {
+                fMatchCache.reset();
+                fMatchCacheStamp = stamp;
+            }
+            if (sk_sp<SkTypeface>* cached = fMatchCache.find(key)) {
+                return SkSafeRef(cached->get());
+            }
+        }
+
+        sk_sp<SkTypeface> typeface(this->matchFamilyStyleUncached(familyName, style));
+
+        SkAutoMutexExclusive ama(fMatchCacheMutex);
+        // Don't keep an answer computed against font sets which have since changed.
+        if (stamp == fMatchCacheStamp) {
+            fMatchCache.insert(key, typeface);
+        }
+        return typeface.release();
+    }
+
+    SkTypeface* matchFamilyStyleUncached(const char familyName[], const SkFontStyle& style) const {
         FCLocker lock;
 
         SkAutoFcPattern pattern;
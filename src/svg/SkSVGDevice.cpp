@@ -32,8 +32,11 @@
 #include "src/core/SkUtils.h"
 #include "src/image/SkImage_Base.h"
 #include "src/shaders/SkShaderBase.h"
+#include "src/utils/SkFloatToDecimal.h"
 #include "src/xml/SkXMLWriter.h"
 
+#include <initializer_list>
+
 namespace {
 
 static SkString svg_color(SkColor color) {
@@ -115,6 +118,25 @@ static const char* svg_join(SkPaint::Join join) {
     return join_map[join];
 }
 
+// Scalars are written with the shortest digits which read back as the same float.
+static void append_scalar(SkString* str, SkScalar value) {
+    char buffer[kMaximumSkFloatToDecimalLength];
+    str->append(buffer, SkFloatToSVGScalar(value, buffer));
+}
+
+static SkString svg_function(const char name[], std::initializer_list<SkScalar> args) {
+    SkString str(name);
+    str.append("(");
+    const char* separator = "";
+    for (SkScalar arg : args) {
+        str.append(separator);
+        append_scalar(&str, arg);
+        separator = " ";
+    }
+    str.append(")");
+    return str;
+}
+
 static SkString svg_transform(const SkMatrix& t) {
     SkASSERT(!t.isIdentity());
 
@@ -124,20 +146,19 @@ static SkString svg_transform(const SkMatrix& t) {
         // TODO: handle perspective matrices?
         break;
     case SkMatrix::kTranslate_Mask:
-        tstr.printf("translate(%g %g)", t.getTranslateX(), t.getTranslateY());
+        tstr = svg_function("translate", { t.getTranslateX(), t.getTranslateY() });
         break;
     case SkMatrix::kScale_Mask:
-        tstr.printf("scale(%g %g)", t.getScaleX(), t.getScaleY());
+        tstr = svg_function("scale", { t.getScaleX(), t.getScaleY() });
         break;
     default:
         // http://www.w3.org/TR/SVG/coords.html#TransformMatrixDefined
         //    | a c e |
         //    | b d f |
         //    | 0 0 1 |
-        tstr.printf("matrix(%g %g %g %g %g %g)",
-                    t.getScaleX(),     t.getSkewY(),
-                    t.getSkewX(),      t.getScaleY(),
-                    t.getTranslateX(), t.getTranslateY());
+        tstr = svg_function("matrix", { t.getScaleX(),     t.getSkewY(),
+                                        t.getSkewX(),      t.getScaleY(),
+                                        t.getTranslateX(), t.getTranslateY() });
         break;
     }
 
@@ -1038,8 +1059,10 @@ private:
         }
 
         position += fOrigin;
-        fPosXStr.appendf("%.8g, ", position.fX);
-        fPosYStr.appendf("%.8g, ", position.fY);
+        append_scalar(&fPosXStr, position.fX);
+        fPosXStr.append(", ");
+        append_scalar(&fPosYStr, position.fY);
+        fPosYStr.append(", ");
 
         if (fConstYStr.isEmpty()) {
             fConstYStr = fPosYStr;
@@ -8,56 +8,227 @@
 #include "src/utils/SkFloatToDecimal.h"
 
 #include <cfloat>
-#include <climits>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 
 #include "include/core/SkTypes.h"
 
-// returns `value * pow(base, e)`, assuming `e` is positive.
-static double pow_by_squaring(double value, double base, int e) {
-    // https://en.wikipedia.org/wiki/Exponentiation_by_squaring
-    SkASSERT(e > 0);
-    while (true) {
-        if (e & 1) {
-            value *= base;
-        }
-        e >>= 1;
-        if (0 == e) {
-            return value;
-        }
-        base *= base;
+// The shortest digits are found with Ulf Adams' Ryu algorithm
+// (https://doi.org/10.1145/3192366.3192369), specialized for floats.  All of the
+// arithmetic is exact, so unlike printf("%.9g") the result is both the shortest
+// string which reads back as the same float and the one closest to it.
+namespace {
+
+constexpr int kMantissaBits = 23;
+constexpr int kExponentBias = 127;
+constexpr int kPow5InvBitCount = 59;
+constexpr int kPow5BitCount = 61;
+
+// kPow5InvSplit[i] = ceil(2^(ceil(log2(5^i)) - 1 + kPow5InvBitCount) / 5^i)
+constexpr uint64_t kPow5InvSplit[] = {
+    576460752303423489u, 461168601842738791u, 368934881474191033u, 295147905179352826u,
+    472236648286964522u, 377789318629571618u, 302231454903657294u, 483570327845851670u,
+    386856262276681336u, 309485009821345069u, 495176015714152110u, 396140812571321688u,
+    316912650057057351u, 507060240091291761u, 405648192073033409u, 324518553658426727u,
+    519229685853482763u, 415383748682786211u, 332306998946228969u, 531691198313966350u,
+    425352958651173080u, 340282366920938464u, 544451787073501542u, 435561429658801234u,
+    348449143727040987u, 557518629963265579u, 446014903970612463u, 356811923176489971u,
+    570899077082383953u, 456719261665907162u, 365375409332725730u,
+};
+
+// kPow5Split[i] = the top kPow5BitCount bits of 5^i.
+constexpr uint64_t kPow5Split[] = {
+    1152921504606846976u, 1441151880758558720u, 1801439850948198400u, 2251799813685248000u,
+    1407374883553280000u, 1759218604441600000u, 2199023255552000000u, 1374389534720000000u,
+    1717986918400000000u, 2147483648000000000u, 1342177280000000000u, 1677721600000000000u,
+    2097152000000000000u, 1310720000000000000u, 1638400000000000000u, 2048000000000000000u,
+    1280000000000000000u, 1600000000000000000u, 2000000000000000000u, 1250000000000000000u,
+    1562500000000000000u, 1953125000000000000u, 1220703125000000000u, 1525878906250000000u,
+    1907348632812500000u, 1192092895507812500u, 1490116119384765625u, 1862645149230957031u,
+    1164153218269348144u, 1455191522836685180u, 1818989403545856475u, 2273736754432320594u,
+    1421085471520200371u, 1776356839400250464u, 2220446049250313080u, 1387778780781445675u,
+    1734723475976807094u, 2168404344971008868u, 1355252715606880542u, 1694065894508600678u,
+    2117582368135750847u, 1323488980084844279u, 1654361225106055349u, 2067951531382569187u,
+    1292469707114105741u, 1615587133892632177u, 2019483917365790221u, 1262177448353618888u,
+};
+
+// ceil(log2(5^e)), or 1 when e is 0.
+int pow5_bits(int e) {
+    SkASSERT(e >= 0 && e <= 3528);
+    return (int)(((uint32_t)e * 1217359) >> 19) + 1;
+}
+
+// floor(log10(2^e))
+int log10_pow2(int e) {
+    SkASSERT(e >= 0 && e <= 1650);
+    return (int)(((uint32_t)e * 78913) >> 18);
+}
+
+// floor(log10(5^e))
+int log10_pow5(int e) {
+    SkASSERT(e >= 0 && e <= 2620);
+    return (int)(((uint32_t)e * 732923) >> 20);
+}
+
+bool multiple_of_pow5(uint32_t value, int p) {
+    int count = 0;
+    while (value % 5 == 0) {
+        value /= 5;
+        ++count;
     }
+    return count >= p;
+}
+
+bool multiple_of_pow2(uint32_t value, int p) {
+    SkASSERT(p < 32);
+    return (value & ((1u << p) - 1)) == 0;
 }
 
-// Return pow(10.0, e), optimized for common cases.
-static double pow10(int e) {
-    switch (e) {
-        case 0:  return 1.0;  // common cases
-        case 1:  return 10.0;
-        case 2:  return 100.0;
-        case 3:  return 1e+03;
-        case 4:  return 1e+04;
-        case 5:  return 1e+05;
-        case 6:  return 1e+06;
-        case 7:  return 1e+07;
-        case 8:  return 1e+08;
-        case 9:  return 1e+09;
-        case 10: return 1e+10;
-        case 11: return 1e+11;
-        case 12: return 1e+12;
-        case 13: return 1e+13;
-        case 14: return 1e+14;
-        case 15: return 1e+15;
-        default:
-            if (e > 15) {
-                return pow_by_squaring(1e+15, 10.0, e - 15);
+// (m * factor) >> shift, for shift > 32, without a 128-bit product.
+uint32_t mul_shift(uint32_t m, uint64_t factor, int shift) {
+    SkASSERT(shift > 32);
+    const uint64_t lo = (uint64_t)m * (uint32_t)factor,
+                   hi = (uint64_t)m * (uint32_t)(factor >> 32);
+    const uint64_t shifted = ((lo >> 32) + hi) >> (shift - 32);
+    SkASSERT(shifted <= UINT32_MAX);
+    return (uint32_t)shifted;
+}
+
+uint32_t mul_pow5_inv_div_pow2(uint32_t m, int q, int j) {
+    SkASSERT(q >= 0 && q < (int)SK_ARRAY_COUNT(kPow5InvSplit));
+    return mul_shift(m, kPow5InvSplit[q], j);
+}
+
+uint32_t mul_pow5_div_pow2(uint32_t m, int i, int j) {
+    SkASSERT(i >= 0 && i < (int)SK_ARRAY_COUNT(kPow5Split));
+    return mul_shift(m, kPow5Split[i], j);
+}
+
+// Finds the shortest digits * 10^exponent which rounds to the positive, finite float with these
+// IEEE fields.
+void shortest_decimal(uint32_t ieeeMantissa, int ieeeExponent,
+                      uint32_t* digits, int* exponent) {
+    // The float is m2 * 2^e2; two more bits make room for the half-way points to its neighbors.
+    int e2;
+    uint32_t m2;
+    if (ieeeExponent == 0) {
+        e2 = 1 - kExponentBias - kMantissaBits - 2;
+        m2 = ieeeMantissa;
+    } else {
+        e2 = ieeeExponent - kExponentBias - kMantissaBits - 2;
+        m2 = (1u << kMantissaBits) | ieeeMantissa;
+    }
+    // Ties read back as the float with the even mantissa, so its half-way points round-trip.
+    const bool acceptBounds = (m2 & 1) == 0;
+
+    // The value and the half-way points to its neighbors, all scaled by 2^-e2.  The neighbor
+    // below is closer when the mantissa is a power of two.
+    const uint32_t mv = 4 * m2,
+                   mp = 4 * m2 + 2;
+    const uint32_t mmShift = ieeeMantissa != 0 || ieeeExponent <= 1;
+    const uint32_t mm = 4 * m2 - 1 - mmShift;
+
+    // Scale to vr * 10^e10, rounding down, and track whether anything nonzero was dropped.
+    uint32_t vr, vp, vm;
+    int e10;
+    bool vmIsTrailingZeros = false,
+         vrIsTrailingZeros = false;
+    uint8_t lastRemovedDigit = 0;
+    if (e2 >= 0) {
+        const int q = log10_pow2(e2);
+        e10 = q;
+        const int k = kPow5InvBitCount + pow5_bits(q) - 1;
+        const int i = -e2 + q + k;
+        vr = mul_pow5_inv_div_pow2(mv, q, i);
+        vp = mul_pow5_inv_div_pow2(mp, q, i);
+        vm = mul_pow5_inv_div_pow2(mm, q, i);
+        if (q != 0 && (vp - 1) / 10 <= vm / 10) {
+            // The digit loop below won't run, so compute the digit it would have removed.
+            const int l = kPow5InvBitCount + pow5_bits(q - 1) - 1;
+            lastRemovedDigit = (uint8_t)(mul_pow5_inv_div_pow2(mv, q - 1, -e2 + q - 1 + l) % 10);
+        }
+        if (q <= 9) {
+            // Only one of mp, mv and mm can be a multiple of 5.
+            if (mv % 5 == 0) {
+                vrIsTrailingZeros = multiple_of_pow5(mv, q);
+            } else if (acceptBounds) {
+                vmIsTrailingZeros = multiple_of_pow5(mm, q);
+            } else {
+                vp -= multiple_of_pow5(mp, q);
+            }
+        }
+    } else {
+        const int q = log10_pow5(-e2);
+        e10 = q + e2;
+        const int i = -e2 - q;
+        const int k = pow5_bits(i) - kPow5BitCount;
+        int j = q - k;
+        vr = mul_pow5_div_pow2(mv, i, j);
+        vp = mul_pow5_div_pow2(mp, i, j);
+        vm = mul_pow5_div_pow2(mm, i, j);
+        if (q != 0 && (vp - 1) / 10 <= vm / 10) {
+            j = q - 1 - (pow5_bits(i + 1) - kPow5BitCount);
+            lastRemovedDigit = (uint8_t)(mul_pow5_div_pow2(mv, i + 1, j) % 10);
+        }
+        if (q <= 1) {
+            // mv has at least two trailing zero bits, so vr is exact.
+            vrIsTrailingZeros = true;
+            if (acceptBounds) {
+                vmIsTrailingZeros = mmShift == 1;
             } else {
-                SkASSERT(e < 0);
-                return pow_by_squaring(1.0, 0.1, -e);
+                --vp;
+            }
+        } else if (q < 31) {
+            vrIsTrailingZeros = multiple_of_pow2(mv, q - 1);
+        }
+    }
+
+    // Remove digits while the bounds still differ, rounding vr to nearest (ties to even) at the
+    // end.  The general case only needs the last removed digit.
+    int removed = 0;
+    uint32_t output;
+    if (vmIsTrailingZeros || vrIsTrailingZeros) {
+        while (vp / 10 > vm / 10) {
+            vmIsTrailingZeros &= vm % 10 == 0;
+            vrIsTrailingZeros &= lastRemovedDigit == 0;
+            lastRemovedDigit = (uint8_t)(vr % 10);
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            ++removed;
+        }
+        if (vmIsTrailingZeros) {
+            while (vm % 10 == 0) {
+                vrIsTrailingZeros &= lastRemovedDigit == 0;
+                lastRemovedDigit = (uint8_t)(vr % 10);
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+                ++removed;
             }
+        }
+        if (vrIsTrailingZeros && lastRemovedDigit == 5 && vr % 2 == 0) {
+            lastRemovedDigit = 4;  // Exactly half-way: round to even.
+        }
+        output = vr + ((vr == vm && (!acceptBounds || !vmIsTrailingZeros)) ||
+                       lastRemovedDigit >= 5);
+    } else {
+        while (vp / 10 > vm / 10) {
+            lastRemovedDigit = (uint8_t)(vr % 10);
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            ++removed;
+        }
+        output = vr + (vr == vm || lastRemovedDigit >= 5);
     }
+    *digits = output;
+    *exponent = e10 + removed;
 }
 
+}  // namespace
+
 /** Write a string into output, including a terminating '\0' (for
     unit testing).  Return strlen(output) (for SkWStream::write) The
     resulting string will be in the form /[-]?([0-9]*.)?[0-9]+/ and
@@ -67,14 +238,15 @@ static double pow10(int e) {
     Motivation: "PDF does not support [numbers] in exponential format
     (such as 6.02e23)."  Otherwise, this function would rely on a
     sprintf-type function from the standard library. */
-unsigned SkFloatToDecimal(float value, char output[kMaximumSkFloatToDecimalLength]) {
+static unsigned float_to_string(float value, char output[kMaximumSkFloatToDecimalLength],
+                                bool allowExponent) {
     /* The longest result is -FLT_MIN.
-       We serialize it as "-.0000000000000000000000000000000000000117549435"
-       which has 48 characters plus a terminating '\0'. */
+       We serialize it as "-.000000000000000000000000000000000000011754944"
+       which has 47 characters plus a terminating '\0'. */
 
     static_assert(kMaximumSkFloatToDecimalLength == 49, "");
     // 3 = '-', '.', and '\0' characters.
-    // 9 = number of significant digits
+    // 9 = maximum number of significant digits
     // abs(FLT_MIN_10_EXP) = number of zeros in FLT_MIN
     static_assert(kMaximumSkFloatToDecimalLength == 3 + 9 - FLT_MIN_10_EXP, "");
 
@@ -88,8 +260,6 @@ unsigned SkFloatToDecimal(float value, char output[kMaximumSkFloatToDecimalLengt
        from this.  Rasterizers that rely on fixed-point scalars should
        gracefully ignore these values that they can not parse. */
     char* output_ptr = &output[0];
-    const char* const end = &output[kMaximumSkFloatToDecimalLength - 1];
-    // subtract one to leave space for '\0'.
 
     /* This function is written to accept any possible input value,
        including non-finite values such as INF and NAN.  In that case,
@@ -114,29 +284,17 @@ unsigned SkFloatToDecimal(float value, char output[kMaximumSkFloatToDecimalLengt
     }
     SkASSERT(value >= 0.0f);
 
-    int binaryExponent;
-    (void)std::frexp(value, &binaryExponent);
-    static const double kLog2 = 0.3010299956639812;  // log10(2.0);
-    int decimalExponent = static_cast<int>(std::floor(kLog2 * binaryExponent));
-    int decimalShift = decimalExponent - 8;
-    double power = pow10(-decimalShift);
-    SkASSERT(value * power <= (double)INT_MAX);
-    int d = static_cast<int>(value * power + 0.5);
-    // SkASSERT(value == (float)(d * pow(10.0, decimalShift)));
-    SkASSERT(d <= 999999999);
-    if (d > 167772159) {  // floor(pow(10,1+log10(1<<24)))
-       // need one fewer decimal digits for 24-bit precision.
-       decimalShift = decimalExponent - 7;
-       // SkASSERT(power * 0.1 = pow10(-decimalShift));
-       // recalculate to get rounding right.
-       d = static_cast<int>(value * (power * 0.1) + 0.5);
-       SkASSERT(d <= 99999999);
-    }
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint32_t d;
+    int decimalShift;
+    shortest_decimal(bits & ((1u << kMantissaBits) - 1), (int)(bits >> kMantissaBits),
+                     &d, &decimalShift);
+    SkASSERT(d > 0 && d <= 999999999);
     while (d % 10 == 0) {
         d /= 10;
         ++decimalShift;
     }
-    SkASSERT(d > 0);
     // SkASSERT(value == (float)(d * pow(10.0, decimalShift)));
     unsigned char buffer[9]; // decimal value buffer.
     int bufferIndex = 0;
@@ -145,7 +303,29 @@ unsigned SkFloatToDecimal(float value, char output[kMaximumSkFloatToDecimalLengt
         d /= 10;
     } while (d != 0);
     SkASSERT(bufferIndex <= (int)sizeof(buffer) && bufferIndex > 0);
-    if (decimalShift >= 0) {
+    // The exponent of the leading digit, as in d.ddde<exponent>.
+    const int exponent = bufferIndex - 1 + decimalShift;
+    if (allowExponent && (exponent >= 21 || exponent < -6)) {
+        --bufferIndex;
+        *output_ptr++ = '0' + buffer[bufferIndex];
+        if (bufferIndex > 0) {
+            *output_ptr++ = '.';
+            while (bufferIndex > 0) {
+                --bufferIndex;
+                *output_ptr++ = '0' + buffer[bufferIndex];
+            }
+        }
+        *output_ptr++ = 'e';
+        int e = exponent;
+        if (e < 0) {
+            *output_ptr++ = '-';
+            e = -e;
+        }
+        if (e >= 10) {
+            *output_ptr++ = '0' + e / 10;
+        }
+        *output_ptr++ = '0' + e % 10;
+    } else if (decimalShift >= 0) {
         do {
             --bufferIndex;
             *output_ptr++ = '0' + buffer[bufferIndex];
@@ -171,14 +351,18 @@ unsigned SkFloatToDecimal(float value, char output[kMaximumSkFloatToDecimalLengt
         while (bufferIndex > 0) {
             --bufferIndex;
             *output_ptr++ = '0' + buffer[bufferIndex];
-            if (output_ptr == end) {
-                break;  // denormalized: don't need extra precision.
-                // Note: denormalized numbers will not have the same number of
-                // significantDigits, but do not need them to round-trip.
-            }
         }
     }
-    SkASSERT(output_ptr <= end);
+    // leave space for '\0'.
+    SkASSERT(output_ptr - output < (int)kMaximumSkFloatToDecimalLength);
     *output_ptr = '\0';
     return static_cast<unsigned>(output_ptr - output);
 }
+
+unsigned SkFloatToDecimal(float value, char output[kMaximumSkFloatToDecimalLength]) {
+    return float_to_string(value, output, false);
+}
+
+unsigned SkFloatToSVGScalar(float value, char output[kMaximumSkFloatToDecimalLength]) {
+    return float_to_string(value, output, true);
+}
@@ -18,6 +18,9 @@ constexpr unsigned kMaximumSkFloatToDecimalLength = 49;
     the original value if the value is finite. This function accepts all
     possible input values.
 
+    The digits are the shortest ones which round-trip; when there are several
+    candidates of that length, the one closest to the value is used.
+
     INFINITY and -INFINITY are rounded to FLT_MAX and -FLT_MAX.
 
     NAN values are converted to 0.
@@ -31,4 +34,15 @@ constexpr unsigned kMaximumSkFloatToDecimalLength = 49;
 */
 unsigned SkFloatToDecimal(float value, char output[kMaximumSkFloatToDecimalLength]);
 
+/** \fn SkFloatToSVGScalar
+    Like SkFloatToDecimal(), but uses scientific notation, e.g. "1.5e-7" or
+    "3e38", when the exponent of the leading digit is at least 21 or less
+    than -6, as JavaScript's Number.prototype.toString() does.  This keeps
+    very small and very large values short, for formats such as SVG which
+    accept an exponent (PDF does not).
+
+    @return strlen(output)
+*/
+unsigned SkFloatToSVGScalar(float value, char output[kMaximumSkFloatToDecimalLength]);
+
 #endif  // SkFloatToDecimal_DEFINED
@@ -0,0 +1,54 @@
+/*
+ * Copyright 2020 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "include/utils/SkParallelPicturePlayback.h"
+
+#include "include/core/SkCanvas.h"
+#include "include/core/SkExecutor.h"
+#include "include/core/SkPicture.h"
+#include "include/core/SkPixmap.h"
+#include "src/core/SkTaskGroup.h"
+
+bool SkParallelPicturePlayback::Draw(const SkPicture* picture, const SkPixmap& dst,
+                                     const SkMatrix& matrix, SkExecutor* executor,
+                                     SkISize tileSize, const SkSurfaceProps* props) {
+    if (!picture || !dst.addr() || dst.bounds().isEmpty()) {
+        return false;
+    }
+    const int tileW = SkTPin(tileSize.width(),  1, dst.width()),
+              tileH = SkTPin(tileSize.height(), 1, dst.height()),
+              tilesX = (dst.width()  + tileW - 1) / tileW,
+              tilesY = (dst.height() + tileH - 1) / tileH;
+
+    auto drawTile = [&](int i) {
+        SkIRect tile = SkIRect::MakeXYWH(i % tilesX * tileW, i / tilesX * tileH, tileW, tileH);
+        SkPixmap subset;
+        if (!dst.extractSubset(&subset, tile)) {
+            return;
+        }
+        // Each tile gets its own canvas, so no state is shared between tasks but the picture.
+        // Its clip is the tile, which SkBigPicture uses to query its BBH for the ops to replay.
+        std::unique_ptr<SkCanvas> canvas = SkCanvas::MakeRasterDirect(
+                subset.info(), subset.writable_addr(), subset.rowBytes(), props);
+        if (!canvas) {
+            return;
+        }
+        canvas->translate(-tile.fLeft, -tile.fTop);
+        canvas->concat(matrix);
+        picture->playback(canvas.get());
+    };
+
+    const int tiles = tilesX * tilesY;
+    if (tiles == 1) {
+        drawTile(0);
+        return true;
+    }
+    SkTaskGroup group(executor ? *executor : SkExecutor::GetDefault());
+    group.batch(tiles, drawTile);
+    group.wait();
+    return true;
+}
@@ -207,16 +207,11 @@ bool SkParsePath::FromSVGString(const char data[], SkPath* result) {
 #include "include/core/SkStream.h"
 #include "include/core/SkString.h"
 #include "src/core/SkGeometry.h"
+#include "src/utils/SkFloatToDecimal.h"
 
 static void write_scalar(SkWStream* stream, SkScalar value) {
-    char buffer[64];
-#ifdef SK_BUILD_FOR_WIN
-    int len = _snprintf(buffer, sizeof(buffer), "%g", value);
-#else
-    int len = snprintf(buffer, sizeof(buffer), "%g", value);
-#endif
-    char* stop = buffer + len;
-    stream->write(buffer, stop - buffer);
+    char buffer[kMaximumSkFloatToDecimalLength];
+    stream->write(buffer, SkFloatToSVGScalar(value, buffer));
 }
 
 static void append_scalars(SkWStream* stream, char verb, const SkScalar data[],
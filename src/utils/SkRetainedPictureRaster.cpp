@@ -0,0 +1,497 @@
+/*
+ * Copyright 2020 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "include/utils/SkRetainedPictureRaster.h"
+
+#include "include/core/SkCanvas.h"
+#include "include/core/SkTextBlob.h"
+#include "include/core/SkVertices.h"
+#include "include/private/SkFloatBits.h"
+#include "include/private/SkTemplates.h"
+#include "src/core/SkDrawShadowInfo.h"
+#include "src/core/SkOpts.h"
+#include "src/core/SkPicturePriv.h"
+#include "src/core/SkRecord.h"
+#include "src/core/SkRecordDraw.h"
+#include "src/core/SkRecorder.h"
+#include "src/core/SkRecords.h"
+
+#include <algorithm>
+#include <atomic>
+
+namespace {
+
+// Appends a key for each op to keys.  Two ops with the same key draw the same pixels.
+//
+// Besides the op itself, a key covers the matrix and clip the op is drawn under, as a hash chain
+// of the state ops since the start of the picture.  Saves push a link onto the chain, restores
+// pop it, so the ops after a save block only depend on what came before the block.
+//
+// Effects are compared by pointer, which is safe as long as both pictures are alive.  Images,
+// text blobs, vertices and pictures are immutable and compared by their unique IDs.  Paths are
+// compared by a hash of their contents, so a path rebuilt the same way in each picture matches.
+class KeyWriter {
+public:
+    explicit KeyWriter(std::vector<uint32_t>* keys) : fKeys(keys) {
+        fStates.push_back(0);
+    }
+
+    template <typename T>
+    void operator()(const T& op) {
+        const size_t start = fKeys->size();
+        this->write(fStates.back());
+        this->write((uint32_t)T::kType);
+        this->writeOp(op);
+
+        const uint32_t* words = fKeys->data() + start;
+        const size_t bytes = (fKeys->size() - start) * sizeof(uint32_t);
+        this->updateState(op, (uint64_t)SkOpts::hash(words, bytes, 0x9e3779b9) << 32
+                                        | SkOpts::hash(words, bytes, 0x7f4a7c15));
+    }
+
+private:
+    void write(uint32_t v) { fKeys->push_back(v); }
+    void write(int v)      { fKeys->push_back((uint32_t)v); }
+    void write(bool v)     { fKeys->push_back(v ? 1 : 0); }
+    void write(float v)    { fKeys->push_back(SkFloat2Bits(v)); }
+    void write(uint64_t v) { fKeys->push_back((uint32_t)v); fKeys->push_back((uint32_t)(v >> 32)); }
+    void write(const void* ptr) { this->write((uint64_t)(uintptr_t)ptr); }
+
+    void write(const float* v, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            this->write(v[i]);
+        }
+    }
+    void writeBytes(const void* data, size_t bytes) {
+        this->write((uint32_t)bytes);
+        const size_t start = fKeys->size();
+        fKeys->resize(start + (bytes + 3) / 4, 0);
+        memcpy(fKeys->data() + start, data, bytes);
+    }
+
+    void write(const SkRect& r)  { this->write(&r.fLeft, 4); }
+    void write(const SkIRect& r) { this->writeBytes(&r, sizeof(r)); }
+    void write(const SkMatrix& m) {
+        float v[9];
+        m.get9(v);
+        this->write(v, 9);
+    }
+    void write(const SkRRect& rr) {
+        float v[SkRRect::kSizeInMemory / sizeof(float)];
+        rr.writeToMemory(v);
+        this->write(v, SK_ARRAY_COUNT(v));
+    }
+    void write(const SkRegion& region) {
+        SkAutoTMalloc<char> storage(region.writeToMemory(nullptr));
+        this->writeBytes(storage.get(), region.writeToMemory(storage.get()));
+    }
+    void write(const SkPath& path) {
+        SkAutoTMalloc<char> storage(path.writeToMemory(nullptr));
+        const size_t bytes = path.writeToMemory(storage.get());
+        this->write((uint64_t)SkOpts::hash(storage.get(), bytes, 0x9e3779b9) << 32
+                             | SkOpts::hash(storage.get(), bytes, 0x7f4a7c15));
+    }
+    void write(const SkPaint& paint) {
+        const SkColor4f color = paint.getColor4f();
+        this->write(color.vec(), 4);
+        this->write(paint.getStrokeWidth());
+        this->write(paint.getStrokeMiter());
+        this->write((uint32_t)paint.getBlendMode()     |
+                    (uint32_t)paint.getStyle()      <<  8 |
+                    (uint32_t)paint.getStrokeCap()  << 10 |
+                    (uint32_t)paint.getStrokeJoin() << 12 |
+                    (uint32_t)paint.getFilterQuality() << 14 |
+                    (uint32_t)paint.isAntiAlias()   << 16 |
+                    (uint32_t)paint.isDither()      << 17);
+        this->write(paint.getShader());
+        this->write(paint.getColorFilter());
+        this->write(paint.getMaskFilter());
+        this->write(paint.getPathEffect());
+        this->write(paint.getImageFilter());
+    }
+    template <typename T>
+    void write(const SkRecords::Optional<T>& optional) {
+        this->write(optional != nullptr);
+        if (optional) {
+            this->write(*optional);
+        }
+    }
+    void write(const SkImage* image) { this->write(image ? image->uniqueID() : 0); }
+
+    // Ops we have no cheap way to compare get a key no other op will ever have.
+    template <typename T>
+    void writeOp(const T&) {
+        static std::atomic<uint32_t> gNextUnique{1};
+        this->write(gNextUnique.fetch_add(1, std::memory_order_relaxed));
+    }
+
+    void writeOp(const SkRecords::NoOp&)    {}
+    void writeOp(const SkRecords::Flush&)   {}
+    void writeOp(const SkRecords::Save&)    {}
+    void writeOp(const SkRecords::Restore&) {}
+    void writeOp(const SkRecords::SaveLayer& op) {
+        this->write(op.bounds);
+        this->write(op.paint);
+        this->write(op.backdrop.get());
+        this->write(op.clipMask.get());
+        this->write(op.clipMatrix);
+        this->write((uint32_t)op.saveLayerFlags);
+    }
+    void writeOp(const SkRecords::SaveBehind& op) { this->write(op.subset); }
+
+    void writeOp(const SkRecords::SetMatrix& op) { this->write(op.matrix); }
+    void writeOp(const SkRecords::Concat& op)    { this->write(op.matrix); }
+    void writeOp(const SkRecords::Concat44& op) {
+        float v[16];
+        op.matrix.getColMajor(v);
+        this->write(v, 16);
+    }
+    void writeOp(const SkRecords::Translate& op) { this->write(op.dx); this->write(op.dy); }
+    void writeOp(const SkRecords::Scale& op)     { this->write(op.sx); this->write(op.sy); }
+
+    void writeOp(const SkRecords::ClipPath& op) {
+        this->write(op.path);
+        this->write((uint32_t)op.opAA.op());
+        this->write(op.opAA.aa());
+    }
+    void writeOp(const SkRecords::ClipRRect& op) {
+        this->write(op.rrect);
+        this->write((uint32_t)op.opAA.op());
+        this->write(op.opAA.aa());
+    }
+    void writeOp(const SkRecords::ClipRect& op) {
+        this->write(op.rect);
+        this->write((uint32_t)op.opAA.op());
+        this->write(op.opAA.aa());
+    }
+    void writeOp(const SkRecords::ClipRegion& op) {
+        this->write(op.region);
+        this->write((uint32_t)op.op);
+    }
+    void writeOp(const SkRecords::ClipShader& op) {
+        this->write(op.shader.get());
+        this->write((uint32_t)op.op);
+    }
+
+    void writeOp(const SkRecords::DrawArc& op) {
+        this->write(op.paint);
+        this->write(op.oval);
+        this->write(op.startAngle);
+        this->write(op.sweepAngle);
+        this->write((uint32_t)op.useCenter);
+    }
+    void writeOp(const SkRecords::DrawDRRect& op) {
+        this->write(op.paint);
+        this->write(op.outer);
+        this->write(op.inner);
+    }
+    void writeOp(const SkRecords::DrawImage& op) {
+        this->write(op.paint);
+        this->write(op.image.get());
+        this->write(op.left);
+        this->write(op.top);
+    }
+    void writeOp(const SkRecords::DrawImageRect& op) {
+        this->write(op.paint);
+        this->write(op.image.get());
+        this->write(op.src);
+        this->write(op.dst);
+        this->write((uint32_t)op.constraint);
+    }
+    void writeOp(const SkRecords::DrawImageNine& op) {
+        this->write(op.paint);
+        this->write(op.image.get());
+        this->write(op.center);
+        this->write(op.dst);
+    }
+    void writeOp(const SkRecords::DrawOval& op)   { this->write(op.paint); this->write(op.oval); }
+    void writeOp(const SkRecords::DrawPaint& op)  { this->write(op.paint); }
+    void writeOp(const SkRecords::DrawBehind& op) { this->write(op.paint); }
+    void writeOp(const SkRecords::DrawPath& op)   { this->write(op.paint); this->write(op.path); }
+    void writeOp(const SkRecords::DrawPicture& op) {
+        this->write(op.paint);
+        this->write(op.picture->uniqueID());
+        this->write(op.matrix);
+    }
+    void writeOp(const SkRecords::DrawPoints& op) {
+        this->write(op.paint);
+        this->write((uint32_t)op.mode);
+        this->write(&op.pts->fX, 2 * op.count);
+    }
+    void writeOp(const SkRecords::DrawRRect& op)  { this->write(op.paint); this->write(op.rrect); }
+    void writeOp(const SkRecords::DrawRect& op)   { this->write(op.paint); this->write(op.rect); }
+    void writeOp(const SkRecords::DrawRegion& op) { this->write(op.paint); this->write(op.region); }
+    void writeOp(const SkRecords::DrawTextBlob& op) {
+        this->write(op.paint);
+        this->write(op.blob->uniqueID());
+        this->write(op.x);
+        this->write(op.y);
+    }
+    void writeOp(const SkRecords::DrawVertices& op) {
+        this->write(op.paint);
+        this->write(op.vertices->uniqueID());
+        this->write((uint32_t)op.bmode);
+    }
+    void writeOp(const SkRecords::DrawShadowRec& op) {
+        this->write(op.path);
+        this->write(&op.rec.fZPlaneParams.fX, 3);
+        this->write(&op.rec.fLightPos.fX, 3);
+        this->write(op.rec.fLightRadius);
+        this->write(op.rec.fAmbientColor);
+        this->write(op.rec.fSpotColor);
+        this->write(op.rec.fFlags);
+    }
+    void writeOp(const SkRecords::DrawAnnotation& op) {
+        this->write(op.rect);
+        this->writeBytes(op.key.c_str(), op.key.size());
+        this->write(op.value.get());
+    }
+    void writeOp(const SkRecords::DrawEdgeAAQuad& op) {
+        this->write(op.rect);
+        this->write(op.clip != nullptr);
+        if (op.clip) {
+            this->write(&op.clip->fX, 8);
+        }
+        this->write((uint32_t)op.aa);
+        this->write(op.color.vec(), 4);
+        this->write((uint32_t)op.mode);
+    }
+
+    void push(uint64_t hash) { fStates.push_back(hash); }
+    void mix (uint64_t hash) { fStates.back() = hash; }
+
+    template <typename T>
+    void updateState(const T&, uint64_t) {}
+
+    void updateState(const SkRecords::Save&,       uint64_t hash) { this->push(hash); }
+    void updateState(const SkRecords::SaveLayer&,  uint64_t hash) { this->push(hash); }
+    void updateState(const SkRecords::SaveBehind&, uint64_t hash) { this->push(hash); }
+    void updateState(const SkRecords::Restore&, uint64_t) {
+        // An unbalanced restore is ignored by the canvas, so we do the same.
+        if (fStates.size() > 1) {
+            fStates.pop_back();
+        }
+    }
+    void updateState(const SkRecords::SetMatrix&,  uint64_t hash) { this->mix(hash); }
+    void updateState(const SkRecords::Concat&,     uint64_t hash) { this->mix(hash); }
+    void updateState(const SkRecords::Concat44&,   uint64_t hash) { this->mix(hash); }
+    void updateState(const SkRecords::Translate&,  uint64_t hash) { this->mix(hash); }
+    void updateState(const SkRecords::Scale&,      uint64_t hash) { this->mix(hash); }
+    void updateState(const SkRecords::ClipPath&,   uint64_t hash) { this->mix(hash); }
+    void updateState(const SkRecords::ClipRRect&,  uint64_t hash) { this->mix(hash); }
+    void updateState(const SkRecords::ClipRect&,   uint64_t hash) { this->mix(hash); }
+    void updateState(const SkRecords::ClipRegion&, uint64_t hash) { this->mix(hash); }
+    void updateState(const SkRecords::ClipShader&, uint64_t hash) { this->mix(hash); }
+
+    std::vector<uint32_t>* fKeys;
+    std::vector<uint64_t>  fStates;
+};
+
+// Past this many changed ops we stop building an exact region and damage their bounding box.
+static constexpr int kMaxDamageRects = 64;
+
+}  // namespace
+
+class SkRetainedPictureRaster::Fingerprint {
+public:
+    explicit Fingerprint(const SkPicture& picture) {
+        sk_sp<SkRecord> rerecorded;
+        const SkRecord* record;
+        if (const SkBigPicture* big = SkPicturePriv::AsSkBigPicture(sk_ref_sp(&picture))) {
+            record = big->record();
+        } else {
+            rerecorded = sk_make_sp<SkRecord>();
+            SkRecorder recorder(rerecorded.get(), picture.cullRect());
+            picture.playback(&recorder);
+            record = rerecorded.get();
+        }
+
+        fCount = record->count();
+        fBounds.reset(fCount);
+        fBarriers.reset(fCount);
+        SkAutoTArray<SkBBoxHierarchy::Metadata> meta(fCount);
+        SkAutoTArray<SkRect> occluders(fCount);
+        SkRecordFillBounds(picture.cullRect(), *record, fBounds.get(), meta.get());
+        SkRecordFillOccluders(*record, occluders.get(), fBarriers.get());
+
+        fOffsets.reserve(fCount + 1);
+        KeyWriter writer(&fKeys);
+        for (int i = 0; i < fCount; i++) {
+            fOffsets.push_back(fKeys.size());
+            record->visit(i, writer);
+        }
+        fOffsets.push_back(fKeys.size());
+    }
+
+    // Returns the damage from this picture's ops to after's, mapped by matrix.
+    SkRegion damage(const Fingerprint& after, const SkMatrix& matrix) const {
+        const int common = std::min(fCount, after.fCount);
+        int prefix = 0;
+        while (prefix < common && this->sameOp(prefix, after, prefix)) {
+            prefix++;
+        }
+        int suffix = 0;
+        while (prefix + suffix < common &&
+               this->sameOp(fCount - 1 - suffix, after, after.fCount - 1 - suffix)) {
+            suffix++;
+        }
+
+        std::vector<SkIRect> rects;
+        auto add = [&](const SkRect& bounds) {
+            SkIRect r = matrix.mapRect(bounds).roundOut();
+            if (!r.isEmpty()) {
+                rects.push_back(r);
+            }
+        };
+        for (int i = prefix; i < fCount - suffix; i++) {
+            add(fBounds[i]);
+        }
+        for (int i = prefix; i < after.fCount - suffix; i++) {
+            add(after.fBounds[i]);
+        }
+
+        SkRegion damage;
+        if ((int)rects.size() <= kMaxDamageRects) {
+            for (const SkIRect& r : rects) {
+                damage.op(r, SkRegion::kUnion_Op);
+            }
+        } else {
+            SkIRect r = SkIRect::MakeEmpty();
+            for (const SkIRect& rect : rects) {
+                r.join(rect);
+            }
+            damage.setRect(r);
+        }
+
+        // Unchanged ops which read back what was drawn before them, like layers with a backdrop
+        // filter, are damaged wherever they overlap the damage.
+        for (int i = after.fCount - suffix; i < after.fCount; i++) {
+            if (after.fBarriers[i]) {
+                SkIRect r = matrix.mapRect(after.fBounds[i]).roundOut();
+                if (damage.intersects(r)) {
+                    damage.op(r, SkRegion::kUnion_Op);
+                }
+            }
+        }
+        return damage;
+    }
+
+private:
+    bool sameOp(int i, const Fingerprint& that, int j) const {
+        const size_t size = fOffsets[i + 1] - fOffsets[i];
+        return size == that.fOffsets[j + 1] - that.fOffsets[j] &&
+               0 == memcmp(fKeys.data() + fOffsets[i], that.fKeys.data() + that.fOffsets[j],
+                           size * sizeof(uint32_t));
+    }
+
+    int                   fCount;
+    SkAutoTArray<SkRect>  fBounds;
+    SkAutoTArray<bool>    fBarriers;
+    // The key of op i is fKeys[fOffsets[i], fOffsets[i+1]).
+    std::vector<uint32_t> fKeys;
+    std::vector<size_t>   fOffsets;
+};
+
+SkRetainedPictureRaster::SkRetainedPictureRaster(const SkImageInfo& info, const SkMatrix& matrix,
+                                                 int tileSize)
+    : fInfo(info)
+    , fMatrix(matrix)
+    , fTileSize(std::max(tileSize, 1))
+    , fTileCountX((info.width()  + fTileSize - 1) / fTileSize)
+    , fTileCountY((info.height() + fTileSize - 1) / fTileSize)
+    , fTiles(fTileCountX * fTileCountY) {}
+
+SkRetainedPictureRaster::~SkRetainedPictureRaster() = default;
+
+void SkRetainedPictureRaster::update(sk_sp<SkPicture> picture, const SkRegion& damage) {
+    SkASSERT(picture);
+    this->drawTiles(*picture, damage);
+    fPicture = std::move(picture);
+    fFingerprint.reset();
+}
+
+SkRegion SkRetainedPictureRaster::update(sk_sp<SkPicture> picture) {
+    SkASSERT(picture);
+    SkRegion damage(fInfo.bounds());
+    if (fPicture) {
+        if (!fFingerprint) {
+            fFingerprint.reset(new Fingerprint(*fPicture));
+        }
+        std::unique_ptr<Fingerprint> next(new Fingerprint(*picture));
+        damage.op(fFingerprint->damage(*next, fMatrix), SkRegion::kIntersect_Op);
+        fFingerprint = std::move(next);
+    }
+    this->drawTiles(*picture, damage);
+    fPicture = std::move(picture);
+    return damage;
+}
+
+void SkRetainedPictureRaster::drawTiles(const SkPicture& picture, const SkRegion& damage) {
+    SkRegion clipped;
+    if (!clipped.op(damage, fInfo.bounds(), SkRegion::kIntersect_Op)) {
+        return;
+    }
+    const SkIRect& bounds = clipped.getBounds();
+    for (int y = bounds.fTop / fTileSize; y <= (bounds.fBottom - 1) / fTileSize; y++) {
+        for (int x = bounds.fLeft / fTileSize; x <= (bounds.fRight - 1) / fTileSize; x++) {
+            SkIRect tileRect = SkIRect::MakeXYWH(x * fTileSize, y * fTileSize,
+                                                 fTileSize, fTileSize);
+            tileRect.intersect(fInfo.bounds());
+            SkRegion tileDamage;
+            if (!tileDamage.op(clipped, tileRect, SkRegion::kIntersect_Op)) {
+                continue;
+            }
+
+            SkBitmap& tile = fTiles[y * fTileCountX + x];
+            if (tile.isNull()) {
+                if (!tile.tryAllocPixels(fInfo.makeWH(tileRect.width(), tileRect.height()))) {
+                    continue;
+                }
+                tile.eraseColor(SK_ColorTRANSPARENT);
+            }
+
+            // The picture's bounding box hierarchy, if any, culls the ops outside of the clip.
+            tileDamage.translate(-tileRect.fLeft, -tileRect.fTop);
+            SkCanvas canvas(tile);
+            canvas.clipRegion(tileDamage);
+            canvas.clear(SK_ColorTRANSPARENT);
+            canvas.translate(-tileRect.fLeft, -tileRect.fTop);
+            canvas.concat(fMatrix);
+            picture.playback(&canvas);
+        }
+    }
+}
+
+void SkRetainedPictureRaster::draw(SkCanvas* canvas, SkScalar x, SkScalar y,
+                                   const SkPaint* paint) const {
+    for (int ty = 0; ty < fTileCountY; ty++) {
+        for (int tx = 0; tx < fTileCountX; tx++) {
+            const SkBitmap& tile = fTiles[ty * fTileCountX + tx];
+            if (!tile.isNull()) {
+                canvas->drawBitmap(tile, x + tx * fTileSize, y + ty * fTileSize, paint);
+            }
+        }
+    }
+}
+
+void SkRetainedPictureRaster::readPixels(SkBitmap* dst) const {
+    dst->allocPixels(fInfo);
+    dst->eraseColor(SK_ColorTRANSPARENT);
+    for (int ty = 0; ty < fTileCountY; ty++) {
+        for (int tx = 0; tx < fTileCountX; tx++) {
+            const SkBitmap& tile = fTiles[ty * fTileCountX + tx];
+            if (!tile.isNull()) {
+                dst->writePixels(tile.pixmap(), tx * fTileSize, ty * fTileSize);
+            }
+        }
+    }
+}
+
+SkRegion SkRetainedPictureRaster::ComputeDamage(const SkPicture& before, const SkPicture& after,
+                                                const SkMatrix& matrix) {
+    return Fingerprint(before).damage(Fingerprint(after), matrix);
+}
@@ -9,6 +9,7 @@
 
 #include "include/core/SkStream.h"
 #include "include/private/SkTo.h"
+#include "src/utils/SkFloatToDecimal.h"
 
 SkXMLWriter::SkXMLWriter(bool doEscapeMarkup) : fDoEscapeMarkup(doEscapeMarkup)
 {}
@@ -40,9 +41,9 @@ void SkXMLWriter::addHexAttribute(const char name[], uint32_t value, int minDigi
 }
 
 void SkXMLWriter::addScalarAttribute(const char name[], SkScalar value) {
-    SkString    tmp;
-    tmp.appendScalar(value);
-    this->addAttribute(name, tmp.c_str());
+    char tmp[kMaximumSkFloatToDecimalLength];
+    SkFloatToSVGScalar(value, tmp);
+    this->addAttribute(name, tmp);
 }
 
 void SkXMLWriter::addText(const char text[], size_t length) {
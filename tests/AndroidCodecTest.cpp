@@ -16,8 +16,10 @@
 #include "include/core/SkImageInfo.h"
 #include "include/core/SkRefCnt.h"
 #include "include/core/SkSize.h"
+#include "include/core/SkStream.h"
 #include "include/core/SkString.h"
 #include "include/core/SkTypes.h"
+#include "include/encode/SkPngEncoder.h"
 #include "include/third_party/skcms/skcms.h"
 #include "src/codec/SkCodecImageGenerator.h"
 #include "src/core/SkPixmapPriv.h"
@@ -299,3 +301,214 @@ DEF_TEST(AndroidCodec_sampledOrientation, r) {
         ERRORF(r, "got result \"%s\"\n", SkCodec::ResultToString(result));
     }
 }
+
+static sk_sp<SkData> encode_png(const SkBitmap& bm) {
+    SkDynamicMemoryWStream stream;
+    if (!SkPngEncoder::Encode(&stream, bm.pixmap(), {})) {
+        return nullptr;
+    }
+    return stream.detachAsData();
+}
+
+DEF_TEST(AndroidCodec_downscaleFilter, r) {
+    // Each 2x2 block is one color, so a box filter to half size reproduces the blocks.
+    const SkColor colors[] = { SK_ColorRED, SK_ColorGREEN, SK_ColorBLUE,
+                               SK_ColorWHITE, SK_ColorBLACK, 0xFF336699 };
+    SkBitmap src;
+    src.allocPixels(SkImageInfo::MakeN32Premul(6, 4));
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 6; x++) {
+            *src.getAddr32(x, y) = SkPreMultiplyColor(colors[(y / 2) * 3 + x / 2]);
+        }
+    }
+    auto data = encode_png(src);
+    REPORTER_ASSERT(r, data);
+    if (!data) {
+        return;
+    }
+
+    auto codec = SkAndroidCodec::MakeFromData(data);
+    REPORTER_ASSERT(r, codec);
+    if (!codec) {
+        return;
+    }
+
+    SkAndroidCodec::AndroidOptions options;
+    options.fDownscaleFilter = SkAndroidCodec::DownscaleFilter::kBox;
+    SkBitmap dst;
+    dst.allocPixels(codec->getInfo().makeWH(3, 2));
+    auto result = codec->getAndroidPixels(dst.info(), dst.getPixels(), dst.rowBytes(), &options);
+    REPORTER_ASSERT(r, SkCodec::kSuccess == result);
+    for (int y = 0; y < 2; y++) {
+        for (int x = 0; x < 3; x++) {
+            REPORTER_ASSERT(r, dst.getColor(x, y) == colors[y * 3 + x],
+                            "(%d, %d) is %08x", x, y, dst.getColor(x, y));
+        }
+    }
+
+    // Both filters keep a solid subset solid, at any smaller size.
+    SkIRect subset = SkIRect::MakeXYWH(2, 0, 2, 2);
+    options.fSubset = &subset;
+    for (auto filter : { SkAndroidCodec::DownscaleFilter::kBox,
+                         SkAndroidCodec::DownscaleFilter::kTriangle }) {
+        options.fDownscaleFilter = filter;
+        dst.allocPixels(codec->getInfo().makeWH(1, 2));
+        result = codec->getAndroidPixels(dst.info(), dst.getPixels(), dst.rowBytes(), &options);
+        REPORTER_ASSERT(r, SkCodec::kSuccess == result);
+        REPORTER_ASSERT(r, dst.getColor(0, 0) == SK_ColorGREEN);
+        REPORTER_ASSERT(r, dst.getColor(0, 1) == SK_ColorGREEN);
+
+        // Filters only shrink.
+        dst.allocPixels(codec->getInfo().makeWH(3, 2));
+        result = codec->getAndroidPixels(dst.info(), dst.getPixels(), dst.rowBytes(), &options);
+        REPORTER_ASSERT(r, SkCodec::kInvalidScale == result);
+    }
+
+    // SkCodecImageGenerator uses the triangle filter for sizes the codec can't decode directly.
+    options.fSubset = nullptr;
+    options.fDownscaleFilter = SkAndroidCodec::DownscaleFilter::kTriangle;
+    dst.allocPixels(codec->getInfo().makeWH(3, 2));
+    result = codec->getAndroidPixels(dst.info(), dst.getPixels(), dst.rowBytes(), &options);
+    REPORTER_ASSERT(r, SkCodec::kSuccess == result);
+
+    auto gen = SkCodecImageGenerator::MakeFromEncodedCodec(data);
+    REPORTER_ASSERT(r, gen);
+    if (gen) {
+        SkBitmap fromGenerator;
+        fromGenerator.allocPixels(dst.info());
+        REPORTER_ASSERT(r, gen->getPixels(fromGenerator.info(), fromGenerator.getPixels(),
+                                          fromGenerator.rowBytes()));
+        REPORTER_ASSERT(r, 0 == memcmp(dst.getPixels(), fromGenerator.getPixels(),
+                                       dst.computeByteSize()));
+    }
+}
+
+// Downscales |codec| and a PNG of its decode at full size; the PNG streams its rows in order, so
+// the two agree whichever path (scanlines, flipped rows, or a whole image decode) |codec| takes.
+static void check_downscale_matches_png(skiatest::Reporter* r, const char* path,
+                                        SkAndroidCodec* codec, SkIRect* subset) {
+    const SkImageInfo info = codec->getInfo().makeColorType(kN32_SkColorType)
+                                             .makeAlphaType(kPremul_SkAlphaType)
+                                             .makeColorSpace(nullptr);
+    const SkIRect bounds = subset ? *subset : info.bounds();
+    SkBitmap full;
+    full.allocPixels(info);
+    auto result = codec->getAndroidPixels(info, full.getPixels(), full.rowBytes());
+    REPORTER_ASSERT(r, SkCodec::kSuccess == result, "%s: %s", path,
+                    SkCodec::ResultToString(result));
+
+    // libjpeg upsamples the edges of a horizontal subset differently, so take top down subsets
+    // from the codec.  Other rows can only be subset by cropping the full image.
+    SkBitmap reference;
+    if (subset && SkCodec::kTopDown_SkScanlineOrder == codec->codec()->getScanlineOrder()) {
+        SkAndroidCodec::AndroidOptions options;
+        options.fSubset = subset;
+        reference.allocPixels(info.makeDimensions(bounds.size()));
+        result = codec->getAndroidPixels(reference.info(), reference.getPixels(),
+                                         reference.rowBytes(), &options);
+        REPORTER_ASSERT(r, SkCodec::kSuccess == result);
+    } else {
+        REPORTER_ASSERT(r, full.extractSubset(&reference, bounds));
+    }
+    auto png = SkAndroidCodec::MakeFromData(encode_png(reference));
+    REPORTER_ASSERT(r, png);
+    if (!png) {
+        return;
+    }
+
+    const SkImageInfo dstInfo = info.makeWH(bounds.width() * 2 / 3, bounds.height() * 2 / 3);
+    for (auto filter : { SkAndroidCodec::DownscaleFilter::kBox,
+                         SkAndroidCodec::DownscaleFilter::kTriangle }) {
+        SkAndroidCodec::AndroidOptions options;
+        options.fSubset = subset;
+        options.fDownscaleFilter = filter;
+        SkBitmap actual, expected;
+        actual.allocPixels(dstInfo);
+        expected.allocPixels(dstInfo);
+        result = codec->getAndroidPixels(dstInfo, actual.getPixels(), actual.rowBytes(),
+                                         &options);
+        REPORTER_ASSERT(r, SkCodec::kSuccess == result, "%s: %s", path,
+                        SkCodec::ResultToString(result));
+        options.fSubset = nullptr;
+        result = png->getAndroidPixels(dstInfo, expected.getPixels(), expected.rowBytes(),
+                                       &options);
+        REPORTER_ASSERT(r, SkCodec::kSuccess == result);
+
+        int mismatches = 0;
+        for (int y = 0; y < dstInfo.height(); y++) {
+            for (int x = 0; x < dstInfo.width(); x++) {
+                const uint8_t* a = static_cast<const uint8_t*>(actual.getAddr(x, y));
+                const uint8_t* e = static_cast<const uint8_t*>(expected.getAddr(x, y));
+                for (int i = 0; i < 4; i++) {
+                    if (SkTAbs(a[i] - e[i]) > 1) {
+                        mismatches++;
+                        break;
+                    }
+                }
+            }
+        }
+        REPORTER_ASSERT(r, 0 == mismatches, "%s, filter %d, subset %s: %d pixels differ", path,
+                        (int) filter, subset ? "yes" : "no", mismatches);
+    }
+}
+
+DEF_TEST(AndroidCodec_downscaleFilterPaths, r) {
+    for (const char* path : { "images/mandrill_512_q075.jpg",  // scanlines
+                              "images/bitfields32.bmp",        // bottom up rows
+                              "images/rle.bmp",                // rows out of order
+                              "images/plane_interlaced.png",   // whole image decode
+                              "images/color_wheel.gif" }) {
+        auto codec = SkAndroidCodec::MakeFromData(GetResourceAsData(path));
+        if (!codec) {
+            // Not every build decodes every format.
+            continue;
+        }
+        check_downscale_matches_png(r, path, codec.get(), nullptr);
+
+        // A subset away from every edge; bottom up rows fall back to a whole image decode.
+        const SkISize dims = codec->getInfo().dimensions();
+        SkIRect subset = SkIRect::MakeLTRB(dims.width() / 4, dims.height() / 4,
+                                           dims.width() * 3 / 4, dims.height() * 3 / 4);
+        if (!codec->getSupportedSubset(&subset)) {
+            continue;
+        }
+        check_downscale_matches_png(r, path, codec.get(), &subset);
+    }
+}
+
+DEF_TEST(AndroidCodec_downscaleFilterIncomplete, r) {
+    const char* path = "images/mandrill_512_q075.jpg";
+    auto data = GetResourceAsData(path);
+    if (!data) {
+        ERRORF(r, "Missing resource %s", path);
+        return;
+    }
+    auto codec = SkAndroidCodec::MakeFromData(SkData::MakeSubset(data.get(), 0,
+                                                                 data->size() / 2));
+    REPORTER_ASSERT(r, codec);
+    if (!codec) {
+        return;
+    }
+
+    SkAndroidCodec::AndroidOptions options;
+    options.fDownscaleFilter = SkAndroidCodec::DownscaleFilter::kTriangle;
+    SkBitmap dst;
+    dst.allocPixels(codec->getInfo().makeColorType(kN32_SkColorType)
+                                    .makeAlphaType(kPremul_SkAlphaType)
+                                    .makeWH(300, 300));
+    const SkColor sentinel = 0xFF123456;
+    dst.eraseColor(sentinel);
+    auto result = codec->getAndroidPixels(dst.info(), dst.getPixels(), dst.rowBytes(), &options);
+    REPORTER_ASSERT(r, SkCodec::kIncompleteInput == result, "%s",
+                    SkCodec::ResultToString(result));
+
+    // The rows that were decoded are written, and the rest are filled rather than left as is.
+    for (int y : { 0, dst.height() - 1 }) {
+        for (int x = 0; x < dst.width(); x++) {
+            if (dst.getColor(x, y) == sentinel) {
+                ERRORF(r, "(%d, %d) was not written", x, y);
+                return;
+            }
+        }
+    }
+}
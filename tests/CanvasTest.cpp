@@ -12,6 +12,7 @@
 #include "include/core/SkColor.h"
 #include "include/core/SkDocument.h"
 #include "include/core/SkFlattenable.h"
+#include "include/core/SkImage.h"
 #include "include/core/SkImageFilter.h"
 #include "include/core/SkImageInfo.h"
 #include "include/core/SkMatrix.h"
@@ -680,3 +681,79 @@ DEF_TEST(Canvas_ClippedOutImageFilter, reporter) {
     REPORTER_ASSERT(reporter, preCTM == postCTM);
 }
 
+// The raster device draws image sets itself; it should match drawing each entry on its own.
+DEF_TEST(Canvas_DrawEdgeAAImageSet_Raster, reporter) {
+    auto make_image = [](int w, int h, SkColor seed) {
+        SkBitmap bitmap;
+        bitmap.allocN32Pixels(w, h, true);
+        for (int y = 0; y < h; ++y) {
+            for (int x = 0; x < w; ++x) {
+                *bitmap.getAddr32(x, y) = SkPreMultiplyColor(seed ^ (x * 0x10307 + y * 0x70103));
+            }
+        }
+        bitmap.setImmutable();
+        return SkImage::MakeFromBitmap(bitmap);
+    };
+    sk_sp<SkImage> a = make_image(64, 64, 0xFF204080),
+                   b = make_image(16, 16, 0xFF804020);
+
+    const SkMatrix preViewMatrices[] = { SkMatrix::MakeTrans(5, 5), SkMatrix::MakeScale(1.5f) };
+    const SkPoint dstClips[] = { {100, 0}, {128, 4}, {124, 32}, {100, 28} };
+    SkCanvas::ImageSetEntry set[] = {
+        // Unscaled and pixel aligned, with and without alpha, and under a translate.
+        {a, SkRect::MakeLTRB(0, 0, 32, 32), SkRect::MakeLTRB(0, 0, 32, 32), -1, 1.0f,
+         SkCanvas::kAll_QuadAAFlags, false},
+        {a, SkRect::MakeLTRB(32, 0, 64, 32), SkRect::MakeLTRB(40, 0, 72, 32), -1, 0.5f,
+         SkCanvas::kNone_QuadAAFlags, false},
+        {b, SkRect::MakeWH(16, 16), SkRect::MakeXYWH(80, 80, 16, 16), 0, 1.0f,
+         SkCanvas::kAll_QuadAAFlags, false},
+        // Scaled, fractional, or clipped.
+        {a, SkRect::MakeLTRB(0, 32, 32, 64), SkRect::MakeLTRB(0, 40, 48, 88), -1, 1.0f,
+         SkCanvas::kAll_QuadAAFlags, false},
+        {b, SkRect::MakeWH(16, 16), SkRect::MakeXYWH(10, 70, 16, 16), 1, 0.75f,
+         SkCanvas::kAll_QuadAAFlags, false},
+        {b, SkRect::MakeWH(16, 16), SkRect::MakeXYWH(60.5f, 100, 16, 16), -1, 1.0f,
+         SkCanvas::kNone_QuadAAFlags, false},
+        {a, SkRect::MakeWH(32, 32), SkRect::MakeXYWH(100, 0, 32, 32), -1, 1.0f,
+         SkCanvas::kAll_QuadAAFlags, true},
+    };
+    const int count = SK_ARRAY_COUNT(set);
+
+    SkPaint paint;
+    paint.setFilterQuality(kLow_SkFilterQuality);
+    paint.setAntiAlias(true);
+
+    SkBitmap batched, separate;
+    batched.allocN32Pixels(150, 150);
+    separate.allocN32Pixels(150, 150);
+    batched.eraseColor(SK_ColorWHITE);
+    separate.eraseColor(SK_ColorWHITE);
+
+    SkCanvas batchedCanvas(batched);
+    batchedCanvas.translate(3, 2);
+    batchedCanvas.experimental_DrawEdgeAAImageSet(set, count, dstClips, preViewMatrices, &paint,
+                                                  SkCanvas::kStrict_SrcRectConstraint);
+
+    SkCanvas separateCanvas(separate);
+    separateCanvas.translate(3, 2);
+    for (const SkCanvas::ImageSetEntry& entry : set) {
+        SkPaint entryPaint = paint;
+        entryPaint.setAntiAlias(entry.fAAFlags == SkCanvas::kAll_QuadAAFlags);
+        entryPaint.setAlphaf(entry.fAlpha);
+        separateCanvas.save();
+        if (entry.fMatrixIndex >= 0) {
+            separateCanvas.concat(preViewMatrices[entry.fMatrixIndex]);
+        }
+        if (entry.fHasClip) {
+            SkPath clip;
+            clip.addPoly(dstClips, 4, true);
+            separateCanvas.clipPath(clip, entryPaint.isAntiAlias());
+        }
+        separateCanvas.drawImageRect(entry.fImage.get(), entry.fSrcRect, entry.fDstRect, &entryPaint,
+                                     SkCanvas::kStrict_SrcRectConstraint);
+        separateCanvas.restore();
+    }
+
+    REPORTER_ASSERT(reporter, 0 == memcmp(batched.getPixels(), separate.getPixels(),
+                                          batched.computeByteSize()));
+}
@@ -5,6 +5,7 @@
  * found in the LICENSE file.
  */
 
+#include "include/android/SkBitmapRegionDecoder.h"
 #include "include/codec/SkAndroidCodec.h"
 #include "include/codec/SkCodec.h"
 #include "include/core/SkBitmap.h"
@@ -13,6 +14,7 @@
 #include "include/core/SkColorSpace.h"
 #include "include/core/SkData.h"
 #include "include/core/SkEncodedImageFormat.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkImage.h"
 #include "include/core/SkImageEncoder.h"
 #include "include/core/SkImageGenerator.h"
@@ -35,6 +37,8 @@
 #include "include/utils/SkFrontBufferedStream.h"
 #include "include/utils/SkRandom.h"
 #include "src/codec/SkCodecImageGenerator.h"
+#include "src/codec/SkJpegRestartIndex.h"
+#include "src/codec/SkTiledImageGenerator.h"
 #include "src/core/SkAutoMalloc.h"
 #include "src/core/SkColorSpacePriv.h"
 #include "src/core/SkMD5.h"
@@ -1011,6 +1015,204 @@ DEF_TEST(Codec_jpeg_rewind, r) {
     REPORTER_ASSERT(r, SkCodec::kIncompleteInput == result);
 }
 
+DEF_TEST(Codec_jpeg_parallel, r) {
+    // mandrill_cmyk.jpg (4:4:4) and mandrill_h2v2_restart.jpg (4:2:0, with partial MCUs at the
+    // right and bottom) have a restart marker every MCU row, and are split into bands.
+    // mandrill_512_q075.jpg has none, and falls back to a serial decode.
+    auto executor = SkExecutor::MakeFIFOThreadPool(4);
+    const struct {
+        const char* path;
+        bool        banded;
+    } recs[] = {
+        { "images/mandrill_cmyk.jpg",           true  },
+        { "images/mandrill_h2v2_restart.jpg",   true  },
+        { "images/mandrill_512_q075.jpg",       false },
+    };
+    for (const auto& rec : recs) {
+        const char* path = rec.path;
+        sk_sp<SkData> data(GetResourceAsData(path));
+        if (!data) {
+            continue;
+        }
+        std::unique_ptr<SkCodec> codec(SkCodec::MakeFromData(data));
+        if (!codec) {
+            ERRORF(r, "Unable to create codec '%s'.", path);
+            continue;
+        }
+
+        for (float scale : { 1.0f, 0.5f }) {
+            for (SkColorType ct : { kN32_SkColorType, kRGB_565_SkColorType }) {
+                SkImageInfo info = codec->getInfo().makeDimensions(codec->getScaledDimensions(scale))
+                                                   .makeColorType(ct);
+                SkBitmap serial, parallel;
+                serial.allocPixels(info);
+                parallel.allocPixels(info);
+
+                REPORTER_ASSERT(r, SkCodec::kSuccess ==
+                                   codec->getPixels(info, serial.getPixels(), serial.rowBytes()));
+                SkCodec::Options options;
+                options.fExecutor = executor.get();
+                const int bandsBefore = SkJpegRestartIndex::BandsMadeForTesting();
+                REPORTER_ASSERT(r, SkCodec::kSuccess ==
+                                   codec->getPixels(info, parallel.getPixels(),
+                                                    parallel.rowBytes(), &options));
+                if (rec.banded) {
+                    REPORTER_ASSERT(r, SkJpegRestartIndex::BandsMadeForTesting() > bandsBefore,
+                                    "%s was not decoded in bands", path);
+                }
+                REPORTER_ASSERT(r, ToolUtils::equal_pixels(serial, parallel), "%s", path);
+            }
+        }
+    }
+}
+
+DEF_TEST(Codec_tiledImageGenerator, r) {
+    // icc-v2-gbr.jpg and wide_gamut_yellow_224_224_64.jpeg have restart markers, so their tiles
+    // are decoded from bands of them.  mandrill_cmyk.jpg has them too, but a CMYK profile.
+    for (const char* path : { "images/icc-v2-gbr.jpg", "images/mandrill_cmyk.jpg",
+                              "images/wide_gamut_yellow_224_224_64.jpeg",
+                              "images/mandrill_512_q075.jpg",
+                              "images/mandrill_512.png" }) {
+        sk_sp<SkData> data(GetResourceAsData(path));
+        if (!data) {
+            continue;
+        }
+        auto whole = SkCodecImageGenerator::MakeFromEncodedCodec(data);
+        auto tiled = SkTiledImageGenerator::Make(data, 96);
+        if (!whole || !tiled) {
+            ERRORF(r, "Unable to create generators for '%s'.", path);
+            continue;
+        }
+
+        SkBitmap expected;
+        expected.allocPixels(whole->getInfo());
+        REPORTER_ASSERT(r, whole->getPixels(expected.info(), expected.getPixels(),
+                                            expected.rowBytes()));
+
+        // Overlapping regions, so that later ones find some of their tiles in the cache.
+        SkRandom random;
+        for (int i = 0; i < 8; i++) {
+            const int w = random.nextRangeU(1, expected.width() / 2),
+                      h = random.nextRangeU(1, expected.height() / 2);
+            const SkIRect subset = SkIRect::MakeXYWH(random.nextULessThan(expected.width() - w),
+                                                     random.nextULessThan(expected.height() - h),
+                                                     w, h);
+            SkBitmap actual, reference;
+            actual.allocPixels(expected.info().makeDimensions(subset.size()));
+            REPORTER_ASSERT(r, tiled->getPixels(actual.info(), actual.getPixels(),
+                                                actual.rowBytes(), subset.topLeft()));
+            SkAssertResult(expected.extractSubset(&reference, subset));
+            REPORTER_ASSERT(r, ToolUtils::equal_pixels(reference, actual), "%s", path);
+        }
+
+        // The whole image, through an SkImage subset.
+        auto image = SkImage::MakeFromGenerator(SkTiledImageGenerator::Make(data, 96));
+        SkBitmap actual;
+        actual.allocPixels(expected.info());
+        REPORTER_ASSERT(r, image->readPixels(actual.pixmap(), 0, 0));
+        REPORTER_ASSERT(r, ToolUtils::equal_pixels(expected, actual), "%s", path);
+    }
+}
+
+// Whether each channel of a and b, read as floats in a's color space, is within tolerance.
+static bool pixels_within(const SkBitmap& a, const SkBitmap& b, float tolerance) {
+    if (a.dimensions() != b.dimensions()) {
+        return false;
+    }
+    const SkImageInfo info = SkImageInfo::Make(a.dimensions(), kRGBA_F32_SkColorType,
+                                               a.alphaType(), a.refColorSpace());
+    SkBitmap fa, fb;
+    fa.allocPixels(info);
+    fb.allocPixels(info);
+    if (!a.readPixels(fa.pixmap()) || !b.readPixels(fb.pixmap())) {
+        return false;
+    }
+    for (int y = 0; y < info.height(); y++) {
+        const float* pa = static_cast<const float*>(fa.getAddr(0, y));
+        const float* pb = static_cast<const float*>(fb.getAddr(0, y));
+        for (int i = 0; i < 4 * info.width(); i++) {
+            if (fabsf(pa[i] - pb[i]) > tolerance) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+DEF_TEST(Codec_tiledBitmapRegionDecoder, r) {
+    // Nearly transparent pixels lose their colors when premultiplied.  SkColor is laid out as
+    // BGRA in memory.
+    SkBitmap faint;
+    faint.allocPixels(SkImageInfo::Make(300, 600, kBGRA_8888_SkColorType, kUnpremul_SkAlphaType));
+    for (int y = 0; y < faint.height(); y++) {
+        for (int x = 0; x < faint.width(); x++) {
+            *faint.getAddr32(x, y) = SkColorSetARGB(1 + x % 4, x % 256, y % 256, 128);
+        }
+    }
+    SkDynamicMemoryWStream faintPng;
+    REPORTER_ASSERT(r, SkPngEncoder::Encode(&faintPng, faint.pixmap(), {}));
+    const sk_sp<SkData> faintData = faintPng.detachAsData();
+
+    // The JPEG has restart markers, so its tiles are decoded from bands of it.  (Without them,
+    // libjpeg's horizontal crops upsample their edges differently from the tiles.)
+    for (const char* path : { "images/mandrill_h2v2_restart.jpg", "images/color_wheel.png",
+                              "faint" }) {
+        sk_sp<SkData> data(strcmp(path, "faint") ? GetResourceAsData(path) : faintData);
+        if (!data) {
+            continue;
+        }
+        std::unique_ptr<SkBitmapRegionDecoder> codec(
+                SkBitmapRegionDecoder::Create(data, SkBitmapRegionDecoder::kAndroidCodec_Strategy));
+        std::unique_ptr<SkBitmapRegionDecoder> tiled(
+                SkBitmapRegionDecoder::Create(data, SkBitmapRegionDecoder::kTiledCache_Strategy));
+        if (!codec || !tiled) {
+            ERRORF(r, "Unable to create region decoders for '%s'.", path);
+            continue;
+        }
+
+        // Regions away from the top (so that restart markers are used), and partly outside.
+        const int w = codec->width(),
+                  h = codec->height();
+        const SkIRect regions[] = {
+            SkIRect::MakeLTRB(w / 4, h / 2, w * 3 / 4, h * 3 / 4),
+            SkIRect::MakeLTRB(w / 3, h / 3, w + 20, h + 10),
+            SkIRect::MakeLTRB(-10, h / 2, w / 2, h - 1),
+        };
+        const int bandsBefore = SkJpegRestartIndex::BandsMadeForTesting();
+        for (const SkIRect& region : regions) {
+            for (SkColorType colorType : { kN32_SkColorType, kRGBA_F16_SkColorType }) {
+                for (bool requireUnpremul : { false, true }) {
+                    for (auto colorSpace : { sk_sp<SkColorSpace>(nullptr),
+                                             SkColorSpace::MakeRGB(SkNamedTransferFn::kSRGB,
+                                                                   SkNamedGamut::kDCIP3) }) {
+                        SkBitmap expected, actual;
+                        REPORTER_ASSERT(r, codec->decodeRegion(&expected, nullptr, region, 1,
+                                                               colorType, requireUnpremul,
+                                                               colorSpace));
+                        REPORTER_ASSERT(r, tiled->decodeRegion(&actual, nullptr, region, 1,
+                                                               colorType, requireUnpremul,
+                                                               colorSpace));
+                        REPORTER_ASSERT(r, expected.info() == actual.info());
+
+                        // Tiles are converted to the color space and type after they are
+                        // decoded, rather than as part of the decode, so allow for rounding.
+                        REPORTER_ASSERT(r, pixels_within(expected, actual, 2 / 255.0f),
+                                        "%s: region (%d, %d, %d, %d), color type %d, %s, %s",
+                                        path, region.left(), region.top(), region.right(),
+                                        region.bottom(), colorType,
+                                        requireUnpremul ? "unpremul" : "premul",
+                                        colorSpace ? "P3" : "no color space");
+                    }
+                }
+            }
+        }
+        if (SkEncodedImageFormat::kJPEG == codec->getEncodedFormat()) {
+            REPORTER_ASSERT(r, SkJpegRestartIndex::BandsMadeForTesting() > bandsBefore,
+                            "%s was not decoded in bands", path);
+        }
+    }
+}
+
 static void check_color_xform(skiatest::Reporter* r, const char* path) {
     std::unique_ptr<SkAndroidCodec> codec(SkAndroidCodec::MakeFromStream(GetResourceAsStream(path)));
 
@@ -12,6 +12,7 @@
 #include "include/core/SkCanvas.h"
 #include "include/core/SkColorPriv.h"
 #include "include/core/SkEncodedImageFormat.h"
+#include "include/core/SkExecutor.h"
 #include "include/core/SkImage.h"
 #include "include/core/SkStream.h"
 #include "include/core/SkSurface.h"
@@ -331,6 +332,46 @@ DEF_TEST(Encode_PngOptions, r) {
     REPORTER_ASSERT(r, almost_equals(bm0, bm2, 0));
 }
 
+DEF_TEST(Encode_PngParallel, r) {
+    SkBitmap bitmap;
+    if (!GetResourceAsBitmap("images/mandrill_512.png", &bitmap)) {
+        return;
+    }
+    SkPixmap src;
+    REPORTER_ASSERT(r, bitmap.peekPixels(&src));
+
+    auto executor = SkExecutor::MakeFIFOThreadPool(4);
+    for (auto filters : { SkPngEncoder::FilterFlag::kAll, SkPngEncoder::FilterFlag::kSub,
+                          SkPngEncoder::FilterFlag::kUp | SkPngEncoder::FilterFlag::kPaeth }) {
+        for (int zlibLevel : { 0, 1, 6, 9 }) {
+            SkPngEncoder::Options options;
+            options.fFilterFlags = filters;
+            options.fZLibLevel = zlibLevel;
+
+            SkDynamicMemoryWStream serialDst, parallelDst;
+            REPORTER_ASSERT(r, SkPngEncoder::Encode(&serialDst, src, options));
+            options.fExecutor = executor.get();
+            REPORTER_ASSERT(r, SkPngEncoder::Encode(&parallelDst, src, options));
+
+            sk_sp<SkData> serial = serialDst.detachAsData(),
+                          parallel = parallelDst.detachAsData();
+            // The bands cost a little compression, and the filter heuristic may choose worse.
+            REPORTER_ASSERT(r, parallel->size() < serial->size() * 11 / 10,
+                            "filters %x level %d: %zu vs %zu", (int)filters, zlibLevel,
+                            parallel->size(), serial->size());
+
+            SkBitmap serialBitmap, parallelBitmap;
+            SkImage::MakeFromEncoded(serial)->asLegacyBitmap(&serialBitmap);
+            sk_sp<SkImage> image = SkImage::MakeFromEncoded(parallel);
+            REPORTER_ASSERT(r, image);
+            if (image) {
+                image->asLegacyBitmap(&parallelBitmap);
+                REPORTER_ASSERT(r, almost_equals(serialBitmap, parallelBitmap, 0));
+            }
+        }
+    }
+}
+
 #ifndef SK_BUILD_FOR_GOOGLE3
 DEF_TEST(Encode_WebpQuality, r) {
     SkBitmap bm;
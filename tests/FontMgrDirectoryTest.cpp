@@ -0,0 +1,119 @@
+/*
+ * Copyright 2020 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "include/core/SkFontMgr.h"
+#include "include/core/SkTypeface.h"
+#include "include/ports/SkFontMgr_directory.h"
+#include "src/ports/SkFontIndex.h"
+#include "src/utils/SkOSPath.h"
+#include "tests/Test.h"
+#include "tools/Resources.h"
+
+#include <stdio.h>
+
+DEF_TEST(FontIndex_RoundTrip, reporter) {
+    SkFontIndex::FileStamp stamp;
+    stamp.fSize = 12345;
+    stamp.fModTime = 0x123456789LL;
+
+    SkTArray<SkFontIndex::Face> faces;
+    SkFontIndex::Face& face = faces.push_back();
+    face.fFamilyName.set("Family");
+    face.fStyle = SkFontStyle::BoldItalic();
+    face.fIsFixedPitch = true;
+    face.fIndex = 2;
+    face.fCoverage = SkFontIndex::Coverage::Make();
+    SkFontIndex::Coverage::Add(face.fCoverage.get(), 'A');
+    SkFontIndex::Coverage::Add(face.fCoverage.get(), 0x1F600);
+    faces.push_back().fFamilyName.set("Other");
+
+    SkFontIndex index;
+    index.addFaces("/fonts/family.ttc", stamp, faces);
+    index.addFaces("/fonts/empty.ttf", stamp, SkTArray<SkFontIndex::Face>());
+    REPORTER_ASSERT(reporter, index.isDirty());
+
+    SkFontIndex read(index.serialize());
+    REPORTER_ASSERT(reporter, !read.isDirty());
+    REPORTER_ASSERT(reporter, read.count() == 2);
+
+    SkTArray<SkFontIndex::Face> found;
+    REPORTER_ASSERT(reporter, read.findFaces("/fonts/empty.ttf", stamp, &found));
+    REPORTER_ASSERT(reporter, found.empty());
+    REPORTER_ASSERT(reporter, !read.findFaces("/fonts/missing.ttf", stamp, &found));
+
+    SkFontIndex::FileStamp changed = stamp;
+    changed.fModTime += 1;
+    REPORTER_ASSERT(reporter, !read.findFaces("/fonts/family.ttc", changed, &found));
+
+    REPORTER_ASSERT(reporter, read.findFaces("/fonts/family.ttc", stamp, &found));
+    REPORTER_ASSERT(reporter, found.count() == 2);
+    if (found.count() == 2) {
+        REPORTER_ASSERT(reporter, found[0].fFamilyName.equals("Family"));
+        REPORTER_ASSERT(reporter, found[0].fStyle == SkFontStyle::BoldItalic());
+        REPORTER_ASSERT(reporter, found[0].fIsFixedPitch);
+        REPORTER_ASSERT(reporter, found[0].fIndex == 2);
+        const SkData* coverage = found[0].fCoverage.get();
+        REPORTER_ASSERT(reporter, coverage);
+        REPORTER_ASSERT(reporter, SkFontIndex::Coverage::MayContain(coverage, 'B'));
+        REPORTER_ASSERT(reporter, SkFontIndex::Coverage::MayContain(coverage, 0x1F601));
+        REPORTER_ASSERT(reporter, !SkFontIndex::Coverage::MayContain(coverage, 0x4E00));
+        REPORTER_ASSERT(reporter, found[1].fFamilyName.equals("Other"));
+        REPORTER_ASSERT(reporter, !found[1].fCoverage);
+    }
+
+    // Only records which were looked up survive.
+    read.removeUnused();
+    REPORTER_ASSERT(reporter, !read.isDirty());
+    REPORTER_ASSERT(reporter, read.count() == 2);
+    SkFontIndex reread(read.serialize());
+    reread.removeUnused();
+    REPORTER_ASSERT(reporter, reread.count() == 0);
+
+    // Anything which is not an index is ignored.
+    const char garbage[] = "not an index";
+    SkFontIndex invalid(SkData::MakeWithCopy(garbage, sizeof(garbage)));
+    REPORTER_ASSERT(reporter, invalid.count() == 0);
+    REPORTER_ASSERT(reporter, invalid.isDirty());
+}
+
+DEF_TEST(FontMgrDirectory_Index, reporter) {
+    SkString tmpDir = skiatest::GetTmpDir();
+    if (tmpDir.isEmpty()) {
+        return;
+    }
+    SkString indexPath = SkOSPath::Join(tmpDir.c_str(), "fontmgr_directory.index");
+    remove(indexPath.c_str());
+
+    SkString fontDir = GetResourcePath("fonts");
+    sk_sp<SkFontMgr> scanned = SkFontMgr_New_Custom_Directory(fontDir.c_str());
+    sk_sp<SkFontMgr> cold = SkFontMgr_New_Custom_Directory(fontDir.c_str(), indexPath.c_str());
+    sk_sp<SkFontMgr> warm = SkFontMgr_New_Custom_Directory(fontDir.c_str(), indexPath.c_str());
+
+    REPORTER_ASSERT(reporter, SkFontIndex::MakeFromFile(indexPath.c_str()).count() > 0);
+    REPORTER_ASSERT(reporter, cold->countFamilies() == scanned->countFamilies());
+    REPORTER_ASSERT(reporter, warm->countFamilies() == scanned->countFamilies());
+    for (int i = 0; i < scanned->countFamilies(); ++i) {
+        SkString expected, actual;
+        scanned->getFamilyName(i, &expected);
+        warm->getFamilyName(i, &actual);
+        REPORTER_ASSERT(reporter, expected == actual);
+
+        sk_sp<SkFontStyleSet> expectedSet(scanned->createStyleSet(i));
+        sk_sp<SkFontStyleSet> actualSet(warm->createStyleSet(i));
+        REPORTER_ASSERT(reporter, expectedSet->count() == actualSet->count());
+    }
+
+    // The recorded coverage allows character fallback.
+    sk_sp<SkTypeface> fallback(warm->matchFamilyStyleCharacter(nullptr, SkFontStyle(),
+                                                               nullptr, 0, 'A'));
+    REPORTER_ASSERT(reporter, fallback);
+    if (fallback) {
+        REPORTER_ASSERT(reporter, fallback->unicharToGlyph('A') != 0);
+    }
+
+    remove(indexPath.c_str());
+}
@@ -101,3 +101,21 @@ DEF_TEST(FontMgrFontConfig, reporter) {
         REPORTER_ASSERT(reporter, success);
     }
 }
+
+DEF_TEST(FontMgrFontConfig_MatchCacheInvalidation, reporter) {
+    FcConfig* config = FcConfigCreate();
+    FcConfigSetSysRoot(config, reinterpret_cast<const FcChar8*>(GetResourcePath("").c_str()));
+    SkString distortablePath(reinterpret_cast<const char*>(FcConfigGetSysRoot(config)));
+    distortablePath += "/fonts/Distortable.ttf";
+    FcConfigBuildFonts(config);
+
+    // The font manager takes the reference, config stays alive as long as it does.
+    sk_sp<SkFontMgr> fontMgr(SkFontMgr_New_FontConfig(config));
+    sk_sp<SkTypeface> before(fontMgr->matchFamilyStyle("Distortable", SkFontStyle()));
+    REPORTER_ASSERT(reporter, !before);
+
+    // Fonts added afterwards must be found, not hidden by the remembered miss.
+    FcConfigAppFontAddFile(config, reinterpret_cast<const FcChar8*>(distortablePath.c_str()));
+    sk_sp<SkTypeface> after(fontMgr->matchFamilyStyle("Distortable", SkFontStyle()));
+    REPORTER_ASSERT(reporter, after);
+}
@@ -68,3 +68,21 @@ DEF_TEST(LRUCacheRandom, r) {
     }
     REPORTER_ASSERT(r, 0 == instances);
 }
+
+DEF_TEST(LRUCacheLeastRecentlyUsed, r) {
+    SkLRUCache<int, int> test(10);
+    REPORTER_ASSERT(r, !test.leastRecentlyUsed());
+    for (int i = 0; i < 5; i++) {
+        test.insert(i, i * 10);
+    }
+    REPORTER_ASSERT(r, 0 == *test.leastRecentlyUsed());
+
+    // Looking up the oldest entry makes it the most recently used one.
+    REPORTER_ASSERT(r, test.find(0));
+    REPORTER_ASSERT(r, 10 == *test.leastRecentlyUsed());
+
+    test.removeLeastRecentlyUsed();
+    REPORTER_ASSERT(r, 4 == test.count());
+    REPORTER_ASSERT(r, !test.find(1));
+    REPORTER_ASSERT(r, 20 == *test.leastRecentlyUsed());
+}
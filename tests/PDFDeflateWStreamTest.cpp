@@ -9,6 +9,8 @@
 
 #ifdef SK_SUPPORT_PDF
 
+#include "include/core/SkData.h"
+#include "include/core/SkExecutor.h"
 #include "include/private/SkTo.h"
 #include "include/utils/SkRandom.h"
 #include "src/pdf/SkDeflate.h"
@@ -167,4 +169,65 @@ DEF_TEST(SkPDF_DeflateWStream, r) {
     REPORTER_ASSERT(r, !emptyDeflateWStream.writeText("FOO"));
 }
 
+namespace {
+// Never runs its work while a stream is using it, like a thread pool whose
+// threads are all busy in jobs which write streams.
+class StalledExecutor final : public SkExecutor {
+public:
+    void add(std::function<void(void)> work) override { fWork.push_back(std::move(work)); }
+    void runAll() {
+        for (auto& work : fWork) {
+            work();
+        }
+        fWork.clear();
+    }
+private:
+    std::vector<std::function<void(void)>> fWork;
+};
+}  // namespace
+
+DEF_TEST(SkPDF_DeflateWStream_Parallel, r) {
+    // Alternate runs of compressible and random data, so some blocks are
+    // stored rather than deflated.
+    SkRandom random(654321);
+    const size_t kSize = 1000000;
+    SkAutoTMalloc<uint8_t> buffer(kSize);
+    for (size_t i = 0; i < kSize; ++i) {
+        buffer[i] = (i / 200000) % 2 ? random.nextU() & 0xff : "0 0 m 10 10 l S\n"[i % 16];
+    }
+
+    auto threadPool = SkExecutor::MakeFIFOThreadPool(4);
+    StalledExecutor stalled;
+    for (SkExecutor* executor : {threadPool.get(), (SkExecutor*)&stalled}) {
+        for (size_t size : {(size_t)100, (size_t)(128 * 1024), kSize}) {
+            SkDynamicMemoryWStream serial, parallel;
+            {
+                SkDeflateWStream deflateWStream(&serial);
+                deflateWStream.write(buffer.get(), size);
+            }
+            {
+                SkDeflateWStream deflateWStream(&parallel, -1, false, executor);
+                for (size_t i = 0; i < size;) {
+                    size_t writeSize = std::min(size - i, (size_t)random.nextRangeU(1, 40000));
+                    REPORTER_ASSERT(r, deflateWStream.write(&buffer[i], writeSize));
+                    i += writeSize;
+                }
+                REPORTER_ASSERT(r, deflateWStream.bytesWritten() == size);
+            }
+            // Splitting into blocks should cost little compression.
+            REPORTER_ASSERT(r, parallel.bytesWritten() < serial.bytesWritten() * 101 / 100 + 64);
+
+            std::unique_ptr<SkStreamAsset> compressed(parallel.detachAsStream());
+            std::unique_ptr<SkStreamAsset> decompressed(stream_inflate(r, compressed.get()));
+            REPORTER_ASSERT(r, decompressed && decompressed->getLength() == size);
+            if (decompressed && decompressed->getLength() == size) {
+                sk_sp<SkData> data = SkData::MakeFromStream(decompressed.get(), size);
+                REPORTER_ASSERT(r, data && 0 == memcmp(data->data(), buffer.get(), size));
+            }
+            // Tasks left behind by a finished stream have nothing to do.
+            stalled.runAll();
+        }
+    }
+}
+
 #endif
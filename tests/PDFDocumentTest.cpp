@@ -6,16 +6,31 @@
  */
 #include "tests/Test.h"
 
+#include "include/core/SkAnnotation.h"
 #include "include/core/SkCanvas.h"
 #include "include/core/SkExecutor.h"
+#include "include/core/SkFont.h"
+#include "include/core/SkImage.h"
+#include "include/core/SkImageEncoder.h"
+#include "include/core/SkMaskFilter.h"
 #include "include/core/SkStream.h"
 #include "include/docs/SkPDFDocument.h"
+#include "include/effects/SkGradientShader.h"
 #include "src/core/SkOSFile.h"
+#include "src/core/SkTaskGroup.h"
+#include "src/pdf/SkPDFDocumentPriv.h"
 #include "src/utils/SkOSPath.h"
 #include "tools/Resources.h"
 
 #include "tools/ToolUtils.h"
 
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "zlib.h"
+
 static void test_empty(skiatest::Reporter* reporter) {
     SkDynamicMemoryWStream stream;
 
@@ -255,3 +270,348 @@ DEF_TEST(SkPDF_abort_jobs, rep) {
     doc->abort();
 }
 
+
+namespace {
+// Runs each task as soon as it is added.
+class InlineExecutor final : public SkExecutor {
+public:
+    void add(std::function<void(void)> work) override { work(); }
+};
+}  // namespace
+
+static sk_sp<SkData> make_parallel_pages_document(SkExecutor* executor) {
+    SkBitmap bitmap;
+    bitmap.allocN32Pixels(16, 16);
+    bitmap.eraseColor(0xFF4F9643);
+    const SkPoint points[] = {{0, 0}, {612, 792}};
+    const SkColor colors[] = {SK_ColorRED, SK_ColorBLUE};
+    sk_sp<SkShader> gradient =
+            SkGradientShader::MakeLinear(points, colors, nullptr, 2, SkTileMode::kClamp);
+
+    SkDynamicMemoryWStream stream;
+    SkPDF::Metadata metadata;
+    metadata.fExecutor = executor;
+    auto doc = SkPDF::MakeDocument(&stream, metadata);
+    for (int i = 0; i < 40; ++i) {
+        SkCanvas* canvas = doc->beginPage(612, 792);
+        SkPaint paint;
+        paint.setShader(gradient);
+        canvas->drawRect({0, 0, 612, 396}, paint);
+        paint.setShader(nullptr);
+        paint.setColor(SkColorSetARGB(0x80, 0, 0, (uint8_t)(20 * i)));
+        canvas->drawCircle(306, 396, 100.0f + i, paint);
+        paint.setBlendMode(SkBlendMode::kSrcIn);
+        canvas->drawRect({100, 100, 300, 300}, paint);
+        paint.setBlendMode(SkBlendMode::kSrcOver);
+        paint.setMaskFilter(SkMaskFilter::MakeBlur(kNormal_SkBlurStyle, 3));
+        canvas->drawRect({400, 500, 500, 600}, paint);
+        // A layer SkRecordOptimize() would fold into the paint of the rect.
+        canvas->saveLayerAlpha(nullptr, 0x80);
+        canvas->drawRect({450, 100, 550, 200}, SkPaint());
+        canvas->restore();
+        canvas->drawBitmap(bitmap, 36, 700);
+        SkString text = SkStringPrintf("Page %d", i);
+        canvas->drawString(text, 72, 72, SkFont(nullptr, 12), SkPaint());
+        SkAnnotateNamedDestination(canvas, {72, 72}, SkData::MakeWithCString(text.c_str()).get());
+        SkAnnotateRectWithURL(canvas, {72, 60, 144, 80},
+                              SkData::MakeWithCString("https://skia.org/").get());
+    }
+    doc->close();
+    return stream.detachAsData();
+}
+
+// Maps the number of each object in a PDF to its bytes, using the cross reference table.
+static std::map<int, std::string> read_objects(const SkData& pdf) {
+    std::map<int, std::string> objects;
+    const char* bytes = (const char*)pdf.data();
+    std::string str(bytes, pdf.size());
+    size_t startxref = str.rfind("startxref\n");
+    if (startxref == std::string::npos) {
+        return objects;
+    }
+    size_t xref = std::stoul(str.substr(startxref + 10));
+    size_t pos = str.find('\n', xref + 5);  // "xref\n0 N\n"
+    if (xref >= str.size() || pos == std::string::npos) {
+        return objects;
+    }
+    int count = std::stoi(str.substr(xref + 7));
+    std::vector<std::pair<size_t, int>> offsets;
+    pos += 1 + 20;  // Skip the free entry.
+    for (int i = 1; i < count && pos + 20 <= str.size(); ++i, pos += 20) {
+        offsets.push_back({std::stoul(str.substr(pos, 10)), i});
+    }
+    std::sort(offsets.begin(), offsets.end());
+    for (size_t i = 0; i < offsets.size(); ++i) {
+        size_t end = i + 1 < offsets.size() ? offsets[i + 1].first : xref;
+        objects[offsets[i].second] = str.substr(offsets[i].first, end - offsets[i].first);
+    }
+    return objects;
+}
+
+static std::string inflate(const std::string& deflated) {
+    z_stream stream = {};
+    if (Z_OK != inflateInit(&stream)) {
+        return "";
+    }
+    stream.next_in = (Bytef*)deflated.data();
+    stream.avail_in = (uInt)deflated.size();
+    std::string inflated;
+    int result;
+    do {
+        char buffer[4096];
+        stream.next_out = (Bytef*)buffer;
+        stream.avail_out = sizeof(buffer);
+        result = ::inflate(&stream, Z_NO_FLUSH);
+        inflated.append(buffer, sizeof(buffer) - stream.avail_out);
+    } while (Z_OK == result);
+    inflateEnd(&stream);
+    return Z_STREAM_END == result ? inflated : "";
+}
+
+// Renames resources (e.g. /G12, /Xf7) by the order they are first used in content, since their
+// names come from object numbers, which depend on how the pages were scheduled.
+static std::string normalize_resource_names(const std::string& content) {
+    std::map<std::string, std::string> names;
+    std::map<std::string, int> counts;
+    std::string normalized;
+    for (size_t i = 0; i < content.size();) {
+        size_t letters = i + 1, digits;
+        if (content[i] == '/') {
+            while (letters < content.size() && isalpha(content[letters])) {
+                letters++;
+            }
+            digits = letters;
+            while (digits < content.size() && isdigit(content[digits])) {
+                digits++;
+            }
+            if (letters > i + 1 && digits > letters) {
+                std::string name = content.substr(i, digits - i);
+                if (!names.count(name)) {
+                    std::string prefix = content.substr(i, letters - i);
+                    names[name] = prefix + "#" + std::to_string(counts[prefix]++);
+                }
+                normalized += names[name];
+                i = digits;
+                continue;
+            }
+        }
+        normalized += content[i++];
+    }
+    return normalized;
+}
+
+// Returns the inflated content stream of each page, in order, with its resources renamed.
+static std::vector<std::string> read_page_contents(const std::map<int, std::string>& objects) {
+    std::vector<std::string> contents;
+    for (const auto& object : objects) {  // Pages are numbered in order.
+        if (object.second.find("/Type /Page\n") == std::string::npos) {
+            continue;
+        }
+        size_t ref = object.second.find("/Contents ");
+        if (ref == std::string::npos) {
+            contents.push_back("");
+            continue;
+        }
+        auto content = objects.find(std::stoi(object.second.substr(ref + 10)));
+        if (content == objects.end()) {
+            contents.push_back("");
+            continue;
+        }
+        const std::string& stream = content->second;
+        size_t begin = stream.find("stream\n"), end = stream.rfind("\nendstream");
+        if (begin == std::string::npos || end == std::string::npos || end < begin + 7) {
+            contents.push_back("");
+            continue;
+        }
+        contents.push_back(normalize_resource_names(inflate(stream.substr(begin + 7,
+                                                                          end - begin - 7))));
+    }
+    return contents;
+}
+
+// Pages drawn in parallel must produce the same objects however the drawing is scheduled, and
+// the same page content as pages drawn directly.
+DEF_TEST(SkPDF_parallel_pages, r) {
+    REQUIRE_PDF_DOCUMENT(SkPDF_parallel_pages, r);
+    // Draw the pages in parallel even if this machine has a single core.
+    const bool force = gSkPDFForceParallelPages.exchange(true);
+    std::unique_ptr<SkExecutor> threadPool = SkExecutor::MakeFIFOThreadPool(4);
+    InlineExecutor inlineExecutor;
+    sk_sp<SkData> parallel = make_parallel_pages_document(threadPool.get());
+    sk_sp<SkData> inlined = make_parallel_pages_document(&inlineExecutor);
+    sk_sp<SkData> serial = make_parallel_pages_document(nullptr);
+    gSkPDFForceParallelPages = force;
+
+    std::map<int, std::string> parallelObjects = read_objects(*parallel);
+    std::map<int, std::string> inlinedObjects = read_objects(*inlined);
+    std::map<int, std::string> serialObjects = read_objects(*serial);
+    REPORTER_ASSERT(r, !parallelObjects.empty());
+    REPORTER_ASSERT(r, parallelObjects == inlinedObjects);
+    // Drawn serially, the pages name their resources differently, but make the same objects.
+    REPORTER_ASSERT(r, serialObjects.size() == parallelObjects.size());
+
+    std::vector<std::string> parallelContents = read_page_contents(parallelObjects);
+    std::vector<std::string> serialContents = read_page_contents(serialObjects);
+    REPORTER_ASSERT(r, parallelContents.size() == 40);
+    REPORTER_ASSERT(r, parallelContents == serialContents);
+    for (size_t i = 0; i < parallelContents.size(); ++i) {
+        REPORTER_ASSERT(r, !parallelContents[i].empty(), "page %zu", i);
+    }
+}
+
+DEF_TEST(SkPDF_stream_pages, r) {
+    REQUIRE_PDF_DOCUMENT(SkPDF_stream_pages, r);
+    constexpr int kPageCount = 100;
+    SkDynamicMemoryWStream stream;
+    SkPDF::Metadata metadata;
+    metadata.fStreamPages = true;
+    auto doc = SkPDF::MakeDocument(&stream, metadata);
+    size_t bytesWritten = 0;
+    for (int i = 0; i < kPageCount; ++i) {
+        SkCanvas* canvas = doc->beginPage(612, 792);
+        // The first and last pages share a font, which is written in between.
+        if (i < 10 || i == kPageCount - 1) {
+            canvas->drawString(SkStringPrintf("Page %d", i), 72, 72, SkFont(nullptr, 12),
+                               SkPaint());
+        }
+        canvas->drawColor(SkColorSetARGB(0x80, 0x00, (uint8_t)(2 * i), 0x00));
+        doc->endPage();
+        // Each page is written as soon as it is finished.
+        REPORTER_ASSERT(r, stream.bytesWritten() > bytesWritten);
+        bytesWritten = stream.bytesWritten();
+    }
+    doc->close();
+    sk_sp<SkData> pdf = stream.detachAsData();
+
+    int pages = 0, leaves = 0;
+    for (const auto& object : read_objects(*pdf)) {
+        const std::string& bytes = object.second;
+        if (bytes.find("<</Type /Page\n") != std::string::npos) {
+            REPORTER_ASSERT(r, bytes.find("/Parent ") != std::string::npos);
+            pages++;
+        } else if (bytes.find("<</Type /Pages\n/Count 8\n") != std::string::npos) {
+            leaves++;
+        }
+    }
+    REPORTER_ASSERT(r, pages == kPageCount);
+    REPORTER_ASSERT(r, leaves == kPageCount / 8);
+    std::string str((const char*)pdf->data(), pdf->size());
+    REPORTER_ASSERT(r, str.find("/Count 100\n") != std::string::npos);
+}
+
+// A streamed document remembers a bounded number of the images it has written.
+DEF_TEST(SkPDF_stream_pages_images, r) {
+    REQUIRE_PDF_DOCUMENT(SkPDF_stream_pages_images, r);
+    constexpr int kPageCount = 24, kImagesPerPage = 100;
+    SkNullWStream stream;
+    SkPDF::Metadata metadata;
+    metadata.fStreamPages = true;
+    auto doc = SkPDF::MakeDocument(&stream, metadata);
+    auto pdf = static_cast<SkPDFDocument*>(doc.get());
+    int mostImages = 0;
+    for (int i = 0; i < kPageCount; ++i) {
+        SkCanvas* canvas = doc->beginPage(612, 792);
+        for (int j = 0; j < kImagesPerPage; ++j) {
+            SkBitmap bitmap;
+            bitmap.allocN32Pixels(2, 2);
+            bitmap.eraseColor(SkColorSetRGB((uint8_t)i, (uint8_t)j, 0x80));
+            canvas->drawImage(SkImage::MakeFromBitmap(bitmap), (j % 10) * 60, (j / 10) * 60);
+        }
+        doc->endPage();
+        mostImages = std::max(mostImages, pdf->fPDFBitmapMap.count());
+    }
+    doc->close();
+    REPORTER_ASSERT(r, mostImages > 0);
+    REPORTER_ASSERT(r, mostImages < kPageCount * kImagesPerPage / 2, "%d", mostImages);
+}
+
+static sk_sp<SkData> make_shared_cache_document(bool useSharedCache) {
+    // A new image with the same translucent pixels each time, as if decoded again.
+    SkBitmap bitmap;
+    bitmap.allocN32Pixels(64, 64);
+    bitmap.eraseColor(SK_ColorTRANSPARENT);
+    SkCanvas(bitmap).drawCircle(32, 32, 24, SkPaint(SkColor4f{0.2f, 0.4f, 0.8f, 1}));
+    sk_sp<SkImage> logo = SkImage::MakeFromBitmap(bitmap);
+
+    SkDynamicMemoryWStream stream;
+    SkPDF::Metadata metadata;
+    metadata.fUseSharedCache = useSharedCache;
+    auto doc = SkPDF::MakeDocument(&stream, metadata);
+    SkCanvas* canvas = doc->beginPage(612, 792);
+    canvas->drawImage(logo, 36, 36);
+    canvas->drawString("Invoice", 72, 144, SkFont(ToolUtils::create_portable_typeface(), 12),
+                       SkPaint());
+    doc->close();
+    return stream.detachAsData();
+}
+
+DEF_TEST(SkPDF_shared_cache, r) {
+    const size_t oldLimit = SkPDF::SetSharedCacheLimit(1 << 20);
+    SkPDF::PurgeSharedCache();
+
+    sk_sp<SkData> uncached = make_shared_cache_document(false);
+    REPORTER_ASSERT(r, SkPDF::GetSharedCacheBytesUsed() == 0);
+
+    sk_sp<SkData> first = make_shared_cache_document(true);
+    const size_t used = SkPDF::GetSharedCacheBytesUsed();
+    REPORTER_ASSERT(r, used > 0);
+    REPORTER_ASSERT(r, first->equals(uncached.get()));
+
+    // Later documents reuse the entries, from any thread.
+    sk_sp<SkData> documents[8];
+    SkTaskGroup tasks;
+    for (sk_sp<SkData>& document : documents) {
+        tasks.add([&document]() { document = make_shared_cache_document(true); });
+    }
+    tasks.wait();
+    REPORTER_ASSERT(r, SkPDF::GetSharedCacheBytesUsed() == used);
+    for (const sk_sp<SkData>& document : documents) {
+        REPORTER_ASSERT(r, document->equals(first.get()));
+    }
+
+    // Entries are purged to fit the budget.
+    SkPDF::SetSharedCacheLimit(used - 1);
+    REPORTER_ASSERT(r, SkPDF::GetSharedCacheBytesUsed() < used);
+    REPORTER_ASSERT(r, make_shared_cache_document(true)->equals(first.get()));
+
+    SkPDF::SetSharedCacheLimit(oldLimit);
+    SkPDF::PurgeSharedCache();
+    REPORTER_ASSERT(r, SkPDF::GetSharedCacheBytesUsed() == 0);
+}
+
+static sk_sp<SkData> make_encoded_views_document(const sk_sp<SkImage>& sheet,
+                                                 bool useSharedCache) {
+    SkDynamicMemoryWStream stream;
+    SkPDF::Metadata metadata;
+    metadata.fUseSharedCache = useSharedCache;
+    auto doc = SkPDF::MakeDocument(&stream, metadata);
+    SkCanvas* canvas = doc->beginPage(612, 792);
+    canvas->drawImage(sheet->makeSubset(SkIRect::MakeXYWH( 0, 0, 32, 32)),  36, 36);
+    canvas->drawImage(sheet->makeSubset(SkIRect::MakeXYWH(32, 0, 32, 32)), 108, 36);
+    canvas->drawImage(sheet->makeColorSpace(SkColorSpace::MakeSRGBLinear()), 36, 108);
+    doc->close();
+    return stream.detachAsData();
+}
+
+DEF_TEST(SkPDF_shared_cache_encoded_views, r) {
+    // Subsets and color converted copies of a lazy image share its encoded data, but not its
+    // pixels; each must be written as itself.
+    SkBitmap bitmap;
+    bitmap.allocN32Pixels(64, 32);
+    bitmap.eraseArea(SkIRect::MakeXYWH( 0, 0, 32, 32), SK_ColorRED);
+    bitmap.eraseArea(SkIRect::MakeXYWH(32, 0, 32, 32), SK_ColorBLUE);
+    sk_sp<SkData> png = SkEncodeBitmap(bitmap, SkEncodedImageFormat::kPNG, 100);
+    REPORTER_ASSERT(r, png);
+    sk_sp<SkImage> sheet = SkImage::MakeFromEncoded(png);
+    REPORTER_ASSERT(r, sheet);
+    if (!sheet) {
+        return;
+    }
+
+    SkPDF::PurgeSharedCache();
+    sk_sp<SkData> uncached = make_encoded_views_document(sheet, false);
+    REPORTER_ASSERT(r, make_encoded_views_document(sheet, true)->equals(uncached.get()));
+    // Again, now that the cache holds all three.
+    REPORTER_ASSERT(r, make_encoded_views_document(sheet, true)->equals(uncached.get()));
+    SkPDF::PurgeSharedCache();
+}
@@ -372,6 +372,36 @@ DEF_TEST(SkPDF_Primitives_Scalar, reporter) {
     }
 }
 
+// Test that SkFloatToDecimal writes the shortest decimal which round trips.
+DEF_TEST(SkPDF_Primitives_ScalarShortest, reporter) {
+    static const struct {
+        float       fValue;
+        const char* fExpected;
+    } kTests[] = {
+        { 0.1f,               ".1" },
+        { -0.5f,              "-.5" },
+        { 1.0f / 3,           ".33333334" },
+        { 2.0f / 3,           ".6666667" },
+        { 100.0f,             "100" },
+        { 16777218.0f,        "16777218" },
+        { 123456792.0f,       "123456790" },
+        { 9.99999861e-10f,    ".0000000009999999" },
+        { FLT_MAX,            "340282350000000000000000000000000000000" },
+        { -FLT_MIN,           "-.000000000000000000000000000000000000011754944" },
+        { FLT_MIN / 8388608,  ".000000000000000000000000000000000000000000001" },
+        { SK_FloatInfinity,   "340282350000000000000000000000000000000" },
+        { SK_FloatNaN,        "0" },
+    };
+    for (const auto& test : kTests) {
+        char floatString[kMaximumSkFloatToDecimalLength];
+        SkFloatToDecimal(test.fValue, floatString);
+        if (0 != strcmp(floatString, test.fExpected)) {
+            ERRORF(reporter, "%.9g: \"%s\" != \"%s\"",
+                   test.fValue, floatString, test.fExpected);
+        }
+    }
+}
+
 // Test SkPDFUtils:: for accuracy.
 DEF_TEST(SkPDF_Primitives_Color, reporter) {
     char buffer[5];
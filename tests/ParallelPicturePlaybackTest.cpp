@@ -0,0 +1,63 @@
+/*
+ * Copyright 2020 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "include/core/SkBitmap.h"
+#include "include/core/SkCanvas.h"
+#include "include/core/SkExecutor.h"
+#include "include/core/SkPictureRecorder.h"
+#include "include/utils/SkParallelPicturePlayback.h"
+#include "tests/Test.h"
+#include "tools/ToolUtils.h"
+
+DEF_TEST(ParallelPicturePlayback, r) {
+    SkRTreeFactory factory;
+    SkPictureRecorder recorder;
+    SkCanvas* canvas = recorder.beginRecording(SkRect::MakeWH(200, 150), &factory);
+    SkPaint paint;
+    paint.setAntiAlias(true);
+    for (int i = 0; i < 20; i++) {
+        paint.setColor(SkColorSetARGB(0xFF, i * 12, 255 - i * 12, i * 7));
+        canvas->drawCircle(10.0f * i, 7.5f * i, 15, paint);
+    }
+
+    // State which spans many tiles: a matrix, a clip and a translucent layer.
+    canvas->save();
+    canvas->rotate(15, 100, 75);
+    canvas->clipRect(SkRect::MakeXYWH(20, 20, 160, 110));
+    SkPaint layerPaint;
+    layerPaint.setAlphaf(0.5f);
+    canvas->saveLayer(nullptr, &layerPaint);
+    paint.setColor(SK_ColorBLUE);
+    canvas->drawRect(SkRect::MakeXYWH(0, 60, 200, 30), paint);
+    canvas->restore();
+    canvas->restore();
+    sk_sp<SkPicture> picture = recorder.finishRecordingAsPicture();
+
+    const SkImageInfo info = SkImageInfo::MakeN32Premul(200, 150);
+    const SkMatrix matrix = SkMatrix::MakeTrans(3, -2);
+
+    SkBitmap expected;
+    expected.allocPixels(info);
+    expected.eraseColor(SK_ColorWHITE);
+    {
+        SkCanvas serial(expected);
+        serial.concat(matrix);
+        picture->playback(&serial);
+    }
+
+    std::unique_ptr<SkExecutor> executor = SkExecutor::MakeFIFOThreadPool(4);
+    for (SkISize tileSize : {SkISize{16, 16}, SkISize{64, 33}, SkISize{1000, 1000}}) {
+        SkBitmap actual;
+        actual.allocPixels(info);
+        actual.eraseColor(SK_ColorWHITE);
+        REPORTER_ASSERT(r, SkParallelPicturePlayback::Draw(picture.get(), actual.pixmap(), matrix,
+                                                           executor.get(), tileSize));
+        REPORTER_ASSERT(r, ToolUtils::equal_pixels(expected, actual));
+    }
+
+    REPORTER_ASSERT(r, !SkParallelPicturePlayback::Draw(picture.get(), SkPixmap()));
+}
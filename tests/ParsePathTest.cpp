@@ -5,6 +5,7 @@
  * found in the LICENSE file.
  */
 
+#include "include/private/SkFloatBits.h"
 #include "include/utils/SkParsePath.h"
 #include "tests/Test.h"
 
@@ -128,3 +129,34 @@ DEF_TEST(ParsePathOptionalCommand, r) {
         REPORTER_ASSERT(r, path.countPoints() == gTests[i].fPoints);
     }
 }
+
+DEF_TEST(ParsePathExactScalars, r) {
+    SkPath path;
+    path.moveTo(1.0f / 3, -0.1f);
+    path.lineTo(12345.678f, 1e-7f);
+    path.quadTo(-2.0f / 3, 16777218.0f, 3.4e38f, -1.1754944e-38f);
+
+    SkString str;
+    SkParsePath::ToSVGString(path, &str);
+    SkPath path2;
+    REPORTER_ASSERT(r, SkParsePath::FromSVGString(str.c_str(), &path2));
+
+    // The shortest round-trip scalars read back as exactly the same points.
+    REPORTER_ASSERT(r, path.countPoints() == path2.countPoints());
+    for (int i = 0; i < path.countPoints() && i < path2.countPoints(); ++i) {
+        REPORTER_ASSERT(r, path.getPoint(i) == path2.getPoint(i));
+    }
+}
+
+DEF_TEST(ParsePathScalarExponents, r) {
+    // Very small and very large scalars are written with an exponent, everything else without.
+    SkPath path;
+    path.moveTo(SkBits2Float(0x15e80300), SkBits2Float(0x400004dc));
+    path.lineTo(1e-7f, .000001f);
+    path.lineTo(3.4e38f, 1000);
+
+    SkString str;
+    SkParsePath::ToSVGString(path, &str);
+    REPORTER_ASSERT(r, str.equals("M9.370879e-26 2.0002966L1e-7 .000001L3.4e38 1000"),
+                    "%s", str.c_str());
+}
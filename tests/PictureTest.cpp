@@ -11,8 +11,10 @@
 #include "include/core/SkClipOp.h"
 #include "include/core/SkColor.h"
 #include "include/core/SkData.h"
+#include "include/core/SkFont.h"
 #include "include/core/SkFontStyle.h"
 #include "include/core/SkImageInfo.h"
+#include "include/core/SkMaskFilter.h"
 #include "include/core/SkMatrix.h"
 #include "include/core/SkPaint.h"
 #include "include/core/SkPath.h"
@@ -23,8 +25,10 @@
 #include "include/core/SkScalar.h"
 #include "include/core/SkShader.h"
 #include "include/core/SkStream.h"
+#include "include/core/SkTextBlob.h"
 #include "include/core/SkTypeface.h"
 #include "include/core/SkTypes.h"
+#include "include/utils/SkNoDrawCanvas.h"
 #include "include/utils/SkRandom.h"
 #include "src/core/SkBigPicture.h"
 #include "src/core/SkClipOpPriv.h"
@@ -32,8 +36,10 @@
 #include "src/core/SkPicturePriv.h"
 #include "src/core/SkRectPriv.h"
 #include "tests/Test.h"
+#include "tools/ToolUtils.h"
 
 #include <memory>
+#include <set>
 
 class SkRRect;
 class SkRegion;
@@ -697,6 +703,56 @@ DEF_TEST(Picture_SkipBBH, r) {
     REPORTER_ASSERT(r, bbh->searchCalls == 1);
 }
 
+// Keeps the bounds of the draws inserted into it.
+struct DrawBoundsBBH : public SkBBoxHierarchy {
+    std::vector<SkRect> fDrawBounds;
+
+    void insert(const SkRect[], int) override { SkASSERT(false); }
+    void insert(const SkRect bounds[], const Metadata meta[], int n) override {
+        for (int i = 0; i < n; i++) {
+            if (meta[i].isDraw) {
+                fDrawBounds.push_back(bounds[i]);
+            }
+        }
+    }
+    void search(const SkRect&, std::vector<int>*) const override {}
+    size_t bytesUsed() const override { return 0; }
+};
+
+// kConservativeBounds_RecordFlag bounds draws with a mask filter by the cull rect, whether the
+// recording is finished as a picture or as a drawable.
+DEF_TEST(Picture_ConservativeBounds, r) {
+    const SkRect cull = SkRect::MakeWH(320, 240);
+    const SkRect rect = SkRect::MakeXYWH(10, 10, 20, 20);
+    SkPaint blur;
+    blur.setMaskFilter(SkMaskFilter::MakeBlur(kNormal_SkBlurStyle, 2));
+
+    for (bool conservative : {false, true}) {
+        for (bool drawable : {false, true}) {
+            auto bbh = sk_make_sp<DrawBoundsBBH>();
+            SkPictureRecorder recorder;
+            SkCanvas* canvas = recorder.beginRecording(
+                    cull, bbh, conservative ? SkPictureRecorder::kConservativeBounds_RecordFlag : 0);
+            canvas->drawRect(rect, SkPaint());
+            canvas->drawRect(rect, blur);
+            if (drawable) {
+                recorder.finishRecordingAsDrawable();
+            } else {
+                recorder.finishRecordingAsPicture();
+            }
+
+            REPORTER_ASSERT(r, bbh->fDrawBounds.size() == 2);
+            if (bbh->fDrawBounds.size() == 2) {
+                REPORTER_ASSERT(r, bbh->fDrawBounds[0] == rect);
+                const SkRect& blurred = bbh->fDrawBounds[1];
+                REPORTER_ASSERT(r, conservative ? blurred == cull
+                                                : blurred.contains(rect) && blurred != cull,
+                                "conservative %d drawable %d", conservative, drawable);
+            }
+        }
+    }
+}
+
 DEF_TEST(Picture_BitmapLeak, r) {
     SkBitmap mut, immut;
     mut.allocN32Pixels(300, 200);
@@ -730,6 +786,105 @@ DEF_TEST(Picture_BitmapLeak, r) {
     REPORTER_ASSERT(r, immut.pixelRef()->unique());
 }
 
+DEF_TEST(Picture_RecycleRecord, r) {
+    auto record_of = [](const sk_sp<SkPicture>& pic) {
+        return SkPicturePriv::AsSkBigPicture(pic)->record();
+    };
+    auto record = [](SkPictureRecorder* recorder, SkColor color) {
+        SkCanvas* canvas = recorder->beginRecording(SkRect::MakeWH(100, 100), nullptr,
+                                                    SkPictureRecorder::kRecycleRecord_RecordFlag);
+        SkPaint paint;
+        paint.setColor(color);
+        canvas->drawRect(SkRect::MakeWH(10, 10), paint);
+        canvas->drawRect(SkRect::MakeXYWH(20, 20, 10, 10), paint);
+        return recorder->finishRecordingAsPicture();
+    };
+    auto color_of = [](const sk_sp<SkPicture>& pic) {
+        SkBitmap bitmap;
+        bitmap.allocN32Pixels(1, 1);
+        SkCanvas canvas(bitmap);
+        canvas.drawPicture(pic);
+        return bitmap.getColor(0, 0);
+    };
+
+    SkPictureRecorder recorder;
+    sk_sp<SkPicture> a = record(&recorder, SK_ColorRED),
+                     b = record(&recorder, SK_ColorGREEN);
+
+    // While a and b are alive, their records can't be reused.
+    sk_sp<SkPicture> c = record(&recorder, SK_ColorBLUE);
+    REPORTER_ASSERT(r, record_of(c) != record_of(a) && record_of(c) != record_of(b));
+    REPORTER_ASSERT(r, color_of(a) == SK_ColorRED);
+    REPORTER_ASSERT(r, color_of(b) == SK_ColorGREEN);
+
+    // Once b is gone, the next picture records into its record.  (a's was dropped for c's.)
+    const SkRecord* recycled = record_of(b);
+    b = nullptr;
+    sk_sp<SkPicture> d = record(&recorder, SK_ColorYELLOW);
+    REPORTER_ASSERT(r, record_of(d) == recycled);
+    REPORTER_ASSERT(r, color_of(c) == SK_ColorBLUE);
+    REPORTER_ASSERT(r, color_of(d) == SK_ColorYELLOW);
+}
+
+// Collects the generation IDs of the paths and the unique IDs of the text blobs drawn.
+class ContentIDCanvas : public SkNoDrawCanvas {
+public:
+    ContentIDCanvas() : SkNoDrawCanvas(100, 100) {}
+
+    std::set<uint32_t> fPathIDs, fBlobIDs;
+
+protected:
+    void onDrawPath(const SkPath& path, const SkPaint&) override {
+        fPathIDs.insert(path.getGenerationID());
+    }
+    void onDrawTextBlob(const SkTextBlob* blob, SkScalar, SkScalar, const SkPaint&) override {
+        fBlobIDs.insert(blob->uniqueID());
+    }
+};
+
+// Draws four copies of a path and of a text blob, either built independently or all the same.
+static sk_sp<SkPicture> draw_copies(uint32_t recordFlags, bool independent) {
+    auto make_path = [] {
+        SkPath path;
+        path.addCircle(50, 50, 20);
+        path.lineTo(90, 10);
+        return path;
+    };
+    auto make_blob = [] { return SkTextBlob::MakeFromString("copy", SkFont()); };
+
+    SkPath path = make_path();
+    sk_sp<SkTextBlob> blob = make_blob();
+    SkPictureRecorder recorder;
+    SkCanvas* canvas = recorder.beginRecording(SkRect::MakeWH(100, 100), nullptr, recordFlags);
+    for (int i = 0; i < 4; i++) {
+        canvas->drawPath(independent ? make_path() : path, SkPaint());
+        canvas->drawTextBlob(independent ? make_blob() : blob, 10, 20, SkPaint());
+    }
+    return recorder.finishRecordingAsPicture();
+}
+
+DEF_TEST(Picture_Deduplicate, r) {
+    auto count_ids = [](const sk_sp<SkPicture>& pic) {
+        ContentIDCanvas canvas;
+        pic->playback(&canvas);
+        return std::make_pair(canvas.fPathIDs.size(), canvas.fBlobIDs.size());
+    };
+
+    sk_sp<SkPicture> copies = draw_copies(0, true);
+    REPORTER_ASSERT(r, count_ids(copies) == std::make_pair((size_t)4, (size_t)4));
+
+    // With kDeduplicate_RecordFlag, the copies are recorded as the first one.
+    sk_sp<SkPicture> deduped = draw_copies(SkPictureRecorder::kDeduplicate_RecordFlag, true);
+    REPORTER_ASSERT(r, count_ids(deduped) == std::make_pair((size_t)1, (size_t)1));
+
+    // Serialized pictures always store one of each, and the copies share it once deserialized.
+    sk_sp<SkData> data = copies->serialize();
+    REPORTER_ASSERT(r, data->size() == draw_copies(0, false)->serialize()->size());
+    sk_sp<SkPicture> deserialized = SkPicture::MakeFromData(data.get());
+    REPORTER_ASSERT(r, deserialized);
+    REPORTER_ASSERT(r, count_ids(deserialized) == std::make_pair((size_t)1, (size_t)1));
+}
+
 // getRecordingCanvas() should return a SkCanvas when recording, null when not recording.
 DEF_TEST(Picture_getRecordingCanvas, r) {
     SkPictureRecorder rec;
@@ -864,6 +1019,57 @@ DEF_TEST(Picture_empty_serial, reporter) {
 }
 
 
+DEF_TEST(Picture_MappedData, r) {
+    SkPictureRecorder nestedRecorder;
+    nestedRecorder.beginRecording(SkRect::MakeWH(16, 16))->drawColor(SK_ColorGREEN);
+    sk_sp<SkPicture> nested = nestedRecorder.finishRecordingAsPicture();
+
+    SkPictureRecorder recorder;
+    SkCanvas* canvas = recorder.beginRecording(SkRect::MakeWH(64, 64));
+    SkPaint paint;
+    paint.setColor(SK_ColorRED);
+    canvas->drawRect({4, 4, 40, 40}, paint);
+    paint.setColor(SK_ColorBLUE);
+    paint.setAntiAlias(true);
+    canvas->drawPath(SkPath().addCircle(32, 32, 20), paint);
+    canvas->drawString("mapped", 4, 60, SkFont(ToolUtils::create_portable_typeface(), 12), paint);
+    canvas->translate(40, 0);
+    canvas->drawPicture(nested);
+    sk_sp<SkPicture> picture = recorder.finishRecordingAsPicture();
+
+    sk_sp<SkData> data = picture->serializeForMapping();
+    sk_sp<SkPicture> mapped = SkPicture::MakeFromMappedData(data);
+    REPORTER_ASSERT(r, mapped);
+    if (!mapped) {
+        return;
+    }
+    REPORTER_ASSERT(r, mapped->cullRect() == picture->cullRect());
+    REPORTER_ASSERT(r, mapped->approximateOpCount() > 0);
+
+    auto draw = [](const SkPicture* pic) {
+        SkBitmap bitmap;
+        bitmap.allocN32Pixels(64, 64);
+        SkCanvas canvas(bitmap);
+        canvas.clear(SK_ColorWHITE);
+        canvas.drawPicture(pic);
+        return bitmap;
+    };
+    REPORTER_ASSERT(r, ToolUtils::equal_pixels(draw(picture.get()), draw(mapped.get())));
+
+    // A mapped picture can be written out in the regular format.
+    sk_sp<SkPicture> reserialized = SkPicture::MakeFromData(mapped->serialize().get());
+    REPORTER_ASSERT(r, reserialized);
+    if (reserialized) {
+        REPORTER_ASSERT(r, ToolUtils::equal_pixels(draw(picture.get()), draw(reserialized.get())));
+    }
+
+    // Regular .skp data and truncated data are rejected.
+    REPORTER_ASSERT(r, !SkPicture::MakeFromMappedData(picture->serialize()));
+    REPORTER_ASSERT(r, !SkPicture::MakeFromMappedData(
+                               SkData::MakeSubset(data.get(), 0, data->size() / 2)));
+    REPORTER_ASSERT(r, !SkPicture::MakeFromMappedData(nullptr));
+}
+
 DEF_TEST(Picture_drawsNothing, r) {
     // Tests that pic->cullRect().isEmpty() is a good way to test a picture
     // recorded with an R-tree draws nothing.
@@ -0,0 +1,158 @@
+/*
+ * Copyright 2020 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "include/utils/SkRandom.h"
+#include "modules/skplaintexteditor/include/rope.h"
+#include "tests/Test.h"
+
+#include <string>
+
+using SkPlainTextEditor::Rope;
+
+// Chunks hold up to 256 values before an insert splits them; these sizes straddle that.
+static constexpr size_t kChunk = 256;
+
+static std::string to_string(const Rope<char>& rope) {
+    std::string str;
+    for (char c : rope) {
+        str.push_back(c);
+    }
+    return str;
+}
+
+static void check(skiatest::Reporter* r, const Rope<char>& rope, const std::string& expected) {
+    REPORTER_ASSERT(r, rope.size() == expected.size());
+    REPORTER_ASSERT(r, rope.empty() == expected.empty());
+    REPORTER_ASSERT(r, to_string(rope) == expected);
+    for (size_t i = 0; i < expected.size(); ++i) {
+        if (rope[i] != expected[i]) {
+            ERRORF(r, "rope[%zu] is '%c', expected '%c'", i, rope[i], expected[i]);
+            return;
+        }
+    }
+}
+
+static void insert(Rope<char>* rope, std::string* str, size_t index, const std::string& text) {
+    rope->insert(index, text.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+        (*rope)[index + i] = text[i];
+    }
+    str->insert(index, text);
+}
+
+static void erase(Rope<char>* rope, std::string* str, size_t begin, size_t end) {
+    rope->erase(begin, end);
+    str->erase(begin, end - begin);
+}
+
+static std::string letters(size_t count, char first = 'a') {
+    std::string text;
+    for (size_t i = 0; i < count; ++i) {
+        text.push_back(first + i % 26);
+    }
+    return text;
+}
+
+DEF_TEST(PlainTextEditor_Rope_Empty, r) {
+    Rope<char> rope;
+    check(r, rope, "");
+    REPORTER_ASSERT(r, rope.begin() == rope.end());
+
+    rope.insert(0, 0);
+    rope.erase(0, 0);
+    check(r, rope, "");
+}
+
+DEF_TEST(PlainTextEditor_Rope_PushBack, r) {
+    Rope<char> rope;
+    std::string str;
+    for (size_t i = 0; i < 5 * kChunk + 3; ++i) {
+        char c = 'a' + i % 26;
+        rope.push_back(c);
+        str.push_back(c);
+        REPORTER_ASSERT(r, rope.back() == c);
+    }
+    check(r, rope, str);
+}
+
+// Inserting past twice the chunk size splits the chunk; values on either side keep their order.
+DEF_TEST(PlainTextEditor_Rope_InsertSplit, r) {
+    for (size_t size : {2 * kChunk - 1, 2 * kChunk, 2 * kChunk + 1, 4 * kChunk + 7}) {
+        for (size_t at : {size_t(0), kChunk - 1, kChunk, kChunk + 1, size}) {
+            if (at > size) {
+                continue;
+            }
+            Rope<char> rope;
+            std::string str;
+            insert(&rope, &str, 0, letters(size));
+            check(r, rope, str);
+            insert(&rope, &str, at, letters(3, 'A'));
+            check(r, rope, str);
+        }
+    }
+
+    // A single insert much larger than a chunk.
+    Rope<char> rope;
+    std::string str;
+    insert(&rope, &str, 0, letters(10));
+    insert(&rope, &str, 5, letters(7 * kChunk + 5, 'A'));
+    check(r, rope, str);
+}
+
+// Erasing across chunks removes emptied chunks and merges small neighbors back together.
+DEF_TEST(PlainTextEditor_Rope_EraseConcat, r) {
+    const size_t size = 6 * kChunk + 11;
+    const size_t boundaries[] = {0, 1, kChunk - 1, kChunk, kChunk + 1, 2 * kChunk,
+                                 3 * kChunk - 1, 3 * kChunk, size - 1, size};
+    for (size_t begin : boundaries) {
+        for (size_t end : boundaries) {
+            if (begin > end) {
+                continue;
+            }
+            Rope<char> rope;
+            std::string str;
+            insert(&rope, &str, 0, letters(size));
+            erase(&rope, &str, begin, end);
+            check(r, rope, str);
+
+            // The rope is still usable at the seam.
+            insert(&rope, &str, begin, "xyz");
+            check(r, rope, str);
+        }
+    }
+
+    // Erasing one value at a time from the front repeatedly empties and merges chunks.
+    Rope<char> rope;
+    std::string str;
+    insert(&rope, &str, 0, letters(3 * kChunk + 1));
+    while (!str.empty()) {
+        erase(&rope, &str, 0, 1);
+    }
+    check(r, rope, str);
+    insert(&rope, &str, 0, "again");
+    check(r, rope, str);
+}
+
+DEF_TEST(PlainTextEditor_Rope_Random, r) {
+    SkRandom rand;
+    Rope<char> rope;
+    std::string str;
+    for (int i = 0; i < 2000; ++i) {
+        size_t at = rand.nextULessThan((uint32_t)str.size() + 1);
+        if (str.empty() || rand.nextBool()) {
+            size_t count = rand.nextBool() ? rand.nextRangeU(1, 8) : rand.nextRangeU(1, 3 * kChunk);
+            insert(&rope, &str, at, letters(count, 'a' + i % 26));
+        } else {
+            size_t end = at + rand.nextULessThan((uint32_t)(str.size() - at) + 1);
+            erase(&rope, &str, at, end);
+        }
+        if (i % 100 == 0) {
+            check(r, rope, str);
+        }
+    }
+    check(r, rope, str);
+}
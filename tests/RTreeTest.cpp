@@ -54,20 +54,10 @@ static void run_queries(skiatest::Reporter* reporter, SkRandom& rand, SkRect rec
 }
 
 DEF_TEST(RTree, reporter) {
-    int expectedDepthMin = -1;
-    int tmp = NUM_RECTS;
-    while (tmp > 0) {
-        tmp -= static_cast<int>(pow(static_cast<double>(SkRTree::kMaxChildren),
-                                    static_cast<double>(expectedDepthMin + 1)));
-        ++expectedDepthMin;
-    }
-
-    int expectedDepthMax = -1;
-    tmp = NUM_RECTS;
-    while (tmp > 0) {
-        tmp -= static_cast<int>(pow(static_cast<double>(SkRTree::kMinChildren),
-                                    static_cast<double>(expectedDepthMax + 1)));
-        ++expectedDepthMax;
+    // The tree is packed, so every level but the root has as few nodes as it can.
+    int expectedDepth = 0;
+    for (int nodes = NUM_RECTS; expectedDepth == 0 || nodes > 1; ++expectedDepth) {
+        nodes = (nodes + SkRTree::kFanout - 1) / SkRTree::kFanout;
     }
 
     SkRandom rand;
@@ -85,7 +75,28 @@ DEF_TEST(RTree, reporter) {
 
         run_queries(reporter, rand, rects, rtree);
         REPORTER_ASSERT(reporter, NUM_RECTS == rtree.getCount());
-        REPORTER_ASSERT(reporter, expectedDepthMin <= rtree.getDepth() &&
-                                  expectedDepthMax >= rtree.getDepth());
+        REPORTER_ASSERT(reporter, expectedDepth == rtree.getDepth());
+    }
+}
+
+DEF_TEST(RTree_SearchBatch, reporter) {
+    SkRandom rand;
+    SkAutoTMalloc<SkRect> rects(NUM_RECTS);
+    for (int j = 0; j < NUM_RECTS; j++) {
+        rects[j] = random_rect(rand);
+    }
+    SkRTree rtree;
+    rtree.insert(rects.get(), NUM_RECTS);
+
+    SkRect queries[NUM_QUERIES];
+    for (size_t i = 0; i < NUM_QUERIES; ++i) {
+        queries[i] = random_rect(rand);
+    }
+    queries[0].setEmpty();  // Empty queries hit nothing.
+
+    std::vector<int> hits[NUM_QUERIES];
+    rtree.searchBatch(queries, NUM_QUERIES, hits);
+    for (size_t i = 0; i < NUM_QUERIES; ++i) {
+        REPORTER_ASSERT(reporter, verify_query(queries[i], rects, hits[i]));
     }
 }
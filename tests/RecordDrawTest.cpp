@@ -8,6 +8,7 @@
 #include "tests/RecordTestUtils.h"
 #include "tests/Test.h"
 
+#include "include/core/SkPictureRecorder.h"
 #include "include/core/SkSurface.h"
 #include "include/effects/SkImageFilters.h"
 #include "src/core/SkImagePriv.h"
@@ -130,6 +131,60 @@ static bool sloppy_rect_eq(SkRect a, SkRect b) {
     return outset.contains(b) && !inset.contains(b);
 }
 
+static void draw_for_bounds(SkCanvas* canvas) {
+    SkPaint shadow;
+    shadow.setImageFilter(SkImageFilters::DropShadow(20, 0, 0, 0, SK_ColorBLACK,  nullptr));
+    SkPaint stroke;
+    stroke.setStyle(SkPaint::kStroke_Style);
+    stroke.setStrokeWidth(4);
+
+    canvas->drawRect(SkRect::MakeXYWH(5, 5, 10, 10), stroke);
+    canvas->saveLayer(nullptr, &shadow);
+        canvas->clipRect(SkRect::MakeWH(20, 40));
+        canvas->save();
+            canvas->translate(10, 10);
+            canvas->rotate(30);
+            canvas->drawRect(SkRect::MakeWH(20, 40), SkPaint());
+        canvas->restore();
+        canvas->saveLayerAlpha(nullptr, 0x80);
+            canvas->drawOval(SkRect::MakeXYWH(1, 2, 3, 4), stroke);
+        canvas->restore();
+    canvas->restore();
+    canvas->save();
+        canvas->scale(0.5f, 0.5f);
+        canvas->drawRect(SkRect::MakeXYWH(20, 20, 10, 10), SkPaint());
+    // Left unbalanced for the tracker to finish.
+}
+
+DEF_TEST(RecordDraw_BoundsTracker, r) {
+    for (bool conservative : {false, true}) {
+        const SkRect cull = SkRect::MakeWH(50, 50);
+        SkRecord record;
+        SkRecorder recorder(&record, cull);
+        SkRecordBoundsTracker tracker;
+        tracker.reset(record, cull, conservative);
+        recorder.setBoundsTracker(&tracker);
+        draw_for_bounds(&recorder);
+        tracker.finish();
+
+        // Tracking the ops as they're recorded gives the same bounds as filling them in after.
+        SkAutoTMalloc<SkRect> bounds(record.count());
+        SkAutoTMalloc<SkBBoxHierarchy::Metadata> meta(record.count());
+        SkRecordFillBounds(cull, record, bounds, meta, conservative);
+        for (int i = 0; i < record.count(); i++) {
+            REPORTER_ASSERT(r, tracker.bounds()[i] == bounds[i]);
+            REPORTER_ASSERT(r, tracker.meta()[i].isDraw == meta[i].isDraw);
+        }
+
+        // Ops 6 and 9 draw under the drop shadow: conservatively they may touch the whole cull.
+        REPORTER_ASSERT(r, record.count() == 15);
+        REPORTER_ASSERT(r, conservative == (bounds[6] == cull));
+        REPORTER_ASSERT(r, conservative == (bounds[9] == cull));
+        // The last rect is drawn outside of any layer, and bounded tightly either way.
+        REPORTER_ASSERT(r, sloppy_rect_eq(bounds[14], SkRect::MakeXYWH(10, 10, 5, 5)));
+    }
+}
+
 // TODO This would be nice, but we can't get it right today.
 #if 0
 DEF_TEST(RecordDraw_BasicBounds, r) {
@@ -311,3 +366,39 @@ DEF_TEST(RecordDraw_drawImage, r){
     REPORTER_ASSERT(r, canvas.fDrawImageRectCalled);
 
 }
+
+DEF_TEST(RecordDraw_SkipsOccludedDraws, r) {
+    SkPaint paint;
+    SkPictureRecorder pictureRecorder;
+    SkCanvas* canvas = pictureRecorder.beginRecording(SkRect::MakeWH(W, H));
+    canvas->drawRect(SkRect::MakeWH(200, 200), paint);      // Only partially hidden by...
+    canvas->drawRect(SkRect::MakeWH(100, 100), paint);      // ...this occluder.
+    canvas->drawRect(SkRect::MakeXYWH(10, 10, 10, 10), paint);
+    sk_sp<SkPicture> picture = pictureRecorder.finishRecordingAsPicture(
+            SkPictureRecorder::kCullOccludedOps_FinishFlag);
+
+    // With the whole picture visible, all three rects are drawn.
+    {
+        SkRecord record;
+        SkRecorder recorder(&record, W, H);
+        picture->playback(&recorder);
+        REPORTER_ASSERT(r, 3 == count_instances_of_type<SkRecords::DrawRect>(record));
+    }
+    // Clipped to the occluder, the first rect can't be seen.
+    {
+        SkRecord record;
+        SkRecorder recorder(&record, W, H);
+        recorder.clipRect(SkRect::MakeLTRB(20, 20, 80, 80));
+        picture->playback(&recorder);
+        REPORTER_ASSERT(r, 2 == count_instances_of_type<SkRecords::DrawRect>(record));
+    }
+    // Scaled down, the occluder no longer covers the clip.
+    {
+        SkRecord record;
+        SkRecorder recorder(&record, W, H);
+        recorder.clipRect(SkRect::MakeLTRB(20, 20, 80, 80));
+        recorder.scale(0.5f, 0.5f);
+        picture->playback(&recorder);
+        REPORTER_ASSERT(r, 3 == count_instances_of_type<SkRecords::DrawRect>(record));
+    }
+}
@@ -13,6 +13,7 @@
 #include "include/core/SkSurface.h"
 #include "include/effects/SkImageFilters.h"
 #include "src/core/SkRecord.h"
+#include "src/core/SkRecordDraw.h"
 #include "src/core/SkRecordOpts.h"
 #include "src/core/SkRecorder.h"
 #include "src/core/SkRecords.h"
@@ -426,3 +427,81 @@ DEF_TEST(savelayer_srcmode_alpha, r) {
     do_savelayer_srcmode(r, 0x80FF0000);
 }
 
+
+static void noop_occluded_draws(SkRecord* record) {
+    SkAutoTMalloc<SkRect> bounds(record->count());
+    SkAutoTMalloc<SkBBoxHierarchy::Metadata> meta(record->count());
+    SkAutoTMalloc<SkRect> occluders(record->count());
+    SkAutoTMalloc<bool> barriers(record->count());
+    SkRecordFillBounds(SkRect::MakeWH(W, H), *record, bounds, meta);
+    SkRecordFillOccluders(*record, occluders, barriers);
+    SkRecordNoopOccludedDraws(record, bounds, occluders, barriers);
+}
+
+DEF_TEST(RecordOpts_NoopOccludedDraws, r) {
+    const SkRect small = SkRect::MakeLTRB(10, 10, 50, 50),
+                   big = SkRect::MakeWH(100, 100);
+    SkPaint opaque, translucent;
+    translucent.setAlpha(0x80);
+
+    {
+        // An opaque rect hides what's under it, but not what's drawn after it.
+        SkRecord record;
+        SkRecorder recorder(&record, W, H);
+        recorder.drawRect(small, opaque);
+        recorder.drawRect(big, opaque);
+        recorder.drawRect(small, opaque);
+        noop_occluded_draws(&record);
+        assert_type<SkRecords::NoOp>(r, record, 0);
+        assert_type<SkRecords::DrawRect>(r, record, 1);
+        assert_type<SkRecords::DrawRect>(r, record, 2);
+    }
+    {
+        // Translucent draws and draws inside layers don't hide anything.
+        SkRecord record;
+        SkRecorder recorder(&record, W, H);
+        recorder.drawRect(small, opaque);
+        recorder.drawRect(big, translucent);
+        recorder.saveLayer(nullptr, nullptr);
+            recorder.drawRect(big, opaque);
+        recorder.restore();
+        noop_occluded_draws(&record);
+        assert_type<SkRecords::DrawRect>(r, record, 0);
+    }
+    {
+        // The occluder is clipped.
+        SkRecord record;
+        SkRecorder recorder(&record, W, H);
+        recorder.drawRect(small, opaque);
+        recorder.save();
+            recorder.clipRect(SkRect::MakeWH(30, 30));
+            recorder.drawRect(big, opaque);
+        recorder.restore();
+        noop_occluded_draws(&record);
+        assert_type<SkRecords::DrawRect>(r, record, 0);
+    }
+    {
+        // A backdrop filter reads back what was drawn before it, hidden or not.
+        SkRecord record;
+        SkRecorder recorder(&record, W, H);
+        recorder.drawRect(small, opaque);
+        auto blur = SkImageFilters::Blur(3, 3, nullptr);
+        recorder.saveLayer({nullptr, nullptr, blur.get(), 0});
+        recorder.restore();
+        recorder.drawRect(big, opaque);
+        noop_occluded_draws(&record);
+        assert_type<SkRecords::DrawRect>(r, record, 0);
+    }
+    {
+        // An antialiased edge could still show through less than a pixel from the occluder's.
+        SkRecord record;
+        SkRecorder recorder(&record, W, H);
+        recorder.drawRect(big, opaque);
+        recorder.drawRect(big.makeOutset(0.5f, 0.5f), opaque);
+        recorder.drawRect(big.makeOutset(1, 1), opaque);
+        noop_occluded_draws(&record);
+        assert_type<SkRecords::NoOp>(r, record, 0);
+        assert_type<SkRecords::DrawRect>(r, record, 1);
+        assert_type<SkRecords::DrawRect>(r, record, 2);
+    }
+}
@@ -97,6 +97,31 @@ DEF_TEST(Record_defrag, r) {
     assert_type<SkRecords::Restore >(r, record, 3);
 }
 
+DEF_TEST(Record_reset, r) {
+    // Any ref-counted effect will do to check that reset() destroys the commands.
+    SkPaint paint;
+    paint.setShader(SkShaders::Color(SK_ColorRED));
+
+    SkRecord record;
+    for (int frame = 0; frame < 3; frame++) {
+        for (int i = 0; i < 100; i++) {
+            APPEND(record, SkRecords::DrawPaint, paint);
+        }
+        REPORTER_ASSERT(r, record.count() == 100);
+        REPORTER_ASSERT(r, !paint.getShader()->unique());
+
+        record.reset();
+        REPORTER_ASSERT(r, record.count() == 0);
+        REPORTER_ASSERT(r, paint.getShader()->unique());
+    }
+
+    // A reset record records just like a new one.
+    APPEND(record, SkRecords::DrawRect, paint, SkRect::MakeWH(10, 10));
+    AreaSummer summer;
+    summer.apply(record);
+    REPORTER_ASSERT(r, summer.area() == 100);
+}
+
 #undef APPEND
 
 template <typename T>
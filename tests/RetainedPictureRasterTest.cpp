@@ -0,0 +1,118 @@
+/*
+ * Copyright 2020 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "include/core/SkBitmap.h"
+#include "include/core/SkCanvas.h"
+#include "include/core/SkPath.h"
+#include "include/core/SkPictureRecorder.h"
+#include "include/utils/SkRetainedPictureRaster.h"
+#include "tests/Test.h"
+#include "tools/ToolUtils.h"
+
+static sk_sp<SkPicture> make_picture(SkColor middle, SkScalar x) {
+    SkRTreeFactory factory;
+    SkPictureRecorder recorder;
+    SkCanvas* canvas = recorder.beginRecording(SkRect::MakeWH(100, 100), &factory);
+    SkPaint paint;
+    paint.setColor(SK_ColorBLUE);
+    canvas->drawRect(SkRect::MakeXYWH(0, 0, 30, 30), paint);
+    paint.setColor(middle);
+    canvas->drawRect(SkRect::MakeXYWH(x, 40, 20, 20), paint);
+    paint.setColor(SK_ColorGREEN);
+    canvas->drawRect(SkRect::MakeXYWH(70, 70, 30, 30), paint);
+    return recorder.finishRecordingAsPicture();
+}
+
+DEF_TEST(RetainedPictureRaster_ComputeDamage, r) {
+    sk_sp<SkPicture> before = make_picture(SK_ColorRED, 40);
+
+    // The same ops, recorded again, draw the same.
+    REPORTER_ASSERT(r, SkRetainedPictureRaster::ComputeDamage(*before, *make_picture(SK_ColorRED,
+                                                                                     40)).isEmpty());
+
+    // A changed paint damages only that rect.
+    SkRegion damage = SkRetainedPictureRaster::ComputeDamage(*before,
+                                                             *make_picture(SK_ColorCYAN, 40));
+    REPORTER_ASSERT(r, damage.isRect());
+    REPORTER_ASSERT(r, damage.getBounds() == SkIRect::MakeXYWH(40, 40, 20, 20));
+
+    // A moved rect damages where it was and where it is now.
+    damage = SkRetainedPictureRaster::ComputeDamage(*before, *make_picture(SK_ColorRED, 45));
+    REPORTER_ASSERT(r, damage.getBounds() == SkIRect::MakeXYWH(40, 40, 25, 20));
+
+    // Damage is in the space of the matrix.
+    damage = SkRetainedPictureRaster::ComputeDamage(*before, *make_picture(SK_ColorCYAN, 40),
+                                                    SkMatrix::MakeScale(2));
+    REPORTER_ASSERT(r, damage.getBounds() == SkIRect::MakeXYWH(80, 80, 40, 40));
+}
+
+static sk_sp<SkPicture> make_path_picture(SkScalar radius, SkPathFillType fillType) {
+    SkRTreeFactory factory;
+    SkPictureRecorder recorder;
+    SkCanvas* canvas = recorder.beginRecording(SkRect::MakeWH(100, 100), &factory);
+    SkPath path;
+    path.moveTo(10, 10).lineTo(40, 10).lineTo(10, 40).close();
+    canvas->drawPath(path, SkPaint());
+    path.reset();
+    path.addCircle(70, 70, radius);
+    path.setFillType(fillType);
+    canvas->drawPath(path, SkPaint());
+    return recorder.finishRecordingAsPicture();
+}
+
+DEF_TEST(RetainedPictureRaster_ComputeDamagePaths, r) {
+    sk_sp<SkPicture> before = make_path_picture(10, SkPathFillType::kWinding);
+
+    // Paths built again the same way draw the same, though they are different SkPaths.
+    REPORTER_ASSERT(r, SkRetainedPictureRaster::ComputeDamage(
+            *before, *make_path_picture(10, SkPathFillType::kWinding)).isEmpty());
+
+    // Changed points damage only that path.
+    SkRegion damage = SkRetainedPictureRaster::ComputeDamage(
+            *before, *make_path_picture(20, SkPathFillType::kWinding));
+    REPORTER_ASSERT(r, damage.getBounds() == SkIRect::MakeLTRB(50, 50, 90, 90));
+
+    // So does a changed fill type.
+    damage = SkRetainedPictureRaster::ComputeDamage(
+            *before, *make_path_picture(10, SkPathFillType::kInverseWinding));
+    REPORTER_ASSERT(r, !damage.isEmpty());
+}
+
+DEF_TEST(RetainedPictureRaster_MatchesFullDraw, r) {
+    const SkImageInfo info = SkImageInfo::MakeN32Premul(100, 100);
+    SkRetainedPictureRaster raster(info, SkMatrix::I(), 32);
+
+    sk_sp<SkPicture> pictures[] = {
+        make_picture(SK_ColorRED,  40),
+        make_picture(SK_ColorCYAN, 40),
+        make_picture(SK_ColorCYAN, 45),
+        make_picture(SK_ColorCYAN, 45),
+    };
+    SkIRect expectedDamage[] = {
+        SkIRect::MakeWH(100, 100),
+        SkIRect::MakeXYWH(40, 40, 20, 20),
+        SkIRect::MakeXYWH(40, 40, 25, 20),
+        SkIRect::MakeEmpty(),
+    };
+    for (size_t i = 0; i < SK_ARRAY_COUNT(pictures); i++) {
+        SkRegion damage = raster.update(pictures[i]);
+        REPORTER_ASSERT(r, damage.getBounds() == expectedDamage[i]);
+
+        SkBitmap expected, actual;
+        expected.allocPixels(info);
+        expected.eraseColor(SK_ColorTRANSPARENT);
+        SkCanvas(expected).drawPicture(pictures[i]);
+        raster.readPixels(&actual);
+        REPORTER_ASSERT(r, ToolUtils::equal_pixels(expected, actual));
+    }
+
+    // With explicit damage, nothing outside of it is redrawn.
+    raster.update(make_picture(SK_ColorRED, 45), SkRegion(SkIRect::MakeWH(10, 10)));
+    SkBitmap actual;
+    raster.readPixels(&actual);
+    REPORTER_ASSERT(r, *actual.getAddr32(50, 50) == SkPreMultiplyColor(SK_ColorCYAN));
+}
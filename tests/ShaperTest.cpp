@@ -7,6 +7,8 @@
 
 #include "include/core/SkData.h"
 #include "include/core/SkFont.h"
+#include "include/core/SkFontMgr.h"
+#include "include/core/SkFontStyle.h"
 #include "include/core/SkPoint.h"
 #include "include/core/SkRefCnt.h"
 #include "include/core/SkTypeface.h"
@@ -14,9 +16,12 @@
 #include "include/private/SkTo.h"
 #include "modules/skshaper/include/SkShaper.h"
 #include "tools/Resources.h"
+#include "tools/ToolUtils.h"
 
 #include <cstdint>
+#include <cstring>
 #include <memory>
+#include <vector>
 
 namespace {
 struct RunHandler final : public SkShaper::RunHandler {
@@ -134,4 +139,153 @@ SHAPER_TEST(vai)
 //SHAPER_TEST(tamil)
 #undef SHAPER_TEST
 
+namespace {
+// Answers character fallback requests with a single typeface, counting how often it is asked.
+// Requests for fOtherCharacter are answered with fOther instead, when set.
+class CountingFallbackFontMgr final : public SkFontMgr {
+public:
+    explicit CountingFallbackFontMgr(sk_sp<SkTypeface> typeface)
+        : fTypeface(std::move(typeface)) {}
+
+    SkUnichar fOtherCharacter = 0;
+    sk_sp<SkTypeface> fOther;
+
+    mutable int fMatchCount = 0;
+
+protected:
+    int onCountFamilies() const override { return 0; }
+    void onGetFamilyName(int, SkString*) const override {}
+    SkFontStyleSet* onCreateStyleSet(int) const override { return nullptr; }
+    SkFontStyleSet* onMatchFamily(const char[]) const override { return nullptr; }
+    SkTypeface* onMatchFamilyStyle(const char[], const SkFontStyle&) const override {
+        return nullptr;
+    }
+    SkTypeface* onMatchFamilyStyleCharacter(const char[], const SkFontStyle&,
+                                            const char*[], int,
+                                            SkUnichar character) const override {
+        ++fMatchCount;
+        if (fOther && character == fOtherCharacter) {
+            return SkRef(fOther.get());
+        }
+        return fTypeface->unicharToGlyph(character) ? SkRef(fTypeface.get()) : nullptr;
+    }
+    SkTypeface* onMatchFaceStyle(const SkTypeface*, const SkFontStyle&) const override {
+        return nullptr;
+    }
+    sk_sp<SkTypeface> onMakeFromData(sk_sp<SkData>, int) const override { return nullptr; }
+    sk_sp<SkTypeface> onMakeFromStreamIndex(std::unique_ptr<SkStreamAsset>,
+                                            int) const override {
+        return nullptr;
+    }
+    sk_sp<SkTypeface> onMakeFromFile(const char[], int) const override { return nullptr; }
+    sk_sp<SkTypeface> onLegacyMakeTypeface(const char[], SkFontStyle) const override {
+        return nullptr;
+    }
+
+private:
+    sk_sp<SkTypeface> fTypeface;
+};
+}  // namespace
+
+DEF_TEST(Shaper_FontFallbackCache, r) {
+    sk_sp<SkTypeface> typeface = ToolUtils::create_portable_typeface();
+    auto fontMgr = sk_make_sp<CountingFallbackFontMgr>(typeface);
+    SkShaper::FontFallbackCache cache;
+    const char* language = "en";
+
+    auto match = [&](SkUnichar uni, SkFontStyle style) {
+        return cache.matchFamilyStyleCharacter(fontMgr.get(), nullptr, style, &language, 1, uni);
+    };
+
+    REPORTER_ASSERT(r, match('a', SkFontStyle()) == typeface);
+    REPORTER_ASSERT(r, fontMgr->fMatchCount == 1);
+    REPORTER_ASSERT(r, match('a', SkFontStyle()) == typeface);
+    REPORTER_ASSERT(r, fontMgr->fMatchCount == 1);
+
+    // The typeface found for 'a' also covers 'b', but the font manager picks another for it.
+    fontMgr->fOtherCharacter = 'b';
+    fontMgr->fOther = ToolUtils::create_portable_typeface("serif", SkFontStyle());
+    REPORTER_ASSERT(r, fontMgr->fOther != typeface);
+    REPORTER_ASSERT(r, match('b', SkFontStyle()) == fontMgr->fOther);
+    REPORTER_ASSERT(r, fontMgr->fMatchCount == 2);
+
+    // Misses are remembered too.
+    REPORTER_ASSERT(r, !match(0x4E00, SkFontStyle()));
+    REPORTER_ASSERT(r, !match(0x4E00, SkFontStyle()));
+    REPORTER_ASSERT(r, fontMgr->fMatchCount == 3);
+
+    // The style is part of the request.
+    REPORTER_ASSERT(r, match('a', SkFontStyle::Bold()) == typeface);
+    REPORTER_ASSERT(r, fontMgr->fMatchCount == 4);
+
+    REPORTER_ASSERT(r, cache.hits() == 2);
+    REPORTER_ASSERT(r, cache.misses() == 4);
+
+    cache.purge();
+    REPORTER_ASSERT(r, cache.count() == 0);
+    REPORTER_ASSERT(r, match('a', SkFontStyle()) == typeface);
+    REPORTER_ASSERT(r, fontMgr->fMatchCount == 5);
+}
+
+#if defined(SK_SHAPER_HARFBUZZ_AVAILABLE)
+namespace {
+struct GlyphRecorder final : public SkShaper::RunHandler {
+    std::vector<SkGlyphID> fGlyphs;
+    std::vector<SkPoint> fPositions;
+    std::vector<uint32_t> fClusters;
+    size_t fCount = 0;
+
+    void beginLine() override {}
+    void runInfo(const RunInfo&) override {}
+    void commitRunInfo() override {}
+    Buffer runBuffer(const RunInfo& info) override {
+        fCount = fGlyphs.size();
+        fGlyphs.resize(fCount + info.glyphCount);
+        fPositions.resize(fCount + info.glyphCount);
+        fClusters.resize(fCount + info.glyphCount);
+        return {fGlyphs.data() + fCount, fPositions.data() + fCount, nullptr,
+                fClusters.data() + fCount, {0, 0}};
+    }
+    void commitRunBuffer(const RunInfo&) override {}
+    void commitLine() override {}
+};
+}  // namespace
+
+DEF_TEST(Shaper_ShapeCache, r) {
+    auto cache = sk_make_sp<SkShaper::ShapeCache>();
+    auto shaper = SkShaper::MakeShapeThenWrap(nullptr, cache);
+    if (!shaper) {
+        ERRORF(r, "Could not create shaper.");
+        return;
+    }
+
+    SkFont font(ToolUtils::create_portable_typeface(), 14);
+    const char text[] = "Shaping the same text twice only shapes it once.";
+
+    GlyphRecorder first;
+    shaper->shape(text, strlen(text), font, true, 1000, &first);
+    REPORTER_ASSERT(r, cache->hits() == 0);
+    REPORTER_ASSERT(r, cache->misses() > 0);
+    REPORTER_ASSERT(r, cache->count() > 0);
+    int misses = cache->misses();
+
+    GlyphRecorder second;
+    shaper->shape(text, strlen(text), font, true, 1000, &second);
+    REPORTER_ASSERT(r, cache->hits() == misses);
+    REPORTER_ASSERT(r, cache->misses() == misses);
+    REPORTER_ASSERT(r, first.fGlyphs == second.fGlyphs);
+    REPORTER_ASSERT(r, first.fClusters == second.fClusters);
+    REPORTER_ASSERT(r, first.fPositions == second.fPositions);
+
+    // A different size is a different run.
+    font.setSize(20);
+    GlyphRecorder larger;
+    shaper->shape(text, strlen(text), font, true, 1000, &larger);
+    REPORTER_ASSERT(r, cache->misses() > misses);
+
+    cache->purge();
+    REPORTER_ASSERT(r, cache->count() == 0);
+}
+#endif
+
 #endif  // !defined(SK_BUILD_FOR_ANDROID_FRAMEWORK) && !defined(SK_BUILD_FOR_GOOGLE3)
@@ -1,6 +1,7 @@
 // Copyright 2019 Google LLC.
 #include <sstream>
 #include <thread>
+#include "include/core/SkTraceMemoryDump.h"
 #include "modules/skparagraph/include/TypefaceFontProvider.h"
 #include "modules/skparagraph/src/ParagraphBuilderImpl.h"
 #include "modules/skparagraph/src/ParagraphImpl.h"
@@ -4794,6 +4795,235 @@ DEF_TEST(SkParagraph_CacheStyles, reporter) {
     test(2, false);
 }
 
+DEF_TEST(SkParagraph_CacheByteLimit, reporter) {
+    sk_sp<ResourceFontCollection> fontCollection = sk_make_sp<ResourceFontCollection>();
+    if (!fontCollection->fontsFound()) return;
+    auto cache = sk_make_sp<ParagraphCache>();
+    fontCollection->setParagraphCache(cache);
+
+    ParagraphStyle paragraph_style;
+    paragraph_style.turnHintingOff();
+    TextStyle text_style;
+    text_style.setFontFamilies({SkString("Roboto")});
+    text_style.setColor(SK_ColorBLACK);
+
+    auto layout = [&](const char* text) {
+        ParagraphBuilderImpl builder(paragraph_style, fontCollection);
+        builder.pushStyle(text_style);
+        builder.addText(text, strlen(text));
+        builder.pop();
+        auto paragraph = builder.Build();
+        paragraph->layout(TestCanvasWidth);
+    };
+
+    layout("text1");
+    REPORTER_ASSERT(reporter, cache->count() == 1);
+    size_t entryBytes = cache->getBytesUsed();
+    REPORTER_ASSERT(reporter, entryBytes > 0);
+
+    // Room for two paragraphs of the same size: the oldest one is evicted by the third.
+    cache->setByteLimit(2 * entryBytes);
+    layout("text2");
+    layout("text3");
+    REPORTER_ASSERT(reporter, cache->count() == 2);
+    REPORTER_ASSERT(reporter, cache->getBytesUsed() <= cache->getByteLimit());
+
+    cache->setByteLimit(entryBytes);
+    REPORTER_ASSERT(reporter, cache->count() == 1);
+
+    class CountingTraceMemoryDump : public SkTraceMemoryDump {
+    public:
+        void dumpNumericValue(const char* dumpName, const char* valueName, const char* units,
+                              uint64_t value) override {
+            if (SkString("size") == SkString(valueName)) {
+                fSize = value;
+            }
+        }
+        void setMemoryBacking(const char*, const char*, const char*) override { }
+        void setDiscardableMemoryBacking(const char*, const SkDiscardableMemory&) override { }
+        LevelOfDetail getRequestedDetails() const override { return kLight_LevelOfDetail; }
+
+        uint64_t fSize = 0;
+    } dump;
+    cache->dumpMemoryStatistics(&dump);
+    REPORTER_ASSERT(reporter, dump.fSize == cache->getBytesUsed());
+
+    // A paragraph which could never fit is not cached at all.
+    cache->setByteLimit(0);
+    layout("text4");
+    REPORTER_ASSERT(reporter, cache->count() == 0);
+}
+
+DEF_TEST(SkParagraph_CacheShared, reporter) {
+    if (!SkLoadICU()) return;
+    auto cache = sk_make_sp<ParagraphCache>();
+    auto fontProvider = sk_make_sp<TypefaceFontProvider>();
+    fontProvider->registerTypeface(ToolUtils::create_portable_typeface(), SkString("Portable"));
+    auto makeCollection = [&]() {
+        auto collection = sk_make_sp<FontCollection>();
+        collection->setAssetFontManager(fontProvider);
+        collection->disableFontFallback();
+        collection->setParagraphCache(cache);
+        return collection;
+    };
+
+    ParagraphStyle paragraph_style;
+    paragraph_style.turnHintingOff();
+    TextStyle text_style;
+    text_style.setFontFamilies({SkString("Portable")});
+    text_style.setColor(SK_ColorBLACK);
+
+    auto layout = [&](sk_sp<FontCollection> collection, const char* text) {
+        ParagraphBuilderImpl builder(paragraph_style, std::move(collection));
+        builder.pushStyle(text_style);
+        builder.addText(text, strlen(text));
+        builder.pop();
+        auto paragraph = builder.Build();
+        paragraph->layout(TestCanvasWidth);
+    };
+
+    // Collections with the same font managers share results.
+    layout(makeCollection(), "shared");
+    layout(makeCollection(), "shared");
+    REPORTER_ASSERT(reporter, cache->count() == 1);
+
+    // A collection with different fonts gets its own entry.
+    auto other = makeCollection();
+    other->setDynamicFontManager(sk_make_sp<TypefaceFontProvider>());
+    layout(other, "shared");
+    REPORTER_ASSERT(reporter, cache->count() == 2);
+
+    // Collections on several threads can use the cache at once.
+    cache->reset();
+    const char* texts[] = { "one two", "three four", "five six", "seven eight" };
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&, collection = makeCollection()]() {
+            for (int j = 0; j < 32; ++j) {
+                layout(collection, texts[j % SK_ARRAY_COUNT(texts)]);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    REPORTER_ASSERT(reporter, cache->count() == SK_ARRAY_COUNT(texts));
+}
+
+DEF_TEST(SkParagraph_RelayoutWithoutReshaping, reporter) {
+    if (!SkLoadICU()) return;
+    auto fontProvider = sk_make_sp<TypefaceFontProvider>();
+    fontProvider->registerTypeface(ToolUtils::create_portable_typeface(), SkString("Portable"));
+    auto fontCollection = sk_make_sp<FontCollection>();
+    fontCollection->setAssetFontManager(fontProvider);
+    fontCollection->disableFontFallback();
+    fontCollection->setParagraphCache(sk_make_sp<ParagraphCache>());
+    int lookups = 0;
+    fontCollection->getParagraphCache()->setChecker(
+            [&lookups](ParagraphImpl*, const char* event, bool) {
+                if (strcmp(event, "addedParagraph") != 0) {
+                    ++lookups;
+                }
+            });
+
+    ParagraphStyle paragraph_style;
+    paragraph_style.turnHintingOff();
+    paragraph_style.setTextAlign(TextAlign::kJustify);
+    TextStyle text_style;
+    text_style.setFontFamilies({SkString("Portable")});
+    text_style.setColor(SK_ColorBLACK);
+    text_style.setLetterSpacing(1);
+
+    const char* text = "The quick brown fox jumps over the lazy dog. "
+                       "The quick brown fox jumps over the lazy dog.";
+    auto build = [&]() {
+        ParagraphBuilderImpl builder(paragraph_style, fontCollection);
+        builder.pushStyle(text_style);
+        builder.addText(text, strlen(text));
+        builder.pop();
+        return builder.Build();
+    };
+
+    auto paragraph = build();
+    paragraph->layout(TestCanvasWidth);
+    REPORTER_ASSERT(reporter, lookups == 1);
+
+    // Changing the width breaks the same runs into lines again.
+    paragraph->layout(100);
+    paragraph->layout(TestCanvasWidth);
+    paragraph->layout(150);
+    REPORTER_ASSERT(reporter, lookups == 1);
+
+    // The result matches a paragraph laid out at that width from scratch.
+    auto fresh = build();
+    fresh->layout(150);
+    REPORTER_ASSERT(reporter, paragraph->lineNumber() == fresh->lineNumber());
+    REPORTER_ASSERT(reporter, SkScalarNearlyEqual(paragraph->getHeight(), fresh->getHeight()));
+    REPORTER_ASSERT(reporter, SkScalarNearlyEqual(paragraph->getLongestLine(),
+                                                  fresh->getLongestLine()));
+}
+
+DEF_TEST(SkParagraph_ReplaceText, reporter) {
+    if (!SkLoadICU()) return;
+    auto fontProvider = sk_make_sp<TypefaceFontProvider>();
+    fontProvider->registerTypeface(ToolUtils::create_portable_typeface(), SkString("Portable"));
+    auto fontCollection = sk_make_sp<FontCollection>();
+    fontCollection->setAssetFontManager(fontProvider);
+    fontCollection->disableFontFallback();
+
+    ParagraphStyle paragraph_style;
+    paragraph_style.turnHintingOff();
+    TextStyle text_style;
+    text_style.setFontFamilies({SkString("Portable")});
+    text_style.setColor(SK_ColorBLACK);
+    auto build = [&](const char* text) {
+        ParagraphBuilderImpl builder(paragraph_style, fontCollection);
+        builder.pushStyle(text_style);
+        builder.addText(text, strlen(text));
+        builder.pop();
+        auto paragraph = builder.Build();
+        paragraph->layout(200);
+        return paragraph;
+    };
+
+    auto compare = [&](Paragraph* edited, const char* expected) {
+        auto fresh = build(expected);
+        auto impl = static_cast<ParagraphImpl*>(edited);
+        auto freshImpl = static_cast<ParagraphImpl*>(fresh.get());
+        REPORTER_ASSERT(reporter, impl->text().size() == strlen(expected));
+        REPORTER_ASSERT(reporter, strncmp(impl->text().data(), expected, strlen(expected)) == 0);
+        REPORTER_ASSERT(reporter, impl->lineNumber() == freshImpl->lineNumber());
+        REPORTER_ASSERT(reporter, SkScalarNearlyEqual(impl->getMaxIntrinsicWidth(),
+                                                      freshImpl->getMaxIntrinsicWidth()));
+        size_t glyphs = 0, freshGlyphs = 0;
+        for (auto& run : impl->runs()) {
+            glyphs += run.size();
+            REPORTER_ASSERT(reporter, run.master() == impl);
+        }
+        for (auto& run : freshImpl->runs()) {
+            freshGlyphs += run.size();
+        }
+        REPORTER_ASSERT(reporter, glyphs == freshGlyphs);
+    };
+
+    auto paragraph = build("Hello world, this is a paragraph.");
+    paragraph->replaceText(6, 11, SkString("there"));
+    paragraph->layout(200);
+    compare(paragraph.get(), "Hello there, this is a paragraph.");
+
+    paragraph->replaceText(0, 0, SkString("Oh. "));
+    paragraph->layout(200);
+    compare(paragraph.get(), "Oh. Hello there, this is a paragraph.");
+
+    paragraph->replaceText(15, 36, SkString(""));
+    paragraph->layout(200);
+    compare(paragraph.get(), "Oh. Hello there.");
+
+    paragraph->updateText(0, SkString("Ah"));
+    paragraph->layout(200);
+    compare(paragraph.get(), "Ah. Hello there.");
+}
+
 DEF_TEST(SkParagraph_EmptyParagraphWithLineBreak, reporter) {
     sk_sp<ResourceFontCollection> fontCollection = sk_make_sp<ResourceFontCollection>();
     if (!fontCollection->fontsFound()) return;
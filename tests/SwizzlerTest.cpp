@@ -7,6 +7,7 @@
 
 #include "include/core/SkSwizzle.h"
 #include "include/private/SkImageInfoPriv.h"
+#include "include/utils/SkRandom.h"
 #include "src/codec/SkSwizzler.h"
 #include "src/core/SkOpts.h"
 #include "tests/Test.h"
@@ -144,6 +145,61 @@ DEF_TEST(SwizzleOpts, r) {
     REPORTER_ASSERT(r, dst == 0xFA04ADCA);
 }
 
+// Checks every length up to a few vectors' worth, to exercise the SIMD loops and their tails.
+DEF_TEST(SwizzleOpts_16BitAndIndex, r) {
+    static const int kMax = 40;
+    SkRandom random;
+    uint8_t src[kMax * 8];
+    for (uint8_t& byte : src) {
+        byte = (uint8_t)random.nextU();
+    }
+    uint32_t ctable[256];
+    for (uint32_t& color : ctable) {
+        color = random.nextU();
+    }
+    auto pack = [](uint8_t a, uint8_t b, uint8_t g, uint8_t r) {
+        return (uint32_t)a << 24 | (uint32_t)b << 16 | (uint32_t)g << 8 | (uint32_t)r;
+    };
+
+    for (int count = 0; count <= kMax; count++) {
+        uint32_t dst[kMax + 1];
+        // Nothing past count may be written.
+        dst[count] = 0xDEADBEEF;
+
+        SkOpts::RGB16_to_RGB1(dst, src, count);
+        for (int i = 0; i < count; i++) {
+            const uint8_t* p = src + 6*i;
+            REPORTER_ASSERT(r, dst[i] == pack(0xFF, p[4], p[2], p[0]));
+        }
+        SkOpts::RGB16_to_BGR1(dst, src, count);
+        for (int i = 0; i < count; i++) {
+            const uint8_t* p = src + 6*i;
+            REPORTER_ASSERT(r, dst[i] == pack(0xFF, p[0], p[2], p[4]));
+        }
+        SkOpts::RGBA16_to_RGBA(dst, src, count);
+        for (int i = 0; i < count; i++) {
+            const uint8_t* p = src + 8*i;
+            REPORTER_ASSERT(r, dst[i] == pack(p[6], p[4], p[2], p[0]));
+        }
+        SkOpts::RGBA16_to_BGRA(dst, src, count);
+        for (int i = 0; i < count; i++) {
+            const uint8_t* p = src + 8*i;
+            REPORTER_ASSERT(r, dst[i] == pack(p[6], p[0], p[2], p[4]));
+        }
+        SkOpts::index8_to_8888(dst, src, count, ctable);
+        for (int i = 0; i < count; i++) {
+            REPORTER_ASSERT(r, dst[i] == ctable[src[i]]);
+        }
+        SkOpts::index4_to_8888(dst, src, count, ctable);
+        for (int i = 0; i < count; i++) {
+            uint8_t index = (i & 1) ? (src[i / 2] & 0xF) : (src[i / 2] >> 4);
+            REPORTER_ASSERT(r, dst[i] == ctable[index]);
+        }
+
+        REPORTER_ASSERT(r, dst[count] == 0xDEADBEEF);
+    }
+}
+
 DEF_TEST(PublicSwizzleOpts, r) {
     uint32_t dst, src;
 
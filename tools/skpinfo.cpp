@@ -5,12 +5,19 @@
  * found in the LICENSE file.
  */
 
+#include "include/core/SkData.h"
 #include "include/core/SkPicture.h"
 #include "include/core/SkStream.h"
+#include "include/core/SkTime.h"
+#include "include/utils/SkNoDrawCanvas.h"
 #include "include/private/SkTo.h"
+#include "include/core/SkTextBlob.h"
+#include "include/private/SkTHash.h"
 #include "src/core/SkFontDescriptor.h"
+#include "src/core/SkPathPriv.h"
 #include "src/core/SkPictureCommon.h"
 #include "src/core/SkPictureData.h"
+#include "src/core/SkTextBlobPriv.h"
 #include "tools/flags/CommandLineFlags.h"
 
 static DEFINE_string2(input, i, "", "skp on which to report");
@@ -19,6 +26,10 @@ static DEFINE_bool2(cullRect, c, true, "cullRect");
 static DEFINE_bool2(flags, f, true, "flags");
 static DEFINE_bool2(tags, t, true, "tags");
 static DEFINE_bool2(quiet, q, false, "quiet");
+static DEFINE_bool(timing, false,
+                   "compare load and first playback time of the skp with its mapped form");
+static DEFINE_bool(duplicates, false,
+                   "report paths and text blobs drawn more than once with the same contents");
 
 // This tool can print simple information about an SKP but its main use
 // is just to check if an SKP has been truncated during the recording
@@ -31,6 +42,106 @@ static const int kInvalidTag = 3;
 static const int kMissingInput = 4;
 static const int kIOError = 5;
 
+// Prints how long it takes to open the picture and to play it back for the first time, both from
+// the skp itself and from the same picture written by SkPicture::serializeForMapping().
+static void print_timing(const char* path) {
+    sk_sp<SkData> skp = SkData::MakeFromFileName(path);
+    if (!skp) {
+        return;
+    }
+    auto time = [](const char* label, sk_sp<SkPicture> (*load)(sk_sp<SkData>), sk_sp<SkData> data) {
+        double start = SkTime::GetNSecs();
+        sk_sp<SkPicture> picture = load(data);
+        double loaded = SkTime::GetNSecs();
+        if (!picture) {
+            SkDebugf("%s: failed to load\n", label);
+            return picture;
+        }
+        SkIRect bounds = picture->cullRect().roundOut();
+        SkNoDrawCanvas canvas(bounds.width(), bounds.height());
+        canvas.translate(-bounds.left(), -bounds.top());
+        picture->playback(&canvas);
+        double drawn = SkTime::GetNSecs();
+        SkDebugf("%s: load %.3f ms, first playback %.3f ms\n",
+                 label, (loaded - start) * 1e-6, (drawn - loaded) * 1e-6);
+        return picture;
+    };
+    sk_sp<SkPicture> picture = time("skp", [](sk_sp<SkData> data) {
+        return SkPicture::MakeFromData(data.get());
+    }, skp);
+    if (picture) {
+        time("mapped", [](sk_sp<SkData> data) {
+            return SkPicture::MakeFromMappedData(std::move(data));
+        }, picture->serializeForMapping());
+    }
+}
+
+// Counts the paths and text blobs drawn by a picture, and how many have distinct contents.
+class DuplicateCounter : public SkNoDrawCanvas {
+public:
+    DuplicateCounter(int width, int height) : SkNoDrawCanvas(width, height) {}
+
+    void report(size_t skpBytes, size_t reserializedBytes) const {
+        SkDebugf("paths: %d drawn, %d distinct, %d distinct storage; "
+                 "%zu bytes, %zu bytes with duplicates shared\n",
+                 fPathCount, fPaths.count(), fPathRefs.count(), fPathBytes, fDistinctPathBytes);
+        SkDebugf("text blobs: %d drawn, %d distinct, %d distinct objects\n",
+                 fBlobCount, fBlobs.count(), fBlobIDs.count());
+        SkDebugf("skp: %zu bytes, re-serialized with duplicates written once: %zu bytes\n",
+                 skpBytes, reserializedBytes);
+    }
+
+protected:
+    void onDrawPath(const SkPath& path, const SkPaint&) override { this->count(path); }
+    void onDrawShadowRec(const SkPath& path, const SkDrawShadowRec&) override {
+        this->count(path);
+    }
+    void onClipPath(const SkPath& path, SkClipOp op, ClipEdgeStyle style) override {
+        this->count(path);
+        this->SkNoDrawCanvas::onClipPath(path, op, style);
+    }
+    void onDrawTextBlob(const SkTextBlob* blob, SkScalar, SkScalar, const SkPaint&) override {
+        fBlobCount++;
+        fBlobs.add({sk_ref_sp(blob)});
+        fBlobIDs.add(blob->uniqueID());
+    }
+
+private:
+    void count(const SkPath& path) {
+        fPathCount++;
+        fPathBytes += path.approximateBytesUsed();
+        if (!fPaths.contains(path)) {
+            fPaths.add(path);
+            fDistinctPathBytes += path.approximateBytesUsed();
+        }
+        fPathRefs.add(path.getGenerationID());
+    }
+
+    int    fPathCount = 0;
+    size_t fPathBytes = 0;
+    size_t fDistinctPathBytes = 0;
+    SkTHashSet<SkPath, SkPathPriv::ContentHasher> fPaths;
+    SkTHashSet<uint32_t> fPathRefs;
+
+    int fBlobCount = 0;
+    SkTHashSet<SkTextBlobContentKey, SkTextBlobContentKey::Hash> fBlobs;
+    SkTHashSet<uint32_t> fBlobIDs;
+};
+
+static void print_duplicates(const char* path) {
+    sk_sp<SkData> skp = SkData::MakeFromFileName(path);
+    sk_sp<SkPicture> picture = skp ? SkPicture::MakeFromData(skp.get()) : nullptr;
+    if (!picture) {
+        SkDebugf("duplicates: failed to load\n");
+        return;
+    }
+    SkIRect bounds = picture->cullRect().roundOut();
+    DuplicateCounter counter(bounds.width(), bounds.height());
+    counter.translate(-bounds.left(), -bounds.top());
+    picture->playback(&counter);
+    counter.report(skp->size(), picture->serialize()->size());
+}
+
 int main(int argc, char** argv) {
     CommandLineFlags::SetUsage("Prints information about an skp file");
     CommandLineFlags::Parse(argc, argv);
@@ -52,6 +163,13 @@ int main(int argc, char** argv) {
 
     size_t totStreamSize = stream.getLength();
 
+    if (FLAGS_timing) {
+        print_timing(FLAGS_input[0]);
+    }
+    if (FLAGS_duplicates) {
+        print_duplicates(FLAGS_input[0]);
+    }
+
     SkPictInfo info;
     if (!SkPicture_StreamIsSKP(&stream, &info)) {
         return kNotAnSKP;